@@ -45,6 +45,10 @@ class BeamHash_III : public PoWScheme {
 	int InitialiseState(blake2b_state& base_state);
 	bool IsValidSolution(const blake2b_state& base_state, std::vector<unsigned char> soln);
 
+	// Same result as IsValidSolution, but works on fixed-size stack buffers, without allocations.
+	// Elements are stored word-major, so the xor/shift/compare passes run over contiguous 64-bit words.
+	static bool IsValidSolutionFast(const blake2b_state& base_state, const uint8_t* pSol, size_t nSol);
+
 	#ifdef ENABLE_MINING
 	bool OptimisedSolve(const blake2b_state& base_state,
                         const std::function<bool(const std::vector<unsigned char>&)> validBlock,
@@ -271,6 +271,200 @@ bool BeamHash_III::IsValidSolution(const blake2b_state& base_state, std::vector<
 }
 
 
+/********
+
+    Allocation-free verifier
+
+    A valid solution keeps the leaves of every subtree contiguous and ordered (the index order check
+    rejects everything else), so the index trees need not be stored: an element of round r covers
+    the indices [i << (r-1), (i+1) << (r-1)). This also makes the distinctness and order checks
+    independent of the work bits, they're done upfront for the whole solution.
+
+********/
+
+namespace beamHashFast {
+
+const uint32_t numElems = 1 << numRounds;
+const uint32_t numWords = workBitSize / 64;
+const uint32_t numMixWords = 512 / 64;
+const uint32_t indexBits = collisionBitSize + 1;
+const uint32_t sipLanes = 8;
+
+static_assert(!(workBitSize % 64), "");
+static_assert(!((numElems * numWords) % sipLanes), "");
+
+// Independent siphash lanes, written so that the compiler can vectorize across them
+static void siphash24Lanes(const uint64_t* prePow, const uint64_t* pNonce, uint64_t* pRes) {
+	uint64_t v0[sipLanes], v1[sipLanes], v2[sipLanes], v3[sipLanes];
+
+	for (uint32_t k = 0; k < sipLanes; k++) {
+		v0[k] = prePow[0]; v1[k] = prePow[1]; v2[k] = prePow[2]; v3[k] = prePow[3] ^ pNonce[k];
+	}
+
+#define sipRoundLanes() \
+	for (uint32_t k = 0; k < sipLanes; k++) { \
+		v0[k] += v1[k]; v2[k] += v3[k]; \
+		v1[k] = sipHash::rotl(v1[k],13); \
+		v3[k] = sipHash::rotl(v3[k],16); \
+		v1[k] ^= v0[k]; v3[k] ^= v2[k]; \
+		v0[k] = sipHash::rotl(v0[k],32); \
+		v2[k] += v1[k]; v0[k] += v3[k]; \
+		v1[k] = sipHash::rotl(v1[k],17); \
+		v3[k] = sipHash::rotl(v3[k],21); \
+		v1[k] ^= v2[k]; v3[k] ^= v0[k]; \
+		v2[k] = sipHash::rotl(v2[k],32); \
+	}
+
+	sipRoundLanes();
+	sipRoundLanes();
+
+	for (uint32_t k = 0; k < sipLanes; k++) {
+		v0[k] ^= pNonce[k];
+		v2[k] ^= 0xff;
+	}
+
+	sipRoundLanes();
+	sipRoundLanes();
+	sipRoundLanes();
+	sipRoundLanes();
+
+#undef sipRoundLanes
+
+	for (uint32_t k = 0; k < sipLanes; k++)
+		pRes[k] = v0[k] ^ v1[k] ^ v2[k] ^ v3[k];
+}
+
+struct Work {
+	uint64_t w[numWords][numElems]; // word-major
+};
+
+static uint32_t getIndex(const uint8_t* pSol, uint32_t i) {
+	uint32_t pos = i * indexBits;
+	const uint8_t* p = pSol + (pos >> 3);
+
+	uint32_t val = p[0] | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+	return (val >> (pos & 7)) & ((1U << indexBits) - 1);
+}
+
+// Replaces the lowest word of the element by the mix of its bits and (some of) its indices
+static void applyMix(Work& x, uint32_t iElem, uint32_t remLen, const uint32_t* pIdx, uint32_t numIdx) {
+	uint64_t pT[numMixWords];
+	for (uint32_t j = 0; j < numWords; j++)
+		pT[j] = x.w[j][iElem];
+	for (uint32_t j = numWords; j < numMixWords; j++)
+		pT[j] = 0;
+
+	uint32_t padNum = ((512-remLen) + collisionBitSize) / (collisionBitSize + 1);
+	padNum = std::min(padNum, numIdx);
+
+	for (uint32_t i = 0; i < padNum; i++) {
+		uint32_t pos = remLen + i * (collisionBitSize + 1); // always within 512 bits
+		uint32_t iWord = pos >> 6;
+		uint32_t nShift = pos & 63;
+
+		pT[iWord] |= uint64_t(pIdx[i]) << nShift;
+		if (nShift && (iWord + 1 < numMixWords))
+			pT[iWord + 1] |= uint64_t(pIdx[i]) >> (64 - nShift);
+	}
+
+	uint64_t result = 0;
+	for (uint32_t i = 0; i < numMixWords; i++)
+		result += sipHash::rotl(pT[i], (29*(i+1)) & 0x3F);
+
+	x.w[0][iElem] = sipHash::rotl(result, 24);
+}
+
+} // namespace beamHashFast
+
+bool BeamHash_III::IsValidSolutionFast(const blake2b_state& base_state, const uint8_t* pSol, size_t nSol) {
+	using namespace beamHashFast;
+
+	if (nSol != 104)
+		return false;
+
+	uint32_t pIdx[numElems];
+	for (uint32_t i = 0; i < numElems; i++)
+		pIdx[i] = getIndex(pSol, i);
+
+	// Index order: the first leaf of each left subtree must be lower than that of its sibling
+	for (uint32_t nLeafs = 1; nLeafs < numElems; nLeafs <<= 1)
+		for (uint32_t i = 0; i < numElems; i += (nLeafs << 1))
+			if (pIdx[i] >= pIdx[i + nLeafs])
+				return false;
+
+	// Distinct indices. Each pair of leaves is compared at exactly one round (where their subtrees merge), hence the whole set must be distinct
+	for (uint32_t i = 1; i < numElems; i++)
+		for (uint32_t j = 0; j < i; j++)
+			if (pIdx[i] == pIdx[j])
+				return false;
+
+	uint64_t prePow[4];
+	blake2b_state state = base_state;
+	blake2b_update(&state, pSol + 100, 4);
+	blake2b_final(&state, (uint8_t*) &prePow[0], static_cast<uint8_t>(32));
+
+	Work pW[2];
+
+	// Seeding: word j of element i is siphash(idx*8 + j)
+	for (uint32_t j = 0; j < numWords; j++) {
+		for (uint32_t i = 0; i < numElems; i += sipLanes) {
+			uint64_t pNonce[sipLanes];
+			for (uint32_t k = 0; k < sipLanes; k++)
+				pNonce[k] = (pIdx[i + k] << 3) + j;
+
+			siphash24Lanes(prePow, pNonce, &pW[0].w[j][i]);
+		}
+	}
+
+	uint32_t n = numElems;
+	for (uint32_t round = 1; n > 1; round++, n >>= 1) {
+		Work& x = pW[(round - 1) & 1];
+		Work& y = pW[round & 1];
+
+		uint32_t remLen = workBitSize-(round-1)*collisionBitSize;
+		if (round == numRounds) remLen -= 64;
+
+		uint32_t nLeafs = 1 << (round - 1);
+		for (uint32_t i = 0; i < n; i++)
+			applyMix(x, i, remLen, pIdx + i * nLeafs, nLeafs);
+
+		uint64_t diff = 0;
+		for (uint32_t i = 0; i < n; i += 2)
+			diff |= x.w[0][i] ^ x.w[0][i + 1];
+
+		if (diff & ((1U << collisionBitSize) - 1))
+			return false;
+
+		remLen = workBitSize-round*collisionBitSize;
+		if (round == numRounds - 1) remLen -= 64;
+		if (round == numRounds) remLen = collisionBitSize;
+
+		// Merge: (a ^ b) >> collisionBitSize, truncated to remLen
+		for (uint32_t j = 0; j < numWords; j++) {
+			uint64_t msk = 0;
+			if (remLen > j * 64)
+				msk = (remLen >= (j + 1) * 64) ? ~0ULL : ((1ULL << (remLen - j * 64)) - 1);
+
+			for (uint32_t i = 0; i < n; i += 2) {
+				uint64_t val = (x.w[j][i] ^ x.w[j][i + 1]) >> collisionBitSize;
+				if (j + 1 < numWords)
+					val |= (x.w[j + 1][i] ^ x.w[j + 1][i + 1]) << (64 - collisionBitSize);
+
+				y.w[j][i >> 1] = val & msk;
+			}
+		}
+	}
+
+	const Work& x = pW[numRounds & 1];
+
+	uint64_t res = 0;
+	for (uint32_t j = 0; j < numWords; j++)
+		res |= x.w[j][0];
+
+	return !res;
+}
+
+
 SolverCancelledException beamSolverCancelled;
 
 bool BeamHash_III::OptimisedSolve(const blake2b_state& base_state,
@@ -246,6 +246,8 @@ int main_impl(int argc, char* argv[])
 					}
 
 					node.m_Cfg.m_VerificationThreads = vm[cli::VERIFICATION_THREADS].as<int>();
+					node.m_Cfg.m_IoThreads = vm[cli::IO_THREADS].as<uint32_t>();
+					node.m_Cfg.m_ReadThreads = vm[cli::READ_THREADS].as<uint32_t>();
 
 					node.m_Cfg.m_LogEvents = vm[cli::LOG_UTXOS].as<bool>();
 
@@ -1,6 +1,18 @@
 #include <assert.h>
 #include "aes.h"
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define BEAM_AES_X86
+#	include <immintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#		define BEAM_TARGET(x)
+#	else // _MSC_VER
+#		include <cpuid.h>
+#		define BEAM_TARGET(x) __attribute__((target(x)))
+#	endif // _MSC_VER
+#endif // x86
+
 /*
 *  FIPS-197 compliant AES implementation
 *
@@ -541,10 +553,144 @@ void AES::Decoder::Init(const Encoder& enc)
 }
 
 
+/* AES-NI backend. Round keys are taken from the portable key schedule (big-endian words) */
+
+#ifdef BEAM_AES_X86
+
+namespace
+{
+	bool DetectAesNi()
+	{
+		uint32_t p[4]; // eax, ebx, ecx, edx
+#ifdef _MSC_VER
+		__cpuid(reinterpret_cast<int*>(p), 1);
+#else // _MSC_VER
+		if (!__get_cpuid(1, p, p + 1, p + 2, p + 3))
+			return false;
+#endif // _MSC_VER
+
+		return
+			(0 != (p[2] & (1U << 25))) && // aes
+			(0 != (p[2] & (1U << 9))); // ssse3
+	}
+
+	const bool g_bAesNiSupported = DetectAesNi();
+	bool g_bAesNi = g_bAesNiSupported;
+
+	struct AesNiKeys
+	{
+		__m128i m_pK[AES::Nr + 1];
+
+		BEAM_TARGET("aes,ssse3")
+		void Load(const uint32_t* pErk)
+		{
+			const __m128i msk = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+			for (uint32_t i = 0; i < _countof(m_pK); i++)
+				m_pK[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (pErk + (i << 2))), msk);
+		}
+
+		BEAM_TARGET("aes,ssse3")
+		__m128i Encode(__m128i x) const
+		{
+			x = _mm_xor_si128(x, m_pK[0]);
+			for (uint32_t i = 1; i < AES::Nr; i++)
+				x = _mm_aesenc_si128(x, m_pK[i]);
+			return _mm_aesenclast_si128(x, m_pK[AES::Nr]);
+		}
+	};
+
+	BEAM_TARGET("aes,ssse3")
+	void Encode_AesNi(const uint32_t* pErk, uint8_t* pDst, const uint8_t* pSrc)
+	{
+		AesNiKeys k;
+		k.Load(pErk);
+		_mm_storeu_si128((__m128i*) pDst, k.Encode(_mm_loadu_si128((const __m128i*) pSrc)));
+	}
+
+	BEAM_TARGET("aes,ssse3")
+	void XCrypt_AesNi(const uint32_t* pErk, beam::uintBig_t<AES::s_BlockSize>& ctr, uint8_t* pBuf, uint32_t nBlocks)
+	{
+		AesNiKeys k;
+		k.Load(pErk);
+
+		// 8 independent blocks in flight, to hide the aesenc latency
+		const uint32_t nPipe = 8;
+
+		for (; nBlocks >= nPipe; nBlocks -= nPipe, pBuf += nPipe * AES::s_BlockSize)
+		{
+			__m128i pX[nPipe];
+			for (uint32_t i = 0; i < nPipe; i++)
+			{
+				pX[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i*) ctr.m_pData), k.m_pK[0]);
+				ctr.Inc();
+			}
+
+			for (uint32_t iRound = 1; iRound < AES::Nr; iRound++)
+				for (uint32_t i = 0; i < nPipe; i++)
+					pX[i] = _mm_aesenc_si128(pX[i], k.m_pK[iRound]);
+
+			for (uint32_t i = 0; i < nPipe; i++)
+			{
+				__m128i* pDst = (__m128i*) (pBuf + i * AES::s_BlockSize);
+				__m128i x = _mm_aesenclast_si128(pX[i], k.m_pK[AES::Nr]);
+				_mm_storeu_si128(pDst, _mm_xor_si128(x, _mm_loadu_si128(pDst)));
+			}
+		}
+
+		for (; nBlocks--; pBuf += AES::s_BlockSize)
+		{
+			__m128i x = k.Encode(_mm_loadu_si128((const __m128i*) ctr.m_pData));
+			ctr.Inc();
+			_mm_storeu_si128((__m128i*) pBuf, _mm_xor_si128(x, _mm_loadu_si128((const __m128i*) pBuf)));
+		}
+	}
+}
+
+bool AES::Accel::IsSupported()
+{
+	return g_bAesNiSupported;
+}
+
+bool AES::Accel::get_Enabled()
+{
+	return g_bAesNi;
+}
+
+void AES::Accel::set_Enabled(bool b)
+{
+	g_bAesNi = b && g_bAesNiSupported;
+}
+
+#else // BEAM_AES_X86
+
+bool AES::Accel::IsSupported()
+{
+	return false;
+}
+
+bool AES::Accel::get_Enabled()
+{
+	return false;
+}
+
+void AES::Accel::set_Enabled(bool)
+{
+}
+
+#endif // BEAM_AES_X86
+
 /* AES 128-bit block encryption routine */
 
 void AES::Encoder::Proceed(uint8_t* pDst, const uint8_t* pSrc) const
 {
+#ifdef BEAM_AES_X86
+	if (g_bAesNi)
+	{
+		Encode_AesNi(m_erk, pDst, pSrc);
+		return;
+	}
+#endif // BEAM_AES_X86
+
 	uint32_t X0, X1, X2, X3, Y0, Y1, Y2, Y3;
 
 	const uint32_t* RK = m_erk;
@@ -824,6 +970,33 @@ void AES::StreamCipher::PerfXor(uint8_t* pBuf, uint32_t nSize)
 
 void AES::StreamCipher::XCrypt(const Encoder& enc, uint8_t* pBuf, uint32_t nSize)
 {
+#ifdef BEAM_AES_X86
+	if (g_bAesNi)
+	{
+		// use the leftover of the previous cipherstream, then process the whole blocks in a pipeline
+		if (m_nBuf)
+		{
+			uint8_t n = static_cast<uint8_t>(std::min<uint32_t>(m_nBuf, nSize));
+			PerfXor(pBuf, n);
+			pBuf += n;
+			nSize -= n;
+		}
+
+		uint32_t nBlocks = nSize / s_BlockSize;
+		if (nBlocks)
+		{
+			XCrypt_AesNi(enc.m_erk, m_Counter, pBuf, nBlocks);
+
+			nBlocks *= s_BlockSize;
+			pBuf += nBlocks;
+			nSize -= nBlocks;
+		}
+
+		if (!nSize)
+			return;
+	}
+#endif // BEAM_AES_X86
+
 	while (true)
 	{
 		if (!m_nBuf)
@@ -8,6 +8,14 @@ struct AES
 	static const int Nr = 14; // num-rounds
 	static const int s_BlockSize = 16;
 
+	struct Accel
+	{
+		// AES-NI, detected at startup. Encoder and StreamCipher use it transparently when enabled
+		static bool IsSupported();
+		static bool get_Enabled();
+		static void set_Enabled(bool); // ignored if not supported. Not thread-safe, should be used at startup (or in tests)
+	};
+
 	struct Encoder
 	{
 		uint32_t m_erk[64]; // encryption round keys. Actually needed 60, but during init extra space is used
@@ -0,0 +1,136 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "arena.h"
+#include <atomic>
+#include <new>
+#include <algorithm>
+
+namespace beam
+{
+	thread_local Arena* Arena::s_pCurrent = nullptr;
+
+	namespace
+	{
+		const size_t s_Align = alignof(std::max_align_t);
+
+		size_t AlignUp(size_t n)
+		{
+			return (n + s_Align - 1) & ~(s_Align - 1);
+		}
+	}
+
+	// every object is prefixed by the pointer to its chunk, or null if it's on the heap
+	static const size_t s_HdrSize = AlignUp(sizeof(void*));
+	static const size_t s_ChunkHdrSize = AlignUp(sizeof(std::atomic<int64_t>));
+
+	static void* AllocateOnHeap(size_t n)
+	{
+		uint8_t* p = static_cast<uint8_t*>(::operator new(s_HdrSize + n));
+		*reinterpret_cast<void**>(p) = nullptr;
+		return p + s_HdrSize;
+	}
+
+	struct Arena::Chunk
+	{
+		// The allocations are accounted in bulk, when the arena leaves the chunk. Till then it's either zero or negative (objects destroyed so far)
+		std::atomic<int64_t> m_Refs;
+
+		static void Release(Chunk* p)
+		{
+			p->~Chunk();
+			::operator delete(p);
+		}
+	};
+
+	Arena::Arena(size_t nSizeHint /* = 0 */)
+	{
+		m_ChunkSize = std::min(std::max(AlignUp(nSizeHint) + s_ChunkHdrSize, s_ChunkMin), s_ChunkMax);
+	}
+
+	Arena::~Arena()
+	{
+		Detach();
+	}
+
+	void Arena::Detach()
+	{
+		if (!m_pChunk)
+			return;
+
+		if (!(m_pChunk->m_Refs.fetch_add(m_Allocs) + m_Allocs))
+			Chunk::Release(m_pChunk); // all the objects are already destroyed
+
+		m_pChunk = nullptr;
+		m_Allocs = 0;
+		m_Used = 0;
+		m_Size = 0;
+	}
+
+	void* Arena::Allocate(size_t n)
+	{
+		size_t nTotal = s_HdrSize + AlignUp(n);
+
+		if (m_Used + nTotal > m_Size)
+		{
+			if (nTotal + s_ChunkHdrSize > s_ChunkMax)
+				return AllocateOnHeap(n); // too big
+
+			Detach();
+
+			m_ChunkSize = std::max(m_ChunkSize, nTotal + s_ChunkHdrSize);
+
+			m_pChunk = new (::operator new(m_ChunkSize)) Chunk;
+			m_pChunk->m_Refs = 0;
+			m_Used = s_ChunkHdrSize;
+			m_Size = m_ChunkSize;
+			m_Chunks++;
+
+			m_ChunkSize = std::min(m_ChunkSize * 2, s_ChunkMax);
+		}
+
+		uint8_t* p = reinterpret_cast<uint8_t*>(m_pChunk) + m_Used;
+		m_Used += nTotal;
+		m_Allocs++;
+		m_Allocations++;
+
+		*reinterpret_cast<Chunk**>(p) = m_pChunk;
+		return p + s_HdrSize;
+	}
+
+	void* Arena::New(size_t n)
+	{
+		return s_pCurrent ?
+			s_pCurrent->Allocate(n) :
+			AllocateOnHeap(n);
+	}
+
+	void Arena::Delete(void* pObj)
+	{
+		if (!pObj)
+			return;
+
+		uint8_t* p = static_cast<uint8_t*>(pObj) - s_HdrSize;
+		Chunk* pChunk = *reinterpret_cast<Chunk**>(p);
+
+		if (!pChunk)
+			::operator delete(p);
+		else
+		{
+			if (1 == pChunk->m_Refs.fetch_sub(1))
+				Chunk::Release(pChunk);
+		}
+	}
+
+} // namespace beam
@@ -0,0 +1,84 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace beam
+{
+	// Bump allocator for the objects decoded at once (tx/block elements).
+	// Objects of the classes that declare BEAM_ARENA_ALLOCATED are allocated from the arena of the current thread (if any, see Arena::Scope),
+	// otherwise from the heap. Each chunk is released once all its objects are destroyed, i.e. the objects may safely outlive both the scope
+	// and the arena itself, and may be destroyed by any thread.
+	class Arena
+	{
+		struct Chunk;
+
+		Chunk* m_pChunk = nullptr;
+		size_t m_Used = 0;
+		size_t m_Size = 0; // of the current chunk
+		int64_t m_Allocs = 0; // in the current chunk
+		size_t m_ChunkSize;
+
+		void Detach();
+
+	public:
+
+		static constexpr size_t s_ChunkMin = 1024;
+		static constexpr size_t s_ChunkMax = 1024 * 64;
+
+		Arena(size_t nSizeHint = 0); // expected total size, to avoid wasting memory for small objects (such as a single tx)
+		~Arena();
+
+		uint32_t m_Chunks = 0;
+		uint32_t m_Allocations = 0;
+
+		void* Allocate(size_t);
+
+		static thread_local Arena* s_pCurrent;
+
+		struct Scope
+		{
+			Arena* m_pPrev;
+
+			Scope(Arena& x) {
+				m_pPrev = s_pCurrent;
+				s_pCurrent = &x;
+			}
+
+			~Scope() {
+				s_pCurrent = m_pPrev;
+			}
+		};
+
+		struct Local; // arena with its scope
+
+		// used by the class-specific operators new/delete
+		static void* New(size_t);
+		static void Delete(void*);
+	};
+
+	struct Arena::Local
+		:public Arena
+	{
+		Scope m_Scope;
+		Local(size_t nSizeHint = 0) :Arena(nSizeHint) ,m_Scope(*this) {}
+	};
+
+} // namespace beam
+
+#define BEAM_ARENA_ALLOCATED \
+	static void* operator new(size_t n) { return beam::Arena::New(n); } \
+	static void operator delete(void* p) { beam::Arena::Delete(p); }
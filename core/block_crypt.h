@@ -159,6 +159,7 @@ namespace beam
 			:public Sigma::Proof
 		{
 			typedef std::unique_ptr<Proof> Ptr;
+			BEAM_ARENA_ALLOCATED
 
 			Asset::ID m_Begin; // 1st element
 			ECC::Point m_hGen;
@@ -431,6 +432,8 @@ namespace beam
 		} m_Internal;
 
 		typedef std::unique_ptr<Input> Ptr;
+		BEAM_ARENA_ALLOCATED
+
 		typedef uint32_t Count; // the type for count of duplicate UTXOs in the system
 
 		struct State
@@ -484,6 +487,7 @@ namespace beam
 		:public TxElement
 	{
 		typedef std::unique_ptr<Output> Ptr;
+		BEAM_ARENA_ALLOCATED
 
 		bool		m_Coinbase;
 		bool		m_RecoveryOnly;
@@ -663,6 +667,7 @@ namespace beam
 	struct TxKernel
 	{
 		typedef std::unique_ptr<TxKernel> Ptr;
+		BEAM_ARENA_ALLOCATED // same for all the derived kernel types
 
 		struct Subtype
 		{
@@ -1304,6 +1309,16 @@ namespace beam
 			uint32_t m_nVerifiers;
 			volatile bool* m_pAbort;
 
+			// optional, skips re-verification of the output proofs that were already verified. Must be thread-safe.
+			struct IProofCache
+			{
+				virtual bool IsVerified(const ECC::Hash::Value&) = 0;
+				// the proof passed, though its batched part may be evaluated later. The caller should keep it pending until then
+				virtual void OnVerified(const ECC::Hash::Value&) = 0;
+			};
+
+			IProofCache* m_pProofCache;
+
 			Params(); // defaults
 		};
 
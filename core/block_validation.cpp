@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "block_crypt.h"
+#include "serialization_adapters.h"
 
 namespace beam
 {
@@ -140,8 +141,35 @@ namespace beam
 
 				if (bSigned)
 				{
-					if (!r.m_pUtxoOut->IsValid(m_Height.m_Min, pt))
-						return false;
+					if (m_Params.m_pProofCache && !r.m_pUtxoOut->m_RecoveryOnly)
+					{
+						// the validity depends on the fork (proof scheme), but not on the exact height
+						ECC::Hash::Processor hp;
+						hp
+							<< "outp"
+							<< static_cast<uint32_t>(iFork);
+
+						ECC::Hash::Value hv;
+						hp.Serialize(*r.m_pUtxoOut) >> hv;
+
+						if (m_Params.m_pProofCache->IsVerified(hv))
+						{
+							if (!pt.Import(r.m_pUtxoOut->m_Commitment))
+								return false;
+						}
+						else
+						{
+							if (!r.m_pUtxoOut->IsValid(m_Height.m_Min, pt))
+								return false;
+
+							m_Params.m_pProofCache->OnVerified(hv);
+						}
+					}
+					else
+					{
+						if (!r.m_pUtxoOut->IsValid(m_Height.m_Min, pt))
+							return false;
+					}
 				}
 				else
 				{
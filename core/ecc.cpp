@@ -14,6 +14,7 @@
 
 #include "common.h"
 #include "ecc_native.h"
+#include "sha256_accel.h"
 
 #if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
 #	pragma GCC diagnostic push
@@ -367,20 +368,165 @@ namespace ECC {
 		m_bInitialized = true;
 	}
 
+	namespace
+	{
+		void Sha256_Transform_Generic(uint32_t* pS, const uint8_t* pData, size_t nBlocks)
+		{
+			for (; nBlocks--; pData += Sha256::s_BlockSize)
+			{
+				uint32_t pChunk[Sha256::s_BlockSize / sizeof(uint32_t)]; // aligned
+				memcpy(pChunk, pData, sizeof(pChunk));
+				secp256k1_sha256_transform(pS, pChunk);
+			}
+		}
+
+		void Sha256_Export(uint8_t* pDst, const uint32_t* pS, uint32_t nStride)
+		{
+			for (uint32_t i = 0; i < 8; i++, pDst += sizeof(uint32_t))
+			{
+				uint32_t x = pS[i * nStride];
+				pDst[0] = static_cast<uint8_t>(x >> 24);
+				pDst[1] = static_cast<uint8_t>(x >> 16);
+				pDst[2] = static_cast<uint8_t>(x >> 8);
+				pDst[3] = static_cast<uint8_t>(x);
+			}
+		}
+
+		// constant-initialized, so that it's valid before (and regardless of) the dynamic initialization
+		Sha256::PfnTransform g_pfnSha256Transform = Sha256_Transform_Generic;
+		uint32_t g_nSha256Accel = 0;
+
+		struct Sha256AccelInit {
+			Sha256AccelInit() { Hash::Accel::set_Enabled(static_cast<uint32_t>(-1)); }
+		} g_Sha256AccelInit;
+	}
+
+	uint32_t Hash::Accel::get_Supported()
+	{
+		uint32_t ret = 0;
+		if (Sha256::IsSupported_ShaNi())
+			ret |= ShaNi;
+		if (Sha256::IsSupported_Avx2())
+			ret |= Avx2;
+		return ret;
+	}
+
+	uint32_t Hash::Accel::get_Enabled()
+	{
+		return g_nSha256Accel;
+	}
+
+	void Hash::Accel::set_Enabled(uint32_t n)
+	{
+		g_nSha256Accel = n & get_Supported();
+
+		g_pfnSha256Transform = (ShaNi & g_nSha256Accel) ?
+			Sha256::Transform_ShaNi :
+			Sha256_Transform_Generic;
+	}
+
 	void Hash::Processor::Write(const void* p, uint32_t n)
 	{
 		assert(m_bInitialized);
-		secp256k1_sha256_write(this, (const uint8_t*) p, n);
+
+		const uint8_t* pSrc = reinterpret_cast<const uint8_t*>(p);
+		uint8_t* pBuf = reinterpret_cast<uint8_t*>(buf);
+
+		uint32_t nBuf = static_cast<uint32_t>(bytes) & (Sha256::s_BlockSize - 1);
+		bytes += n;
+
+		if (nBuf)
+		{
+			uint32_t nFill = Sha256::s_BlockSize - nBuf;
+			if (n < nFill)
+			{
+				memcpy(pBuf + nBuf, pSrc, n);
+				return;
+			}
+
+			memcpy(pBuf + nBuf, pSrc, nFill);
+			g_pfnSha256Transform(s, pBuf, 1);
+
+			pSrc += nFill;
+			n -= nFill;
+		}
+
+		uint32_t nBlocks = n / Sha256::s_BlockSize;
+		if (nBlocks)
+		{
+			g_pfnSha256Transform(s, pSrc, nBlocks);
+
+			nBlocks *= Sha256::s_BlockSize;
+			pSrc += nBlocks;
+			n -= nBlocks;
+		}
+
+		if (n)
+			memcpy(pBuf, pSrc, n);
 	}
 
 	void Hash::Processor::Finalize(Value& v)
 	{
 		assert(m_bInitialized);
-		secp256k1_sha256_finalize(this, v.m_pData);
-		
+
+		uint8_t pTail[Sha256::s_BlockSize * 2];
+		uint32_t nBlocks = Sha256::PadTail(pTail, reinterpret_cast<const uint8_t*>(buf), static_cast<uint32_t>(bytes) & (Sha256::s_BlockSize - 1), bytes);
+
+		g_pfnSha256Transform(s, pTail, nBlocks);
+		Sha256_Export(v.m_pData, s, 1);
+
+		SecureErase(pTail, sizeof(pTail));
 		m_bInitialized = false;
 	}
 
+	void Hash::Multi::Calculate(Value* pOut, const void* pIn, uint32_t nSize, uint32_t nCount)
+	{
+		const uint8_t* pSrc = reinterpret_cast<const uint8_t*>(pIn);
+
+		// SHA-NI on a single lane outperforms the 8-lane AVX2, hence multi-buffer only when it's absent
+		if ((Accel::Avx2 & g_nSha256Accel) && !(Accel::ShaNi & g_nSha256Accel))
+		{
+			uint32_t nBlocks = nSize / Sha256::s_BlockSize;
+			uint32_t nTail = nSize - nBlocks * Sha256::s_BlockSize;
+
+			for (; nCount >= Sha256::s_Lanes; nCount -= Sha256::s_Lanes)
+			{
+				uint32_t pS[8 * Sha256::s_Lanes];
+				const uint8_t* pp[Sha256::s_Lanes];
+				uint8_t ppTail[Sha256::s_Lanes][Sha256::s_BlockSize * 2];
+				uint32_t nTailBlocks = 0;
+
+				for (uint32_t iLane = 0; iLane < Sha256::s_Lanes; iLane++)
+				{
+					for (uint32_t i = 0; i < 8; i++)
+						pS[i * Sha256::s_Lanes + iLane] = Sha256::s_pIV[i];
+
+					pp[iLane] = pSrc + nSize * iLane;
+					nTailBlocks = Sha256::PadTail(ppTail[iLane], pp[iLane] + nSize - nTail, nTail, nSize);
+				}
+
+				Sha256::Transform_Avx2_x8(pS, pp, nBlocks);
+
+				for (uint32_t iLane = 0; iLane < Sha256::s_Lanes; iLane++)
+					pp[iLane] = ppTail[iLane];
+
+				Sha256::Transform_Avx2_x8(pS, pp, nTailBlocks);
+
+				for (uint32_t iLane = 0; iLane < Sha256::s_Lanes; iLane++)
+					Sha256_Export(pOut[iLane].m_pData, pS + iLane, Sha256::s_Lanes);
+
+				pSrc += nSize * Sha256::s_Lanes;
+				pOut += Sha256::s_Lanes;
+			}
+		}
+
+		// the rest
+		for (uint32_t i = 0; i < nCount; i++, pSrc += nSize)
+			Processor()
+				<< beam::Blob(pSrc, nSize)
+				>> pOut[i];
+	}
+
 	void Hash::Processor::Write(const beam::Blob& v)
 	{
 		Write(v.p, v.n);
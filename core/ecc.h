@@ -15,6 +15,7 @@
 #pragma once
 #include "common.h"
 #include "uintBig.h"
+#include "arena.h"
 
 namespace ECC
 {
@@ -152,6 +153,8 @@ namespace ECC
 
 		class Processor;
 		class Mac;
+		struct Multi;
+		struct Accel;
 	};
 
 	typedef beam::Amount Amount;
@@ -379,6 +382,8 @@ namespace ECC
 
 		struct Confidential
 		{
+			BEAM_ARENA_ALLOCATED
+
 			// Bulletproof scheme
 			struct Part1 {
 				Point m_A;
@@ -453,6 +458,8 @@ namespace ECC
 
 		struct Public
 		{
+			BEAM_ARENA_ALLOCATED
+
 			Signature m_Signature;
 			Amount m_Value;
 
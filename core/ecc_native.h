@@ -604,6 +604,29 @@ namespace ECC
 		void operator >> (Value& hv) { Finalize(hv); }
 	};
 
+	struct Hash::Multi
+	{
+		// Hashes of multiple independent messages of the same size, computed in parallel lanes when the CPU allows
+		static void Calculate(Value* pOut, const void* pIn, uint32_t nSize, uint32_t nCount);
+
+		// Each message is a pair of consecutive hashes (Merkle joint). pIn holds 2*nCount values
+		static void Pairs(Value* pOut, const Value* pIn, uint32_t nCount)
+		{
+			Calculate(pOut, pIn, sizeof(Value) * 2, nCount);
+		}
+	};
+
+	struct Hash::Accel
+	{
+		// SHA-256 hardware acceleration, selected at startup according to the CPU capabilities
+		static const uint32_t ShaNi = 1;
+		static const uint32_t Avx2 = 2; // multi-buffer, 8 lanes
+
+		static uint32_t get_Supported();
+		static uint32_t get_Enabled();
+		static void set_Enabled(uint32_t); // masked by the supported. Not thread-safe, should be used at startup (or in tests)
+	};
+
 	class Hash::Mac
 		:private secp256k1_hmac_sha256_t
 	{
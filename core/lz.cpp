@@ -0,0 +1,224 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lz.h"
+#include <cstring>
+
+namespace beam
+{
+	// Sequence: token (literals count : 4 bits, match length - s_MinMatch : 4 bits), extra literals count, literals,
+	// match offset (2 bytes, LE), extra match length. The counts that don't fit the token are continued by bytes,
+	// each 0xff means more bytes follow.
+	// The last sequence has literals only.
+
+	namespace
+	{
+		const uint32_t s_TokenMax = 0xf;
+
+		uint32_t Read32(const uint8_t* p)
+		{
+			uint32_t x;
+			memcpy(&x, p, sizeof(x));
+			return x;
+		}
+
+		uint8_t* WriteCount(uint8_t* p, size_t n)
+		{
+			for (; n >= 0xff; n -= 0xff)
+				*p++ = 0xff;
+			*p++ = static_cast<uint8_t>(n);
+			return p;
+		}
+
+		bool ReadCount(size_t& n, const uint8_t*& p, const uint8_t* pEnd, size_t nMax)
+		{
+			while (true)
+			{
+				if (p == pEnd)
+					return false;
+
+				uint8_t x = *p++;
+				n += x;
+
+				if (n > nMax)
+					return false;
+				if (0xff != x)
+					return true;
+			}
+		}
+	}
+
+	size_t Lz::Encoder::Encode(uint8_t* pDst, size_t nMaxDst, const uint8_t* pSrc, size_t nDict, size_t nSrc)
+	{
+		const uint32_t nTbl = 1U << s_HashBits;
+		m_vTbl.assign(nTbl, 0);
+		uint32_t* pTbl = &m_vTbl.front();
+
+		auto fnHash = [](uint32_t x) {
+			return (x * 2654435761U) >> (32 - s_HashBits);
+		};
+
+		const size_t nEnd = nDict + nSrc;
+
+		size_t i = 0;
+		for (; i + s_MinMatch <= nDict; i++)
+			pTbl[fnHash(Read32(pSrc + i))] = static_cast<uint32_t>(i);
+
+		uint8_t* p = pDst;
+		uint8_t* const pDstEnd = pDst + nMaxDst;
+
+		auto fnSequence = [&](size_t iLit, size_t nLit, size_t nOffset, size_t nMatch) -> bool
+		{
+			// worst case: token, literals with their count, offset, match count
+			if (static_cast<size_t>(pDstEnd - p) < nLit + nLit / 0xff + nMatch / 0xff + 5)
+				return false;
+
+			uint8_t* pToken = p++;
+			uint8_t nToken = 0;
+
+			if (nLit >= s_TokenMax)
+			{
+				nToken = s_TokenMax << 4;
+				p = WriteCount(p, nLit - s_TokenMax);
+			}
+			else
+				nToken = static_cast<uint8_t>(nLit << 4);
+
+			memcpy(p, pSrc + iLit, nLit);
+			p += nLit;
+
+			if (nMatch)
+			{
+				*p++ = static_cast<uint8_t>(nOffset);
+				*p++ = static_cast<uint8_t>(nOffset >> 8);
+
+				nMatch -= s_MinMatch;
+				if (nMatch >= s_TokenMax)
+				{
+					nToken |= s_TokenMax;
+					p = WriteCount(p, nMatch - s_TokenMax);
+				}
+				else
+					nToken |= static_cast<uint8_t>(nMatch);
+			}
+
+			*pToken = nToken;
+			return true;
+		};
+
+		size_t iAnchor = i = nDict;
+		uint32_t nMisses = 0;
+
+		while (i + s_MinMatch <= nEnd)
+		{
+			uint32_t x = Read32(pSrc + i);
+			uint32_t& iCandidate = pTbl[fnHash(x)];
+			size_t j = iCandidate;
+			iCandidate = static_cast<uint32_t>(i);
+
+			if ((j >= i) || (i - j > s_MaxOffset) || (Read32(pSrc + j) != x))
+			{
+				// the more we miss, the faster we skip
+				i += 1 + (nMisses++ >> 6);
+				continue;
+			}
+
+			// extend backwards, within the pending literals
+			while ((i > iAnchor) && j && (pSrc[i - 1] == pSrc[j - 1]))
+			{
+				i--;
+				j--;
+			}
+
+			size_t nMatch = s_MinMatch;
+			while ((i + nMatch < nEnd) && (pSrc[i + nMatch] == pSrc[j + nMatch]))
+				nMatch++;
+
+			if (!fnSequence(iAnchor, i - iAnchor, i - j, nMatch))
+				return 0;
+
+			i += nMatch;
+			iAnchor = i;
+			nMisses = 0;
+
+			if (i - 2 + s_MinMatch <= nEnd)
+				pTbl[fnHash(Read32(pSrc + i - 2))] = static_cast<uint32_t>(i - 2);
+		}
+
+		if (!fnSequence(iAnchor, nEnd - iAnchor, 0, 0))
+			return 0;
+
+		return p - pDst;
+	}
+
+	bool Lz::Decode(uint8_t* pDst, size_t nDict, size_t nDst, const uint8_t* pSrc, size_t nSrc)
+	{
+		uint8_t* p = pDst + nDict;
+		uint8_t* const pDstEnd = p + nDst;
+		const uint8_t* const pSrcEnd = pSrc + nSrc;
+
+		while (true)
+		{
+			if (pSrc == pSrcEnd)
+				return false;
+
+			uint8_t nToken = *pSrc++;
+
+			size_t nLit = nToken >> 4;
+			if ((s_TokenMax == nLit) && !ReadCount(nLit, pSrc, pSrcEnd, nDst))
+				return false;
+
+			if ((nLit > static_cast<size_t>(pSrcEnd - pSrc)) || (nLit > static_cast<size_t>(pDstEnd - p)))
+				return false;
+
+			memcpy(p, pSrc, nLit);
+			p += nLit;
+			pSrc += nLit;
+
+			if (pSrc == pSrcEnd)
+				return (p == pDstEnd) && !(nToken & s_TokenMax); // the last sequence
+
+			if (pSrcEnd - pSrc < 2)
+				return false;
+
+			size_t nOffset = pSrc[0] | (static_cast<size_t>(pSrc[1]) << 8);
+			pSrc += 2;
+
+			if (!nOffset || (nOffset > static_cast<size_t>(p - pDst)))
+				return false;
+
+			size_t nMatch = nToken & s_TokenMax;
+			if ((s_TokenMax == nMatch) && !ReadCount(nMatch, pSrc, pSrcEnd, nDst))
+				return false;
+			nMatch += s_MinMatch;
+
+			if (nMatch > static_cast<size_t>(pDstEnd - p))
+				return false;
+
+			const uint8_t* pMatch = p - nOffset;
+			if (nOffset >= nMatch)
+			{
+				memcpy(p, pMatch, nMatch);
+				p += nMatch;
+			}
+			else
+			{
+				// overlapping, i.e. repeating pattern
+				for (size_t k = 0; k < nMatch; k++)
+					*p++ = *pMatch++;
+			}
+		}
+	}
+
+} // namespace beam
@@ -0,0 +1,49 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace beam
+{
+	// Byte-oriented LZ77 codec (lz4-like sequences of literals and matches), tuned for speed rather than ratio.
+	// Incompressible data (such as proofs) is skipped quickly: the match search steps up as long as no matches are found.
+	// Optionally a preset dictionary is used: a prefix that may be referenced by the matches, but isn't encoded.
+	struct Lz
+	{
+		static const uint32_t s_MinMatch = 4;
+		static const uint32_t s_MaxOffset = 0xffff;
+
+		static size_t get_MaxEncoded(size_t n) { return n + n / 255 + 16; }
+		static size_t get_MaxDecoded(size_t n) { return n * 255 + 16; } // a match count byte adds at most 255 bytes
+
+		class Encoder
+		{
+			static const uint32_t s_HashBits = 14;
+			std::vector<uint32_t> m_vTbl;
+
+		public:
+			// pSrc contains the dictionary (nDict bytes), followed by the data to encode (nSrc bytes).
+			// Returns the encoded size, or 0 if it would exceed nMaxDst.
+			size_t Encode(uint8_t* pDst, size_t nMaxDst, const uint8_t* pSrc, size_t nDict, size_t nSrc);
+		};
+
+		// pDst contains the dictionary (nDict bytes), the data is decoded after it.
+		// Succeeds only if exactly nDst bytes are decoded, and the whole input is consumed.
+		static bool Decode(uint8_t* pDst, size_t nDict, size_t nDst, const uint8_t* pSrc, size_t nSrc);
+	};
+
+} // namespace beam
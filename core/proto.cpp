@@ -16,7 +16,10 @@
 #include "core/serialization_adapters.h"
 #include "core/ecc_native.h"
 #include "proto.h"
+#include "lz.h"
 #include "../utility/logger.h"
+#include <thread>
+#include <atomic>
 
 namespace beam {
 namespace proto {
@@ -27,6 +30,7 @@ ProtocolPlus::ProtocolPlus(uint8_t v0, uint8_t v1, uint8_t v2, size_t maxMessage
     :Protocol(v0, v1, v2, maxMessageTypes, errorHandler, serializedFragmentsSize)
 {
     ResetVars();
+    add_custom_message_handler(s_CodeCompressed, this, 5, 1024*1024*10, OnCompressed);
 }
 
 void ProtocolPlus::ResetVars()
@@ -34,6 +38,7 @@ void ProtocolPlus::ResetVars()
     m_Mode = Mode::Plaintext;
     m_MyNonce = Zero;
     m_RemoteNonce = Zero;
+    m_Compress = false;
 }
 
 void ProtocolPlus::Decrypt(uint8_t* p, uint32_t nSize)
@@ -75,6 +80,12 @@ void ProtocolPlus::get_HMac(ECC::Hash::Mac& hm, MacValue& res)
 }
 
 void ProtocolPlus::Encrypt(SerializedMsg& sm, MsgSerializer& ser)
+{
+    Seal(sm, ser);
+    XCryptOut(sm);
+}
+
+void ProtocolPlus::Seal(SerializedMsg& sm, MsgSerializer& ser)
 {
     MacValue hmac;
 
@@ -115,7 +126,7 @@ void ProtocolPlus::Encrypt(SerializedMsg& sm, MsgSerializer& ser)
 
         get_HMac(hm, hmac);
 
-        // 4. Overwrite the hmac, encrypt
+        // 4. Overwrite the hmac
         n2 = n;
 
         for (size_t i = 0; i < sm.size(); i++)
@@ -133,12 +144,142 @@ void ProtocolPlus::Encrypt(SerializedMsg& sm, MsgSerializer& ser)
             }
 
             n2 -= iov.size;
+        }
+    }
+}
 
-            m_CipherOut.XCrypt(m_Enc, dst, (uint32_t) iov.size);
+void ProtocolPlus::XCryptOut(SerializedMsg& sm)
+{
+    if (Mode::Plaintext != m_Mode)
+    {
+        for (size_t i = 0; i < sm.size(); i++)
+        {
+            io::IOVec& iov = sm[i];
+            m_CipherOut.XCrypt(m_Enc, (uint8_t*) iov.data, (uint32_t) iov.size);
         }
     }
 }
 
+const std::vector<uint8_t>& ProtocolPlus::get_CompressDictionary()
+{
+    // Empty for now. A dictionary trained on serialized body packs, header packs and events gained less than 2% even for 1K messages,
+    // since they're dominated by the curve points and proofs. Note: changing it breaks the compatibility, requires a new Extension version.
+    static const std::vector<uint8_t> s_vDict;
+    return s_vDict;
+}
+
+void ProtocolPlus::Compress(SerializedMsg& sm, MsgSerializer& ser, uint8_t nCode)
+{
+    ser.finalize(sm);
+
+    size_t nSize = 0;
+    for (size_t i = 0; i < sm.size(); i++)
+        nSize += sm[i].size;
+
+    assert(nSize >= MsgHeader::SIZE);
+    nSize -= MsgHeader::SIZE;
+
+    // the encoder needs the dictionary followed by the message body, contiguous
+    const std::vector<uint8_t>& vDict = get_CompressDictionary();
+
+    std::vector<uint8_t> vSrc(vDict.size() + nSize);
+    if (!vDict.empty())
+        memcpy(&vSrc.front(), &vDict.front(), vDict.size());
+
+    size_t nPos = vDict.size();
+    size_t nSkip = MsgHeader::SIZE;
+
+    for (size_t i = 0; i < sm.size(); i++)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(sm[i].data);
+        size_t n = sm[i].size;
+
+        size_t n2 = std::min(n, nSkip);
+        p += n2;
+        n -= n2;
+        nSkip -= n2;
+
+        if (n)
+        {
+            memcpy(&vSrc.front() + nPos, p, n);
+            nPos += n;
+        }
+    }
+
+    sm.clear();
+
+    const uint32_t nHdr = 5;
+    std::vector<uint8_t> vDst;
+    size_t nDst = 0;
+
+    if (nSize >= s_CompressMin)
+    {
+        // should save at least 1/16, otherwise not worth it
+        vDst.resize(nSize - nSize / 16);
+
+        Lz::Encoder enc;
+        nDst = enc.Encode(&vDst.front() + nHdr, vDst.size() - nHdr, &vSrc.front(), vDict.size(), nSize);
+    }
+
+    if (nDst)
+    {
+        vDst[0] = nCode;
+        for (uint32_t i = 0; i < 4; i++)
+            vDst[i + 1] = static_cast<uint8_t>(nSize >> (i << 3));
+
+        ser.new_message(s_CodeCompressed);
+        ser.write(&vDst.front(), nDst + nHdr);
+    }
+    else
+    {
+        ser.new_message(nCode);
+        if (nSize)
+            ser.write(&vSrc.front() + vDict.size(), nSize);
+    }
+}
+
+bool ProtocolPlus::OnCompressed(void* pThis, IErrorHandler& errorHandler, Deserializer& des, uint64_t fromStream, const void* p, size_t n)
+{
+    return reinterpret_cast<ProtocolPlus*>(pThis)->OnCompressed(errorHandler, des, fromStream, reinterpret_cast<const uint8_t*>(p), n);
+}
+
+bool ProtocolPlus::OnCompressed(IErrorHandler& errorHandler, Deserializer& des, uint64_t fromStream, const uint8_t* p, size_t n)
+{
+    // The wrapped message is checked against the context only after the decompression, hence the wrapper itself is accepted only over the secure channel.
+    // The declared size is checked against the max expansion before the allocation
+    const uint32_t nHdr = 5;
+    if ((n >= nHdr) && (Mode::Duplex == m_Mode))
+    {
+        uint8_t nCode = p[0];
+
+        uint32_t nSize = 0;
+        for (uint32_t i = 0; i < 4; i++)
+            nSize |= static_cast<uint32_t>(p[i + 1]) << (i << 3);
+
+        if ((nCode < _maxMessageTypes) && (s_CodeCompressed != nCode) && (nSize <= Lz::get_MaxDecoded(n - nHdr)))
+        {
+            const DispatchTableItem& x = _dispatchTable[nCode];
+            if (x.callback && (nSize >= x.minSize) && (nSize <= x.maxSize))
+            {
+                const std::vector<uint8_t>& vDict = get_CompressDictionary();
+
+                std::vector<uint8_t> v(vDict.size() + nSize);
+                if (!v.empty())
+                {
+                    if (!vDict.empty())
+                        memcpy(&v.front(), &vDict.front(), vDict.size());
+
+                    if (Lz::Decode(&v.front(), vDict.size(), nSize, p + nHdr, n - nHdr))
+                        return x.callback(x.msgHandler, errorHandler, des, fromStream, &v.front() + vDict.size(), nSize);
+                }
+            }
+        }
+    }
+
+    errorHandler.on_protocol_error(fromStream, ProtocolError::message_corrupted);
+    return false;
+}
+
 void InitCipherIV(AES::StreamCipher& c, const ECC::Hash::Value& hvSecret, const ECC::Hash::Value& hvParam)
 {
     ECC::NoLeak<ECC::Hash::Value> hvIV;
@@ -189,7 +330,48 @@ void ProtocolPlus::InitCipher()
 }
 
 
-bool Bbs::Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native& nonce, const void* p, uint32_t n)
+// The hint bytes: the marker, followed by the masked tag. Both are derived from the sender ephemeral key, i.e. differ for every message
+static void get_BbsHintMask(uint8_t* pMask, const uint8_t* pPublic)
+{
+    static_assert(Bbs::s_HintSize <= ECC::Hash::Value::nBytes, "");
+
+    ECC::Hash::Value hv;
+    ECC::Hash::Processor()
+        << "bbs.hint.v1"
+        << Blob(pPublic, PeerID::nBytes)
+        >> hv;
+
+    memcpy(pMask, hv.m_pData, Bbs::s_HintSize);
+}
+
+Bbs::HintTag Bbs::get_HintTag(const PeerID& pid)
+{
+    ECC::Hash::Value hv;
+    ECC::Hash::Processor()
+        << "bbs.hint"
+        << pid
+        >> hv;
+
+    return hv.m_pData[0];
+}
+
+bool Bbs::get_Hint(HintTag& tag, const uint8_t* p, uint32_t n)
+{
+    if (n < PeerID::nBytes + ECC::Hash::Value::nBytes + s_HintSize)
+        return false;
+
+    uint8_t pMask[s_HintSize];
+    get_BbsHintMask(pMask, p);
+
+    p += n - s_HintSize;
+    if (memcmp(p, pMask, s_HintSize - sizeof(HintTag)))
+        return false;
+
+    tag = p[s_HintSize - sizeof(HintTag)] ^ pMask[s_HintSize - sizeof(HintTag)];
+    return true;
+}
+
+bool Bbs::Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native& nonce, const void* p, uint32_t n, bool bHint /* = false */)
 {
     PeerID myPublic;
     myPublic.FromSk(nonce);
@@ -200,18 +382,40 @@ bool Bbs::Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native
     if (!InitViaDiffieHellman(nonce, publicAddr, enc, hmac, &cOut, NULL))
         return false; // bad address
 
-    hmac.Write(p, n);
+    uint32_t nHint = bHint ? s_HintSize : 0;
     ECC::Hash::Value hvMac;
-    hmac >> hvMac;
 
-    res.resize(myPublic.nBytes + hvMac.nBytes + n);
+    res.resize(myPublic.nBytes + hvMac.nBytes + n + nHint);
     uint8_t* pDst = &res.at(0);
 
     memcpy(pDst, myPublic.m_pData, myPublic.nBytes);
-    memcpy(pDst + myPublic.nBytes, hvMac.m_pData, hvMac.nBytes);
-    memcpy(pDst + myPublic.nBytes + hvMac.nBytes, p, n);
+    pDst += myPublic.nBytes;
+
+    // encrypt with zero mac (and hint), then xor the mac into its cipherstream
+    memset0(pDst, hvMac.nBytes);
+    memcpy(pDst + hvMac.nBytes, p, n);
+    memset0(pDst + hvMac.nBytes + n, nHint);
 
-    cOut.XCrypt(enc, pDst + myPublic.nBytes, hvMac.nBytes + n);
+    cOut.XCrypt(enc, pDst, hvMac.nBytes + n + nHint);
+
+    hmac.Write(p, n);
+
+    if (bHint)
+    {
+        // the hint plaintext is chosen s.t. its ciphertext is the hint
+        uint8_t* pHint = pDst + hvMac.nBytes + n;
+
+        uint8_t pHintCt[s_HintSize];
+        get_BbsHintMask(pHintCt, myPublic.m_pData);
+        pHintCt[s_HintSize - sizeof(HintTag)] ^= get_HintTag(publicAddr);
+
+        memxor(pHint, pHintCt, s_HintSize); // now it's the plaintext
+        hmac.Write(pHint, s_HintSize);
+        memcpy(pHint, pHintCt, s_HintSize);
+    }
+
+    hmac >> hvMac;
+    memxor(pDst, hvMac.m_pData, hvMac.nBytes);
 
     return true;
 }
@@ -277,6 +481,7 @@ union HighestMsgCode
 #define THE_MACRO(code, msg) uint8_t m_pBuf_##msg[code + 1];
     BeamNodeMsgsAll(THE_MACRO)
 #undef THE_MACRO
+    uint8_t m_pBuf_Compressed[ProtocolPlus::s_CodeCompressed + 1];
 };
 
 bool NotCalled_VerifyNoDuplicatedIDs(uint32_t id)
@@ -294,13 +499,150 @@ bool NotCalled_VerifyNoDuplicatedIDs(uint32_t id)
 
 /////////////////////////
 // NodeConnection
+
+// Messages with many tx elements are decoded into an arena, all the elements of a single message share a few memory chunks
+template <typename TMsg> struct MsgDeserializeScope { typedef Protocol::NoScope Type; };
+template <> struct MsgDeserializeScope<NewTransaction_NoInit> { typedef Arena::Local Type; };
+
+// Messages that carry bulk data, compressed if the peer supports it
+template <typename TMsg> struct MsgCompressible { static const bool Value = false; };
+template <> struct MsgCompressible<BodyPack> { static const bool Value = true; };
+template <> struct MsgCompressible<HdrPack> { static const bool Value = true; };
+template <> struct MsgCompressible<Events> { static const bool Value = true; };
+
+struct NodeConnection::IoThreads::IMsg
+{
+    virtual ~IMsg() {}
+    virtual bool Dispatch(NodeConnection&) = 0;
+};
+
+template <typename TMsg>
+struct NodeConnection::IoThreads::Msg
+    :public IMsg
+{
+    TMsg m_Msg;
+    Msg(TMsg&& v) :m_Msg(std::move(v)) {}
+
+    virtual bool Dispatch(NodeConnection& x) override
+    {
+        return x.OnMsgInternal(0, std::move(m_Msg));
+    }
+};
+
+struct NodeConnection::IoThreads::Event
+{
+    struct Type {
+        enum Enum {
+            Msg,
+            IoErr,
+            ProtocolErr,
+            Drown
+        };
+    };
+
+    Type::Enum m_Type;
+    std::shared_ptr<Channel> m_pChannel;
+    std::unique_ptr<IMsg> m_pMsg;
+    bool m_Suspended = false; // the channel waits for the message to be handled, the cipher may change
+    io::ErrorCode m_IoErr = io::EC_OK;
+    ProtocolError m_eProtoErr = ProtocolError::no_error;
+
+    Event(Type::Enum eType) :m_Type(eType) {}
+};
+
+struct NodeConnection::IoThreads::Cmd
+{
+    struct Type {
+        enum Enum {
+            Open,
+            Write,
+            Sync,
+            Resume,
+            Close
+        };
+    };
+
+    // cipher, once initialized
+    struct Keys
+    {
+        AES::Encoder m_Enc;
+        AES::StreamCipher m_CipherIn;
+        AES::StreamCipher m_CipherOut;
+        ECC::Hash::Mac m_HMac;
+    };
+
+    Type::Enum m_Type;
+    std::shared_ptr<Channel> m_pChannel;
+    uv_os_sock_t m_Socket = 0; // Open
+    io::SharedBuffer m_Buf; // Write, sealed
+    ProtocolPlus::Mode::Enum m_Mode = ProtocolPlus::Mode::Plaintext; // Sync
+    std::unique_ptr<Keys> m_pKeys; // Sync
+
+    Cmd(Type::Enum eType, std::shared_ptr<Channel>&& pChannel) :m_Type(eType), m_pChannel(std::move(pChannel)) {}
+};
+
+struct NodeConnection::IoThreads::Thread
+{
+    io::Reactor::Ptr m_pReactor;
+    io::AsyncEvent::Ptr m_pEvt;
+    std::thread m_Thread;
+
+    std::mutex m_Mutex;
+    std::vector<Cmd> m_vCmds;
+
+    uint32_t m_Channels = 0; // owner thread, for balancing
+
+    void Post(Cmd&&);
+    void OnCmds();
+};
+
+struct NodeConnection::Channel
+    :public IErrorHandler
+    ,public std::enable_shared_from_this<Channel>
+{
+    IoThreads& m_This;
+    IoThreads::Thread& m_Thread;
+
+    // owner thread
+    NodeConnection* m_pConnection = nullptr; // reset when closed
+    ProtocolPlus::Mode::Enum m_Mode = ProtocolPlus::Mode::Plaintext; // as sent to the I/O thread
+
+    io::Address m_Addr;
+    size_t m_UnsentHiMark;
+
+    std::atomic<size_t> m_Queued; // sent by the owner, not written yet
+    std::atomic<size_t> m_Unsent; // of the stream, as of the last I/O
+
+    // I/O thread
+    ProtocolPlus m_Protocol;
+    std::unique_ptr<Connection> m_Connection;
+    SerializedMsg m_vOut;
+    bool m_FlushPending = false;
+    bool m_Drown = false;
+
+    Channel(IoThreads&, IoThreads::Thread&);
+
+    void OnCmd(IoThreads::Cmd&);
+    void Flush();
+    void PostEvent(IoThreads::Event&&);
+
+    template <typename TMsg>
+    bool OnMsgIo(uint64_t, TMsg&&);
+
+    // IErrorHandler
+    virtual void on_protocol_error(uint64_t, ProtocolError error) override;
+    virtual void on_connection_error(uint64_t, io::ErrorCode errorCode) override;
+};
+
 NodeConnection::NodeConnection()
     :m_Protocol('B', 'm', 10, sizeof(HighestMsgCode), *this, 20000)
     ,m_ConnectPending(false)
 	,m_RulesCfgSent(false)
+	,m_HoldOutgoing(false)
+	,m_nHeld(0)
 {
 #define THE_MACRO(code, msg) \
-    m_Protocol.add_message_handler<NodeConnection, msg##_NoInit, &NodeConnection::OnMsgInternal>(uint8_t(code), this, 0, 1024*1024*10);
+    m_Protocol.add_message_handler<NodeConnection, msg##_NoInit, &NodeConnection::OnMsgInternal, MsgDeserializeScope<msg##_NoInit>::Type>(uint8_t(code), this, 0, 1024*1024*10);
 
     BeamNodeMsgsAll(THE_MACRO)
 #undef THE_MACRO
@@ -323,6 +665,18 @@ void NodeConnection::Reset()
     m_Connection = NULL;
     m_pAsyncFail = NULL;
 
+    if (m_pChannel)
+    {
+        IoThreads::Cmd cmd(IoThreads::Cmd::Type::Close, std::move(m_pChannel));
+        cmd.m_pChannel->m_pConnection = nullptr;
+        cmd.m_pChannel->m_Thread.m_Channels--;
+        cmd.m_pChannel->m_Thread.Post(std::move(cmd));
+    }
+
+    m_HoldOutgoing = false;
+    m_lstHeld.clear();
+    m_nHeld = 0;
+
     m_Protocol.ResetVars();
 }
 
@@ -347,7 +701,11 @@ void NodeConnection::TestIoResultAsync(const io::Result& res)
 
 void NodeConnection::TestNotDrown()
 {
-	if (!m_pAsyncFail && m_UnsentHiMark && (get_Unsent() > m_UnsentHiMark))
+	size_t nUnsent = m_pChannel ?
+		m_nHeld : // the rest is tested by the I/O thread, after the actual write
+		get_Unsent();
+
+	if (!m_pAsyncFail && m_UnsentHiMark && (nUnsent > m_UnsentHiMark))
 	{
 		io::AsyncEvent::Callback cb = [this]()
 		{
@@ -370,7 +728,7 @@ void NodeConnection::OnConnectInternal(uint64_t tag, io::TcpStream::Ptr&& newStr
 
 void NodeConnection::OnConnectInternal2(io::TcpStream::Ptr&& newStream, io::ErrorCode status)
 {
-    assert(!m_Connection && m_ConnectPending);
+    assert(!m_Connection && !m_pChannel && m_ConnectPending);
     m_ConnectPending = false;
 
     if (newStream)
@@ -417,9 +775,63 @@ void NodeConnection::OnIoErr(io::ErrorCode err)
     OnDisconnect(r);
 }
 
+void NodeConnection::HoldOutgoing()
+{
+    m_HoldOutgoing = true;
+}
+
+void NodeConnection::ReleaseOutgoing()
+{
+    m_HoldOutgoing = false;
+}
+
+void NodeConnection::FlushOutgoing()
+{
+    assert(!m_HoldOutgoing);
+
+    for (; !m_lstHeld.empty(); m_lstHeld.pop_front())
+    {
+        m_nHeld -= m_lstHeld.front().size;
+
+        if (!IsLive())
+            continue;
+
+        if (m_pChannel)
+        {
+            WriteChannel(std::move(m_lstHeld.front()));
+            continue;
+        }
+
+        m_SerializeCache.push_back(m_lstHeld.front());
+        m_Protocol.XCryptOut(m_SerializeCache);
+        io::Result res = m_Connection->write_msg(m_SerializeCache);
+        m_SerializeCache.clear();
+
+        TestIoResultAsync(res);
+    }
+
+    if (IsLive())
+        TestNotDrown();
+}
+
 size_t NodeConnection::get_Unsent() const
 {
-	return m_Connection ? m_Connection->get_Unsent() : 0;
+	size_t n = m_nHeld;
+
+	if (m_pChannel)
+		n += m_pChannel->m_Queued + m_pChannel->m_Unsent;
+	else if (m_Connection)
+		n += m_Connection->get_Unsent();
+
+	return n;
+}
+
+io::Address NodeConnection::get_PeerAddr() const
+{
+	if (m_pChannel)
+		return m_pChannel->m_Addr;
+
+	return m_Connection ? m_Connection->peer_address() : io::Address();
 }
 
 void NodeConnection::on_protocol_error(uint64_t, ProtocolError error)
@@ -475,7 +887,7 @@ void NodeConnection::ThrowUnexpected(const char* sz, NodeProcessingException::Ty
 
 void NodeConnection::Connect(const io::Address& addr, const boost::optional<io::Address> proxyAddr)
 {
-    assert(!m_Connection && !m_ConnectPending);
+    assert(!m_Connection && !m_pChannel && !m_ConnectPending);
 
     io::Result res;
     if (proxyAddr)
@@ -500,10 +912,14 @@ void NodeConnection::Connect(const io::Address& addr, const boost::optional<io::
 
 void NodeConnection::Accept(io::TcpStream::Ptr&& newStream)
 {
-    assert(!m_Connection && !m_ConnectPending);
+    assert(!m_Connection && !m_pChannel && !m_ConnectPending);
 
     newStream->enable_keepalive(Rules::get().DA.Target_s); // it should be comparable to the block rate
 
+    IoThreads* pIo = get_IoThreads();
+    if (pIo && pIo->IsEnabled() && pIo->Attach(*this, newStream))
+        return;
+
     m_Connection = std::make_unique<Connection>(
         m_Protocol,
         uint64_t(this),
@@ -515,7 +931,7 @@ void NodeConnection::Accept(io::TcpStream::Ptr&& newStream)
 
 bool NodeConnection::IsLive() const
 {
-    return m_Connection && !m_pAsyncFail;
+    return (m_Connection || m_pChannel) && !m_pAsyncFail;
 }
 
 #define THE_MACRO(code, msg) \
@@ -525,6 +941,23 @@ void NodeConnection::Send(const msg& v) \
         return; \
     m_SerializeCache.clear(); \
     MsgSerializer& ser = m_Protocol.serializeNoFinalize(m_SerializeCache, uint8_t(code), v); \
+    if (MsgCompressible<msg>::Value && m_Protocol.m_Compress) \
+        m_Protocol.Compress(m_SerializeCache, ser, uint8_t(code)); \
+    if (m_HoldOutgoing || m_pChannel) \
+    { \
+        m_Protocol.Seal(m_SerializeCache, ser); \
+        io::SharedBuffer buf = io::normalize(m_SerializeCache, true); \
+        m_SerializeCache.clear(); \
+        if (m_HoldOutgoing) \
+        { \
+            m_nHeld += buf.size; \
+            m_lstHeld.push_back(std::move(buf)); \
+            TestNotDrown(); \
+        } \
+        else \
+            WriteChannel(std::move(buf)); \
+        return; \
+    } \
     m_Protocol.Encrypt(m_SerializeCache, ser); \
     io::Result res = m_Connection->write_msg(m_SerializeCache); \
     m_SerializeCache.clear(); \
@@ -725,7 +1158,7 @@ void NodeConnection::OnMsg(Login&& msg)
 
                 Height hScheme = pFork[1].m_Height;
 
-                LOG_WARNING() << "Peer " << m_Connection->peer_address() << " incompatible with HF " << (nMyFork + 1) << ", Height=" << hScheme;
+                LOG_WARNING() << "Peer " << get_PeerAddr() << " incompatible with HF " << (nMyFork + 1) << ", Height=" << hScheme;
 
                 Height hMinScheme = get_MinPeerFork();
                 if (hMinScheme >= hScheme)
@@ -734,7 +1167,7 @@ void NodeConnection::OnMsg(Login&& msg)
 
             if (i + 1 != msg.m_Cfgs.size())
             {
-                LOG_WARNING() << "Peer " << m_Connection->peer_address() << " has unknown fork: " << msg.m_Cfgs[i + 1];
+                LOG_WARNING() << "Peer " << get_PeerAddr() << " has unknown fork: " << msg.m_Cfgs[i + 1];
             }
 
 			OnLoginInternal(std::move(msg));
@@ -763,12 +1196,14 @@ void NodeConnection::OnLoginInternal(Login&& msg)
     if (LoginFlags::Extension::Maximum != nExt)
     {
         bool bNewer = (nExt > LoginFlags::Extension::Maximum);
-        LOG_WARNING() << "Peer " << m_Connection->peer_address() << " uses " << (bNewer ? "newer" : "older") << " ext: " << nExt;
+        LOG_WARNING() << "Peer " << get_PeerAddr() << " uses " << (bNewer ? "newer" : "older") << " ext: " << nExt;
 
         if (nExt < LoginFlags::Extension::Minimum)
             ThrowUnexpected("Legacy", NodeProcessingException::Type::Incompatible);
     }
 
+    m_Protocol.m_Compress = (nExt >= 7);
+
 	OnLogin(std::move(msg));
 }
 
@@ -968,6 +1403,368 @@ void NodeConnection::Server::Listen(const io::Address& addr)
     m_pServer = io::TcpServer::create(io::Reactor::get_Current(), addr, BIND_THIS_MEMFN(OnAccepted));
 }
 
+void NodeConnection::SyncChannel()
+{
+    Channel& c = *m_pChannel;
+    if (c.m_Mode == m_Protocol.m_Mode)
+        return;
+
+    IoThreads::Cmd cmd(IoThreads::Cmd::Type::Sync, std::shared_ptr<Channel>(m_pChannel));
+    cmd.m_Mode = m_Protocol.m_Mode;
+
+    if (ProtocolPlus::Mode::Plaintext == c.m_Mode)
+    {
+        // cipher initialized. From now on it's used only by the I/O thread
+        cmd.m_pKeys = std::make_unique<IoThreads::Cmd::Keys>();
+        cmd.m_pKeys->m_Enc = m_Protocol.m_Enc;
+        cmd.m_pKeys->m_CipherIn = m_Protocol.m_CipherIn;
+        cmd.m_pKeys->m_CipherOut = m_Protocol.m_CipherOut;
+        cmd.m_pKeys->m_HMac = m_Protocol.m_HMac;
+    }
+
+    c.m_Mode = m_Protocol.m_Mode;
+    c.m_Thread.Post(std::move(cmd));
+}
+
+void NodeConnection::WriteChannel(io::SharedBuffer&& buf)
+{
+    SyncChannel(); // before the message sealed in the new mode
+
+    m_pChannel->m_Queued += buf.size;
+
+    IoThreads::Cmd cmd(IoThreads::Cmd::Type::Write, std::shared_ptr<Channel>(m_pChannel));
+    cmd.m_Buf = std::move(buf);
+    m_pChannel->m_Thread.Post(std::move(cmd));
+}
+
+/////////////////////////
+// NodeConnection::IoThreads
+NodeConnection::IoThreads::IoThreads()
+{
+}
+
+NodeConnection::IoThreads::~IoThreads()
+{
+    Stop();
+}
+
+void NodeConnection::IoThreads::Initialize(uint32_t nThreads)
+{
+    assert(!IsEnabled());
+    if (!nThreads)
+        return;
+
+#ifdef WIN32
+    LOG_WARNING() << "I/O threads are not supported";
+#else // WIN32
+    m_pEvt = io::AsyncEvent::create(io::Reactor::get_Current(), [this]() { OnEvents(); });
+
+    m_vThreads.resize(nThreads);
+    for (uint32_t i = 0; i < nThreads; i++)
+    {
+        m_vThreads[i] = std::make_unique<Thread>();
+        Thread& t = *m_vThreads[i];
+
+        t.m_pReactor = io::Reactor::create();
+        t.m_pEvt = io::AsyncEvent::create(*t.m_pReactor, [&t]() { t.OnCmds(); });
+        t.m_Thread = std::thread([&t]() {
+            io::Reactor::Scope scope(*t.m_pReactor);
+            t.m_pReactor->run();
+        });
+    }
+#endif // WIN32
+}
+
+void NodeConnection::IoThreads::Stop()
+{
+    for (size_t i = 0; i < m_vThreads.size(); i++)
+    {
+        Thread& t = *m_vThreads[i];
+        t.m_pReactor->stop();
+
+        if (t.m_Thread.joinable())
+            t.m_Thread.join();
+    }
+
+    for (size_t i = 0; i < m_vThreads.size(); i++)
+        m_vThreads[i]->m_vCmds.clear();
+
+    m_vEvents.clear();
+    m_vThreads.clear();
+    m_pEvt.reset();
+}
+
+bool NodeConnection::IoThreads::Attach(NodeConnection& x, io::TcpStream::Ptr& pStream)
+{
+    assert(IsEnabled());
+
+    Thread* pThread = m_vThreads.front().get();
+    for (size_t i = 1; i < m_vThreads.size(); i++)
+        if (pThread->m_Channels > m_vThreads[i]->m_Channels)
+            pThread = m_vThreads[i].get();
+
+    io::Address addr = pStream->peer_address();
+
+    uv_os_sock_t sock;
+    io::Result res = pStream->detach_socket(sock);
+    if (!res)
+    {
+        LOG_WARNING() << "Can't detach socket: " << io::error_str(res.error());
+        return false;
+    }
+
+    pStream.reset();
+
+    auto pChannel = std::make_shared<Channel>(*this, *pThread);
+    pChannel->m_pConnection = &x;
+    pChannel->m_Addr = addr;
+    pChannel->m_UnsentHiMark = x.m_UnsentHiMark;
+
+    x.m_pChannel = pChannel;
+    pThread->m_Channels++;
+
+    Cmd cmd(Cmd::Type::Open, std::move(pChannel));
+    cmd.m_Socket = sock;
+    pThread->Post(std::move(cmd));
+
+    return true;
+}
+
+void NodeConnection::IoThreads::PostEvent(Event&& evt)
+{
+    bool bWasEmpty;
+    {
+        std::unique_lock<std::mutex> scope(m_Mutex);
+        bWasEmpty = m_vEvents.empty();
+        m_vEvents.push_back(std::move(evt));
+    }
+
+    if (bWasEmpty)
+        m_pEvt->post();
+}
+
+void NodeConnection::IoThreads::OnEvents()
+{
+    std::vector<Event> vEvents;
+    {
+        std::unique_lock<std::mutex> scope(m_Mutex);
+        vEvents.swap(m_vEvents);
+    }
+
+    for (size_t i = 0; i < vEvents.size(); i++)
+    {
+        Event& evt = vEvents[i];
+        NodeConnection* pConn = evt.m_pChannel->m_pConnection;
+        if (!pConn)
+            continue; // closed meanwhile
+
+        switch (evt.m_Type)
+        {
+        case Event::Type::Msg:
+            evt.m_pMsg->Dispatch(*pConn);
+
+            if (evt.m_Suspended && (evt.m_pChannel->m_pConnection == pConn)) // still alive
+            {
+                pConn->SyncChannel();
+
+                Thread& t = evt.m_pChannel->m_Thread;
+                t.Post(Cmd(Cmd::Type::Resume, std::move(evt.m_pChannel)));
+            }
+            break;
+
+        case Event::Type::IoErr:
+            pConn->on_connection_error(0, evt.m_IoErr);
+            break;
+
+        case Event::Type::ProtocolErr:
+            pConn->on_protocol_error(0, evt.m_eProtoErr);
+            break;
+
+        case Event::Type::Drown:
+            if (!pConn->m_pAsyncFail)
+            {
+                DisconnectReason r;
+                r.m_Type = DisconnectReason::Drown;
+                pConn->OnDisconnect(r);
+            }
+            break;
+        }
+    }
+}
+
+void NodeConnection::IoThreads::Thread::Post(Cmd&& cmd)
+{
+    bool bWasEmpty;
+    {
+        std::unique_lock<std::mutex> scope(m_Mutex);
+        bWasEmpty = m_vCmds.empty();
+        m_vCmds.push_back(std::move(cmd));
+    }
+
+    if (bWasEmpty)
+        m_pEvt->post();
+}
+
+void NodeConnection::IoThreads::Thread::OnCmds()
+{
+    std::vector<Cmd> vCmds;
+    {
+        std::unique_lock<std::mutex> scope(m_Mutex);
+        vCmds.swap(m_vCmds);
+    }
+
+    for (size_t i = 0; i < vCmds.size(); i++)
+        vCmds[i].m_pChannel->OnCmd(vCmds[i]);
+
+    // the consecutive writes are coalesced
+    for (size_t i = 0; i < vCmds.size(); i++)
+        vCmds[i].m_pChannel->Flush();
+}
+
+/////////////////////////
+// NodeConnection::Channel
+NodeConnection::Channel::Channel(IoThreads& x, IoThreads::Thread& t)
+    :m_This(x)
+    ,m_Thread(t)
+    ,m_Queued(0)
+    ,m_Unsent(0)
+    ,m_Protocol('B', 'm', 10, sizeof(HighestMsgCode), *this, 1024)
+{
+#define THE_MACRO(code, msg) \
+    m_Protocol.add_message_handler<Channel, msg##_NoInit, &Channel::OnMsgIo<msg##_NoInit>, MsgDeserializeScope<msg##_NoInit>::Type>(uint8_t(code), this, 0, 1024*1024*10);
+
+    BeamNodeMsgsAll(THE_MACRO)
+#undef THE_MACRO
+}
+
+void NodeConnection::Channel::OnCmd(IoThreads::Cmd& cmd)
+{
+    switch (cmd.m_Type)
+    {
+    case IoThreads::Cmd::Type::Open:
+        try {
+            m_Connection = std::make_unique<Connection>(
+                m_Protocol,
+                uint64_t(this),
+                Connection::inbound,
+                100,
+                io::Reactor::get_Current().tcp_attach(cmd.m_Socket)
+                );
+        }
+        catch (const io::Exception& e) {
+            on_connection_error(0, e.errorCode);
+        }
+        break;
+
+    case IoThreads::Cmd::Type::Write:
+        m_Queued -= cmd.m_Buf.size;
+
+        if (m_Connection)
+        {
+            m_vOut.push_back(std::move(cmd.m_Buf));
+            m_Protocol.XCryptOut(m_vOut);
+            io::Result res = m_Connection->write_msg(m_vOut, false);
+            m_vOut.clear();
+
+            if (res)
+                m_FlushPending = true;
+            else
+                on_connection_error(0, res.error());
+        }
+        break;
+
+    case IoThreads::Cmd::Type::Sync:
+        m_Protocol.m_Mode = cmd.m_Mode;
+
+        if (cmd.m_pKeys)
+        {
+            m_Protocol.m_Enc = cmd.m_pKeys->m_Enc;
+            m_Protocol.m_CipherIn = cmd.m_pKeys->m_CipherIn;
+            m_Protocol.m_CipherOut = cmd.m_pKeys->m_CipherOut;
+            m_Protocol.m_HMac = cmd.m_pKeys->m_HMac;
+        }
+        break;
+
+    case IoThreads::Cmd::Type::Resume:
+        if (m_Connection)
+            m_Connection->resume_reading();
+        break;
+
+    case IoThreads::Cmd::Type::Close:
+        m_Connection.reset();
+        break;
+    }
+}
+
+void NodeConnection::Channel::Flush()
+{
+    if (!m_FlushPending)
+        return;
+    m_FlushPending = false;
+
+    if (!m_Connection)
+        return;
+
+    io::Result res = m_Connection->write_msg(m_vOut);
+    if (!res)
+    {
+        on_connection_error(0, res.error());
+        return;
+    }
+
+    size_t nUnsent = m_Connection->get_Unsent();
+    m_Unsent = nUnsent;
+
+    if (!m_Drown && m_UnsentHiMark && (nUnsent > m_UnsentHiMark))
+    {
+        m_Drown = true;
+        PostEvent(IoThreads::Event(IoThreads::Event::Type::Drown));
+    }
+}
+
+void NodeConnection::Channel::PostEvent(IoThreads::Event&& evt)
+{
+    evt.m_pChannel = shared_from_this();
+    m_This.PostEvent(std::move(evt));
+}
+
+template <typename TMsg>
+bool NodeConnection::Channel::OnMsgIo(uint64_t, TMsg&& v)
+{
+    IoThreads::Event evt(IoThreads::Event::Type::Msg);
+    evt.m_pMsg = std::make_unique<IoThreads::Msg<TMsg> >(std::move(v));
+
+    if (ProtocolPlus::Mode::Duplex != m_Protocol.m_Mode)
+    {
+        // the next message may be encrypted, by the cipher that the owner is about to initialize
+        evt.m_Suspended = true;
+        m_Connection->suspend_reading();
+    }
+
+    m_Unsent = m_Connection->get_Unsent();
+
+    PostEvent(std::move(evt));
+    return true;
+}
+
+void NodeConnection::Channel::on_protocol_error(uint64_t, ProtocolError error)
+{
+    m_Connection.reset();
+
+    IoThreads::Event evt(IoThreads::Event::Type::ProtocolErr);
+    evt.m_eProtoErr = error;
+    PostEvent(std::move(evt));
+}
+
+void NodeConnection::Channel::on_connection_error(uint64_t, io::ErrorCode errorCode)
+{
+    m_Connection.reset();
+
+    IoThreads::Event evt(IoThreads::Event::Type::IoErr);
+    evt.m_IoErr = errorCode;
+    PostEvent(std::move(evt));
+}
+
 /////////////////////////
 // Event
 void Event::IParser::ProceedOnce(Deserializer& der)
@@ -23,6 +23,7 @@
 #include "../utility/io/timer.h"
 #include "aes.h"
 #include "block_crypt.h"
+#include <mutex>
 
 namespace beam {
 namespace proto {
@@ -312,6 +313,7 @@ namespace proto {
     macro(0x3f, BbsMsg) \
     macro(0x45, GetStateSummary) \
     macro(0x46, StateSummary) \
+    /* 0x47 is reserved for the compressed messages wrapper, see ProtocolPlus */ \
 
 
     struct LoginFlags {
@@ -334,9 +336,10 @@ namespace proto {
             // 4 - Supports proto::Events (replaces proto::EventsLegacy)
             // 5 - Supports Events serif, max num of events per message increased from 64 to 1024
             // 6 - Newer Event::AssetCtl
+            // 7 - Supports compressed BodyPack, HdrPack, Events
 
             static const uint32_t Minimum = 4;
-            static const uint32_t Maximum = 6;
+            static const uint32_t Maximum = 7;
 
             static void set(uint32_t& nFlags, uint32_t nExt);
             static uint32_t get(uint32_t nFlags);
@@ -517,7 +520,22 @@ namespace proto {
 
 		typedef uintBig_t<4> NonceType;
 
-		bool Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native& nonce, const void*, uint32_t); // will fail iff addr is invalid
+		// Optional recipient hint: a marker and a short tag of the recipient address, appended such that they're the last bytes of the ciphertext,
+		// i.e. readable without decryption. The receiver tries to decrypt only with the addresses of the matching tag.
+		// For legacy receivers it's just extra trailing bytes of the plaintext.
+		// The marker is derived from the sender ephemeral key (which opens the message), so that hinted messages don't share a constant pattern.
+		// It's long enough that a legacy message is practically never taken for a hinted one, which would make the receiver skip it on a tag mismatch.
+		// This doesn't hide the hint from those aware of the scheme, it's checked by anyone without keys.
+		// The tag is deliberately short, it only narrows the candidates within the channel, but doesn't identify the recipient.
+		// Still it leaks 8 bits of the recipient linkage: an observer can tell messages with different tags are for different addresses,
+		// and messages with the same tag are 256 times more likely to be for the same one.
+		typedef uint8_t HintTag;
+		static const uint32_t s_HintSize = 8; // 7-byte marker + tag
+
+		HintTag get_HintTag(const PeerID&);
+		bool get_Hint(HintTag&, const uint8_t* p, uint32_t n); // false for legacy (non-hinted) messages
+
+		bool Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native& nonce, const void*, uint32_t, bool bHint = false); // will fail iff addr is invalid
 		bool Decrypt(uint8_t*& p, uint32_t& n, const ECC::Scalar::Native& privateAddr);
 	};
 
@@ -598,6 +616,14 @@ namespace proto {
         typedef uintBig_t<8> MacValue;
         static void get_HMac(ECC::Hash::Mac&, MacValue&);
 
+        // Compressed message is sent wrapped: code, original size (4 bytes, LE), Lz-encoded data (with the preset dictionary).
+        // The receiver unwraps it regardless to the negotiated extension, the sender uses it only if the peer supports it.
+        static const uint8_t s_CodeCompressed = 0x47;
+        static const uint32_t s_CompressMin = 1024; // smaller messages are sent as-is
+        bool m_Compress; // outgoing
+
+        static const std::vector<uint8_t>& get_CompressDictionary();
+
         ProtocolPlus(uint8_t v0, uint8_t v1, uint8_t v2, size_t maxMessageTypes, IErrorHandler& errorHandler, size_t serializedFragmentsSize);
         void ResetVars();
         void InitCipher();
@@ -608,6 +634,15 @@ namespace proto {
         virtual bool VerifyMsg(const uint8_t*, uint32_t nSize) override;
 
         void Encrypt(SerializedMsg&, MsgSerializer&);
+        void Seal(SerializedMsg&, MsgSerializer&); // finalize and append the hmac, no encryption yet
+        void XCryptOut(SerializedMsg&);
+
+        // Replaces the message being serialized by its compressed wrapper, unless it's not worth it. Should be followed by Seal/Encrypt
+        void Compress(SerializedMsg&, MsgSerializer&, uint8_t nCode);
+
+    private:
+        static bool OnCompressed(void*, IErrorHandler&, Deserializer&, uint64_t, const void*, size_t);
+        bool OnCompressed(IErrorHandler&, Deserializer&, uint64_t, const uint8_t*, size_t);
     };
 
     struct INodeMsgHandler
@@ -654,8 +689,17 @@ namespace proto {
         io::AsyncEvent::Ptr m_pAsyncFail;
         bool m_ConnectPending;
 		bool m_RulesCfgSent;
+		bool m_HoldOutgoing;
 
         SerializedMsg m_SerializeCache;
+        std::list<io::SharedBuffer> m_lstHeld; // sealed, not encrypted yet
+        size_t m_nHeld; // bytes in m_lstHeld, counted as unsent
+
+        struct Channel;
+        std::shared_ptr<Channel> m_pChannel; // if served by an I/O thread
+        void SyncChannel();
+        void WriteChannel(io::SharedBuffer&&);
+        io::Address get_PeerAddr() const;
 
         void TestIoResultAsync(const io::Result& res);
         void TestInputMsgContext(uint8_t);
@@ -685,6 +729,9 @@ namespace proto {
         void Connect(const io::Address& addr, const boost::optional<io::Address> proxyAddr = boost::none);
         void Accept(io::TcpStream::Ptr&& newStream);
 
+        struct IoThreads;
+        virtual IoThreads* get_IoThreads() { return nullptr; } // if enabled - the connection is moved to one of them on accept/connect
+
         // Secure-channel-specific
         void SecureConnect(); // must be connected already
 
@@ -766,6 +813,13 @@ namespace proto {
 		size_t m_UnsentHiMark = 0;
 		void TestNotDrown();
 
+		// Outgoing messages can be held: serialized and queued, but not encrypted and sent yet. Used to send a delayed response
+		// before the messages that follow it: Release, send the response, then Flush the held ones in their original order.
+		// The held messages are a part of the unsent data, i.e. the peer drowns if it doesn't read the responses meanwhile.
+		void HoldOutgoing();
+		void ReleaseOutgoing();
+		void FlushOutgoing();
+
         void OnIoErr(io::ErrorCode);
         void OnExc(const std::exception&);
         void OnProcessingExc(const NodeProcessingException& exception);
@@ -783,6 +837,34 @@ namespace proto {
         };
     };
 
+    // Threads with their own reactors that serve the connections: socket I/O, decryption and MAC verification, messages framing and
+    // deserialization. The messages are handled in the owner thread, the outgoing ones are serialized and sealed there, and encrypted
+    // and written by the I/O thread. Not supported on Windows (the sockets can't be moved between the reactors).
+    struct NodeConnection::IoThreads
+    {
+        struct IMsg;
+        template <typename TMsg> struct Msg;
+        struct Event;
+        struct Cmd;
+        struct Thread;
+
+        std::vector<std::unique_ptr<Thread> > m_vThreads;
+        std::mutex m_Mutex;
+        std::vector<Event> m_vEvents;
+        io::AsyncEvent::Ptr m_pEvt;
+
+        IoThreads();
+        ~IoThreads();
+
+        bool IsEnabled() const { return !m_vThreads.empty(); }
+        void Initialize(uint32_t nThreads);
+        void Stop();
+
+        bool Attach(NodeConnection&, io::TcpStream::Ptr&); // the stream is left intact on failure
+        void PostEvent(Event&&); // I/O thread
+        void OnEvents();
+    };
+
     std::ostream& operator << (std::ostream& s, const NodeConnection::DisconnectReason&);
 
 } // namespace proto
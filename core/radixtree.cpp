@@ -14,6 +14,7 @@
 
 #include "radixtree.h"
 #include "ecc_native.h"
+#include "../utility/executor.h"
 
 namespace beam {
 
@@ -45,7 +46,8 @@ void RadixTree::Clear()
 	{
 		OnDirty();
 
-		DeleteNode(get_Root());
+		if (!DeleteAll())
+			DeleteNode(get_Root());
 		m_RootOffset = 0;
 	}
 }
@@ -461,6 +463,70 @@ size_t RadixTree::Count() const
 	return t.m_Count;
 }
 
+/////////////////////////////
+// RadixTree::SlabAllocator
+RadixTree::SlabAllocator::SlabAllocator(uint32_t nSize)
+	:m_pSlabs(nullptr)
+	,m_pFree(nullptr)
+{
+	if (nSize >= s_CacheLine)
+		m_nSize = (nSize + s_CacheLine - 1) & ~(s_CacheLine - 1);
+	else
+	{
+		// power of 2, so that cache lines are shared by whole elements only
+		for (m_nSize = sizeof(void*); m_nSize < nSize; )
+			m_nSize <<= 1;
+	}
+
+	m_nPerSlab = (s_SlabSize - s_CacheLine) / m_nSize; // 1st cache line is for the slab header
+	assert(m_nPerSlab);
+}
+
+void RadixTree::SlabAllocator::Grow()
+{
+	uint8_t* pBuf = static_cast<uint8_t*>(::operator new(s_SlabSize, std::align_val_t(s_CacheLine)));
+
+	Slab* pSlab = reinterpret_cast<Slab*>(pBuf);
+	pSlab->m_pNext = m_pSlabs;
+	m_pSlabs = pSlab;
+
+	pBuf += s_CacheLine;
+
+	// in reverse order, so that elements are allocated in ascending order
+	for (uint32_t i = m_nPerSlab; i--; )
+		Free(pBuf + m_nSize * i);
+}
+
+void* RadixTree::SlabAllocator::Allocate()
+{
+	if (!m_pFree)
+		Grow();
+
+	void* p = m_pFree;
+	m_pFree = *static_cast<void**>(p);
+	return p;
+}
+
+void RadixTree::SlabAllocator::Free(void* p)
+{
+	assert(p);
+	*static_cast<void**>(p) = m_pFree;
+	m_pFree = p;
+}
+
+void RadixTree::SlabAllocator::Reset()
+{
+	while (m_pSlabs)
+	{
+		Slab* pSlab = m_pSlabs;
+		m_pSlabs = pSlab->m_pNext;
+
+		::operator delete(pSlab, std::align_val_t(s_CacheLine));
+	}
+
+	m_pFree = nullptr;
+}
+
 /////////////////////////////
 // RadixHashTree
 void RadixHashTree::get_Hash(Merkle::Hash& hv)
@@ -507,6 +573,129 @@ const Merkle::Hash& RadixHashTree::get_Hash(Node& n, Merkle::Hash& hv)
 	return x.m_Hash;
 }
 
+void RadixHashTree::get_Hash(Merkle::Hash& hv, Executor& ex)
+{
+	Node* p = get_Root();
+	if (!p)
+	{
+		hv = Zero;
+		return;
+	}
+
+	if (!(Node::s_Clean & p->m_Bits))
+	{
+		OnDirty();
+
+		std::vector<JointVec> vLevels;
+		CollectDirty(*p, vLevels);
+
+		struct Task
+			:public Executor::TaskSync
+		{
+			RadixHashTree* m_pThis;
+			MyJoint* const* m_pp;
+			uint32_t m_Count;
+
+			virtual void Exec(Executor::Context& ctx) override
+			{
+				uint32_t i0, nCount;
+				ctx.get_Portion(i0, nCount, m_Count);
+				m_pThis->HashJoints(m_pp + i0, nCount);
+			}
+		};
+
+		const uint32_t nParallelMin = 0x100; // below this it's not worth to wake the threads
+		uint32_t nThreads = ex.get_Threads();
+
+		for (size_t iLevel = 0; iLevel < vLevels.size(); iLevel++)
+		{
+			const JointVec& v = vLevels[iLevel];
+			uint32_t nCount = static_cast<uint32_t>(v.size());
+
+			// ExecAll waits for all the pending tasks first. If the executor is busy (e.g. verifying the next blocks) - hash on this thread rather than stall behind them
+			if ((nThreads > 1) && (nCount >= nParallelMin) && !ex.Flush(static_cast<uint32_t>(-1)))
+			{
+				Task t;
+				t.m_pThis = this;
+				t.m_pp = &v.front();
+				t.m_Count = nCount;
+				ex.ExecAll(t);
+			}
+			else
+				HashJoints(&v.front(), nCount);
+		}
+
+		assert(Node::s_Clean & p->m_Bits);
+	}
+
+	hv = get_Hash(*p, hv);
+}
+
+uint32_t RadixHashTree::CollectDirty(Node& n, std::vector<JointVec>& vLevels)
+{
+	if (Node::s_Clean & n.m_Bits)
+		return 0;
+
+	if (Node::s_Leaf & n.m_Bits)
+	{
+		n.m_Bits |= Node::s_Clean; // leaf hash is evaluated on-demand
+		return 0;
+	}
+
+	MyJoint& x = Cast::Up<MyJoint>(n);
+
+	uint32_t nLevel = 0;
+	for (size_t i = 0; i < _countof(x.m_ppC); i++)
+		std::setmax(nLevel, CollectDirty(*x.m_ppC[i].get_Strict(), vLevels));
+
+	if (vLevels.size() <= nLevel)
+		vLevels.resize(nLevel + 1);
+
+	vLevels[nLevel].push_back(&x);
+	return nLevel + 1;
+}
+
+void RadixHashTree::HashJoints(MyJoint* const* pp, uint32_t nCount)
+{
+	// Each joint hash is a hash of 2 sibling hashes. Prepare them in batches, and hash them via multi-buffer
+	Merkle::Hash pIn[s_HashBatch][2];
+	Merkle::Hash pOut[s_HashBatch];
+
+	while (nCount)
+	{
+		uint32_t n = (nCount < s_HashBatch) ? nCount : s_HashBatch;
+
+		for (uint32_t i = 0; i < n; i++)
+		{
+			const MyJoint& x = *pp[i];
+			for (uint32_t j = 0; j < _countof(x.m_ppC); j++)
+			{
+				Node& c = *x.m_ppC[j].get_Strict();
+				assert(Node::s_Clean & c.m_Bits);
+
+				const Merkle::Hash& hv = (Node::s_Leaf & c.m_Bits) ?
+					get_LeafHash(c, pIn[i][j]) :
+					Cast::Up<MyJoint>(c).m_Hash;
+
+				if (&hv != &pIn[i][j])
+					pIn[i][j] = hv;
+			}
+		}
+
+		ECC::Hash::Multi::Pairs(pOut, &pIn[0][0], n);
+
+		for (uint32_t i = 0; i < n; i++)
+		{
+			MyJoint& x = *pp[i];
+			x.m_Hash = pOut[i];
+			x.m_Bits |= Node::s_Clean;
+		}
+
+		pp += n;
+		nCount -= n;
+	}
+}
+
 void RadixHashTree::get_Proof(Merkle::Proof& proof, const CursorBase& cu)
 {
 	uint16_t n = cu.get_Depth();
@@ -846,6 +1035,100 @@ void UtxoTree::Compact::FlushInternal(uint16_t nBitsCommonNext)
 	}
 }
 
+/////////////////////////////
+// RadixHashOnlyTreePooled
+RadixHashOnlyTreePooled::RadixHashOnlyTreePooled()
+	:m_Leafs(sizeof(MyLeaf))
+	,m_Joints(sizeof(MyJoint))
+{
+}
+
+RadixTree::Leaf* RadixHashOnlyTreePooled::CreateLeaf()
+{
+	return new (m_Leafs.Allocate()) MyLeaf;
+}
+
+void RadixHashOnlyTreePooled::DeleteLeaf(Leaf* p)
+{
+	m_Leafs.Free(p);
+}
+
+RadixTree::Joint* RadixHashOnlyTreePooled::CreateJoint()
+{
+	return new (m_Joints.Allocate()) MyJoint;
+}
+
+void RadixHashOnlyTreePooled::DeleteJoint(Joint* p)
+{
+	m_Joints.Free(p);
+}
+
+bool RadixHashOnlyTreePooled::DeleteAll()
+{
+	m_Leafs.Reset();
+	m_Joints.Reset();
+	return true;
+}
+
+/////////////////////////////
+// UtxoTreePooled
+UtxoTreePooled::UtxoTreePooled()
+	:m_Leafs(sizeof(MyLeaf))
+	,m_Joints(sizeof(MyJoint))
+	,m_Queues(sizeof(MyLeaf::IDQueue))
+	,m_Nodes(sizeof(MyLeaf::IDNode))
+{
+}
+
+RadixTree::Leaf* UtxoTreePooled::CreateLeaf()
+{
+	return new (m_Leafs.Allocate()) MyLeaf;
+}
+
+void UtxoTreePooled::DeleteEmptyLeaf(Leaf* p)
+{
+	m_Leafs.Free(p);
+}
+
+RadixTree::Joint* UtxoTreePooled::CreateJoint()
+{
+	return new (m_Joints.Allocate()) MyJoint;
+}
+
+void UtxoTreePooled::DeleteJoint(Joint* p)
+{
+	m_Joints.Free(p);
+}
+
+UtxoTree::MyLeaf::IDQueue* UtxoTreePooled::CreateIDQueue()
+{
+	return new (m_Queues.Allocate()) MyLeaf::IDQueue;
+}
+
+void UtxoTreePooled::DeleteIDQueue(MyLeaf::IDQueue* p)
+{
+	m_Queues.Free(p);
+}
+
+UtxoTree::MyLeaf::IDNode* UtxoTreePooled::CreateIDNode()
+{
+	return new (m_Nodes.Allocate()) MyLeaf::IDNode;
+}
+
+void UtxoTreePooled::DeleteIDNode(MyLeaf::IDNode* p)
+{
+	m_Nodes.Free(p);
+}
+
+bool UtxoTreePooled::DeleteAll()
+{
+	m_Leafs.Reset();
+	m_Joints.Reset();
+	m_Queues.Reset();
+	m_Nodes.Reset();
+	return true;
+}
+
 /////////////////////////////
 // UtxoTreeMapped
 bool UtxoTreeMapped::Open(const char* sz, const Stamp& s)
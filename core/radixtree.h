@@ -20,6 +20,8 @@
 namespace beam
 {
 
+struct Executor;
+
 class RadixTree
 {
 protected:
@@ -95,6 +97,7 @@ protected:
 	virtual uint8_t* GetLeafKey(const Leaf&) const = 0;
 	virtual void DeleteJoint(Joint*) = 0;
 	virtual void DeleteLeaf(Leaf*) = 0;
+	virtual bool DeleteAll() { return false; } // optionally release all the nodes at once, without traversing the tree
 
 public:
 
@@ -103,6 +106,33 @@ public:
 
 	void Clear();
 
+	// In-memory pooled allocation policy, alternative to the individual new/delete.
+	// Elements of the same type are carved from cache-line aligned slabs, freed elements are reused. All the slabs are released at once on Reset().
+	class SlabAllocator
+	{
+		struct Slab {
+			Slab* m_pNext;
+		};
+
+		Slab* m_pSlabs;
+		void* m_pFree;
+		uint32_t m_nSize; // adjusted, so that elements don't span unnecessary cache lines
+		uint32_t m_nPerSlab;
+
+		void Grow();
+
+	public:
+		static const uint32_t s_CacheLine = 64;
+		static const uint32_t s_SlabSize = 0x10000;
+
+		SlabAllocator(uint32_t nSize);
+		~SlabAllocator() { Reset(); }
+
+		void* Allocate();
+		void Free(void*);
+		void Reset();
+	};
+
 	class CursorBase
 	{
 	protected:
@@ -188,6 +218,7 @@ public:
 	};
 
 	void get_Hash(Merkle::Hash&);
+	void get_Hash(Merkle::Hash&, Executor&); // dirty joints are recalculated level-by-level (bottom-up), each level in parallel (if the executor is idle) and in batches
 	void get_Proof(Merkle::Proof&, const CursorBase&);
 
 protected:
@@ -197,6 +228,11 @@ protected:
 
 	const Merkle::Hash& get_Hash(Node&, Merkle::Hash&);
 
+	typedef std::vector<MyJoint*> JointVec;
+	uint32_t CollectDirty(Node&, std::vector<JointVec>&); // returns the level, 0 for clean nodes and leafs
+	static const uint32_t s_HashBatch = 8; // joints hashed at once, matches the multi-buffer lanes (Hash::Accel::Avx2)
+	void HashJoints(MyJoint* const*, uint32_t nCount); // children must be clean
+
 	virtual const Merkle::Hash& get_LeafHash(Node&, Merkle::Hash&) = 0;
 };
 
@@ -367,6 +403,50 @@ protected:
 	TxoID PopIDRaw(MyLeaf::IDQueue&);
 };
 
+class RadixHashOnlyTreePooled
+	:public RadixHashOnlyTree
+{
+	SlabAllocator m_Leafs;
+	SlabAllocator m_Joints;
+
+protected:
+	virtual Leaf* CreateLeaf() override;
+	virtual void DeleteLeaf(Leaf*) override;
+	virtual Joint* CreateJoint() override;
+	virtual void DeleteJoint(Joint*) override;
+	virtual bool DeleteAll() override;
+
+public:
+	RadixHashOnlyTreePooled();
+	~RadixHashOnlyTreePooled() { Clear(); }
+};
+
+// In-memory utxo set on the slab allocators. Not used by the node: its utxo set is UtxoTreeMapped, which is already allocated from the mapped file.
+class UtxoTreePooled
+	:public UtxoTree
+{
+	SlabAllocator m_Leafs;
+	SlabAllocator m_Joints;
+	SlabAllocator m_Queues;
+	SlabAllocator m_Nodes;
+
+protected:
+	virtual Leaf* CreateLeaf() override;
+	virtual void DeleteEmptyLeaf(Leaf*) override;
+	virtual Joint* CreateJoint() override;
+	virtual void DeleteJoint(Joint*) override;
+	virtual bool DeleteAll() override;
+
+	virtual MyLeaf::IDQueue* CreateIDQueue() override;
+	virtual void DeleteIDQueue(MyLeaf::IDQueue*) override;
+	virtual MyLeaf::IDNode* CreateIDNode() override;
+	virtual void DeleteIDNode(MyLeaf::IDNode*) override;
+
+public:
+	UtxoTreePooled();
+	~UtxoTreePooled() { Clear(); }
+};
+
 class UtxoTreeMapped
 	:public UtxoTree
 {
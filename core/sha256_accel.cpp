@@ -0,0 +1,291 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sha256_accel.h"
+#include <string.h>
+#include <assert.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define BEAM_SHA256_X86
+#	include <immintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#		define BEAM_TARGET(x)
+#	else // _MSC_VER
+#		include <cpuid.h>
+#		define BEAM_TARGET(x) __attribute__((target(x)))
+#	endif // _MSC_VER
+#endif // x86
+
+namespace ECC {
+namespace Sha256 {
+
+	const uint32_t s_pIV[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+
+	const uint32_t s_pK[64] = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+	};
+
+	uint32_t PadTail(uint8_t* pDst, const uint8_t* pTail, uint32_t nTail, uint64_t nTotalBytes)
+	{
+		assert(nTail < s_BlockSize);
+
+		memcpy(pDst, pTail, nTail);
+		pDst[nTail++] = 0x80;
+
+		uint32_t nBlocks = (nTail + 8 > s_BlockSize) ? 2 : 1;
+		uint32_t nSize = nBlocks * s_BlockSize;
+
+		memset(pDst + nTail, 0, nSize - 8 - nTail);
+
+		uint64_t nBits = nTotalBytes << 3;
+		for (uint32_t i = 0; i < 8; i++)
+			pDst[nSize - 1 - i] = static_cast<uint8_t>(nBits >> (i << 3));
+
+		return nBlocks;
+	}
+
+#ifdef BEAM_SHA256_X86
+
+	namespace
+	{
+		struct CpuFeatures
+		{
+			bool m_ShaNi = false;
+			bool m_Avx2 = false;
+
+			static void CpuId(uint32_t* p, uint32_t nLeaf)
+			{
+#ifdef _MSC_VER
+				__cpuidex(reinterpret_cast<int*>(p), nLeaf, 0);
+#else // _MSC_VER
+				__cpuid_count(nLeaf, 0, p[0], p[1], p[2], p[3]);
+#endif // _MSC_VER
+			}
+
+			static uint64_t ReadXCR0()
+			{
+#ifdef _MSC_VER
+				return _xgetbv(0);
+#else // _MSC_VER
+				uint32_t nLo, nHi;
+				__asm__ volatile("xgetbv" : "=a"(nLo), "=d"(nHi) : "c"(0));
+				return (uint64_t(nHi) << 32) | nLo;
+#endif // _MSC_VER
+			}
+
+			CpuFeatures()
+			{
+				uint32_t p[4]; // eax, ebx, ecx, edx
+				CpuId(p, 0);
+				uint32_t nMaxLeaf = p[0];
+				if (nMaxLeaf < 7)
+					return;
+
+				CpuId(p, 1);
+				bool bSsse3 = 0 != (p[2] & (1U << 9));
+				bool bSse41 = 0 != (p[2] & (1U << 19));
+				bool bOsxSave = 0 != (p[2] & (1U << 27));
+				bool bAvx = 0 != (p[2] & (1U << 28));
+
+				CpuId(p, 7);
+				m_ShaNi = bSsse3 && bSse41 && (0 != (p[1] & (1U << 29)));
+
+				// AVX2 also requires the OS to preserve the ymm state
+				if (bAvx && bOsxSave && (0 != (p[1] & (1U << 5))))
+					m_Avx2 = (6 == (ReadXCR0() & 6));
+			}
+		};
+
+		const CpuFeatures& get_CpuFeatures()
+		{
+			static const CpuFeatures s_Val;
+			return s_Val;
+		}
+	}
+
+	bool IsSupported_ShaNi()
+	{
+		return get_CpuFeatures().m_ShaNi;
+	}
+
+	bool IsSupported_Avx2()
+	{
+		return get_CpuFeatures().m_Avx2;
+	}
+
+	BEAM_TARGET("sha,sse4.1,ssse3")
+	void Transform_ShaNi(uint32_t* pS, const uint8_t* pData, size_t nBlocks)
+	{
+		const __m128i msk = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+		// state is kept as ABEF/CDGH, as required by the sha256rnds2
+		__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*) pS), 0xB1); // CDAB
+		__m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*) (pS + 4)), 0x1B); // EFGH
+		__m128i s0 = _mm_alignr_epi8(tmp, s1, 8); // ABEF
+		s1 = _mm_blend_epi16(s1, tmp, 0xF0); // CDGH
+
+		for (; nBlocks--; pData += s_BlockSize)
+		{
+			__m128i s0Prev = s0;
+			__m128i s1Prev = s1;
+
+			__m128i pW[4];
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				__m128i& w = pW[i & 3];
+
+				if (i < 4)
+					w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (pData + (i << 4))), msk);
+				else
+				{
+					__m128i x = _mm_sha256msg1_epu32(w, pW[(i + 1) & 3]);
+					x = _mm_add_epi32(x, _mm_alignr_epi8(pW[(i + 3) & 3], pW[(i + 2) & 3], 4));
+					w = _mm_sha256msg2_epu32(x, pW[(i + 3) & 3]);
+				}
+
+				__m128i msg = _mm_add_epi32(w, _mm_loadu_si128((const __m128i*) (s_pK + (i << 2))));
+				s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+				s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(msg, 0x0E));
+			}
+
+			s0 = _mm_add_epi32(s0, s0Prev);
+			s1 = _mm_add_epi32(s1, s1Prev);
+		}
+
+		tmp = _mm_shuffle_epi32(s0, 0x1B); // FEBA
+		s1 = _mm_shuffle_epi32(s1, 0xB1); // DCHG
+		_mm_storeu_si128((__m128i*) pS, _mm_blend_epi16(tmp, s1, 0xF0)); // DCBA
+		_mm_storeu_si128((__m128i*) (pS + 4), _mm_alignr_epi8(s1, tmp, 8)); // HGFE
+	}
+
+#	define SHA256_X8_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n))
+#	define SHA256_X8_XOR3(a, b, c) _mm256_xor_si256(_mm256_xor_si256(a, b), c)
+
+	BEAM_TARGET("avx2")
+	void Transform_Avx2_x8(uint32_t* pS, const uint8_t* const* ppData, size_t nBlocks)
+	{
+		// byte-swap within each 32-bit word
+		const __m256i msk = _mm256_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL, 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+		const uint8_t* pp[s_Lanes];
+		memcpy(pp, ppData, sizeof(pp));
+
+		__m256i pSt[8];
+		for (uint32_t i = 0; i < 8; i++)
+			pSt[i] = _mm256_loadu_si256((const __m256i*) (pS + i * s_Lanes));
+
+		for (; nBlocks--; )
+		{
+			__m256i pW[16];
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t pLane[s_Lanes];
+				for (uint32_t iLane = 0; iLane < s_Lanes; iLane++)
+					memcpy(pLane + iLane, pp[iLane] + (i << 2), sizeof(uint32_t));
+
+				pW[i] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) pLane), msk);
+			}
+
+			for (uint32_t iLane = 0; iLane < s_Lanes; iLane++)
+				pp[iLane] += s_BlockSize;
+
+			__m256i a = pSt[0], b = pSt[1], c = pSt[2], d = pSt[3], e = pSt[4], f = pSt[5], g = pSt[6], h = pSt[7];
+
+			for (uint32_t i = 0; i < 64; i++)
+			{
+				__m256i& w = pW[i & 15];
+
+				if (i >= 16)
+				{
+					const __m256i& w15 = pW[(i + 1) & 15];
+					const __m256i& w2 = pW[(i + 14) & 15];
+
+					__m256i s0 = SHA256_X8_XOR3(SHA256_X8_ROTR(w15, 7), SHA256_X8_ROTR(w15, 18), _mm256_srli_epi32(w15, 3));
+					__m256i s1 = SHA256_X8_XOR3(SHA256_X8_ROTR(w2, 17), SHA256_X8_ROTR(w2, 19), _mm256_srli_epi32(w2, 10));
+
+					w = _mm256_add_epi32(_mm256_add_epi32(w, s0), _mm256_add_epi32(pW[(i + 9) & 15], s1));
+				}
+
+				__m256i t1 = _mm256_add_epi32(h, SHA256_X8_XOR3(SHA256_X8_ROTR(e, 6), SHA256_X8_ROTR(e, 11), SHA256_X8_ROTR(e, 25)));
+				t1 = _mm256_add_epi32(t1, _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g))); // Ch
+				t1 = _mm256_add_epi32(t1, _mm256_add_epi32(w, _mm256_set1_epi32(s_pK[i])));
+
+				__m256i t2 = SHA256_X8_XOR3(SHA256_X8_ROTR(a, 2), SHA256_X8_ROTR(a, 13), SHA256_X8_ROTR(a, 22));
+				t2 = _mm256_add_epi32(t2, _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)))); // Maj
+
+				h = g;
+				g = f;
+				f = e;
+				e = _mm256_add_epi32(d, t1);
+				d = c;
+				c = b;
+				b = a;
+				a = _mm256_add_epi32(t1, t2);
+			}
+
+			pSt[0] = _mm256_add_epi32(pSt[0], a);
+			pSt[1] = _mm256_add_epi32(pSt[1], b);
+			pSt[2] = _mm256_add_epi32(pSt[2], c);
+			pSt[3] = _mm256_add_epi32(pSt[3], d);
+			pSt[4] = _mm256_add_epi32(pSt[4], e);
+			pSt[5] = _mm256_add_epi32(pSt[5], f);
+			pSt[6] = _mm256_add_epi32(pSt[6], g);
+			pSt[7] = _mm256_add_epi32(pSt[7], h);
+		}
+
+		for (uint32_t i = 0; i < 8; i++)
+			_mm256_storeu_si256((__m256i*) (pS + i * s_Lanes), pSt[i]);
+	}
+
+#	undef SHA256_X8_ROTR
+#	undef SHA256_X8_XOR3
+
+#else // BEAM_SHA256_X86
+
+	bool IsSupported_ShaNi()
+	{
+		return false;
+	}
+
+	bool IsSupported_Avx2()
+	{
+		return false;
+	}
+
+	void Transform_ShaNi(uint32_t*, const uint8_t*, size_t)
+	{
+		assert(false);
+	}
+
+	void Transform_Avx2_x8(uint32_t*, const uint8_t* const*, size_t)
+	{
+		assert(false);
+	}
+
+#endif // BEAM_SHA256_X86
+
+} // namespace Sha256
+} // namespace ECC
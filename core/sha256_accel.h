@@ -0,0 +1,45 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+namespace ECC {
+namespace Sha256 {
+
+	// Low-level SHA-256 compression backends. State is 8 native-endian words, data is raw (big-endian) 64-byte blocks.
+	// Callers must check the CPU support before using the accelerated variants.
+
+	static const uint32_t s_BlockSize = 64;
+	static const uint32_t s_Lanes = 8; // multi-buffer width
+
+	extern const uint32_t s_pIV[8];
+	extern const uint32_t s_pK[64];
+
+	typedef void (*PfnTransform)(uint32_t* pS, const uint8_t* pData, size_t nBlocks);
+
+	// Builds the final padded block(s) from the message tail (less than a block). Returns the number of blocks (1 or 2)
+	uint32_t PadTail(uint8_t* pDst, const uint8_t* pTail, uint32_t nTail, uint64_t nTotalBytes);
+
+	bool IsSupported_ShaNi();
+	bool IsSupported_Avx2();
+
+	void Transform_ShaNi(uint32_t* pS, const uint8_t* pData, size_t nBlocks);
+
+	// 8 independent states, transposed: pS[iWord * s_Lanes + iLane]. Each lane pointer is advanced by nBlocks
+	void Transform_Avx2_x8(uint32_t* pS, const uint8_t* const* ppData, size_t nBlocks);
+
+} // namespace Sha256
+} // namespace ECC
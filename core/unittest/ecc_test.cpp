@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <iostream>
+#include <atomic>
 #include "../ecc_native.h"
 #include "../block_rw.h"
 #include "../shielded.h"
@@ -68,6 +69,50 @@ secp256k1_context* g_psecp256k1 = NULL;
 
 int g_TestsFailed = 0;
 
+// heap allocations count, to benchmark the arena
+std::atomic<uint64_t> g_HeapAllocs(0);
+
+// not inlined, otherwise gcc sees malloc/free paired with the operators new/delete, and complains (-Wmismatched-new-delete)
+#ifdef _MSC_VER
+#	define HEAP_HOOK __declspec(noinline)
+#else
+#	define HEAP_HOOK __attribute__((noinline))
+#endif
+
+HEAP_HOOK void* operator new(size_t n)
+{
+	g_HeapAllocs++;
+	void* p = malloc(n);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+HEAP_HOOK void* operator new[](size_t n)
+{
+	return operator new(n);
+}
+
+HEAP_HOOK void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+HEAP_HOOK void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+HEAP_HOOK void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+HEAP_HOOK void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
 const beam::Height g_hFork = 3; // whatever
 
 void TestFailed(const char* szExpr, uint32_t nLine)
@@ -233,6 +278,66 @@ void TestHash()
 		// hash values must change, even if no explicit input was fed.
 		verify_test(!(hv == hv2));
 	}
+
+	// all the accelerated backends must produce the same
+	const uint32_t nAccel0 = Hash::Accel::get_Enabled();
+	const uint32_t nSupported = Hash::Accel::get_Supported();
+
+	uint8_t pBuf[0x400];
+	GenRandom(pBuf, sizeof(pBuf));
+
+	const uint32_t pSizes[] = { 0, 1, 31, 55, 56, 63, 64, 65, 119, 120, 128, 200 };
+	const uint32_t nCount = 19; // not multiple of lanes
+
+	Hash::Value pRef[_countof(pSizes)][nCount];
+	Hash::Value pOut[nCount];
+
+	for (uint32_t nAccel = 0; nAccel <= (Hash::Accel::ShaNi | Hash::Accel::Avx2); nAccel++)
+	{
+		if ((nAccel & nSupported) != nAccel)
+			continue;
+
+		Hash::Accel::set_Enabled(nAccel);
+
+		// standard test vectors
+		Hash::Processor() << beam::Blob("abc", 3) >> hv;
+		Hash::Value hvExp;
+		hvExp.Scan("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+		verify_test(hv == hvExp);
+
+		Hash::Processor hp;
+		char szA[1000];
+		memset(szA, 'a', sizeof(szA));
+		for (uint32_t i = 0; i < 1000; i++)
+			hp << beam::Blob(szA, sizeof(szA));
+		hp >> hv;
+		hvExp.Scan("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+		verify_test(hv == hvExp);
+
+		for (uint32_t iSize = 0; iSize < _countof(pSizes); iSize++)
+		{
+			uint32_t nSize = pSizes[iSize];
+			Hash::Multi::Calculate(pOut, pBuf, nSize, nCount);
+
+			for (uint32_t i = 0; i < nCount; i++)
+			{
+				// feed it in uneven portions
+				Hash::Processor hp2;
+				const uint8_t* p = pBuf + nSize * i;
+				uint32_t n0 = nSize / 3;
+				hp2 << beam::Blob(p, n0) << beam::Blob(p + n0, nSize - n0) >> hv;
+
+				verify_test(hv == pOut[i]);
+
+				if (nAccel)
+					verify_test(hv == pRef[iSize][i]);
+				else
+					pRef[iSize][i] = hv;
+			}
+		}
+	}
+
+	Hash::Accel::set_Enabled(nAccel0);
 }
 
 void TestScalars()
@@ -1381,6 +1486,141 @@ void TestCutThrough()
 	verify_test(ctx.ValidateAndSummarize(tm.m_Trans, tm.m_Trans.get_Reader()));
 }
 
+struct ArenaBody
+{
+	// synthetic block, elements cloned from a real tx
+	beam::ByteBuffer m_bbP;
+	beam::ByteBuffer m_bbE;
+
+	void Create(uint32_t nInputs, uint32_t nOutputs, uint32_t nKernels)
+	{
+		TransactionMaker tm;
+		tm.AddInput(0, 3000);
+		tm.AddOutput(0, 2000);
+		std::vector<beam::TxKernel::Ptr> lstDummy;
+		tm.CreateTxKernel(tm.m_Trans.m_vKernels, 1000, lstDummy, true, false);
+
+		beam::Block::Body block;
+		block.ZeroInit();
+
+		beam::Serializer ser;
+		ser & *tm.m_Trans.m_vInputs.front() & *tm.m_Trans.m_vOutputs.front() & tm.m_Trans.m_vKernels.front();
+
+		beam::Deserializer der;
+		for (uint32_t i = 0; i < std::max(std::max(nInputs, nOutputs), nKernels); i++)
+		{
+			der.reset(ser.buffer().first, ser.buffer().second);
+
+			beam::Input::Ptr pInp(new beam::Input);
+			beam::Output::Ptr pOut(new beam::Output);
+			beam::TxKernel::Ptr pKrn;
+			der & *pInp & *pOut & pKrn;
+
+			if (i < nInputs)
+				block.m_vInputs.push_back(std::move(pInp));
+			if (i < nOutputs)
+				block.m_vOutputs.push_back(std::move(pOut));
+			if (i < nKernels)
+				block.m_vKernels.push_back(std::move(pKrn));
+		}
+
+		ser.reset();
+		ser & Cast::Down<beam::Block::BodyBase>(block);
+		ser & Cast::Down<beam::TxVectors::Perishable>(block);
+		ser.swap_buf(m_bbP);
+
+		ser & Cast::Down<beam::TxVectors::Eternal>(block);
+		ser.swap_buf(m_bbE);
+	}
+
+	void Decode(beam::Block::Body& block) const
+	{
+		beam::Deserializer der;
+		der.reset(m_bbP);
+		der & Cast::Down<beam::Block::BodyBase>(block);
+		der & Cast::Down<beam::TxVectors::Perishable>(block);
+
+		der.reset(m_bbE);
+		der & Cast::Down<beam::TxVectors::Eternal>(block);
+	}
+};
+
+void TestArena()
+{
+	using beam::Arena;
+
+	{
+		beam::Output::Ptr pOut;
+		beam::TxKernel::Ptr pKrn;
+		{
+			Arena::Local arena(Arena::s_ChunkMax);
+			pOut.reset(new beam::Output);
+			pOut->m_pConfidential.reset(new RangeProof::Confidential);
+			pKrn.reset(new beam::TxKernelStd);
+
+			verify_test(arena.m_Allocations == 3);
+			verify_test(arena.m_Chunks == 1);
+
+			{
+				Arena::Scope scope2(arena); // nested scopes are ok
+				verify_test(Arena::s_pCurrent == &arena);
+			}
+			verify_test(Arena::s_pCurrent == &arena);
+
+			pKrn.reset(); // destroyed before the arena, its memory is reclaimed only with the whole chunk
+		}
+
+		verify_test(!Arena::s_pCurrent);
+
+		// the objects outlive the arena
+		pOut->m_Incubation = 15;
+		verify_test(pOut->m_pConfidential && !pOut->m_pPublic);
+		pOut.reset();
+	}
+
+	{
+		// oversized allocations go to the heap
+		Arena arena;
+		void* p = arena.Allocate(Arena::s_ChunkMax);
+		verify_test(!arena.m_Allocations && !arena.m_Chunks);
+		Arena::Delete(p);
+
+		// chunk sizes are adjusted to the hint
+		Arena arena2(Arena::s_ChunkMin / 2);
+		for (uint32_t i = 0; i < 100; i++)
+			Arena::Delete(arena2.Allocate(Arena::s_ChunkMin / 4));
+		verify_test(arena2.m_Allocations == 100);
+		verify_test(arena2.m_Chunks < 10);
+	}
+
+	{
+		// decoded block elements are arena-allocated, the result is the same
+		ArenaBody ab;
+		ab.Create(10, 20, 5);
+
+		beam::Block::Body block;
+		uint32_t nAllocations;
+		{
+			Arena::Local arena(ab.m_bbP.size() + ab.m_bbE.size());
+			ab.Decode(block);
+			nAllocations = arena.m_Allocations;
+		}
+
+		verify_test(block.m_vInputs.size() == 10);
+		verify_test(block.m_vOutputs.size() == 20);
+		verify_test(block.m_vKernels.size() == 5);
+		verify_test(nAllocations == 10 + 20 * 2 + 5);
+
+		beam::Serializer ser;
+		ser & Cast::Down<beam::Block::BodyBase>(block);
+		ser & Cast::Down<beam::TxVectors::Perishable>(block);
+
+		beam::ByteBuffer bbP;
+		ser.swap_buf(bbP);
+		verify_test(bbP == ab.m_bbP);
+	}
+}
+
 void TestAES()
 {
 	// AES in ECB mode (simplest): https://csrc.nist.gov/CSRC/media/Projects/Cryptographic-Standards-and-Guidelines/documents/examples/AES_Core256.pdf
@@ -1424,6 +1664,44 @@ void TestAES()
 
 	sd.dec.Proceed(pBuf, pBuf); // inplace decode
 	verify_test(!memcmp(pBuf, pPlaintext, sizeof(pPlaintext)));
+
+	if (AES::Accel::IsSupported())
+	{
+		const bool bAccel0 = AES::Accel::get_Enabled();
+
+		// encoder
+		AES::Accel::set_Enabled(true);
+		memcpy(pBuf, pPlaintext, sizeof(pBuf));
+		se.enc.Proceed(pBuf, pBuf);
+		verify_test(!memcmp(pBuf, pCiphertext, sizeof(pBuf)));
+
+		// stream cipher, fed in uneven portions, crossing the counter carry
+		uint8_t pData[0x400], pOut[2][sizeof(pData)];
+		GenRandom(pData, sizeof(pData));
+
+		for (uint32_t iAccel = 0; iAccel < 2; iAccel++)
+		{
+			AES::Accel::set_Enabled(!!iAccel);
+
+			AES::StreamCipher asc;
+			asc.Reset();
+			asc.m_Counter.Inc();
+			asc.m_Counter.Negate(); // -1, would wrap-around soon
+
+			memcpy(pOut[iAccel], pData, sizeof(pData));
+
+			for (uint32_t nPos = 0, nStep = 1; nPos < sizeof(pData); nStep = nStep * 3 + 1)
+			{
+				uint32_t n = std::min<uint32_t>(nStep % 300, sizeof(pData) - nPos);
+				asc.XCrypt(se.enc, pOut[iAccel] + nPos, n);
+				nPos += n;
+			}
+		}
+
+		verify_test(!memcmp(pOut[0], pOut[1], sizeof(pData)));
+
+		AES::Accel::set_Enabled(bAccel0);
+	}
 }
 
 void TestKdfPair(Key::IKdf& skdf, Key::IPKdf& pkdf)
@@ -1529,6 +1807,68 @@ void TestBbs()
 	n = (uint32_t) buf.size();
 
 	verify_test(!beam::proto::Bbs::Decrypt(p, n, privateAddr));
+
+	beam::proto::Bbs::HintTag tag;
+	verify_test(!beam::proto::Bbs::get_Hint(tag, &buf.at(0), (uint32_t) buf.size()));
+
+	// hinted message
+	SetRandom(privateAddr);
+	publicAddr.FromSk(privateAddr);
+
+	SetRandom(nonce);
+	verify_test(beam::proto::Bbs::Encrypt(buf, publicAddr, nonce, szMsg, sizeof(szMsg), true));
+
+	verify_test(beam::proto::Bbs::get_Hint(tag, &buf.at(0), (uint32_t) buf.size()));
+	verify_test(beam::proto::Bbs::get_HintTag(publicAddr) == tag);
+
+	{
+		// no constant pattern, the hint differs for every message
+		beam::ByteBuffer buf2;
+		SetRandom(nonce);
+		verify_test(beam::proto::Bbs::Encrypt(buf2, publicAddr, nonce, szMsg, sizeof(szMsg), true));
+
+		verify_test(beam::proto::Bbs::get_Hint(tag, &buf2.at(0), (uint32_t) buf2.size()));
+		verify_test(beam::proto::Bbs::get_HintTag(publicAddr) == tag);
+
+		const uint32_t nMarker = beam::proto::Bbs::s_HintSize - sizeof(tag);
+		verify_test(memcmp(&buf.at(buf.size() - beam::proto::Bbs::s_HintSize), &buf2.at(buf2.size() - beam::proto::Bbs::s_HintSize), nMarker));
+	}
+
+	p = &buf.at(0);
+	n = (uint32_t) buf.size();
+
+	// legacy receivers just see the trailing bytes
+	verify_test(beam::proto::Bbs::Decrypt(p, n, privateAddr));
+	verify_test(n == sizeof(szMsg) + beam::proto::Bbs::s_HintSize);
+	verify_test(!memcmp(p, szMsg, sizeof(szMsg)));
+
+	// tampered hint
+	buf.back() ^= 1;
+	p = &buf.at(0);
+	n = (uint32_t) buf.size();
+	verify_test(!beam::proto::Bbs::Decrypt(p, n, privateAddr));
+
+	// legacy message, whose ciphertext ends with what looks like a shorter marker and the tag
+	const uint8_t pTail[] = { 0xb5, 0x4e, 0x7a, beam::proto::Bbs::get_HintTag(publicAddr) };
+	uint8_t pMsg[sizeof(szMsg)];
+	memcpy(pMsg, szMsg, sizeof(szMsg));
+
+	SetRandom(nonce);
+	Scalar::Native nonce2 = nonce;
+	verify_test(beam::proto::Bbs::Encrypt(buf, publicAddr, nonce, pMsg, sizeof(pMsg)));
+
+	// same nonce, same keystream
+	for (uint32_t i = 0; i < sizeof(pTail); i++)
+		pMsg[sizeof(pMsg) - sizeof(pTail) + i] ^= buf[buf.size() - sizeof(pTail) + i] ^ pTail[i];
+
+	verify_test(beam::proto::Bbs::Encrypt(buf, publicAddr, nonce2, pMsg, sizeof(pMsg)));
+	verify_test(!memcmp(&buf.at(buf.size() - sizeof(pTail)), pTail, sizeof(pTail)));
+	verify_test(!beam::proto::Bbs::get_Hint(tag, &buf.at(0), (uint32_t) buf.size()));
+
+	p = &buf.at(0);
+	n = (uint32_t) buf.size();
+	verify_test(beam::proto::Bbs::Decrypt(p, n, privateAddr));
+	verify_test((n == sizeof(pMsg)) && !memcmp(p, pMsg, n));
 }
 
 void TestRatio(const beam::Difficulty& d0, const beam::Difficulty& d1, double k)
@@ -1694,6 +2034,153 @@ void TestFourCC()
 	TEST_FOURCC(h)
 }
 
+struct ExecutorTestTask
+	:public beam::Executor::TaskAsync
+{
+	std::atomic<uint32_t>* m_pCounter;
+	uint32_t m_Children = 0;
+	uint32_t m_Work = 0;
+
+	virtual void Exec(beam::Executor::Context& ctx) override
+	{
+		verify_test(ctx.m_iThread < ctx.m_pThis->get_Threads());
+
+		Hash::Value hv = Zero;
+		for (uint32_t i = 0; i < m_Work; i++)
+			Hash::Processor() << hv >> hv;
+
+		for (uint32_t i = 0; i < m_Children; i++)
+		{
+			std::unique_ptr<ExecutorTestTask> pTask(new ExecutorTestTask);
+			pTask->m_pCounter = m_pCounter;
+			ctx.m_pThis->Push(std::move(pTask));
+		}
+
+		(*m_pCounter)++;
+	}
+};
+
+struct ExecutorTestCtl
+	:public beam::Executor::TaskSync
+{
+	std::vector<uint32_t> m_vHits;
+	std::vector<uint32_t> m_vCovered;
+	std::mutex m_Mutex;
+
+	virtual void Exec(beam::Executor::Context& ctx) override
+	{
+		uint32_t i0, nCount;
+		ctx.get_Portion(i0, nCount, static_cast<uint32_t>(m_vCovered.size()));
+
+		std::unique_lock<std::mutex> scope(m_Mutex);
+		m_vHits[ctx.m_iThread]++;
+		for (uint32_t i = 0; i < nCount; i++)
+			m_vCovered[i0 + i]++;
+	}
+};
+
+void TestExecutor()
+{
+	for (uint32_t nThreads : { 1U, 3U, 8U })
+	{
+		beam::ExecutorMT ex;
+		ex.set_Threads(nThreads);
+		ex.m_QueueSize = 4; // force the overflow paths
+
+		std::atomic<uint32_t> nDone(0);
+
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			std::unique_ptr<ExecutorTestTask> pTask(new ExecutorTestTask);
+			pTask->m_pCounter = &nDone;
+			ex.Push(std::move(pTask));
+		}
+
+		verify_test(!ex.Flush(0));
+		verify_test(nDone == 1000);
+
+		// partial flush
+		for (uint32_t i = 0; i < 100; i++)
+		{
+			std::unique_ptr<ExecutorTestTask> pTask(new ExecutorTestTask);
+			pTask->m_pCounter = &nDone;
+			pTask->m_Work = 50;
+			ex.Push(std::move(pTask));
+		}
+
+		verify_test(ex.Flush(10) <= 10);
+		verify_test(!ex.Flush(0));
+		verify_test(nDone == 1100);
+
+		// tasks submitted from within tasks
+		for (uint32_t i = 0; i < 20; i++)
+		{
+			std::unique_ptr<ExecutorTestTask> pTask(new ExecutorTestTask);
+			pTask->m_pCounter = &nDone;
+			pTask->m_Children = 10;
+			ex.Push(std::move(pTask));
+		}
+
+		verify_test(!ex.Flush(0));
+		verify_test(nDone == 1320);
+
+		// control task: exactly once per thread, portions cover everything
+		for (uint32_t iCycle = 0; iCycle < 3; iCycle++)
+		{
+			ExecutorTestCtl ctl;
+			ctl.m_vHits.resize(nThreads, 0);
+			ctl.m_vCovered.resize(1001, 0);
+
+			ex.ExecAll(ctl);
+
+			for (uint32_t i = 0; i < nThreads; i++)
+				verify_test(1 == ctl.m_vHits[i]);
+			for (size_t i = 0; i < ctl.m_vCovered.size(); i++)
+				verify_test(1 == ctl.m_vCovered[i]);
+		}
+
+		// concurrent flushers with different targets, and ExecAll. A lost wakeup would hang here
+		for (uint32_t iCycle = 0; iCycle < 20; iCycle++)
+		{
+			for (uint32_t i = 0; i < 200; i++)
+			{
+				std::unique_ptr<ExecutorTestTask> pTask(new ExecutorTestTask);
+				pTask->m_pCounter = &nDone;
+				pTask->m_Work = 20;
+				ex.Push(std::move(pTask));
+			}
+
+			ExecutorTestCtl ctl;
+			ctl.m_vHits.resize(nThreads, 0);
+			ctl.m_vCovered.resize(100, 0);
+
+			std::thread t0([&ex]() { ex.Flush(0); });
+			std::thread t1([&ex]() { ex.Flush(150); });
+			std::thread t2([&ex, &ctl]() { ex.ExecAll(ctl); });
+			ex.Flush(50);
+
+			t0.join();
+			t1.join();
+			t2.join();
+
+			verify_test(!ex.Flush(0));
+			for (uint32_t i = 0; i < nThreads; i++)
+				verify_test(1 == ctl.m_vHits[i]);
+		}
+
+		verify_test(nDone == 1320 + 20 * 200);
+
+		// tasks left in the queues are discarded on stop
+		for (uint32_t i = 0; i < 50; i++)
+		{
+			std::unique_ptr<ExecutorTestTask> pTask(new ExecutorTestTask);
+			pTask->m_pCounter = &nDone;
+			ex.Push(std::move(pTask));
+		}
+		ex.Stop();
+	}
+}
+
 void TestTreasury()
 {
 	beam::Treasury::Parameters pars;
@@ -2134,6 +2621,7 @@ void TestAll()
 	TestTransaction();
 	TestMultiSigOutput();
 	TestCutThrough();
+	TestArena();
 	TestAES();
 	TestKdf();
 	TestBbs();
@@ -2141,6 +2629,7 @@ void TestAll()
 	TestProtoVer();
 	TestRandom();
 	TestFourCC();
+	TestExecutor();
 	TestTreasury();
 	TestAssetProof();
 	TestAssetEmission();
@@ -2457,6 +2946,101 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	{
+		const uint32_t nAccel0 = Hash::Accel::get_Enabled();
+
+		Hash::Value pIn[2 * 64];
+		Hash::Value pOut[64];
+		GenRandom(pIn, sizeof(pIn));
+
+		for (uint32_t nAccel = 0; nAccel <= (Hash::Accel::ShaNi | Hash::Accel::Avx2); nAccel++)
+		{
+			if ((nAccel & Hash::Accel::get_Supported()) != nAccel)
+				continue;
+
+			Hash::Accel::set_Enabled(nAccel);
+
+			char sz[0x40];
+			snprintf(sz, sizeof(sz), "Hash.Init.1K.Out.A%u", nAccel);
+
+			{
+				uint8_t pBuf[0x400];
+				GenRandom(pBuf, sizeof(pBuf));
+
+				BenchmarkMeter bm(sz);
+				do
+				{
+					for (uint32_t i = 0; i < bm.N; i++)
+					{
+						Hash::Processor()
+							<< beam::Blob(pBuf, sizeof(pBuf))
+							>> hv;
+					}
+
+				} while (bm.ShouldContinue());
+			}
+
+			snprintf(sz, sizeof(sz), "Hash.Pairs.64.A%u", nAccel);
+			{
+				BenchmarkMeter bm(sz);
+				do
+				{
+					for (uint32_t i = 0; i < bm.N; i++)
+						Hash::Multi::Pairs(pOut, pIn, _countof(pOut));
+
+				} while (bm.ShouldContinue());
+			}
+		}
+
+		Hash::Accel::set_Enabled(nAccel0);
+	}
+
+	{
+		// executor overhead: tiny tasks measure the scheduling cost, heavy ones the scaling
+		for (uint32_t nThreads = 1; nThreads <= 64; nThreads <<= 1)
+		{
+			beam::ExecutorMT ex;
+			ex.set_Threads(nThreads);
+
+			std::atomic<uint32_t> nDone(0);
+
+			char sz[0x40];
+			snprintf(sz, sizeof(sz), "Executor.Tiny.T%u", nThreads);
+			{
+				BenchmarkMeter bm(sz);
+				do
+				{
+					for (uint32_t i = 0; i < bm.N; i++)
+					{
+						std::unique_ptr<ExecutorTestTask> pTask(new ExecutorTestTask);
+						pTask->m_pCounter = &nDone;
+						ex.Push(std::move(pTask));
+					}
+					ex.Flush(0);
+
+				} while (bm.ShouldContinue());
+			}
+
+			snprintf(sz, sizeof(sz), "Executor.Heavy.T%u", nThreads);
+			{
+				BenchmarkMeter bm(sz);
+				bm.N = 10;
+				do
+				{
+					for (uint32_t i = 0; i < bm.N; i++)
+					{
+						std::unique_ptr<ExecutorTestTask> pTask(new ExecutorTestTask);
+						pTask->m_pCounter = &nDone;
+						pTask->m_Work = 1000;
+						ex.Push(std::move(pTask));
+					}
+					ex.Flush(0);
+
+				} while (bm.ShouldContinue());
+			}
+		}
+	}
+
 	Hash::Processor() << "abcd" >> hv;
 
 	Signature sig;
@@ -2580,7 +3164,14 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	for (uint32_t iAccel = 0; iAccel < 2; iAccel++)
 	{
+		const bool bAccel0 = AES::Accel::get_Enabled();
+		if (iAccel && !AES::Accel::IsSupported())
+			break;
+
+		AES::Accel::set_Enabled(!!iAccel);
+
 		AES::Encoder enc;
 		enc.Init(hv.m_pData);
 		AES::StreamCipher asc;
@@ -2588,7 +3179,7 @@ void RunBenchmark()
 
 		uint8_t pBuf[0x400];
 
-		BenchmarkMeter bm("AES.XCrypt-1MB");
+		BenchmarkMeter bm(iAccel ? "AES.XCrypt-1MB.AesNi" : "AES.XCrypt-1MB");
 		bm.N = 10;
 		do
 		{
@@ -2599,6 +3190,8 @@ void RunBenchmark()
 			}
 
 		} while (bm.ShouldContinue());
+
+		AES::Accel::set_Enabled(bAccel0);
 	}
 
 	{
@@ -2639,6 +3232,42 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	{
+		ArenaBody ab;
+		ab.Create(2000, 5000, 1000);
+
+		for (uint32_t iArena = 0; iArena < 2; iArena++)
+		{
+			// decode + destroy
+			uint64_t nAllocs = g_HeapAllocs;
+			{
+				beam::Block::Body block;
+				std::unique_ptr<beam::Arena::Local> pArena;
+				if (iArena)
+					pArena = std::make_unique<beam::Arena::Local>(ab.m_bbP.size() + ab.m_bbE.size());
+				ab.Decode(block);
+			}
+			nAllocs = g_HeapAllocs - nAllocs;
+
+			BenchmarkMeter bm(iArena ? "Block.Decode.Arena" : "Block.Decode.Heap");
+			bm.N = 1;
+			do
+			{
+				for (uint32_t i = 0; i < bm.N; i++)
+				{
+					beam::Block::Body block;
+					std::unique_ptr<beam::Arena::Local> pArena;
+					if (iArena)
+						pArena = std::make_unique<beam::Arena::Local>(ab.m_bbP.size() + ab.m_bbE.size());
+					ab.Decode(block);
+				}
+
+			} while (bm.ShouldContinue());
+
+			printf("    2K inputs, 5K outputs, 1K kernels: %u heap allocations\n", static_cast<uint32_t>(nAllocs));
+		}
+	}
+
 }
 
 
@@ -13,9 +13,12 @@
 // limitations under the License.
 
 #include <iostream>
+#include <cstring>
 #include "../radixtree.h"
 #include "../navigator.h"
 #include "../../utility/serialize.h"
+#include "../../utility/test_helpers.h"
+#include "../../utility/executor.h"
 
 #ifndef WIN32
 #	include <unistd.h>
@@ -239,12 +242,11 @@ namespace beam
 			SetLeafID(x.m_ID, i, bTest);
 	}
 
-	void TestUtxoTree()
+	void TestUtxoTree(UtxoTree& t)
 	{
 		std::vector<UtxoTree::Key> vKeys;
 		vKeys.resize(70000);
 
-		UtxoTree t;
 		Merkle::Hash hv1, hv2, hvMid;
 
 		for (uint32_t i = 0; i < vKeys.size(); i++)
@@ -412,6 +414,319 @@ namespace beam
 		verify_test(hv1 == hv2);
 	}
 
+	void TestUtxoTree()
+	{
+		{
+			UtxoTree t;
+			TestUtxoTree(t);
+		}
+		{
+			UtxoTreePooled t;
+			TestUtxoTree(t);
+		}
+
+		// pooled hash-only tree must be equivalent
+		RadixHashOnlyTree t0;
+		RadixHashOnlyTreePooled t1;
+
+		for (uint32_t i = 0; i < 10000; i++)
+		{
+			Merkle::Hash hv;
+			ECC::Hash::Processor() << i >> hv;
+
+			for (uint32_t iTree = 0; iTree < 2; iTree++)
+			{
+				RadixHashOnlyTree& t = iTree ? t1 : t0;
+
+				RadixHashOnlyTree::Cursor cu;
+				bool bCreate = true;
+				verify_test(t.Find(cu, hv, bCreate) && bCreate);
+
+				if (!(i % 3))
+					t.Delete(cu);
+			}
+		}
+
+		ExecutorMT ex;
+		ex.set_Threads(4); // force the parallel path, regardless to the actual number of cores
+
+		// the level-wise parallel hash must be the same
+		Merkle::Hash hv0, hv1;
+		t0.get_Hash(hv0);
+		t1.get_Hash(hv1, ex);
+		verify_test(hv0 == hv1);
+		verify_test(t0.Count() == t1.Count());
+
+		// partial update
+		for (uint32_t i = 0; i < 10000; i += 7)
+		{
+			Merkle::Hash hv;
+			ECC::Hash::Processor() << i >> hv;
+
+			for (uint32_t iTree = 0; iTree < 2; iTree++)
+			{
+				RadixHashOnlyTree& t = iTree ? t1 : t0;
+
+				RadixHashOnlyTree::Cursor cu;
+				bool bCreate = true;
+				t.Find(cu, hv, bCreate);
+
+				if (!bCreate)
+					t.Delete(cu);
+			}
+		}
+
+		t0.get_Hash(hv0);
+		t1.get_Hash(hv1, ex);
+		verify_test(hv0 == hv1);
+		verify_test(t0.Count() == t1.Count());
+	}
+
+	template <typename TTree>
+	void BenchmarkUtxoTree(const char* sz, const std::vector<UtxoTree::Key>& vKeys)
+	{
+		TTree t;
+		Merkle::Hash hv;
+		helpers::StopWatch sw;
+
+		sw.start();
+		for (size_t i = 0; i < vKeys.size(); i++)
+		{
+			UtxoTree::Cursor cu;
+			bool bCreate = true;
+			t.Find(cu, vKeys[i], bCreate)->m_ID = i;
+		}
+		sw.stop();
+		uint64_t tIns_us = sw.microseconds();
+
+		sw.start();
+		t.get_Hash(hv);
+		sw.stop();
+		uint64_t tHash_us = sw.microseconds();
+
+		// delete and re-insert every 2nd element, then rehash. Similar to the block apply
+		sw.start();
+		for (size_t i = 0; i < vKeys.size(); i += 2)
+		{
+			UtxoTree::Cursor cu;
+			bool bCreate = false;
+			t.Find(cu, vKeys[i], bCreate);
+			t.Delete(cu);
+		}
+		for (size_t i = 0; i < vKeys.size(); i += 2)
+		{
+			UtxoTree::Cursor cu;
+			bool bCreate = true;
+			t.Find(cu, vKeys[i], bCreate)->m_ID = i;
+		}
+		sw.stop();
+		uint64_t tDel_us = sw.microseconds();
+
+		sw.start();
+		t.get_Hash(hv);
+		sw.stop();
+		tHash_us += sw.microseconds();
+
+		sw.start();
+		t.Clear();
+		sw.stop();
+
+		printf("%-16s: Insert=%.3f us, Delete+Insert=%.3f us, Hash=%.3f us (per element), Clear=%u ms\n",
+			sz,
+			double(tIns_us) / vKeys.size(),
+			double(tDel_us) / vKeys.size(),
+			double(tHash_us) / vKeys.size(),
+			static_cast<uint32_t>(sw.milliseconds()));
+	}
+
+	void BenchmarkUtxoTree()
+	{
+		std::vector<UtxoTree::Key> vKeys;
+		vKeys.resize(300000);
+
+		for (size_t i = 0; i < vKeys.size(); i++)
+		{
+			UtxoTree::Key::Data d;
+			SetRandomUtxoKey(d);
+			vKeys[i] = d;
+		}
+
+		BenchmarkUtxoTree<UtxoTree>("UtxoTree.Heap", vKeys);
+		BenchmarkUtxoTree<UtxoTreePooled>("UtxoTree.Pooled", vKeys);
+	}
+
+	void BenchmarkUtxoTreeMapped()
+	{
+#ifdef WIN32
+		const char* szPath[] = { "mytest_utxo0.bin", "mytest_utxo1.bin" };
+#else // WIN32
+		const char* szPath[] = { "/tmp/mytest_utxo0.bin", "/tmp/mytest_utxo1.bin" };
+#endif // WIN32
+
+		ExecutorMT ex;
+		ex.set_Threads(4); // force the parallel path, regardless to the actual number of cores
+
+		{
+			UtxoTreeMapped pT[2]; // serial vs parallel
+			UtxoTreeMapped::Stamp us = Zero;
+
+			for (uint32_t iT = 0; iT < _countof(pT); iT++)
+			{
+				DeleteFile(szPath[iT]);
+				pT[iT].Open(szPath[iT], us);
+			}
+
+			std::vector<UtxoTree::Key> vKeys;
+			vKeys.resize(200000);
+
+			for (size_t i = 0; i < vKeys.size(); i++)
+			{
+				UtxoTree::Key::Data d;
+				SetRandomUtxoKey(d);
+				vKeys[i] = d;
+
+				for (uint32_t iT = 0; iT < _countof(pT); iT++)
+				{
+					pT[iT].EnsureReserve();
+
+					UtxoTree::Cursor cu;
+					bool bCreate = true;
+					pT[iT].Find(cu, vKeys[i], bCreate)->m_ID = i;
+				}
+			}
+
+			Merkle::Hash hv0, hv1;
+			helpers::StopWatch sw;
+
+			sw.start();
+			pT[0].get_Hash(hv0);
+			sw.stop();
+			uint64_t tInit0_us = sw.microseconds();
+
+			sw.start();
+			pT[1].get_Hash(hv1, ex);
+			sw.stop();
+			uint64_t tInit1_us = sw.microseconds();
+
+			verify_test(hv0 == hv1);
+
+			// blocks: each spends some random UTXOs and creates new ones
+			const uint32_t nBlocks = 100;
+			const uint32_t nSpend = 1000;
+			const uint32_t nCreate = 1500;
+
+			uint64_t tBlock0_us = 0, tBlock1_us = 0;
+
+			for (uint32_t iBlock = 0; iBlock < nBlocks; iBlock++)
+			{
+				for (uint32_t i = 0; i < nSpend; i++)
+				{
+					size_t iKey;
+					ECC::GenRandom(&iKey, sizeof(iKey));
+					iKey %= vKeys.size();
+
+					for (uint32_t iT = 0; iT < _countof(pT); iT++)
+					{
+						UtxoTree::Cursor cu;
+						bool bCreate = false;
+						verify_test(pT[iT].Find(cu, vKeys[iKey], bCreate));
+						pT[iT].Delete(cu);
+					}
+
+					vKeys[iKey] = vKeys.back();
+					vKeys.pop_back();
+				}
+
+				for (uint32_t i = 0; i < nCreate; i++)
+				{
+					UtxoTree::Key::Data d;
+					SetRandomUtxoKey(d);
+					vKeys.emplace_back();
+					vKeys.back() = d;
+
+					for (uint32_t iT = 0; iT < _countof(pT); iT++)
+					{
+						pT[iT].EnsureReserve();
+
+						UtxoTree::Cursor cu;
+						bool bCreate = true;
+						pT[iT].Find(cu, vKeys.back(), bCreate)->m_ID = vKeys.size();
+					}
+				}
+
+				sw.start();
+				pT[0].get_Hash(hv0);
+				sw.stop();
+				tBlock0_us += sw.microseconds();
+
+				sw.start();
+				pT[1].get_Hash(hv1, ex);
+				sw.stop();
+				tBlock1_us += sw.microseconds();
+
+				verify_test(hv0 == hv1);
+			}
+
+			printf("UtxoTree.Mapped : Initial hash Serial=%u ms, Parallel=%u ms. Per-block hash Serial=%.3f ms, Parallel=%.3f ms (%u threads)\n",
+				static_cast<uint32_t>(tInit0_us / 1000),
+				static_cast<uint32_t>(tInit1_us / 1000),
+				double(tBlock0_us) / (nBlocks * 1000),
+				double(tBlock1_us) / (nBlocks * 1000),
+				ex.get_Threads());
+
+			// pipeline: the block is hashed while the executor is still busy with the pending tasks (verification of the next blocks)
+			struct BusyTask
+				:public Executor::TaskAsync
+			{
+				virtual void Exec(Executor::Context&) override
+				{
+					Merkle::Hash hv = Zero;
+					for (uint32_t i = 0; i < 20000; i++)
+						ECC::Hash::Processor() << hv >> hv;
+				}
+			};
+
+			for (uint32_t i = 0; i < nCreate; i++)
+			{
+				UtxoTree::Key::Data d;
+				SetRandomUtxoKey(d);
+				vKeys.emplace_back();
+				vKeys.back() = d;
+
+				for (uint32_t iT = 0; iT < _countof(pT); iT++)
+				{
+					pT[iT].EnsureReserve();
+
+					UtxoTree::Cursor cu;
+					bool bCreate = true;
+					pT[iT].Find(cu, vKeys.back(), bCreate)->m_ID = vKeys.size();
+				}
+			}
+
+			sw.start();
+			for (uint32_t i = 0; i < 64; i++)
+				ex.Push(std::make_unique<BusyTask>());
+			pT[1].get_Hash(hv1, ex);
+			sw.stop();
+			uint64_t tBusy_us = sw.microseconds();
+
+			sw.start();
+			ex.Flush(0);
+			sw.stop();
+			uint64_t tBacklog_us = sw.microseconds();
+
+			pT[0].get_Hash(hv0);
+			verify_test(hv0 == hv1);
+
+			printf("UtxoTree.Mapped : Hash with a busy executor=%.3f ms, the remaining backlog=%u ms\n",
+				double(tBusy_us) / 1000,
+				static_cast<uint32_t>(tBacklog_us / 1000));
+		}
+
+		for (uint32_t iT = 0; iT < _countof(szPath); iT++)
+			DeleteFile(szPath[iT]);
+	}
+
 	struct MyMmr
 		:public Merkle::Mmr
 	{
@@ -671,11 +986,19 @@ namespace beam
 
 } // namespace beam
 
-int main()
+int main(int argc, char* argv[])
 {
+	bool bBenchmark = (argc > 1) && !strcmp(argv[1], "--benchmark");
+
 	beam::TestNavigator();
 	beam::TestUtxoTree();
 	beam::TestMmr();
 
+	if (bBenchmark)
+	{
+		beam::BenchmarkUtxoTree();
+		beam::BenchmarkUtxoTreeMapped();
+	}
+
 	return g_TestsFailed ? -1 : 0;
 }
@@ -26,7 +26,9 @@ namespace beam { namespace explorer {
 namespace {
 
 static const size_t PACKER_FRAGMENTS_SIZE = 4096;
-static const size_t CACHE_DEPTH = 100000;
+static const size_t CACHE_MAX_SIZE = 512 * 1024 * 1024; // rendered block bodies, bytes
+static const Height PRERENDER_MAX = 16; // new blocks rendered per state change
+static const uint64_t MAX_BLOCKS_PER_REQUEST = 1500;
 
 const char* hash_to_hex(char* buf, const Merkle::Hash& hash) {
     return to_hex(buf, hash.m_pData, hash.nBytes);
@@ -47,45 +49,72 @@ const char* difficulty_to_hex(char* buf, const Difficulty& d) {
     return uint256_to_hex(buf, raw);
 }
 
+void clamp_blocks_range(uint64_t& n) {
+    if (n > MAX_BLOCKS_PER_REQUEST) n = MAX_BLOCKS_PER_REQUEST;
+    else if (n == 0) n = 1;
+}
+
+/// Rendered block bodies by height, shared as is with the outgoing messages.
+/// Kept regardless of the depth, evicted in the insertion order only when the size limit is reached
 struct ResponseCache {
     io::SharedBuffer status;
-    std::map<Height, io::SharedBuffer> blocks;
     Height currentHeight=0;
 
-    explicit ResponseCache(size_t depth) : _depth(depth)
+    struct Block {
+        io::SharedBuffer body;
+        Merkle::Hash hash; // for ETag
+    };
+
+    std::map<Height, Block> blocks;
+
+    explicit ResponseCache(size_t maxSize) : _maxSize(maxSize)
     {}
 
-    void compact() {
-        if (blocks.empty() || currentHeight <= _depth) return;
-        Height horizon = currentHeight - _depth;
-        if (blocks.rbegin()->first < horizon) {
-            blocks.clear();
-            return;
+    const Block* get_block(Height h) const {
+        const auto& it = blocks.find(h);
+        return (it == blocks.end()) ? nullptr : &it->second;
+    }
+
+    void put_block(Height h, const Merkle::Hash& hash, const io::SharedBuffer& body) {
+        Block& b = blocks[h];
+        if (b.body.empty()) {
+            _order.push_back(h);
+        } else {
+            _size -= b.body.size;
         }
-        auto b = blocks.begin();
-        auto it = b;
-        while (it != blocks.end()) {
-            if (it->first >= horizon) break;
-            ++it;
+
+        b.body = body;
+        b.hash = hash;
+        _size += body.size;
+
+        while ((_size > _maxSize) && !_order.empty()) {
+            Height hEvict = _order.front();
+            _order.pop_front();
+
+            auto it = blocks.find(hEvict);
+            if (it != blocks.end()) {
+                _size -= it->second.body.size;
+                blocks.erase(it);
+            }
         }
-        blocks.erase(b, it);
     }
 
-    bool get_block(io::SerializedMsg& out, Height h) {
-        const auto& it = blocks.find(h);
-        if (it == blocks.end()) return false;
-        out.push_back(it->second);
-        return true;
-    }
+    /// removes all the blocks above the given height
+    void truncate(Height h) {
+        for (auto it = blocks.upper_bound(h); it != blocks.end(); ) {
+            _size -= it->second.body.size;
+            it = blocks.erase(it);
+        }
 
-    void put_block(Height h, const io::SharedBuffer& body) {
-        if (currentHeight - h > _depth) return;
-        compact();
-        blocks[h] = body;
+        _order.erase(
+            std::remove_if(_order.begin(), _order.end(), [h](Height x) { return x > h; }),
+            _order.end());
     }
 
 private:
-    size_t _depth;
+    size_t _maxSize;
+    size_t _size = 0;
+    std::deque<Height> _order;
 };
 
 using nlohmann::json;
@@ -101,7 +130,7 @@ public:
         _nodeBackend(node.get_Processor()),
         _statusDirty(true),
         _nodeIsSyncing(true),
-        _cache(CACHE_DEPTH)
+        _cache(CACHE_MAX_SIZE)
     {
         init_helper_fragments();
         _hook = &node.m_Cfg.m_Observer;
@@ -145,18 +174,40 @@ private:
         const auto& cursor = _nodeBackend.m_Cursor;
         _cache.currentHeight = cursor.m_Sid.m_Height;
         _statusDirty = true;
+        prerender_blocks();
         if (_nextHook) _nextHook->OnStateChanged();
     }
 
     void OnRolledBack(const Block::SystemState::ID& id) override {
 
-        auto& blocks = _cache.blocks;
-
-        blocks.erase(blocks.lower_bound(id.m_Height), blocks.end());
+        _cache.truncate(id.m_Height);
+        std::setmin(_prerenderedHeight, id.m_Height);
 
         if (_nextHook) _nextHook->OnRolledBack(id);
     }
 
+    /// Renders the newly arrived blocks, so that they're served from the cache. Older ones are rendered on demand
+    void prerender_blocks() {
+        if (_nodeIsSyncing) return;
+
+        Height h1 = _cache.currentHeight;
+        Height h0 = _prerenderedHeight;
+        if (h1 > h0 + PRERENDER_MAX) {
+            h0 = h1 - PRERENDER_MAX;
+        }
+
+        for (Height h = h0 + 1; h <= h1; h++) {
+            if (_cache.get_block(h)) continue;
+
+            uint64_t row = 0;
+            io::SharedBuffer body;
+            Merkle::Hash hash;
+            if (!render_block(body, hash, h, row, nullptr)) break;
+        }
+
+        _prerenderedHeight = h1;
+    }
+
     bool get_status(io::SerializedMsg& out) override {
         if (_statusDirty) {
             const auto& cursor = _nodeBackend.m_Cursor;
@@ -379,7 +430,7 @@ private:
     };
 
 
-    bool extract_block_from_row(json& out, uint64_t row, Height height) {
+    bool extract_block_from_row(json& out, Merkle::Hash& hash, uint64_t row, Height height) {
         NodeDB& db = _nodeBackend.get_DB();
 
         Block::SystemState::Full blockState;
@@ -491,12 +542,13 @@ private:
                 {"kernels",    kernels}
             };
 
+            hash = id.m_Hash;
             LOG_DEBUG() << out;
         }
         return ok;
     }
 
-    bool extract_block(json& out, Height height, uint64_t& row, uint64_t* prevRow) {
+    bool extract_block(json& out, Merkle::Hash& hash, Height height, uint64_t& row, uint64_t* prevRow) {
         bool ok = true;
         if (row == 0) {
             ok = extract_row(height, row, prevRow);
@@ -506,14 +558,33 @@ private:
                 *prevRow = 0;
             }
         }
-        return ok && extract_block_from_row(out, row, height);
+        return ok && extract_block_from_row(out, hash, row, height);
+    }
+
+    /// Renders the block json and puts it into the cache. Returns false if the block isn't available
+    bool render_block(io::SharedBuffer& body, Merkle::Hash& hash, Height height, uint64_t& row, uint64_t* prevRow) {
+        if (height > _cache.currentHeight) return false;
+
+        json j;
+        if (!extract_block(j, hash, height, row, prevRow)) return false;
+
+        _sm.clear();
+        bool ok = serialize_json_msg(_sm, _packer, j);
+        if (ok) {
+            body = io::normalize(_sm, false);
+            _cache.put_block(height, hash, body);
+        }
+        _sm.clear();
+        return ok;
     }
 
     bool get_block_impl(io::SerializedMsg& out, uint64_t height, uint64_t& row, uint64_t* prevRow) {
-        if (_cache.get_block(out, height)) {
-            if (prevRow && row > 0) {
-                extract_row(height, row, prevRow);
-            }
+        const ResponseCache::Block* pBlock = _cache.get_block(height);
+        if (pBlock) {
+            // stitched as is, no DB access. The rows chain is broken, the next miss will look it up
+            out.push_back(pBlock->body);
+            row = 0;
+            if (prevRow) *prevRow = 0;
             return true;
         }
 
@@ -523,24 +594,8 @@ private:
         }
 
         io::SharedBuffer body;
-        bool blockAvailable = (height <= _cache.currentHeight);
-        if (blockAvailable) {
-            json j;
-            if (!extract_block(j, height, row, prevRow)) {
-                blockAvailable = false;
-            } else {
-                _sm.clear();
-                if (serialize_json_msg(_sm, _packer, j)) {
-                    body = io::normalize(_sm, false);
-                    _cache.put_block(height, body);
-                } else {
-                    return false;
-                }
-                _sm.clear();
-            }
-        }
-
-        if (blockAvailable) {
+        Merkle::Hash hash;
+        if (render_block(body, hash, height, row, prevRow)) {
             out.push_back(body);
             return true;
         }
@@ -572,9 +627,7 @@ private:
     }
 
     bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) override {
-        static const uint64_t maxElements = 1500;
-        if (n > maxElements) n = maxElements;
-        else if (n==0) n=1;
+        clamp_blocks_range(n);
         Height endHeight = startHeight + n - 1;
         out.push_back(_leftBrace);
         uint64_t row = 0;
@@ -593,6 +646,42 @@ private:
         return true;
     }
 
+    static void format_etag(std::string& etag, const char* prefix, const Merkle::Hash& hv) {
+        char buf[Merkle::Hash::nTxtLen + 1];
+        hash_to_hex(buf, hv);
+
+        etag = "\"";
+        etag += prefix;
+        etag += buf;
+        etag += "\"";
+    }
+
+    bool get_block_etag(std::string& etag, uint64_t height) override {
+        const ResponseCache::Block* pBlock = _cache.get_block(height);
+        if (!pBlock) return false;
+
+        format_etag(etag, "b1-", pBlock->hash);
+        return true;
+    }
+
+    bool get_blocks_etag(std::string& etag, uint64_t startHeight, uint64_t n) override {
+        clamp_blocks_range(n);
+
+        ECC::Hash::Processor hp;
+        hp << startHeight << n;
+
+        for (uint64_t i = 0; i < n; i++) {
+            const ResponseCache::Block* pBlock = _cache.get_block(startHeight + i);
+            if (!pBlock) return false;
+            hp << pBlock->hash;
+        }
+
+        Merkle::Hash hv;
+        hp >> hv;
+        format_etag(etag, "bs1-", hv);
+        return true;
+    }
+
     bool get_peers(io::SerializedMsg& out) override
     {
         auto& peers = _node.get_AcessiblePeerAddrs();
@@ -641,6 +730,7 @@ private:
     Node::IObserver* _nextHook;
 
     ResponseCache _cache;
+    Height _prerenderedHeight = 0;
 
     io::SerializedMsg _sm;
 };
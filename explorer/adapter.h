@@ -38,6 +38,11 @@ struct IAdapter {
 
     virtual bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) = 0;
 
+    /// ETag for /block and /blocks responses. Returns false if unknown (not rendered yet), then the response shouldn't be tagged
+    virtual bool get_block_etag(std::string& etag, uint64_t height) = 0;
+
+    virtual bool get_blocks_etag(std::string& etag, uint64_t startHeight, uint64_t n) = 0;
+
     virtual bool get_peers(io::SerializedMsg& out) = 0;
 };
 
@@ -34,6 +34,8 @@ struct Options {
     static const unsigned logRotationPeriod = 3*60*60*1000; // 3 hours
     std::vector<uint32_t> whitelist;
     uint32_t logCleanupPeriod;
+    uint32_t ioThreads;
+    uint32_t readThreads;
 };
 
 static bool parse_cmdline(int argc, char* argv[], Options& o);
@@ -93,6 +95,8 @@ bool parse_cmdline(int argc, char* argv[], Options& o) {
         (cli::PASS, po::value<string>()->default_value(""), "password for owner key")
         (cli::IP_WHITELIST, po::value<std::string>()->default_value(""), "IP whitelist")
         (cli::LOG_CLEANUP_DAYS, po::value<uint32_t>()->default_value(5), "old logfiles cleanup period(days)")
+        (cli::IO_THREADS, po::value<uint32_t>()->default_value(0), "number of threads serving the node connections (0 = served by the node thread)")
+        (cli::READ_THREADS, po::value<uint32_t>()->default_value(0), "number of threads serving heavy read-only requests from db snapshots (0 = served by the node thread)")
     ;
 
     cliOptions.add(createRulesOptionsDescription());
@@ -130,6 +134,8 @@ bool parse_cmdline(int argc, char* argv[], Options& o) {
         o.nodeConnectTo = vm[cli::NODE_PEER].as<string>();
         o.nodeListenTo.port(vm[cli::PORT].as<uint16_t>());
         o.explorerListenTo.port(vm[API_PORT_PARAMETER].as<uint16_t>());
+        o.ioThreads = vm[cli::IO_THREADS].as<uint32_t>();
+        o.readThreads = vm[cli::READ_THREADS].as<uint32_t>();
 
         std::string keyOwner = vm[cli::KEY_OWNER].as<string>();
         if (!keyOwner.empty())
@@ -202,6 +208,8 @@ void setup_node(Node& node, const Options& o) {
     node.m_Cfg.m_Listen.ip(o.nodeListenTo.ip());
     node.m_Cfg.m_MiningThreads = 0;
     node.m_Cfg.m_VerificationThreads = -1;
+    node.m_Cfg.m_IoThreads = o.ioThreads;
+    node.m_Cfg.m_ReadThreads = o.readThreads;
 
     node.m_Keys.m_pOwner = o.ownerKey;
 
@@ -37,6 +37,27 @@ enum Dirs {
 
 } //namespace
 
+bool Server::etag_matches(const std::string& ifNoneMatch, const std::string& etag) {
+    std::string_view tag(etag);
+    if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+
+    for (size_t pos = 0; pos < ifNoneMatch.size(); ) {
+        size_t end = ifNoneMatch.find(',', pos);
+        if (end == std::string::npos) end = ifNoneMatch.size();
+
+        std::string_view token(ifNoneMatch.data() + pos, end - pos);
+        pos = end + 1;
+
+        while (!token.empty() && (token.front() == ' ' || token.front() == '\t')) token.remove_prefix(1);
+        while (!token.empty() && (token.back() == ' ' || token.back() == '\t')) token.remove_suffix(1);
+
+        if (token == "*") return true;
+        if (token.substr(0, 2) == "W/") token.remove_prefix(2);
+        if (!token.empty() && token == tag) return true;
+    }
+    return false;
+}
+
 Server::Server(IAdapter& adapter, io::Reactor& reactor, io::Address bindAddress, const std::string& keysFileName, const std::vector<uint32_t>& whitelist) :
     _msgCreator(2000),
     _backend(adapter),
@@ -117,6 +138,8 @@ bool Server::on_request(uint64_t id, const HttpMsgReader::Message& msg) {
 
     const HttpConnection::Ptr& conn = it->second;
 
+    _ifNoneMatch = msg.msg->get_header("If-None-Match");
+
     bool (Server::*func)(const HttpConnection::Ptr&) = 0;
 
     if (_currentUrl.parse(path, dirs)) {
@@ -188,9 +211,19 @@ bool Server::send_block(const HttpConnection::Ptr &conn) {
     else 
     {
         auto height = _currentUrl.get_int_arg("height", 0);
+
+        std::string etag;
+        if (_backend.get_block_etag(etag, height) && etag_matches(_ifNoneMatch, etag)) {
+            return send(conn, 304, "Not Modified", &etag);
+        }
+
         if (!_backend.get_block(_body, height)) {
             return send(conn, 500, "Internal error #2");
         }
+
+        if (_backend.get_block_etag(etag, height)) {
+            return send(conn, 200, "OK", &etag);
+        }
     }
 
     return send(conn, 200, "OK");
@@ -202,9 +235,20 @@ bool Server::send_blocks(const HttpConnection::Ptr& conn) {
     if (start <= 0 || n < 0) {
         return send(conn, 400, "Bad request");
     }
+
+    // unchanged range costs nothing: the tag is derived from the cached block hashes
+    std::string etag;
+    if (_backend.get_blocks_etag(etag, start, n) && etag_matches(_ifNoneMatch, etag)) {
+        return send(conn, 304, "Not Modified", &etag);
+    }
+
     if (!_backend.get_blocks(_body, start, n)) {
         return send(conn, 500, "Internal error #3");
     }
+
+    if (_backend.get_blocks_etag(etag, start, n)) {
+        return send(conn, 200, "OK", &etag);
+    }
     return send(conn, 200, "OK");
 }
 
@@ -215,18 +259,22 @@ bool Server::send_peers(const HttpConnection::Ptr& conn) {
     return send(conn, 200, "OK");
 }
 
-bool Server::send(const HttpConnection::Ptr& conn, int code, const char* message) {
+bool Server::send(const HttpConnection::Ptr& conn, int code, const char* message, const std::string* etag) {
     assert(conn);
 
     size_t bodySize = 0;
     for (const auto& f : _body) { bodySize += f.size; }
 
+    HeaderPair headers[] = {
+        { "ETag", etag ? etag->c_str() : "" }
+    };
+
     bool ok = _msgCreator.create_response(
         _headers,
         code,
         message,
-        0, //headers,
-        0, //sizeof(headers) / sizeof(HeaderPair),
+        etag ? headers : 0,
+        etag ? 1 : 0,
         1,
         "application/json",
         bodySize
@@ -244,7 +292,7 @@ bool Server::send(const HttpConnection::Ptr& conn, int code, const char* message
 
     _headers.clear();
     _body.clear();
-    return (ok && code == 200);
+    return (ok && (code == 200 || code == 304));
 }
 
 Server::IPAccessControl::IPAccessControl(const std::string &ipsFileName) :
@@ -28,6 +28,9 @@ class Server {
 public:
     Server(IAdapter& adapter, io::Reactor& reactor, io::Address bindAddress, const std::string& keysFileName, const std::vector<uint32_t>& whitelist);
 
+    /// If-None-Match: *, or a comma-separated list of entity tags, weak comparison (W/ prefix ignored)
+    static bool etag_matches(const std::string& ifNoneMatch, const std::string& etag);
+
 private:
     class IPAccessControl {
     public:
@@ -53,7 +56,7 @@ private:
     bool send_block(const HttpConnection::Ptr& conn);
     bool send_blocks(const HttpConnection::Ptr& conn);
     bool send_peers(const HttpConnection::Ptr& conn);
-    bool send(const HttpConnection::Ptr& conn, int code, const char* message);
+    bool send(const HttpConnection::Ptr& conn, int code, const char* message, const std::string* etag = nullptr);
 
     HttpMsgCreator _msgCreator;
     IAdapter& _backend;
@@ -65,6 +68,7 @@ private:
     HttpUrl _currentUrl;
     io::SerializedMsg _headers;
     io::SerializedMsg _body;
+    std::string _ifNoneMatch; // of the current request
     //AccessControl _acl;
     IPAccessControl _acl;
     std::vector<uint32_t> _whitelist;
@@ -13,8 +13,11 @@
 // limitations under the License.
 
 #include "explorer/adapter.h"
+#include "explorer/server.h"
+#include "http/http_client.h"
 #include "node/node.h"
 #include "utility/logger.h"
+#include "utility/io/timer.h"
 #include <future>
 #include <boost/filesystem.hpp>
 #include <wallet/core/common_utils.h>
@@ -34,6 +37,17 @@ struct NodeParams {
 };
 
 static const uint16_t NODE_PORT=20000;
+static const uint16_t EXPLORER_PORT=20001;
+
+int g_nErrors = 0;
+
+#define verify_test(x) \
+    do { \
+        if (!(x)) { \
+            LOG_ERROR() << "assertion failed: " #x " at " << __LINE__; \
+            ++g_nErrors; \
+        } \
+    } while (false)
 
 WaitHandle run_node(const NodeParams& params) {
     WaitHandle ret;
@@ -102,6 +116,243 @@ int test_adapter(int seconds) {
     return 0;
 }
 
+void test_etag_matches() {
+    using explorer::Server;
+
+    const std::string tag = "\"b1-aa\"";
+
+    verify_test(!Server::etag_matches("", tag));
+    verify_test(Server::etag_matches("*", tag));
+    verify_test(Server::etag_matches(tag, tag));
+    verify_test(Server::etag_matches("W/" + tag, tag));
+    verify_test(Server::etag_matches("\"x\", " + tag, tag));
+    verify_test(Server::etag_matches("\"x\",W/" + tag + " ,\"y\"", tag));
+    verify_test(Server::etag_matches("\"x\", *", tag));
+
+    // no partial matches
+    verify_test(!Server::etag_matches("\"b1-a\"", tag));
+    verify_test(!Server::etag_matches("\"b1-aaa\"", tag));
+    verify_test(!Server::etag_matches("b1-aa", tag));
+    verify_test(!Server::etag_matches("\"x\"" + tag, tag));
+    verify_test(!Server::etag_matches("\"x\", W/\"b1-aa", tag));
+}
+
+/// Block response cache, ETags and 304 via the explorer server, on a mining node.
+/// Runs in the node thread, advances by the timer
+struct CacheTest {
+    Node& _node;
+    explorer::IAdapter& _adapter;
+    io::Reactor& _reactor;
+    HttpClient _client;
+    io::Timer::Ptr _timer;
+
+    unsigned _step = 0;
+    unsigned _ticks = 0;
+    bool _pending = false;
+
+    // the last response
+    int _code = 0;
+    std::string _etag;
+    size_t _bodySize = 0;
+
+    std::string _etagBlock;
+    std::string _etagRange;
+    io::SharedBuffer _status;
+    Height _height = 0;
+
+    CacheTest(Node& node, explorer::IAdapter& adapter, io::Reactor& reactor) :
+        _node(node),
+        _adapter(adapter),
+        _reactor(reactor),
+        _client(reactor),
+        _timer(io::Timer::create(reactor))
+    {}
+
+    void run() {
+        _timer->start(50, true, [this]() { on_timer(); });
+        _reactor.run();
+        verify_test(_step == 10); // all done
+    }
+
+    Height get_height() {
+        return _node.get_Processor().m_Cursor.m_ID.m_Height;
+    }
+
+    std::string get_expected_etag(Height h) {
+        NodeDB& db = _node.get_Processor().get_DB();
+        Merkle::Hash hv;
+        db.get_StateHash(db.FindActiveStateStrict(h), hv);
+        return "\"b1-" + hv.str() + "\"";
+    }
+
+    io::SharedBuffer get_status() {
+        io::SerializedMsg msg;
+        verify_test(_adapter.get_status(msg));
+        return io::normalize(msg, true);
+    }
+
+    void request(const char* pathAndQuery, const std::string& ifNoneMatch) {
+        HeaderPair headers[] = {
+            { "If-None-Match", ifNoneMatch.c_str() }
+        };
+
+        HttpClient::Request r;
+        r.address(io::Address::localhost().port(EXPLORER_PORT))
+            .pathAndQuery(pathAndQuery)
+            .headers(headers)
+            .numHeaders(ifNoneMatch.empty() ? 0 : 1)
+            .callback([this](uint64_t, const HttpMsgReader::Message& msg) -> bool {
+                _pending = false;
+                _code = 0;
+                _etag.clear();
+                _bodySize = 0;
+                if (msg.what == HttpMsgReader::http_message) {
+                    _code = msg.msg->get_status();
+                    _etag = msg.msg->get_header("ETag");
+                    msg.msg->get_body(_bodySize);
+                }
+                return false;
+            });
+
+        _pending = true;
+        verify_test(_client.send_request(r));
+    }
+
+    void on_timer() {
+        if (++_ticks > 1200) {
+            LOG_ERROR() << "cache test timed out at step " << _step;
+            ++g_nErrors;
+            _reactor.stop();
+            return;
+        }
+
+        if (_pending) return;
+
+        Height h = get_height();
+
+        switch (_step) {
+        case 0: {
+            if (h < 3) return;
+
+            // rendered once, then served from the cache
+            io::SerializedMsg m1, m2;
+            verify_test(_adapter.get_block(m1, 2));
+            verify_test(_adapter.get_block(m2, 2));
+            verify_test(m1.size() == 1 && m2.size() == 1 && m1[0].data == m2[0].data);
+
+            std::string etag, etag2;
+            verify_test(_adapter.get_block_etag(etag, 2));
+            verify_test(etag == get_expected_etag(2));
+
+            m1.clear();
+            verify_test(_adapter.get_blocks(m1, 1, 2));
+            verify_test(_adapter.get_blocks_etag(etag, 1, 2));
+            verify_test(_adapter.get_blocks_etag(etag2, 1, 2) && (etag == etag2));
+            verify_test(_adapter.get_blocks_etag(etag2, 2, 1) && (etag != etag2));
+            verify_test(!_adapter.get_blocks_etag(etag2, h, 2)); // beyond the tip, unknown
+
+            _status = get_status();
+            _height = h;
+
+            request("/block?height=2", "");
+            break;
+        }
+
+        case 1:
+            verify_test(_code == 200 && _bodySize > 0);
+            verify_test(_etag == get_expected_etag(2));
+            _etagBlock = _etag;
+            request("/block?height=2", _etagBlock);
+            break;
+
+        case 2:
+            verify_test(_code == 304 && _bodySize == 0);
+            verify_test(_etag == _etagBlock);
+            request("/block?height=2", "\"x\", W/" + _etagBlock);
+            break;
+
+        case 3:
+            verify_test(_code == 304 && _bodySize == 0);
+            request("/block?height=2", "\"b1-\"");
+            break;
+
+        case 4:
+            verify_test(_code == 200 && _bodySize > 0);
+            request("/blocks?height=1&n=2", "");
+            break;
+
+        case 5:
+            verify_test(_code == 200 && _bodySize > 0 && !_etag.empty());
+            _etagRange = _etag;
+            request("/blocks?height=1&n=2", _etagRange);
+            break;
+
+        case 6:
+            verify_test(_code == 304 && _bodySize == 0);
+            break;
+
+        case 7: {
+            // new tip
+            if (h <= _height) return;
+
+            io::SharedBuffer status = get_status();
+            verify_test((status.size != _status.size) || memcmp(status.data, _status.data, status.size));
+
+            // rollback, the blocks above are invalidated, and replaced by the new ones
+            _node.get_Processor().ManualRollbackTo(1);
+            verify_test(get_height() == 1);
+
+            std::string etag;
+            verify_test(!_adapter.get_block_etag(etag, 2));
+            verify_test(!_adapter.get_blocks_etag(etag, 1, 2));
+            break;
+        }
+
+        case 8:
+            if (h < 2) return;
+            request("/block?height=2", _etagBlock);
+            break;
+
+        case 9:
+            verify_test(_code == 200 && _bodySize > 0);
+            verify_test(!_etag.empty() && (_etag != _etagBlock));
+            verify_test(_etag == get_expected_etag(2));
+            _reactor.stop();
+            break;
+        }
+
+        _step++;
+    }
+};
+
+void test_cache() {
+    cleanup_files();
+
+    io::Reactor::Ptr reactor = io::Reactor::create();
+    io::Reactor::Scope scope(*reactor);
+
+    Node node;
+    node.m_Cfg.m_Listen.port(NODE_PORT);
+    node.m_Cfg.m_Listen.ip(INADDR_ANY);
+    node.m_Cfg.m_MiningThreads = 1;
+    node.m_Cfg.m_VerificationThreads = 1;
+    node.m_Cfg.m_TestMode.m_FakePowSolveTime_ms = 100;
+
+    ECC::uintBig seed;
+    ECC::Hash::Processor()
+        << Blob("yyy", 3)
+        >> seed;
+    node.m_Keys.InitSingleKey(seed);
+
+    explorer::IAdapter::Ptr adapter = explorer::create_adapter(node);
+    node.Initialize();
+
+    explorer::Server server(*adapter, *reactor, io::Address::localhost().port(EXPLORER_PORT), "", {});
+
+    CacheTest t(node, *adapter, *reactor);
+    t.run();
+}
+
 } //namespace
 
 int main(int argc, char* argv[]) {
@@ -122,6 +373,8 @@ int main(int argc, char* argv[]) {
     ECC::InitializeContext();
     Rules::get().DA.Target_s = 1; // 1 minute
     Rules::get().DA.Difficulty0 = 1;
+    Rules::get().TreasuryChecksum = Zero; // no treasury, mined from the genesis
+    Rules::get().UpdateChecksum();
 
     int seconds = 0;
     if (argc > 1) {
@@ -132,7 +385,10 @@ int main(int argc, char* argv[]) {
         Rules::get().FakePoW = true;
     }
 
+    test_etag_matches();
+    test_cache();
+
     int ret = test_adapter(seconds);
-    return ret;
+    return ret ? ret : (g_nErrors ? -1 : 0);
 }
 
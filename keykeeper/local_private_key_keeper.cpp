@@ -25,10 +25,17 @@ namespace beam::wallet
     /////////////////////////
     // LocalPrivateKeyKeeper2
     LocalPrivateKeyKeeper2::LocalPrivateKeyKeeper2(const Key::IKdf::Ptr& pKdf)
-        :m_pKdf(pKdf)
+        :m_pExecutor(get_SharedExecutor())
+        ,m_pKdf(pKdf)
     {
     }
 
+    const std::shared_ptr<ExecutorMT>& LocalPrivateKeyKeeper2::get_SharedExecutor()
+    {
+        static const std::shared_ptr<ExecutorMT> s_pExec = std::make_shared<ExecutorMT>();
+        return s_pExec;
+    }
+
     IPrivateKeyKeeper2::Status::Type LocalPrivateKeyKeeper2::ToImage(Point::Native& res, uint32_t iGen, const Scalar::Native& sk)
     {
         const Generator::Obscured* pGen;
@@ -315,8 +322,7 @@ namespace beam::wallet
         x.m_pKernel->UpdateMsg();
         x.get_SkOut(prover.m_Witness.V.m_R_Output, x.m_pKernel->m_Fee, *m_pKdf);
 
-        ExecutorMT exec;
-        Executor::Scope scope(exec);
+        Executor::Scope scope(*m_pExecutor);
         x.m_pKernel->Sign(prover, x.m_AssetID);
 
         return Status::Success;
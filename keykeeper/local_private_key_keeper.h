@@ -16,6 +16,7 @@
 
 #include "wallet/core/private_key_keeper.h"
 #include "wallet/core/variables_db.h"
+#include "utility/executor.h"
 #include <utility>
 
 namespace beam::wallet
@@ -41,6 +42,13 @@ namespace beam::wallet
         KEY_KEEPER_METHODS(THE_MACRO)
 #undef THE_MACRO
 
+        // Executor for the proof generation (shielded inputs). Its threads are kept alive between the proofs, and several proofs
+        // (from different keykeepers/threads) may run on it concurrently. By default the process-wide shared executor is used.
+        std::shared_ptr<Executor> m_pExecutor;
+
+        // thread count may be adjusted via set_Threads() before the proofs are generated
+        static const std::shared_ptr<ExecutorMT>& get_SharedExecutor();
+
     protected:
 
         ECC::Key::IKdf::Ptr m_pKdf;
@@ -0,0 +1,565 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bbs_store.h"
+#include "../core/proto.h"
+#include "../utility/logger.h"
+#include <boost/filesystem.hpp>
+
+namespace beam {
+
+namespace
+{
+	// on-disk record header, followed by the message body
+	struct RecHdr
+	{
+		uint64_t m_ID;
+		uint64_t m_Time;
+		uint64_t m_Channel;
+		BbsStore::Key m_Key;
+		uint32_t m_Nonce;
+		uint32_t m_Size;
+	};
+
+	static_assert(sizeof(RecHdr) == 64, "");
+
+	const char s_szSegmentExt[] = ".seg";
+	const char s_szLastID[] = "last_id";
+
+	boost::filesystem::path PathFromUtf8(const std::string& s)
+	{
+#ifdef WIN32
+		return boost::filesystem::path(Utf8toUtf16(s.c_str()));
+#else // WIN32
+		return boost::filesystem::path(s);
+#endif // WIN32
+	}
+
+	FILE* OpenFile(const std::string& s, const char* szMode)
+	{
+#ifdef WIN32
+		std::wstring wsMode(szMode, szMode + strlen(szMode));
+		return _wfopen(Utf8toUtf16(s.c_str()).c_str(), wsMode.c_str());
+#else // WIN32
+		return fopen(s.c_str(), szMode);
+#endif // WIN32
+	}
+
+	void SeekFile(FILE* pF, uint64_t nOffset)
+	{
+#ifdef WIN32
+		int ret = _fseeki64(pF, nOffset, SEEK_SET);
+#else // WIN32
+		int ret = fseeko(pF, nOffset, SEEK_SET);
+#endif // WIN32
+		if (ret)
+			std::ThrowSystemError(errno);
+	}
+
+	void ReadFile(FILE* pF, void* p, size_t n)
+	{
+		if (fread(p, 1, n, pF) != n)
+			throw std::runtime_error("bbs segment underflow");
+	}
+}
+
+size_t BbsStore::KeyHash::operator()(const Key& key) const
+{
+	// the key is a hash already
+	size_t ret;
+	memcpy(&ret, key.m_pData, sizeof(ret));
+	return ret;
+}
+
+BbsStore::BbsStore()
+	:m_LastID(0)
+{
+	ZeroObject(m_Totals);
+}
+
+BbsStore::~BbsStore()
+{
+	Close();
+}
+
+void BbsStore::Close()
+{
+	while (!m_Segments.empty())
+	{
+		Segment& s = m_Segments.begin()->second;
+		for (size_t i = 0; i < s.m_vMsgs.size(); i++)
+		{
+			Msg& m = *s.m_vMsgs[i];
+			m_IDs.erase(IDSet::s_iterator_to(m.m_ID));
+			m_CSeqs.erase(CSeqSet::s_iterator_to(m.m_CSeq));
+		}
+
+		CloseFile(s);
+		m_Segments.erase(m_Segments.begin());
+	}
+
+	m_Msgs.clear();
+	m_sDir.clear();
+	m_LastID = 0;
+	ZeroObject(m_Totals);
+}
+
+void BbsStore::Destroy(const char* szDir)
+{
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(PathFromUtf8(szDir), ec);
+}
+
+void BbsStore::get_SegmentPath(std::string& sPath, Timestamp t) const
+{
+	sPath = m_sDir;
+	sPath += '/';
+	sPath += std::to_string(t);
+	sPath += s_szSegmentExt;
+}
+
+void BbsStore::get_LastIDPath(std::string& sPath) const
+{
+	sPath = m_sDir;
+	sPath += '/';
+	sPath += s_szLastID;
+}
+
+void BbsStore::LoadLastID()
+{
+	std::string sPath;
+	get_LastIDPath(sPath);
+
+	FILE* pF = OpenFile(sPath, "rb");
+	if (!pF)
+		return;
+
+	uint64_t nID = 0;
+	if (fread(&nID, 1, sizeof(nID), pF) == sizeof(nID))
+		std::setmax(m_LastID, nID);
+
+	fclose(pF);
+}
+
+void BbsStore::SaveLastID()
+{
+	std::string sPath, sTmp;
+	get_LastIDPath(sPath);
+	sTmp = sPath + ".tmp";
+
+	FILE* pF = OpenFile(sTmp, "wb");
+	if (!pF)
+		std::ThrowSystemError(errno);
+
+	bool bOk =
+		(fwrite(&m_LastID, 1, sizeof(m_LastID), pF) == sizeof(m_LastID)) &&
+		!fflush(pF);
+
+	int nErr = errno;
+	fclose(pF);
+
+	if (!bOk)
+		std::ThrowSystemError(nErr);
+
+	boost::filesystem::rename(PathFromUtf8(sTmp), PathFromUtf8(sPath));
+}
+
+FILE* BbsStore::get_File(Segment& s)
+{
+	if (s.m_pF)
+	{
+		m_lstOpen.erase(m_lstOpen.iterator_to(s.m_Open));
+		m_lstOpen.push_back(s.m_Open);
+		return s.m_pF;
+	}
+
+	while (!m_lstOpen.empty() && (m_lstOpen.size() >= std::max(m_MaxOpenFiles, 1U)))
+		CloseFile(m_lstOpen.front().get_ParentObj());
+
+	std::string sPath;
+	get_SegmentPath(sPath, s.m_Key);
+
+	s.m_pF = OpenFile(sPath, "a+b");
+	if (!s.m_pF)
+		std::ThrowSystemError(errno);
+
+	m_lstOpen.push_back(s.m_Open);
+	return s.m_pF;
+}
+
+void BbsStore::CloseFile(Segment& s)
+{
+	if (!s.m_pF)
+		return;
+
+	m_lstOpen.erase(m_lstOpen.iterator_to(s.m_Open));
+	fclose(s.m_pF);
+	s.m_pF = nullptr;
+}
+
+void BbsStore::Open(const char* szDir)
+{
+	Close();
+
+	boost::filesystem::path pathDir = PathFromUtf8(szDir);
+	boost::filesystem::create_directories(pathDir);
+	m_sDir = szDir;
+
+	std::vector<Timestamp> vKeys;
+
+	for (boost::filesystem::directory_iterator it(pathDir), itEnd; itEnd != it; it++)
+	{
+		const boost::filesystem::path& p = it->path();
+		if (p.extension().string() != s_szSegmentExt)
+			continue;
+
+		std::string sStem = p.stem().string();
+		if (sStem.empty() || (sStem.find_first_not_of("0123456789") != std::string::npos))
+			continue;
+
+		vKeys.push_back(std::stoull(sStem));
+	}
+
+	std::sort(vKeys.begin(), vKeys.end());
+
+	std::string sPath;
+	for (size_t i = 0; i < vKeys.size(); i++)
+	{
+		get_SegmentPath(sPath, vKeys[i]);
+		LoadSegment(vKeys[i], sPath);
+	}
+
+	LoadLastID();
+
+	if (!m_Segments.empty())
+		LOG_INFO() << "Bbs store: " << m_Totals.m_Count << " messages, " << m_Segments.size() << " segments";
+}
+
+void BbsStore::LoadSegment(Timestamp key, const std::string& sPath)
+{
+	uint64_t nSizeGood = 0;
+	uint64_t nSizeFile = 0;
+	std::vector<RecHdr> vRecs;
+
+	{
+		FILE* pF = OpenFile(sPath, "rb");
+		if (!pF)
+			std::ThrowSystemError(errno);
+
+		nSizeFile = boost::filesystem::file_size(PathFromUtf8(sPath));
+
+		try
+		{
+			uint64_t nIDPrev = 0;
+			while (nSizeGood + sizeof(RecHdr) <= nSizeFile)
+			{
+				RecHdr hdr;
+				SeekFile(pF, nSizeGood);
+				ReadFile(pF, &hdr, sizeof(hdr));
+
+				if ((hdr.m_Size > proto::Bbs::s_MaxMsgSize) ||
+					(hdr.m_ID <= nIDPrev) ||
+					(nSizeGood + sizeof(RecHdr) + hdr.m_Size > nSizeFile))
+					break; // torn or corrupted tail
+
+				nIDPrev = hdr.m_ID;
+				vRecs.push_back(hdr);
+				nSizeGood += sizeof(RecHdr) + hdr.m_Size;
+			}
+		}
+		catch (const std::exception&)
+		{
+		}
+
+		fclose(pF);
+	}
+
+	if (vRecs.empty())
+	{
+		beam::DeleteFile(sPath.c_str());
+		return;
+	}
+
+	if (nSizeGood != nSizeFile)
+	{
+		LOG_WARNING() << "Bbs segment " << sPath << " truncated from " << nSizeFile << " to " << nSizeGood;
+		boost::filesystem::resize_file(PathFromUtf8(sPath), nSizeGood);
+	}
+
+	Segment& s = m_Segments[key];
+	s.m_Key = key;
+	s.m_Size = nSizeGood;
+
+	uint64_t nOffset = 0;
+	for (size_t i = 0; i < vRecs.size(); i++)
+	{
+		const RecHdr& hdr = vRecs[i];
+		if (m_Msgs.end() == m_Msgs.find(hdr.m_Key)) // duplicates are possible only if the files were tampered with
+			AddMsg(s, hdr.m_Key, hdr.m_ID, hdr.m_Channel, hdr.m_Time, hdr.m_Size, nOffset);
+
+		nOffset += sizeof(RecHdr) + hdr.m_Size;
+	}
+}
+
+BbsStore::Segment& BbsStore::OpenSegment(Timestamp t)
+{
+	Timestamp nPeriod = std::max<Timestamp>(m_SegmentPeriod_s, 1);
+	Timestamp key = t - t % nPeriod;
+
+	SegmentMap::iterator it = m_Segments.find(key);
+	if (m_Segments.end() != it)
+		return it->second;
+
+	Segment& s = m_Segments[key];
+	s.m_Key = key;
+
+	try
+	{
+		get_File(s); // create it
+	}
+	catch (const std::exception&)
+	{
+		m_Segments.erase(key);
+		throw;
+	}
+
+	return s;
+}
+
+void BbsStore::DeleteSegment(SegmentMap::iterator it)
+{
+	Segment& s = it->second;
+
+	// the segment may contain the highest ID
+	SaveLastID();
+
+	for (size_t i = 0; i < s.m_vMsgs.size(); i++)
+	{
+		Msg& m = *s.m_vMsgs[i];
+
+		m_IDs.erase(IDSet::s_iterator_to(m.m_ID));
+		m_CSeqs.erase(CSeqSet::s_iterator_to(m.m_CSeq));
+		m_Msgs.erase(*m.m_pKey); // m is destroyed
+	}
+
+	m_Totals.m_Count -= s.m_Totals.m_Count;
+	m_Totals.m_Size -= s.m_Totals.m_Size;
+
+	CloseFile(s);
+
+	std::string sPath;
+	get_SegmentPath(sPath, s.m_Key);
+	beam::DeleteFile(sPath.c_str());
+
+	m_Segments.erase(it);
+}
+
+BbsStore::Msg* BbsStore::AddMsg(Segment& s, const Key& key, uint64_t nID, BbsChannel ch, Timestamp t, uint32_t nSize, uint64_t nOffset)
+{
+	MsgMap::iterator it = m_Msgs.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple()).first;
+	Msg& m = it->second;
+
+	m.m_pKey = &it->first;
+	m.m_pSeg = &s;
+	m.m_Offset = nOffset;
+	m.m_Time = t;
+	m.m_Size = nSize;
+	m.m_ID.m_Value = nID;
+	m.m_CSeq.m_Channel = ch;
+	m.m_CSeq.m_ID = nID;
+
+	m.m_TimeMaxPrefix = s.m_vMsgs.empty() ? t : std::max(t, s.m_vMsgs.back()->m_TimeMaxPrefix);
+
+	m_IDs.insert(m.m_ID);
+	m_CSeqs.insert(m.m_CSeq);
+	s.m_vMsgs.push_back(&m);
+
+	if (s.m_Totals.m_Count)
+	{
+		std::setmin(s.m_TimeMin, t);
+		std::setmax(s.m_TimeMax, t);
+	}
+	else
+		s.m_TimeMin = s.m_TimeMax = t;
+
+	s.m_Totals.m_Count++;
+	s.m_Totals.m_Size += nSize;
+	m_Totals.m_Count++;
+	m_Totals.m_Size += nSize;
+
+	std::setmax(m_LastID, nID);
+	return &m;
+}
+
+uint64_t BbsStore::BbsIns(const Data& d)
+{
+	assert(IsOpen());
+	assert(m_Msgs.end() == m_Msgs.find(d.m_Key));
+
+	Segment& s = OpenSegment(d.m_TimePosted);
+	FILE* pF = get_File(s);
+
+	RecHdr hdr;
+	hdr.m_ID = m_LastID + 1;
+	hdr.m_Time = d.m_TimePosted;
+	hdr.m_Channel = d.m_Channel;
+	hdr.m_Key = d.m_Key;
+	hdr.m_Nonce = d.m_Nonce;
+	hdr.m_Size = d.m_Message.n;
+
+	// in append mode all the writes go to the end, regardless to the current position.
+	// The seek is still needed to switch the stream from reading to writing.
+	if (fseek(pF, 0, SEEK_END) ||
+		(fwrite(&hdr, 1, sizeof(hdr), pF) != sizeof(hdr)) ||
+		(fwrite(d.m_Message.p, 1, d.m_Message.n, pF) != d.m_Message.n) ||
+		fflush(pF))
+		std::ThrowSystemError(errno);
+
+	uint64_t nOffset = s.m_Size;
+	s.m_Size += sizeof(hdr) + d.m_Message.n;
+
+	AddMsg(s, d.m_Key, hdr.m_ID, d.m_Channel, d.m_TimePosted, d.m_Message.n, nOffset);
+	return hdr.m_ID;
+}
+
+void BbsStore::ReadMsg(const Msg& m, WalkerBbs& x)
+{
+	FILE* pF = get_File(*m.m_pSeg);
+
+	RecHdr hdr;
+	SeekFile(pF, m.m_Offset);
+	ReadFile(pF, &hdr, sizeof(hdr));
+
+	if ((hdr.m_ID != m.m_ID.m_Value) || (hdr.m_Size != m.m_Size))
+		throw std::runtime_error("bbs segment corrupted");
+
+	x.m_Buf.resize(hdr.m_Size);
+	if (hdr.m_Size)
+		ReadFile(pF, &x.m_Buf.front(), hdr.m_Size);
+
+	x.m_ID = hdr.m_ID;
+	x.m_Data.m_Key = hdr.m_Key;
+	x.m_Data.m_Channel = hdr.m_Channel;
+	x.m_Data.m_TimePosted = hdr.m_Time;
+	x.m_Data.m_Nonce = hdr.m_Nonce;
+	x.m_Data.m_Message = Blob(x.m_Buf);
+}
+
+bool BbsStore::BbsFind(WalkerBbs& x)
+{
+	MsgMap::iterator it = m_Msgs.find(x.m_Data.m_Key);
+	if (m_Msgs.end() == it)
+		return false;
+
+	ReadMsg(it->second, x);
+	return true;
+}
+
+uint64_t BbsStore::BbsFind(const Key& key)
+{
+	MsgMap::iterator it = m_Msgs.find(key);
+	return (m_Msgs.end() == it) ? 0 : it->second.m_ID.m_Value;
+}
+
+void BbsStore::EnumBbsCSeq(WalkerBbs& x)
+{
+	x.m_pThis = this;
+}
+
+bool BbsStore::WalkerBbs::MoveNext()
+{
+	assert(m_pThis);
+
+	Msg::CSeq key;
+	key.m_Channel = m_Data.m_Channel;
+	key.m_ID = m_ID;
+
+	CSeqSet::iterator it = m_pThis->m_CSeqs.upper_bound(key);
+	if ((m_pThis->m_CSeqs.end() == it) || (it->m_Channel != m_Data.m_Channel))
+		return false;
+
+	m_pThis->ReadMsg(it->get_ParentObj(), *this);
+	return true;
+}
+
+void BbsStore::EnumAllBbsSeq(WalkerBbsLite& x)
+{
+	x.m_pThis = this;
+}
+
+bool BbsStore::WalkerBbsLite::MoveNext()
+{
+	assert(m_pThis);
+
+	Msg::ID key;
+	key.m_Value = m_ID;
+
+	IDSet::iterator it = m_pThis->m_IDs.upper_bound(key);
+	if (m_pThis->m_IDs.end() == it)
+		return false;
+
+	const Msg& m = it->get_ParentObj();
+	m_ID = m.m_ID.m_Value;
+	m_Key = *m.m_pKey;
+	m_Size = m.m_Size;
+	return true;
+}
+
+uint64_t BbsStore::BbsFindCursor(Timestamp t)
+{
+	// lowest ID of a message posted at t or later
+	uint64_t ret = m_LastID + 1;
+
+	for (SegmentMap::iterator it = m_Segments.begin(); m_Segments.end() != it; it++)
+	{
+		const Segment& s = it->second;
+		if (s.m_TimeMax < t)
+			continue;
+
+		// messages within a segment are in ID order. The first one whose prefix max time reaches t is the first one posted at t or later
+		auto itMsg = std::lower_bound(s.m_vMsgs.begin(), s.m_vMsgs.end(), t, [](const Msg* p, Timestamp t_) { return p->m_TimeMaxPrefix < t_; });
+		assert(s.m_vMsgs.end() != itMsg); // since m_TimeMax >= t
+
+		std::setmin(ret, (*itMsg)->m_ID.m_Value);
+	}
+
+	return ret;
+}
+
+Timestamp BbsStore::get_BbsMaxTime() const
+{
+	Timestamp ret = 0;
+	for (SegmentMap::const_iterator it = m_Segments.begin(); m_Segments.end() != it; it++)
+		std::setmax(ret, it->second.m_TimeMax);
+	return ret;
+}
+
+void BbsStore::Cleanup(Timestamp tsExpired, const Totals& lims)
+{
+	while (!m_Segments.empty())
+	{
+		SegmentMap::iterator it = m_Segments.begin();
+
+		bool bInLimits =
+			(m_Totals.m_Count <= lims.m_Count) &&
+			(m_Totals.m_Size <= lims.m_Size);
+
+		if (bInLimits && (it->second.m_TimeMax >= tsExpired))
+			break;
+
+		DeleteSegment(it);
+	}
+}
+
+} // namespace beam
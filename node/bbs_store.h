@@ -0,0 +1,176 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "db.h"
+#include <unordered_map>
+#include <boost/intrusive/set.hpp>
+#include <boost/intrusive/list.hpp>
+
+namespace beam {
+
+// Append-only BBS message store, kept apart from the node DB.
+// Messages are grouped into segment files by their posted time (one file per m_SegmentPeriod_s bucket), and are never
+// modified or deleted individually. Expiration removes the whole segment, once all its messages are stale (or to fit the limits).
+// All the indexes (by key, by ID, by channel) are in-memory, rebuilt on open by scanning the segments.
+// The highest assigned ID is saved separately when segments are deleted, so that IDs are never reused.
+class BbsStore
+{
+public:
+
+	typedef NodeDB::WalkerBbs::Key Key;
+	typedef NodeDB::WalkerBbs::Data Data;
+	typedef NodeDB::BbsTotals Totals;
+
+	Timestamp m_SegmentPeriod_s = 3600;
+	uint32_t m_MaxOpenFiles = 16; // segment files are opened on demand, the least recently used are closed
+
+	BbsStore();
+	~BbsStore();
+
+	void Open(const char* szDir);
+	void Close();
+	bool IsOpen() const { return !m_sDir.empty(); }
+
+	static void Destroy(const char* szDir); // deletes all the files
+
+	struct WalkerBbs
+	{
+		uint64_t m_ID;
+		Data m_Data;
+
+		bool MoveNext();
+
+		BbsStore* m_pThis = nullptr;
+		ByteBuffer m_Buf;
+	};
+
+	void EnumBbsCSeq(WalkerBbs&); // set channel and ID before invocation
+	uint64_t BbsIns(const Data&); // must be unique (if not sure - first try to find it). Returns the ID
+	bool BbsFind(WalkerBbs&); // set Key
+	uint64_t BbsFind(const Key&);
+	uint64_t BbsFindCursor(Timestamp);
+	Timestamp get_BbsMaxTime() const;
+	uint64_t get_BbsLastID() const { return m_LastID; }
+	void get_BbsTotals(Totals& x) const { x = m_Totals; }
+
+	struct WalkerBbsLite
+	{
+		uint64_t m_ID;
+		Key m_Key;
+		uint32_t m_Size;
+
+		bool MoveNext();
+
+		BbsStore* m_pThis = nullptr;
+	};
+
+	void EnumAllBbsSeq(WalkerBbsLite&); // ordered by m_ID. Must be initialized to specify the lower bound
+
+	// Deletes the oldest segments while they're either completely expired, or the limits are exceeded
+	void Cleanup(Timestamp tsExpired, const Totals& lims);
+
+	uint32_t get_Segments() const { return static_cast<uint32_t>(m_Segments.size()); }
+
+private:
+
+	struct Segment;
+
+	struct Msg
+	{
+		struct ID
+			:public boost::intrusive::set_base_hook<>
+		{
+			uint64_t m_Value;
+			bool operator < (const ID& x) const { return m_Value < x.m_Value; }
+
+			IMPLEMENT_GET_PARENT_OBJ(Msg, m_ID)
+		} m_ID;
+
+		struct CSeq
+			:public boost::intrusive::set_base_hook<>
+		{
+			BbsChannel m_Channel;
+			uint64_t m_ID;
+
+			bool operator < (const CSeq& x) const {
+				if (m_Channel != x.m_Channel)
+					return m_Channel < x.m_Channel;
+				return m_ID < x.m_ID;
+			}
+
+			IMPLEMENT_GET_PARENT_OBJ(Msg, m_CSeq)
+		} m_CSeq;
+
+		const Key* m_pKey;
+		Segment* m_pSeg;
+		uint64_t m_Offset;
+		Timestamp m_Time;
+		Timestamp m_TimeMaxPrefix; // max time of this and the preceding messages in the segment. Monotonic, allows binary search
+		uint32_t m_Size;
+	};
+
+	struct Segment
+	{
+		Timestamp m_Key = 0;
+		uint64_t m_Size = 0; // file size
+		Timestamp m_TimeMin = 0;
+		Timestamp m_TimeMax = 0;
+		Totals m_Totals;
+
+		std::vector<Msg*> m_vMsgs; // in ID order
+
+		FILE* m_pF = nullptr; // if open
+		struct Open
+			:public boost::intrusive::list_base_hook<>
+		{
+			IMPLEMENT_GET_PARENT_OBJ(Segment, m_Open)
+		} m_Open;
+
+		Segment() { ZeroObject(m_Totals); }
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key&) const;
+	};
+
+	typedef std::unordered_map<Key, Msg, KeyHash> MsgMap;
+	typedef boost::intrusive::set<Msg::ID> IDSet;
+	typedef boost::intrusive::set<Msg::CSeq> CSeqSet;
+	typedef std::map<Timestamp, Segment> SegmentMap;
+
+	std::string m_sDir;
+	MsgMap m_Msgs;
+	IDSet m_IDs;
+	CSeqSet m_CSeqs;
+	SegmentMap m_Segments;
+	boost::intrusive::list<Segment::Open> m_lstOpen; // the most recently used at the back
+	uint64_t m_LastID;
+	Totals m_Totals;
+
+	void get_SegmentPath(std::string&, Timestamp) const;
+	void get_LastIDPath(std::string&) const;
+	void LoadLastID();
+	void SaveLastID();
+	FILE* get_File(Segment&);
+	void CloseFile(Segment&);
+	Segment& OpenSegment(Timestamp);
+	void LoadSegment(Timestamp, const std::string&);
+	void DeleteSegment(SegmentMap::iterator);
+	Msg* AddMsg(Segment&, const Key&, uint64_t nID, BbsChannel, Timestamp, uint32_t nSize, uint64_t nOffset);
+	void ReadMsg(const Msg&, WalkerBbs&);
+};
+
+} // namespace beam
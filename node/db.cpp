@@ -154,6 +154,8 @@ void NodeDB::Statement::Close()
 
 void NodeDB::Close()
 {
+	m_TxoPending.Clear();
+
 	if (m_pDb)
 	{
 		for (size_t i = 0; i < _countof(m_pPrep); i++)
@@ -325,13 +327,24 @@ const void* NodeDB::Recordset::get_BlobStrict(int col, uint32_t n)
 	return x.p;
 }
 
-void NodeDB::Open(const char* szPath)
+void NodeDB::Open(const char* szPath, bool bSharedRead /* = false */)
 {
 	TestRet(sqlite3_open_v2(szPath, &m_pDb, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_CREATE, NULL));
 	// Attempt to fix the "busy" error when PC goes to sleep and then awakes. Try the busy handler with non-zero timeout (maybe a single retry would be enough)
 	sqlite3_busy_timeout(m_pDb, 5000);
 
-	ExecTextOut("PRAGMA locking_mode = EXCLUSIVE");
+	if (bSharedRead)
+	{
+		// readers don't block the writer (and vice versa), they see the last committed state
+		if (ExecTextOut("PRAGMA journal_mode = WAL") != "wal")
+			ThrowError("WAL mode not supported");
+	}
+	else
+	{
+		ExecTextOut("PRAGMA locking_mode = EXCLUSIVE");
+		ExecTextOut("PRAGMA journal_mode = DELETE"); // WAL mode is persistent, revert it if the previous run used shared read
+	}
+
 	ExecTextOut("PRAGMA journal_size_limit=1048576"); // limit journal file, otherwise it may remain huge even after tx commit, until the app is closed
 
 	bool bCreate;
@@ -398,6 +411,12 @@ void NodeDB::Open(const char* szPath)
 	t.Commit();
 }
 
+void NodeDB::OpenReader(const char* szPath)
+{
+	TestRet(sqlite3_open_v2(szPath, &m_pDb, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL));
+	sqlite3_busy_timeout(m_pDb, 5000);
+}
+
 void NodeDB::CheckIntegrity()
 {
 	std::string s = ExecTextOut("PRAGMA integrity_check");
@@ -740,6 +759,7 @@ void NodeDB::Transaction::Start(NodeDB& db)
 void NodeDB::Transaction::Commit()
 {
 	assert(m_pDB);
+	m_pDB->TxoFlush();
 	m_pDB->ExecStep(Query::Commit, "COMMIT");
 	m_pDB = NULL;
 }
@@ -748,6 +768,7 @@ void NodeDB::Transaction::Rollback()
 {
 	if (m_pDB)
 	{
+		m_pDB->m_TxoPending.Clear();
 		m_pDB->ExecStep(Query::Rollback, "ROLLBACK");
 		m_pDB = nullptr;
 	}
@@ -1966,6 +1987,13 @@ void NodeDB::BbsDel(uint64_t id)
 	TestChanged1Row();
 }
 
+void NodeDB::BbsDelUpTo(uint64_t id)
+{
+	Recordset rs(*this, Query::BbsDelUpTo, "DELETE FROM " TblBbs " WHERE " TblBbs_ID "<=?");
+	rs.put(0, id);
+	rs.Step();
+}
+
 uint64_t NodeDB::BbsIns(const WalkerBbs::Data& d)
 {
 	Recordset rs(*this, Query::BbsIns, "INSERT INTO " TblBbs "(" TblBbs_InsFieldsListed ") VALUES(?,?,?,?,?)");
@@ -2133,16 +2161,169 @@ Height NodeDB::FindBlock(const Blob& hash)
     return h;
 }
 
+#define TblTxo_InsFields "INSERT INTO " TblTxo "(" TblTxo_ID "," TblTxo_Value "," TblTxo_SpendHeight ") VALUES"
+
+void NodeDB::TxoPending::Add(TxoID id, const Blob& b)
+{
+	assert(m_vID.empty() || (m_vID.back() < id));
+
+	m_vID.push_back(id);
+	m_vSpend.push_back(MaxHeight);
+
+	if (b.n)
+	{
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(b.p);
+		m_Values.insert(m_Values.end(), p, p + b.n);
+	}
+	m_vEnd.push_back(static_cast<uint32_t>(m_Values.size()));
+}
+
+void NodeDB::TxoPending::Clear()
+{
+	m_vID.clear();
+	m_vSpend.clear();
+	m_vEnd.clear();
+	m_Values.clear();
+	m_vSpent.clear();
+}
+
+bool NodeDB::TxoPending::Find(size_t& i, TxoID id) const
+{
+	auto it = std::lower_bound(m_vID.begin(), m_vID.end(), id);
+	if ((m_vID.end() == it) || (*it != id))
+		return false;
+
+	i = it - m_vID.begin();
+	return true;
+}
+
+void NodeDB::TxoPending::TrimFrom(TxoID id)
+{
+	size_t n = std::lower_bound(m_vID.begin(), m_vID.end(), id) - m_vID.begin();
+
+	m_vID.resize(n);
+	m_vSpend.resize(n);
+	m_vEnd.resize(n);
+	m_Values.resize(n ? m_vEnd.back() : 0);
+}
+
+Blob NodeDB::TxoPending::get_Value(size_t i) const
+{
+	uint32_t n0 = i ? m_vEnd[i - 1] : 0;
+	uint32_t n = m_vEnd[i] - n0;
+	return Blob(n ? &m_Values[n0] : nullptr, n);
+}
+
+void NodeDB::TxoPut(Recordset& rs, int col, size_t i)
+{
+	rs.put(col, m_TxoPending.m_vID[i]);
+	rs.put(col + 1, m_TxoPending.get_Value(i));
+
+	Height h = m_TxoPending.m_vSpend[i];
+	if (MaxHeight != h)
+		rs.put(col + 2, h);
+}
+
+bool NodeDB::IsTxoWriteBehind()
+{
+	return m_TxoPendingMax && !sqlite3_get_autocommit(m_pDb);
+}
+
+void NodeDB::TxoFlush()
+{
+	const uint32_t nBatch = TxoPending::s_RowsPerStatement;
+	const size_t nRows = m_TxoPending.m_vID.size();
+	size_t i = 0;
+
+	if (nRows >= nBatch)
+	{
+		static const std::string s_sSql = [] {
+			std::string s = TblTxo_InsFields;
+			for (uint32_t j = 0; j < nBatch; j++)
+				s += j ? ",(?,?,?)" : "(?,?,?)";
+			return s;
+		}();
+
+		for (; nRows - i >= nBatch; )
+		{
+			Recordset rs(*this, Query::TxoAddBatch, s_sSql.c_str());
+			for (uint32_t j = 0; j < nBatch; j++, i++)
+				TxoPut(rs, j * 3, i);
+			rs.Step();
+		}
+	}
+
+	for (; i < nRows; i++)
+	{
+		Recordset rs(*this, Query::TxoAdd, TblTxo_InsFields "(?,?,?)");
+		TxoPut(rs, 0, i);
+		rs.Step();
+	}
+
+	// spend marks. Consecutive marks of the same height (typical for a block) are merged
+	const auto& vSpent = m_TxoPending.m_vSpent;
+	for (i = 0; i < vSpent.size(); )
+	{
+		Height h = vSpent[i].second;
+		size_t n = 1;
+		while ((n < nBatch) && (i + n < vSpent.size()) && (vSpent[i + n].second == h))
+			n++;
+
+		if (n < nBatch)
+		{
+			for (; n--; i++)
+				TxoSetSpentRaw(vSpent[i].first, h);
+			continue;
+		}
+
+		static const std::string s_sSql = [] {
+			std::string s = "UPDATE " TblTxo " SET " TblTxo_SpendHeight "=? WHERE " TblTxo_ID " IN (";
+			for (uint32_t j = 0; j < nBatch; j++)
+				s += j ? ",?" : "?";
+			return s + ")";
+		}();
+
+		Recordset rs(*this, Query::TxoSetSpentBatch, s_sSql.c_str());
+		if (MaxHeight != h)
+			rs.put(0, h);
+		for (uint32_t j = 0; j < nBatch; j++, i++)
+			rs.put(j + 1, vSpent[i].first);
+
+		rs.Step();
+		if (static_cast<int>(nBatch) != get_RowsChanged())
+			ThrowError("Txo spend batch failed");
+	}
+
+	m_TxoPending.Clear();
+}
+
 void NodeDB::TxoAdd(TxoID id, const Blob& b)
 {
-	Recordset rs(*this, Query::TxoAdd, "INSERT INTO " TblTxo "(" TblTxo_ID "," TblTxo_Value ") VALUES(?,?)");
-	rs.put(0, id);
-	rs.put(1, b);
-	rs.Step();
+	if (!IsTxoWriteBehind())
+	{
+		// no transaction, write immediately
+		TxoFlush();
+
+		Recordset rs(*this, Query::TxoAdd, TblTxo_InsFields "(?,?,?)");
+		rs.put(0, id);
+		rs.put(1, b);
+		rs.Step();
+		return;
+	}
+
+	if (!m_TxoPending.m_vID.empty() && (m_TxoPending.m_vID.back() >= id))
+		TxoFlush(); // keep it ordered
+
+	m_TxoPending.Add(id, b);
+
+	if (m_TxoPending.m_vID.size() >= m_TxoPendingMax)
+		TxoFlush();
 }
 
 void NodeDB::TxoDel(TxoID id)
 {
+	TxoFlush();
+
 	Recordset rs(*this, Query::TxoDel, "DELETE FROM " TblTxo " WHERE " TblTxo_ID "=?");
 	rs.put(0, id);
 	rs.Step();
@@ -2151,12 +2332,36 @@ void NodeDB::TxoDel(TxoID id)
 
 void NodeDB::TxoDelFrom(TxoID id)
 {
+	m_TxoPending.TrimFrom(id);
+	TxoFlush();
+
 	Recordset rs(*this, Query::TxoDelFrom, "DELETE FROM " TblTxo " WHERE " TblTxo_ID ">=?");
 	rs.put(0, id);
 	rs.Step();
 }
 
 void NodeDB::TxoSetSpent(TxoID id, Height h)
+{
+	size_t i;
+	if (m_TxoPending.Find(i, id))
+	{
+		m_TxoPending.m_vSpend[i] = h;
+		return;
+	}
+
+	if (IsTxoWriteBehind())
+	{
+		m_TxoPending.m_vSpent.emplace_back(id, h);
+		if (m_TxoPending.m_vSpent.size() >= m_TxoPendingMax)
+			TxoFlush();
+		return;
+	}
+
+	TxoFlush();
+	TxoSetSpentRaw(id, h);
+}
+
+void NodeDB::TxoSetSpentRaw(TxoID id, Height h)
 {
 	Recordset rs(*this, Query::TxoSetSpent, "UPDATE " TblTxo " SET " TblTxo_SpendHeight "=? WHERE " TblTxo_ID "=?");
 	if (MaxHeight != h)
@@ -2169,6 +2374,7 @@ void NodeDB::TxoSetSpent(TxoID id, Height h)
 
 void NodeDB::EnumTxos(WalkerTxo& wlk, TxoID id0)
 {
+	TxoFlush();
 	wlk.m_Rs.Reset(*this, Query::TxoEnum, "SELECT " TblTxo_ID "," TblTxo_Value "," TblTxo_SpendHeight " FROM " TblTxo " WHERE " TblTxo_ID ">=? ORDER BY " TblTxo_ID);
 	wlk.m_Rs.put(0, id0);
 }
@@ -2191,6 +2397,8 @@ bool NodeDB::WalkerTxo::MoveNext()
 
 void NodeDB::TxoSetValue(TxoID id, const Blob& v)
 {
+	TxoFlush();
+
 	Recordset rs(*this, Query::TxoSetValue, "UPDATE " TblTxo " SET " TblTxo_Value "=? WHERE " TblTxo_ID "=?");
 	rs.put(0, v);
 	rs.put(1, id);
@@ -2200,6 +2408,16 @@ void NodeDB::TxoSetValue(TxoID id, const Blob& v)
 
 void NodeDB::TxoGetValue(WalkerTxo& wlk, TxoID id0)
 {
+	size_t i;
+	if (m_TxoPending.Find(i, id0))
+	{
+		// copy, the pending buffer may be reallocated or flushed by the next Txo modification
+		Blob val = m_TxoPending.get_Value(i);
+		val.Export(wlk.m_Buf);
+		wlk.m_Value = Blob(wlk.m_Buf);
+		return;
+	}
+
 	wlk.m_Rs.Reset(*this, Query::TxoGetValue, "SELECT " TblTxo_Value " FROM " TblTxo " WHERE " TblTxo_ID "=?");
 	wlk.m_Rs.put(0, id0);
 
@@ -2627,6 +2845,8 @@ void NodeDB::MigrateFrom18()
 	std::vector<StateInput> vInps;
 	Height h = 0;
 
+	TxoFlush();
+
 	WalkerTxo wlk;
 	wlk.m_Rs.Reset(*this, Query::TxoEnumBySpentMigrate, "SELECT " TblTxo_ID "," TblTxo_Value "," TblTxo_SpendHeight " FROM " TblTxo " WHERE " TblTxo_SpendHeight " IS NOT NULL ORDER BY " TblTxo_SpendHeight "," TblTxo_ID);
 	while (true)
@@ -140,6 +140,7 @@ public:
 			BbsFind,
 			BbsFindCursor,
 			BbsDel,
+			BbsDelUpTo,
 			BbsIns,
 			BbsMaxTime,
 			BbsTotals,
@@ -152,9 +153,11 @@ public:
 			KernelFind,
 			KernelDel,
 			TxoAdd,
+			TxoAddBatch,
 			TxoDel,
 			TxoDelFrom,
 			TxoSetSpent,
+			TxoSetSpentBatch,
 			TxoEnum,
 			TxoEnumBySpentMigrate,
 			TxoSetValue,
@@ -209,7 +212,8 @@ public:
 	virtual ~NodeDB();
 
 	void Close();
-	void Open(const char* szPath);
+	void Open(const char* szPath, bool bSharedRead = false); // shared read: WAL mode, other connections may read concurrently (see OpenReader)
+	void OpenReader(const char* szPath); // read-only connection, sees the last committed state. The db must be opened in shared read mode
 	bool IsOpen() const
 	{
 		return nullptr != m_pDb;
@@ -440,6 +444,7 @@ public:
 	bool BbsFind(WalkerBbs&); // set Key
 	uint64_t BbsFind(const WalkerBbs::Key&);
 	void BbsDel(uint64_t id);
+	void BbsDelUpTo(uint64_t id); // inclusive
 	uint64_t BbsFindCursor(Timestamp);
 	Timestamp get_BbsMaxTime();
 	uint64_t get_BbsLastID();
@@ -496,10 +501,15 @@ public:
 
 	uint64_t FindStateWorkGreater(const Difficulty::Raw&);
 
+	// Within a transaction TxoAdd and TxoSetSpent are write-behind: kept in memory and written in bulk (multi-row statements)
+	// on commit, or when needed by other Txo queries. Value lookups and spend marks for pending rows are served in-memory.
+	uint32_t m_TxoPendingMax = 4096; // 0 - disable write-behind
+
 	void TxoAdd(TxoID, const Blob&);
 	void TxoDel(TxoID);
 	void TxoDelFrom(TxoID);
 	void TxoSetSpent(TxoID, Height);
+	void TxoFlush();
 
 	struct WalkerTxo
 	{
@@ -507,6 +517,7 @@ public:
 		TxoID m_ID;
 		Blob m_Value;
 		Height m_SpendHeight;
+		ByteBuffer m_Buf; // own copy of the value, if it's pending (not written yet)
 
 		bool MoveNext();
 	};
@@ -633,6 +644,30 @@ private:
 
 	Statement m_pPrep[Query::count];
 
+	struct TxoPending
+	{
+		// columnar, IDs are ascending
+		std::vector<TxoID> m_vID;
+		std::vector<Height> m_vSpend;
+		std::vector<uint32_t> m_vEnd; // value end offsets within m_Values
+		ByteBuffer m_Values;
+
+		std::vector<std::pair<TxoID, Height> > m_vSpent; // marks for the already written rows, in order
+
+		static const uint32_t s_RowsPerStatement = 64;
+
+		void Add(TxoID, const Blob&);
+		void Clear();
+		bool Find(size_t&, TxoID) const;
+		void TrimFrom(TxoID);
+		Blob get_Value(size_t) const;
+
+	} m_TxoPending;
+
+	void TxoPut(Recordset&, int col, size_t iPending);
+	bool IsTxoWriteBehind();
+	void TxoSetSpentRaw(TxoID, Height);
+
 	void Prepare(Statement&, const char*);
 
 	void TestRet(int);
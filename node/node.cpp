@@ -702,6 +702,10 @@ void Node::Processor::OnRolledBack()
 {
     LOG_INFO() << "Rolled back to: " << m_Cursor.m_ID;
 
+	get_ParentObj().m_Readers.OnRolledBack(m_Cursor.m_ID.m_Height);
+
+	get_ParentObj().m_RecoveryCache.ShrinkTo(0);
+
 	TxPool::Fluff& txp = get_ParentObj().m_TxPool;
     while (!txp.m_setOutdated.empty())
     {
@@ -913,6 +917,8 @@ void Node::Initialize(IExternalPOW* externalPOW)
     m_Processor.m_ExecutorMT.set_Threads(std::max<uint32_t>(m_Cfg.m_VerificationThreads, 1U));
 
     m_Processor.m_Horizon = m_Cfg.m_Horizon;
+    if (m_Cfg.m_ReadThreads)
+        m_Cfg.m_ProcessorParams.m_SharedRead = true;
     m_Processor.Initialize(m_Cfg.m_sPathLocal.c_str(), m_Cfg.m_ProcessorParams);
 
 	if (m_Cfg.m_ProcessorParams.m_EraseSelfID)
@@ -941,6 +947,8 @@ void Node::Initialize(IExternalPOW* externalPOW)
 	ZeroObject(m_SyncStatus);
     RefreshCongestions();
 
+    m_IoThreads.Initialize(m_Cfg.m_IoThreads);
+
     if (m_Cfg.m_Listen.port())
     {
         m_Server.Listen(m_Cfg.m_Listen);
@@ -950,9 +958,9 @@ void Node::Initialize(IExternalPOW* externalPOW)
 
     m_PeerMan.Initialize();
     m_Miner.Initialize(externalPOW);
-	m_Processor.get_DB().get_BbsTotals(m_Bbs.m_Totals);
-    m_Bbs.Cleanup();
-	m_Bbs.m_HighestPosted_s = m_Processor.get_DB().get_BbsMaxTime();
+    m_Readers.Initialize();
+	if (m_Cfg.m_Bbs.IsEnabled())
+		m_Bbs.Open();
 }
 
 uint32_t Node::get_AcessiblePeerCount() const
@@ -1073,28 +1081,68 @@ bool Node::Bbs::IsInLimits() const
 {
 	const NodeDB::BbsTotals& lims = get_ParentObj().m_Cfg.m_Bbs.m_Limit;
 
+	NodeDB::BbsTotals tots;
+	m_Store.get_BbsTotals(tots);
+
 	return
-		(m_Totals.m_Count <= lims.m_Count) &&
-		(m_Totals.m_Size <= lims.m_Size);
+		(tots.m_Count <= lims.m_Count) &&
+		(tots.m_Size <= lims.m_Size);
 }
 
-void Node::Bbs::Cleanup()
+void Node::Bbs::Open()
 {
+	Node& n = get_ParentObj();
+
+	std::string sPath;
+	NodeProcessor::get_BbsPath(sPath, n.m_Cfg.m_sPathLocal.c_str());
+
+	m_Store.m_SegmentPeriod_s = n.m_Cfg.m_Bbs.m_SegmentPeriod_s;
+	m_Store.Open(sPath.c_str());
+
+	ImportFromDB();
+	Cleanup();
+
+	m_HighestPosted_s = m_Store.get_BbsMaxTime();
+}
+
+void Node::Bbs::ImportFromDB()
+{
+	// older versions kept the messages in the node DB. Move them to the store once
 	NodeDB& db = get_ParentObj().m_Processor.get_DB();
-	NodeDB::WalkerBbsTimeLen wlk;
 
-	Timestamp ts = getTimestamp() - get_ParentObj().m_Cfg.m_Bbs.m_MessageTimeout_s;
+	NodeDB::BbsTotals tots;
+	db.get_BbsTotals(tots);
+	if (!tots.m_Count)
+		return;
+
+	LOG_INFO() << "Moving " << tots.m_Count << " bbs messages from the node DB";
 
-	for (db.EnumAllBbs(wlk); wlk.MoveNext(); )
+	NodeDB::WalkerBbsLite wlk;
+	wlk.m_ID = 0;
+	uint64_t nIDMax = 0;
+
+	for (db.EnumAllBbsSeq(wlk); wlk.MoveNext(); )
 	{
-		if (IsInLimits() && (wlk.m_Time >= ts))
-			break;
+		nIDMax = wlk.m_ID;
+		if (m_Store.BbsFind(wlk.m_Key))
+			continue;
 
-		db.BbsDel(wlk.m_ID);
-		m_Totals.m_Count--;
-		m_Totals.m_Size -= wlk.m_Size;
+		NodeDB::WalkerBbs wlkMsg;
+		wlkMsg.m_Data.m_Key = wlk.m_Key;
+		if (db.BbsFind(wlkMsg))
+			m_Store.BbsIns(wlkMsg.m_Data);
 	}
 
+	// the store is already flushed. The node DB is always within a transaction, delete all the moved messages at once, and commit
+	db.BbsDelUpTo(nIDMax);
+	get_ParentObj().m_Processor.CommitDB();
+}
+
+void Node::Bbs::Cleanup()
+{
+	Timestamp ts = getTimestamp() - get_ParentObj().m_Cfg.m_Bbs.m_MessageTimeout_s;
+	m_Store.Cleanup(ts, get_ParentObj().m_Cfg.m_Bbs.m_Limit);
+
 	m_LastCleanup_ms = GetTime_ms();
 }
 
@@ -1128,12 +1176,16 @@ Node::~Node()
     }
     m_Miner.m_vThreads.clear();
 
+    m_Readers.Stop();
+
     for (PeerList::iterator it = m_lstPeers.begin(); m_lstPeers.end() != it; it++)
         it->m_LoginFlags = 0; // prevent re-assigning of tasks in the next loop
 
     while (!m_lstPeers.empty())
         m_lstPeers.front().DeleteSelf(false, proto::NodeConnection::ByeReason::Stopping);
 
+    m_IoThreads.Stop();
+
     while (!m_lstTasksUnassigned.empty())
         DeleteUnassignedTask(m_lstTasksUnassigned.front());
 
@@ -1489,6 +1541,13 @@ void Node::Peer::DeleteSelf(bool bIsError, uint8_t nByeReason)
 {
     LOG_INFO() << "-Peer " << m_RemoteAddr;
 
+    if (m_pReadTask)
+    {
+        m_pReadTask->m_pPeer = nullptr; // orphan it, the held messages are dropped
+        m_pReadTask.reset();
+        ReleaseOutgoing();
+    }
+
     if (nByeReason && (Flags::Connected & m_Flags))
     {
         proto::Bye msg;
@@ -1966,29 +2025,119 @@ bool Node::Peer::GetBlock(proto::BodyBuffers& out, const NodeDB::StateID& sid, c
 		ThrowUnexpected();
 	}
 
+	if (proto::BodyBuffers::Recovery1 != msg.m_FlagP)
+		return m_This.m_Processor.GetBlock(sid, pE, pP, msg.m_Height0, msg.m_HorizonLo1, msg.m_HorizonHi1, bActive);
+
+	RecoveryCache::Entry::Key key;
+	key.m_Row = sid.m_Row;
+	key.m_h0 = msg.m_Height0;
+	key.m_hLo1 = msg.m_HorizonLo1;
+	key.m_hHi1 = msg.m_HorizonHi1;
+
+	const ByteBuffer* pCached = m_This.m_RecoveryCache.Find(key);
+	if (pCached)
+	{
+		// still must be available wrt our current horizons. Without the perishable part this check is cheap
+		if (!m_This.m_Processor.GetBlock(sid, pE, nullptr, msg.m_Height0, msg.m_HorizonLo1, msg.m_HorizonHi1, bActive))
+			return false;
+
+		out.m_Perishable = *pCached;
+		return true;
+	}
+
 	if (!m_This.m_Processor.GetBlock(sid, pE, pP, msg.m_Height0, msg.m_HorizonLo1, msg.m_HorizonHi1, bActive))
 		return false;
 
-	if (proto::BodyBuffers::Recovery1 == msg.m_FlagP)
-	{
-		Block::Body block;
+	ConvertToRecovery1(out.m_Perishable);
 
-		Deserializer der;
-		der.reset(out.m_Perishable);
-		der & Cast::Down<Block::BodyBase>(block);
-		der & Cast::Down<TxVectors::Perishable>(block);
+	// Outputs spent above our tip may still be spent within the requested horizons, and then pruned differently.
+	// Cache only the bodies that can't change this way
+	if (std::max(msg.m_HorizonLo1, msg.m_HorizonHi1) <= m_This.m_Processor.m_Cursor.m_ID.m_Height)
+		m_This.m_RecoveryCache.Insert(key, out.m_Perishable, m_This.m_Cfg.m_BandwidthCtl.m_MaxRecoveryCache);
 
-		for (size_t i = 0; i < block.m_vOutputs.size(); i++)
-			block.m_vOutputs[i]->m_RecoveryOnly = true;
+	return true;
+}
+
+void Node::ConvertToRecovery1(ByteBuffer& buf)
+{
+	Block::Body block;
+
+	Deserializer der;
+	der.reset(buf);
+	der & Cast::Down<Block::BodyBase>(block);
+	der & Cast::Down<TxVectors::Perishable>(block);
+
+	for (size_t i = 0; i < block.m_vOutputs.size(); i++)
+		block.m_vOutputs[i]->m_RecoveryOnly = true;
+
+	Serializer ser;
+	ser & Cast::Down<Block::BodyBase>(block);
+	ser & Cast::Down<TxVectors::Perishable>(block);
+
+	ser.swap_buf(buf);
+}
+
+bool Node::RecoveryCache::Entry::Key::operator < (const Key& x) const
+{
+	if (m_Row != x.m_Row)
+		return m_Row < x.m_Row;
+	if (m_h0 != x.m_h0)
+		return m_h0 < x.m_h0;
+	if (m_hLo1 != x.m_hLo1)
+		return m_hLo1 < x.m_hLo1;
+	return m_hHi1 < x.m_hHi1;
+}
+
+const ByteBuffer* Node::RecoveryCache::Find(const Entry::Key& key)
+{
+	KeySet::iterator it = m_Keys.find(key);
+	if (m_Keys.end() == it)
+		return nullptr;
+
+	Entry& e = it->get_ParentObj();
+	m_Mru.erase(MruList::s_iterator_to(e.m_Mru));
+	m_Mru.push_front(e.m_Mru);
+
+	return &e.m_Body;
+}
+
+void Node::RecoveryCache::Insert(const Entry::Key& key, const ByteBuffer& buf, size_t nMaxSize)
+{
+	size_t nSize = get_EntrySize(buf);
+	if (nSize > nMaxSize)
+		return;
 
-		Serializer ser;
-		ser & Cast::Down<Block::BodyBase>(block);
-		ser & Cast::Down<TxVectors::Perishable>(block);
+	ShrinkTo(nMaxSize - nSize);
 
-		ser.swap_buf(out.m_Perishable);
+	Entry* pE = new Entry;
+	pE->m_Key.m_Row = key.m_Row;
+	pE->m_Key.m_h0 = key.m_h0;
+	pE->m_Key.m_hLo1 = key.m_hLo1;
+	pE->m_Key.m_hHi1 = key.m_hHi1;
+	pE->m_Body = buf;
+
+	if (!m_Keys.insert(pE->m_Key).second)
+	{
+		delete pE; // already there
+		return;
 	}
 
-	return true;
+	m_Mru.push_front(pE->m_Mru);
+	m_Size += nSize;
+}
+
+void Node::RecoveryCache::Delete(Entry& e)
+{
+	m_Size -= get_EntrySize(e.m_Body);
+	m_Keys.erase(KeySet::s_iterator_to(e.m_Key));
+	m_Mru.erase(MruList::s_iterator_to(e.m_Mru));
+	delete &e;
+}
+
+void Node::RecoveryCache::ShrinkTo(size_t nSize)
+{
+	while (m_Size > nSize)
+		Delete(m_Mru.back().get_ParentObj());
 }
 
 bool Node::Peer::ShouldAcceptBodyPack()
@@ -2119,6 +2268,7 @@ void Node::OnTransactionDeferred(Transaction::Ptr&& pTx, const PeerID* pSender,
     TxDeferred::Element txd;
     txd.m_pTx = std::move(pTx);
     txd.m_Fluff = bFluff;
+    txd.m_Received_ms = GetTime_ms();
 
     if (pSender)
         txd.m_Sender = *pSender;
@@ -2146,11 +2296,82 @@ void Node::OnTransactionDeferred(Transaction::Ptr&& pTx, const PeerID* pSender,
 
 void Node::TxDeferred::OnSchedule()
 {
-    if (!m_lst.empty())
+    Node& n = get_ParentObj();
+    TxValidationStats& st = n.m_TxValidationStats;
+
+    // Take a batch of txs, verify them context-free all at once (in parallel, sharing the multi-exponentiation),
+    // then handle them one-by-one (context-dependent verification, pool insertion).
+    // Without verification threads the batch would be verified by the reactor thread, so it's one tx per tick, as before.
+    std::list<Element> lst;
+    {
+        uint32_t nBatch = (n.m_Cfg.m_VerificationThreads > 0) ? std::max(n.m_Cfg.m_DeferredTxBatch, 1U) : 1U;
+
+        auto it = m_lst.begin();
+        for (uint32_t i = nBatch; i && (m_lst.end() != it); i--)
+            it++;
+
+        lst.splice(lst.end(), m_lst, m_lst.begin(), it);
+    }
+
+    if (!lst.empty())
     {
-        TxDeferred::Element& x = m_lst.front();
-        get_ParentObj().OnTransaction(std::move(x.m_pTx), &x.m_Sender, x.m_Fluff);
-        m_lst.pop_front();
+        uint32_t t0_ms = GetTime_ms();
+
+        Transaction::Context::Params pars;
+        std::deque<Transaction::Context> vCtx;
+        std::vector<NodeProcessor::TxBatchEntry> vBatch;
+        vBatch.reserve(lst.size());
+
+        for (auto it = lst.begin(); lst.end() != it; it++)
+        {
+            uint32_t dt_ms = t0_ms - it->m_Received_ms;
+            st.m_Wait_ms += dt_ms;
+            std::setmax(st.m_WaitMax_ms, dt_ms);
+
+            if (!n.IsTxVerificationNeeded(*it->m_pTx, it->m_Fluff))
+            {
+                st.m_Skipped++;
+                continue;
+            }
+
+            Transaction::Context& ctx = vCtx.emplace_back(pars);
+            ctx.m_Height.m_Min = n.m_Processor.m_Cursor.m_ID.m_Height + 1;
+
+            NodeProcessor::TxBatchEntry& e = vBatch.emplace_back();
+            e.m_pTx = it->m_pTx.get();
+            e.m_pCtx = &ctx;
+            e.m_bValid = false;
+        }
+
+        if (!vBatch.empty() && !n.m_Processor.ValidateAndSummarizeBatch(&vBatch.front(), static_cast<uint32_t>(vBatch.size())))
+            st.m_BatchesFailed++;
+
+        uint32_t t1_ms = GetTime_ms();
+
+        size_t i = 0;
+        for (auto it = lst.begin(); lst.end() != it; it++)
+        {
+            // skipped txs are handled without the batch. Should their status change meanwhile (say, the duplicate was evicted) - they're verified individually
+            const NodeProcessor::TxBatchEntry* pBatched = nullptr;
+            if ((i < vBatch.size()) && (vBatch[i].m_pTx == it->m_pTx.get()))
+            {
+                pBatched = &vBatch[i++];
+                if (!pBatched->m_bValid)
+                    st.m_Invalid++;
+            }
+
+            n.OnTransaction(std::move(it->m_pTx), &it->m_Sender, it->m_Fluff, pBatched);
+        }
+
+        st.m_Txs += lst.size();
+        st.m_Batches++;
+        st.m_Verify_ms += t1_ms - t0_ms;
+        st.m_Process_ms += GetTime_ms() - t1_ms;
+
+        if (n.m_Cfg.m_LogTxFluff)
+            LOG_INFO() << "Deferred txs batch: " << lst.size() << ", skipped=" << (lst.size() - vBatch.size()) << ", verify=" << (t1_ms - t0_ms) << " ms"
+                << ". Total: txs=" << st.m_Txs << ", skipped=" << st.m_Skipped << ", invalid=" << st.m_Invalid
+                << ", batches=" << st.m_Batches << ", failed=" << st.m_BatchesFailed << ", max wait=" << st.m_WaitMax_ms << " ms";
     }
 
     if (m_lst.empty())
@@ -2158,19 +2379,81 @@ void Node::TxDeferred::OnSchedule()
 
 }
 
-uint8_t Node::OnTransaction(Transaction::Ptr&& pTx, const PeerID* pSender, bool bFluff)
+uint8_t Node::OnTransaction(Transaction::Ptr&& pTx, const PeerID* pSender, bool bFluff, const NodeProcessor::TxBatchEntry* pBatched /* = nullptr */)
 {
     return bFluff ?
-        OnTransactionFluff(std::move(pTx), pSender, nullptr) :
-        OnTransactionStem(std::move(pTx));
+        OnTransactionFluff(std::move(pTx), pSender, nullptr, pBatched) :
+        OnTransactionStem(std::move(pTx), pBatched);
 }
 
-uint8_t Node::ValidateTx(Transaction::Context& ctx, const Transaction& tx)
+uint8_t Node::ValidateTxLimits(const Transaction& tx)
 {
-	ctx.m_Height.m_Min = m_Processor.m_Cursor.m_ID.m_Height + 1;
+	TxStats s;
+	tx.get_Reader().AddStats(s);
+	if (!(s.m_Inputs + s.m_Outputs) || !s.m_Kernels) {
+		// stupid compiler insists on parentheses here!
+		return proto::TxStatus::TooSmall;
+	}
 
-	if (!(m_Processor.ValidateAndSummarize(ctx, tx, tx.get_Reader()) && ctx.IsValidTransaction()))
-		return proto::TxStatus::Invalid;
+	if ((s.m_InputsShielded > Rules::get().Shielded.MaxIns) || (s.m_OutputsShielded > Rules::get().Shielded.MaxOuts)) {
+		return proto::TxStatus::LimitExceeded;
+	}
+
+	return proto::TxStatus::Ok;
+}
+
+bool Node::IsTxVerificationNeeded(const Transaction& tx, bool bFluff)
+{
+	// must be consistent with OnTransactionStem/OnTransactionFluff
+	if (bFluff)
+	{
+		TxPool::Fluff::Element::Tx key;
+		tx.get_Key(key.m_Key);
+
+		return m_TxPool.m_setTxs.end() == m_TxPool.m_setTxs.find(key);
+	}
+
+	if (proto::TxStatus::Ok != ValidateTxLimits(tx))
+		return false;
+
+	// the first stem tx that shares a kernel decides: the new tx is either obscured, a duplicate, or it's verified
+	for (size_t i = 0; i < tx.m_vKernels.size(); i++)
+	{
+		TxPool::Stem::Element::Kernel key;
+		key.m_pKrn = tx.m_vKernels[i].get();
+
+		TxPool::Stem::KrnSet::iterator it = m_Dandelion.m_setKrns.find(key);
+		if (m_Dandelion.m_setKrns.end() == it)
+			continue;
+
+		bool bElemCovers = true, bNewCovers = true;
+		it->m_pThis->m_pValue->get_Reader().Compare(tx.get_Reader(), bElemCovers, bNewCovers);
+
+		return bNewCovers && !bElemCovers;
+	}
+
+	return true;
+}
+
+uint8_t Node::ValidateTx(Transaction::Context& ctx, const Transaction& tx, const NodeProcessor::TxBatchEntry* pBatched)
+{
+	if (pBatched)
+	{
+		// context-free part is already verified
+		assert(pBatched->m_pTx == &tx);
+		if (!pBatched->m_bValid)
+			return proto::TxStatus::Invalid;
+
+		ctx.m_Height = pBatched->m_pCtx->m_Height;
+		ctx.m_Stats = pBatched->m_pCtx->m_Stats;
+	}
+	else
+	{
+		ctx.m_Height.m_Min = m_Processor.m_Cursor.m_ID.m_Height + 1;
+
+		if (!(m_Processor.ValidateAndSummarize(ctx, tx, tx.get_Reader()) && ctx.IsValidTransaction()))
+			return proto::TxStatus::Invalid;
+	}
 
     uint8_t nCode = m_Processor.ValidateTxContextEx(tx, ctx.m_Height, false);
 	if (proto::TxStatus::Ok != nCode)
@@ -2277,18 +2560,11 @@ uint32_t Node::RandomUInt32(uint32_t threshold)
     return threshold;
 }
 
-uint8_t Node::OnTransactionStem(Transaction::Ptr&& ptx)
+uint8_t Node::OnTransactionStem(Transaction::Ptr&& ptx, const NodeProcessor::TxBatchEntry* pBatched /* = nullptr */)
 {
-	TxStats s;
-	ptx->get_Reader().AddStats(s);
-	if (!(s.m_Inputs + s.m_Outputs) || !s.m_Kernels) {
-		// stupid compiler insists on parentheses here!
-		return proto::TxStatus::TooSmall;
-	}
-
-    if ((s.m_InputsShielded > Rules::get().Shielded.MaxIns) || (s.m_OutputsShielded > Rules::get().Shielded.MaxOuts)) {
-        return proto::TxStatus::LimitExceeded;
-    }
+	uint8_t nCodeLimits = ValidateTxLimits(*ptx);
+	if (proto::TxStatus::Ok != nCodeLimits)
+		return nCodeLimits;
 
 	Transaction::Context::Params pars;
 	Transaction::Context ctx(pars);
@@ -2334,7 +2610,7 @@ uint8_t Node::OnTransactionStem(Transaction::Ptr&& ptx)
 
 		if (!bTested)
 		{
-			uint8_t nCode = ValidateTx(ctx, *ptx);
+			uint8_t nCode = ValidateTx(ctx, *ptx, pBatched);
 			if (proto::TxStatus::Ok != nCode)
 				return nCode;
 
@@ -2349,7 +2625,7 @@ uint8_t Node::OnTransactionStem(Transaction::Ptr&& ptx)
     {
 		if (!bTested)
 		{
-			uint8_t nCode = ValidateTx(ctx, *ptx);
+			uint8_t nCode = ValidateTx(ctx, *ptx, pBatched);
 			if (proto::TxStatus::Ok != nCode)
 				return nCode;
 		}
@@ -2633,7 +2909,7 @@ Height Node::SampleDummySpentHeight()
 	return h;
 }
 
-uint8_t Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, const PeerID* pSender, TxPool::Stem::Element* pElem)
+uint8_t Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, const PeerID* pSender, TxPool::Stem::Element* pElem, const NodeProcessor::TxBatchEntry* pBatched /* = nullptr */)
 {
     Transaction::Ptr ptx;
     ptx.swap(ptxArg);
@@ -2677,7 +2953,7 @@ uint8_t Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, const PeerID* pSende
     m_Wtx.Delete(key.m_Key);
 
     // new transaction
-    uint8_t nCode = pElem ? proto::TxStatus::Ok : ValidateTx(ctx, tx);
+    uint8_t nCode = pElem ? proto::TxStatus::Ok : ValidateTx(ctx, tx, pBatched);
     LogTx(tx, nCode, key.m_Key);
 
 	if (proto::TxStatus::Ok != nCode) {
@@ -2716,7 +2992,7 @@ uint8_t Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, const PeerID* pSende
 		peer.SetTxCursor(pNewTxElem);
     }
 
-    if (m_Miner.IsEnabled() && !m_Miner.m_pTaskToFinalize)
+    if (m_Miner.IsEnabled() && !m_Miner.m_pTaskToFinalize && m_TxPool.m_Template.m_Dirty)
         m_Miner.SetTimer(m_Cfg.m_Timeout.m_MiningSoftRestart_ms, false);
 
     return nCode;
@@ -2873,11 +3149,11 @@ void Node::Peer::BroadcastBbs()
 
 	size_t nExtra = 0;
 
-	NodeDB& db = m_This.m_Processor.get_DB();
-	NodeDB::WalkerBbsLite wlk;
+	BbsStore& bbs = m_This.m_Bbs.m_Store;
+	BbsStore::WalkerBbsLite wlk;
 
 	wlk.m_ID = m_CursorBbs;
-	for (db.EnumAllBbsSeq(wlk); wlk.MoveNext(); )
+	for (bbs.EnumAllBbsSeq(wlk); wlk.MoveNext(); )
 	{
 		proto::BbsHaveMsg msgOut;
 		msgOut.m_Key = wlk.m_Key;
@@ -3105,13 +3381,8 @@ void Node::Peer::OnMsg(proto::GetProofUtxo&& msg)
     Send(t.m_Msg);
 }
 
-void Node::Processor::GenerateProofShielded(Merkle::Proof& p, const uintBigFor<TxoID>::Type& mmrIdx)
+void Node::Processor::AppendProofShielded(Merkle::Proof& p)
 {
-    TxoID nIdx;
-    mmrIdx.Export(nIdx);
-
-    m_Mmr.m_Shielded.get_Proof(p, nIdx);
-
     struct MyProofBuilder
         :public NodeProcessor::ProofBuilder
     {
@@ -3123,58 +3394,129 @@ void Node::Processor::GenerateProofShielded(Merkle::Proof& p, const uintBigFor<T
     pb.GenerateProof();
 }
 
-void Node::Peer::OnMsg(proto::GetProofShieldedOutp&& msg)
+bool Node::Processor::FindShielded(NodeDB& db, const proto::GetProofShieldedOutp& msg, proto::ProofShieldedOutp& msgOut, TxoID& nMmrIdx)
 {
-    if (msg.m_SerialPub.m_Y > 1)
-        ThrowUnexpected(); // would not be necessary if/when our serialization will take care of this
+    NodeDB::Recordset rs;
+    Blob blob(&msg.m_SerialPub, sizeof(msg.m_SerialPub));
+    if (!db.UniqueFind(blob, rs))
+        return false;
 
-    proto::ProofShieldedOutp msgOut;
+    const NodeProcessor::ShieldedOutpPacked& sop = rs.get_As<NodeProcessor::ShieldedOutpPacked>(0); // Note: will throw CorruptionException if of wrong size
 
-	Processor& p = m_This.m_Processor;
-    if (!p.IsFastSync())
-	{
-        NodeDB::Recordset rs;
-        Blob blob(&msg.m_SerialPub, sizeof(msg.m_SerialPub));
-        if (p.get_DB().UniqueFind(blob, rs))
-        {
-            const NodeProcessor::ShieldedOutpPacked& sop = rs.get_As<NodeProcessor::ShieldedOutpPacked>(0); // Note: will throw CorruptionException if of wrong size
+    sop.m_Height.Export(msgOut.m_Height);
+    sop.m_TxoID.Export(msgOut.m_ID);
+    msgOut.m_Commitment = sop.m_Commitment;
+    sop.m_MmrIndex.Export(nMmrIdx);
 
-            sop.m_Height.Export(msgOut.m_Height);
-            sop.m_TxoID.Export(msgOut.m_ID);
-            msgOut.m_Commitment = sop.m_Commitment;
+    return true;
+}
 
-            p.GenerateProofShielded(msgOut.m_Proof, sop.m_MmrIndex);
-        }
-	}
+bool Node::Processor::FindShielded(NodeDB& db, const proto::GetProofShieldedInp& msg, proto::ProofShieldedInp& msgOut, TxoID& nMmrIdx)
+{
+    NodeDB::Recordset rs;
 
-	Send(msgOut);
+    ECC::Point key = msg.m_SpendPk;
+    key.m_Y |= 2;
+    Blob blob(&key, sizeof(key));
+    if (!db.UniqueFind(blob, rs))
+        return false;
+
+    const NodeProcessor::ShieldedInpPacked& sip = rs.get_As<NodeProcessor::ShieldedInpPacked>(0); // Note: will throw CorruptionException if of wrong size
+
+    sip.m_Height.Export(msgOut.m_Height);
+    sip.m_MmrIndex.Export(nMmrIdx);
+
+    return true;
 }
 
-void Node::Peer::OnMsg(proto::GetProofShieldedInp&& msg)
+template <typename TMsg, typename TMsgOut>
+struct Node::Readers::TaskShielded
+    :public Task
 {
-    if (msg.m_SpendPk.m_Y > 1)
-        ThrowUnexpected(); // would not be necessary if/when our serialization will take care of this
+    TMsg m_Msg;
+    TMsgOut m_MsgOut;
+    uint64_t m_nShielded; // mmr count at the snapshot
+    bool m_bFound = false;
+    bool m_bProof = false;
 
-    proto::ProofShieldedInp msgOut;
+    static void Serve(Processor& p, const TMsg& msg, TMsgOut& msgOut)
+    {
+        TxoID nMmrIdx;
+        if (!p.IsFastSync() && Processor::FindShielded(p.get_DB(), msg, msgOut, nMmrIdx))
+        {
+            p.m_Mmr.m_Shielded.get_Proof(msgOut.m_Proof, nMmrIdx);
+            p.AppendProofShielded(msgOut.m_Proof);
+        }
+    }
 
-    Processor& p = m_This.m_Processor;
-    if (!p.IsFastSync())
+    static void Process(Peer& peer, const TMsg& msg)
     {
-        NodeDB::Recordset rs;
+        Processor& p = peer.m_This.m_Processor;
 
-        msg.m_SpendPk.m_Y |= 2;
-        Blob blob(&msg.m_SpendPk, sizeof(msg.m_SpendPk));
-        if (p.get_DB().UniqueFind(blob, rs))
+        // The mmr proof depends on the elements count, the reader can build it only if there's no uncommitted part
+        if (peer.m_This.m_Readers.IsEnabled() && !peer.m_pReadTask && !p.IsFastSync() && (p.m_Mmr.m_Shielded.m_Count == p.m_Committed.m_Shielded))
         {
-            const NodeProcessor::ShieldedInpPacked& sip = rs.get_As<NodeProcessor::ShieldedInpPacked>(0); // Note: will throw CorruptionException if of wrong size
+            auto pTask = std::make_shared<TaskShielded>();
+            pTask->m_Msg = msg;
+            pTask->m_nShielded = p.m_Committed.m_Shielded;
 
-            sip.m_Height.Export(msgOut.m_Height);
+            peer.m_This.m_Readers.Push(peer, std::move(pTask));
+            return;
+        }
+
+        TMsgOut msgOut;
+        Serve(p, msg, msgOut);
+        peer.Send(msgOut);
+    }
+
+    void Exec(NodeDB& db) override
+    {
+        TxoID nMmrIdx;
+        m_bFound = Processor::FindShielded(db, m_Msg, m_MsgOut, nMmrIdx);
 
-            p.GenerateProofShielded(msgOut.m_Proof, sip.m_MmrIndex);
+        if (m_bFound && (nMmrIdx < m_nShielded)) // otherwise it's newer than the snapshot
+        {
+            NodeDB::StreamMmr mmr(db, NodeDB::StreamType::ShieldedMmr, true);
+            mmr.m_Count = m_nShielded;
+            mmr.get_Proof(m_MsgOut.m_Proof, nMmrIdx);
+            m_bProof = true;
         }
     }
 
-    Send(msgOut);
+    void OnDone(Peer& peer) override
+    {
+        Processor& p = peer.m_This.m_Processor;
+
+        if (m_bOk && !m_bStale && !p.IsFastSync() && (p.m_Mmr.m_Shielded.m_Count == m_nShielded) && (m_bProof == m_bFound))
+        {
+            if (m_bProof)
+                p.AppendProofShielded(m_MsgOut.m_Proof);
+        }
+        else
+        {
+            // fallback
+            m_MsgOut = TMsgOut();
+            Serve(p, m_Msg, m_MsgOut);
+        }
+
+        peer.Send(m_MsgOut);
+    }
+};
+
+void Node::Peer::OnMsg(proto::GetProofShieldedOutp&& msg)
+{
+    if (msg.m_SerialPub.m_Y > 1)
+        ThrowUnexpected(); // would not be necessary if/when our serialization will take care of this
+
+    Readers::TaskShielded<proto::GetProofShieldedOutp, proto::ProofShieldedOutp>::Process(*this, msg);
+}
+
+void Node::Peer::OnMsg(proto::GetProofShieldedInp&& msg)
+{
+    if (msg.m_SpendPk.m_Y > 1)
+        ThrowUnexpected(); // would not be necessary if/when our serialization will take care of this
+
+    Readers::TaskShielded<proto::GetProofShieldedInp, proto::ProofShieldedInp>::Process(*this, msg);
 }
 
 void Node::Peer::OnMsg(proto::GetProofAsset&& msg)
@@ -3332,8 +3674,8 @@ void Node::Peer::OnMsg(proto::BbsMsg&& msg)
     if (msg.m_TimePosted + Rules::get().DA.MaxAhead_s < m_This.m_Bbs.m_HighestPosted_s)
         return; // don't allow too much out-of-order messages
 
-    NodeDB& db = m_This.m_Processor.get_DB();
-    NodeDB::WalkerBbs wlk;
+    BbsStore& bbs = m_This.m_Bbs.m_Store;
+    BbsStore::WalkerBbs wlk;
 
     wlk.m_Data.m_Channel = msg.m_Channel;
     wlk.m_Data.m_TimePosted = msg.m_TimePosted;
@@ -3342,17 +3684,15 @@ void Node::Peer::OnMsg(proto::BbsMsg&& msg)
 
     Bbs::CalcMsgKey(wlk.m_Data);
 
-    if (db.BbsFind(wlk.m_Data.m_Key))
+    if (bbs.BbsFind(wlk.m_Data.m_Key))
         return; // already have it
 
     m_This.m_Bbs.MaybeCleanup();
 
-    uint64_t id = db.BbsIns(wlk.m_Data);
+    uint64_t id = bbs.BbsIns(wlk.m_Data);
     m_This.m_Bbs.m_W.Delete(wlk.m_Data.m_Key);
 
 	std::setmax(m_This.m_Bbs.m_HighestPosted_s, msg.m_TimePosted);
-	m_This.m_Bbs.m_Totals.m_Count++;
-	m_This.m_Bbs.m_Totals.m_Size += wlk.m_Data.m_Message.n;
 
     // 1. Send to other BBS-es
 
@@ -3397,8 +3737,7 @@ void Node::Peer::OnMsg(proto::BbsHaveMsg&& msg)
     if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
-    NodeDB& db = m_This.m_Processor.get_DB();
-	if (db.BbsFind(msg.m_Key)) {
+	if (m_This.m_Bbs.m_Store.BbsFind(msg.m_Key)) {
 		// stupid compiler insists on parentheses here!
 		return; // already have it
 	}
@@ -3418,11 +3757,10 @@ void Node::Peer::OnMsg(proto::BbsGetMsg&& msg)
 	if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
-	NodeDB& db = m_This.m_Processor.get_DB();
-    NodeDB::WalkerBbs wlk;
+    BbsStore::WalkerBbs wlk;
 
     wlk.m_Data.m_Key = msg.m_Key;
-    if (!db.BbsFind(wlk))
+    if (!m_This.m_Bbs.m_Store.BbsFind(wlk))
         return; // don't have it
 
     SendBbsMsg(wlk.m_Data);
@@ -3460,7 +3798,7 @@ void Node::Peer::OnMsg(proto::BbsSubscribe&& msg)
         m_This.m_Bbs.m_Subscribed.insert(pS->m_Bbs);
         m_Subscriptions.insert(pS->m_Peer);
 
-		pS->m_Cursor = m_This.m_Processor.get_DB().BbsFindCursor(msg.m_TimeFrom) - 1;
+		pS->m_Cursor = m_This.m_Bbs.m_Store.BbsFindCursor(msg.m_TimeFrom) - 1;
 
 		BroadcastBbs(*pS);
     }
@@ -3473,13 +3811,12 @@ void Node::Peer::BroadcastBbs(Bbs::Subscription& s)
 	if (IsChocking())
 		return;
 
-	NodeDB& db = m_This.m_Processor.get_DB();
-	NodeDB::WalkerBbs wlk;
+	BbsStore::WalkerBbs wlk;
 
 	wlk.m_Data.m_Channel = s.m_Peer.m_Channel;
 	wlk.m_ID = s.m_Cursor;
 
-	for (db.EnumBbsCSeq(wlk); wlk.MoveNext(); )
+	for (m_This.m_Bbs.m_Store.EnumBbsCSeq(wlk); wlk.MoveNext(); )
 	{
 		SendBbsMsg(wlk.m_Data);
 		if (IsChocking())
@@ -3494,57 +3831,265 @@ void Node::Peer::OnMsg(proto::BbsResetSync&& msg)
 	if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
-	m_CursorBbs = m_This.m_Processor.get_DB().BbsFindCursor(msg.m_TimeFrom) - 1;
+	m_CursorBbs = m_This.m_Bbs.m_Store.BbsFindCursor(msg.m_TimeFrom) - 1;
 	BroadcastBbs();
 }
 
-void Node::Peer::OnMsg(proto::GetEvents&& msg)
+void Node::Readers::Initialize()
 {
-    proto::Events msgOut;
+    const Config& cfg = get_ParentObj().m_Cfg;
+    if (!cfg.m_ReadThreads)
+        return;
 
-    if (Flags::Viewer & m_Flags)
+    m_pEvtDone = io::AsyncEvent::create(io::Reactor::get_Current(), [this]() { OnDone(); });
+
+    m_vThreads.resize(cfg.m_ReadThreads);
+    for (uint32_t i = 0; i < cfg.m_ReadThreads; i++)
+        m_vThreads[i] = std::thread(&Readers::RunThread, this);
+}
+
+void Node::Readers::Stop()
+{
     {
-		Processor& p = m_This.m_Processor;
-		NodeDB& db = p.get_DB();
-        NodeDB::WalkerEvent wlk;
+        std::unique_lock<std::mutex> scope(m_Mutex);
+        m_bStop = true;
+    }
 
-        Height hLast = 0;
-        uint32_t nCount = 0;
+    m_Cv.notify_all();
 
-        bool bSkipAssets = (proto::LoginFlags::Extension::get(m_LoginFlags) < 6);
-        static_assert(proto::LoginFlags::Extension::Minimum < 6); // remove this logic when older protocol won't be supported
+    for (size_t i = 0; i < m_vThreads.size(); i++)
+        if (m_vThreads[i].joinable())
+            m_vThreads[i].join();
+
+    m_vThreads.clear();
+    m_qPending.clear();
+    m_qDone.clear();
+}
+
+void Node::Readers::Push(Peer& peer, Task::Ptr&& pTask)
+{
+    assert(!peer.m_pReadTask);
+    pTask->m_pPeer = &peer;
+    pTask->m_hSnapshot = get_ParentObj().m_Processor.m_Committed.m_Height;
+    peer.m_pReadTask = pTask;
+    peer.HoldOutgoing();
+
+    {
+        std::unique_lock<std::mutex> scope(m_Mutex);
+        m_qPending.push_back(std::move(pTask));
+    }
 
-        // we'll send up to s_Max num of events, even to older clients, they won't complain
-        static_assert(proto::Event::s_Max > proto::Event::s_Max0);
+    m_Cv.notify_one();
+}
+
+void Node::Readers::RunThread()
+{
+    NodeDB db;
+    try {
+        db.OpenReader(get_ParentObj().m_Cfg.m_sPathLocal.c_str());
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR() << "Reader db open failed: " << e.what();
+    }
 
-        Serializer ser;
+    while (true)
+    {
+        Task::Ptr pTask;
 
-        for (db.EnumEvents(wlk, msg.m_HeightMin); wlk.MoveNext(); hLast = wlk.m_Height)
         {
-            if ((nCount >= proto::Event::s_Max) && (wlk.m_Height != hLast))
+            std::unique_lock<std::mutex> scope(m_Mutex);
+            while (!m_bStop && m_qPending.empty())
+                m_Cv.wait(scope);
+
+            if (m_bStop)
                 break;
 
-			if (p.IsFastSync() && (wlk.m_Height > p.m_SyncData.m_h0))
-				break;
+            pTask = std::move(m_qPending.front());
+            m_qPending.pop_front();
+        }
+
+        if (db.IsOpen())
+        {
+            try {
+                pTask->Exec(db);
+                pTask->m_bOk = true;
+            }
+            catch (const std::exception& e) {
+                LOG_WARNING() << "Reader task failed: " << e.what();
+            }
+        }
 
-            if (bSkipAssets)
+        {
+            std::unique_lock<std::mutex> scope(m_Mutex);
+            m_qDone.push_back(std::move(pTask));
+        }
+
+        m_pEvtDone->post();
+    }
+}
+
+void Node::Readers::OnDone()
+{
+    while (true)
+    {
+        Task::Ptr pTask;
+
+        {
+            std::unique_lock<std::mutex> scope(m_Mutex);
+            if (m_qDone.empty())
+                break;
+
+            pTask = std::move(m_qDone.front());
+            m_qDone.pop_front();
+        }
+
+        Peer* pPeer = pTask->m_pPeer;
+        if (!pPeer)
+            continue; // orphaned
+
+        assert(pPeer->m_pReadTask == pTask);
+        pPeer->m_pReadTask.reset();
+        pPeer->ReleaseOutgoing();
+
+        try {
+            pTask->OnDone(*pPeer);
+            pPeer->FlushOutgoing();
+        }
+        catch (const std::exception& e) {
+            pPeer->OnExc(e);
+        }
+    }
+}
+
+void Node::Readers::OnRolledBack(Height h)
+{
+    // the pending tasks may see the reverted data (if it was committed)
+    for (PeerList::iterator it = get_ParentObj().m_lstPeers.begin(); get_ParentObj().m_lstPeers.end() != it; ++it)
+    {
+        Task* pTask = it->m_pReadTask.get();
+        if (pTask && (pTask->m_hSnapshot > h))
+            pTask->m_bStale = true;
+    }
+}
+
+struct Node::Readers::TaskEvents
+    :public Task
+{
+    struct Collector
+    {
+        Serializer m_Ser;
+        Height m_hLast = 0;
+        uint32_t m_nCount = 0;
+
+        void Reset()
+        {
+            m_Ser.reset();
+            m_hLast = 0;
+            m_nCount = 0;
+        }
+
+        // may be continued with the next range
+        void Collect(NodeDB& db, Height hMin, Height hMax, bool bSkipAssets)
+        {
+            NodeDB::WalkerEvent wlk;
+
+            // we'll send up to s_Max num of events, even to older clients, they won't complain
+            static_assert(proto::Event::s_Max > proto::Event::s_Max0);
+
+            for (db.EnumEvents(wlk, hMin); wlk.MoveNext(); m_hLast = wlk.m_Height)
             {
-                Deserializer der;
-                der.reset(wlk.m_Body.p, wlk.m_Body.n);
+                if ((m_nCount >= proto::Event::s_Max) && (wlk.m_Height != m_hLast))
+                    break;
+
+                if (wlk.m_Height > hMax)
+                    break;
+
+                if (bSkipAssets)
+                {
+                    Deserializer der;
+                    der.reset(wlk.m_Body.p, wlk.m_Body.n);
 
-                proto::Event::Type::Enum eType;
-                der & eType;
-                if (proto::Event::Type::AssetCtl == eType)
-                    continue; // skip
+                    proto::Event::Type::Enum eType;
+                    der & eType;
+                    if (proto::Event::Type::AssetCtl == eType)
+                        continue; // skip
+                }
+
+                m_Ser & wlk.m_Height;
+                m_Ser.WriteRaw(wlk.m_Body.p, wlk.m_Body.n);
+
+                m_nCount++;
             }
+        }
+    };
 
-            ser & wlk.m_Height;
-            ser.WriteRaw(wlk.m_Body.p, wlk.m_Body.n);
+    Height m_hMin;
+    Height m_hMax; // within the snapshot
+    bool m_bSkipAssets;
+    Collector m_Collector;
 
-            nCount++;   
-		}
+    static Height get_MaxHeight(const Processor& p)
+    {
+        return p.IsFastSync() ? p.m_SyncData.m_h0 : MaxHeight;
+    }
+
+    void Exec(NodeDB& db) override
+    {
+        m_Collector.Collect(db, m_hMin, m_hMax, m_bSkipAssets);
+    }
+
+    void OnDone(Peer& peer) override
+    {
+        Processor& p = peer.m_This.m_Processor;
+        Height hMax = get_MaxHeight(p);
+
+        if (!m_bOk || m_bStale)
+        {
+            // fallback
+            m_Collector.Reset();
+            m_Collector.Collect(p.get_DB(), m_hMin, hMax, m_bSkipAssets);
+        }
+        else
+        {
+            // complete with what was added after the snapshot
+            if (m_hMax < hMax)
+                m_Collector.Collect(p.get_DB(), std::max(m_hMin, m_hMax + 1), hMax, m_bSkipAssets);
+        }
+
+        proto::Events msg;
+        m_Collector.m_Ser.swap_buf(msg.m_Events);
+        peer.Send(msg);
+    }
+};
+
+void Node::Peer::OnMsg(proto::GetEvents&& msg)
+{
+    proto::Events msgOut;
+
+    if (Flags::Viewer & m_Flags)
+    {
+		Processor& p = m_This.m_Processor;
+
+        bool bSkipAssets = (proto::LoginFlags::Extension::get(m_LoginFlags) < 6);
+        static_assert(proto::LoginFlags::Extension::Minimum < 6); // remove this logic when older protocol won't be supported
+
+        Height hMax = Readers::TaskEvents::get_MaxHeight(p);
+
+        // the reader sees only the committed state, the rest is collected on completion
+        if (m_This.m_Readers.IsEnabled() && !m_pReadTask && (msg.m_HeightMin <= p.m_Committed.m_Height))
+        {
+            auto pTask = std::make_shared<Readers::TaskEvents>();
+            pTask->m_hMin = msg.m_HeightMin;
+            pTask->m_hMax = std::min(hMax, p.m_Committed.m_Height);
+            pTask->m_bSkipAssets = bSkipAssets;
+
+            m_This.m_Readers.Push(*this, std::move(pTask));
+            return;
+        }
 
-        ser.swap_buf(msgOut.m_Events);
+        Readers::TaskEvents::Collector c;
+        c.Collect(p.get_DB(), msg.m_HeightMin, hMax, bSkipAssets);
+        c.m_Ser.swap_buf(msgOut.m_Events);
     }
     else
         LOG_WARNING() << "Peer " << m_RemoteAddr << " Unauthorized Utxo events request.";
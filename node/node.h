@@ -15,6 +15,7 @@
 #pragma once
 
 #include "processor.h"
+#include "bbs_store.h"
 #include "utility/io/timer.h"
 #include "core/proto.h"
 #include "core/block_crypt.h"
@@ -73,13 +74,16 @@ struct Node
 		uint32_t m_MaxConcurrentBlocksRequest = 18;
 		uint32_t m_MaxPoolTransactions = 100 * 1000;
 		uint32_t m_MaxDeferredTransactions = 100 * 1000;
+		uint32_t m_DeferredTxBatch = 64; // deferred txs are verified in batches: in parallel, sharing the multi-exponentiation. Only with m_VerificationThreads > 0
 		uint32_t m_MiningThreads = 0; // by default disabled
+		uint32_t m_ReadThreads = 0; // serve heavy read-only requests (events, shielded proofs) from db snapshots, concurrently with the block processing. 0 - disabled
+		uint32_t m_IoThreads = 0; // serve the connections (socket I/O, encryption, deserialization) by dedicated threads, the messages are still handled by the node thread. 0 - disabled
 
 		bool m_LogEvents = false; // may be insecure. Off by default.
 		bool m_LogTxStem = true;
 		bool m_LogTxFluff = true;
 
-		// Number of verification threads for CPU-hungry cryptography. Currently used for block validation only.
+		// Number of verification threads for CPU-hungry cryptography. Used for block and deferred txs validation.
 		// 0: single threaded
 		// negative: number of cores minus number of mining threads.
 		int m_VerificationThreads = 0;
@@ -96,6 +100,7 @@ struct Node
 		{
 			uint32_t m_MessageTimeout_s = 3600 * 12; // 1/2 day
 			uint32_t m_CleanupPeriod_ms = 3600 * 1000; // 1 hour
+			uint32_t m_SegmentPeriod_s = 3600; // messages are stored in per-period segment files, expired segments are deleted as a whole
 
 			NodeDB::BbsTotals m_Limit;
 
@@ -121,6 +126,8 @@ struct Node
 			size_t m_MaxBodyPackSize = 1024 * 1024 * 5;
 			uint32_t m_MaxBodyPackCount = 3000;
 
+			size_t m_MaxRecoveryCache = 1024 * 1024 * 64; // recovery-form bodies served to the syncing peers. Set to 0 to disable
+
 		} m_BandwidthCtl;
 
 		struct TestMode {
@@ -203,6 +210,21 @@ struct Node
 	bool m_UpdatedFromPeers = false;
 	bool m_PostStartSynced = false;
 
+	struct TxValidationStats
+	{
+		// deferred txs (received from other nodes), validated in batches
+		uint64_t m_Txs = 0;
+		uint64_t m_Skipped = 0; // resolved without the crypto: rejected by the cheap checks, or duplicates
+		uint64_t m_Invalid = 0;
+		uint64_t m_Batches = 0;
+		uint64_t m_BatchesFailed = 0; // txs were re-verified individually
+		uint64_t m_Verify_ms = 0; // context-free verification, parallel
+		uint64_t m_Process_ms = 0; // context-dependent checks and pool insertion, on the reactor thread
+		uint64_t m_Wait_ms = 0; // total time txs spent in the deferred queue
+		uint32_t m_WaitMax_ms = 0;
+
+	} m_TxValidationStats;
+
 	bool GenerateRecoveryInfo(const char*);
 	void PrintTxos();
 	void PrintRollbackStats();
@@ -211,6 +233,53 @@ struct Node
 
 	bool DecodeAndCheckHdrs(std::vector<Block::SystemState::Full>&, const proto::HdrPack&);
 
+	struct RecoveryCache
+	{
+		// Perishable block parts in the recovery form (without range proofs), as served to the syncing peers.
+		// Flushed on rollback, since the spent outputs are pruned from the body wrt the active branch
+		struct Entry
+		{
+			struct Key
+				:public boost::intrusive::set_base_hook<>
+			{
+				uint64_t m_Row;
+				Height m_h0;
+				Height m_hLo1;
+				Height m_hHi1;
+
+				bool operator < (const Key&) const;
+				IMPLEMENT_GET_PARENT_OBJ(Entry, m_Key)
+			} m_Key;
+
+			struct Mru
+				:public boost::intrusive::list_base_hook<>
+			{
+				IMPLEMENT_GET_PARENT_OBJ(Entry, m_Mru)
+			} m_Mru;
+
+			ByteBuffer m_Body;
+		};
+
+		typedef boost::intrusive::set<Entry::Key> KeySet;
+		typedef boost::intrusive::list<Entry::Mru> MruList;
+
+		KeySet m_Keys;
+		MruList m_Mru;
+		size_t m_Size = 0;
+
+		~RecoveryCache() { ShrinkTo(0); }
+
+		const ByteBuffer* Find(const Entry::Key&); // modifies MRU if found
+		void Insert(const Entry::Key&, const ByteBuffer&, size_t nMaxSize);
+		void ShrinkTo(size_t);
+		void Delete(Entry&);
+
+		static size_t get_EntrySize(const ByteBuffer& buf) { return sizeof(Entry) + buf.size(); }
+
+	} m_RecoveryCache;
+
+	static void ConvertToRecovery1(ByteBuffer& perishable);
+
 private:
 
 	struct Processor
@@ -247,7 +316,10 @@ private:
 		bool BuildCwp();
 
 		void GenerateProofStateStrict(Merkle::HardProof&, Height);
-		void GenerateProofShielded(Merkle::Proof&, const uintBigFor<TxoID>::Type& mmrIdx);
+		void AppendProofShielded(Merkle::Proof&); // from the shielded mmr root to the state definition
+
+		static bool FindShielded(NodeDB&, const proto::GetProofShieldedOutp&, proto::ProofShieldedOutp&, TxoID& nMmrIdx);
+		static bool FindShielded(NodeDB&, const proto::GetProofShieldedInp&, proto::ProofShieldedInp&, TxoID& nMmrIdx);
 
 		bool m_bFlushPending = false;
 		io::Timer::Ptr m_pFlushTimer;
@@ -372,6 +444,7 @@ private:
 			Transaction::Ptr m_pTx;
 			PeerID m_Sender;
 			bool m_Fluff;
+			uint32_t m_Received_ms;
 		};
 
 		std::list<Element> m_lst;
@@ -381,10 +454,10 @@ private:
 		IMPLEMENT_GET_PARENT_OBJ(Node, m_TxDeferred)
 	} m_TxDeferred;
 
-	uint8_t OnTransaction(Transaction::Ptr&&, const PeerID*, bool bFluff);
+	uint8_t OnTransaction(Transaction::Ptr&&, const PeerID*, bool bFluff, const NodeProcessor::TxBatchEntry* pBatched = nullptr);
 	void OnTransactionDeferred(Transaction::Ptr&&, const PeerID*, bool bFluff);
-	uint8_t OnTransactionStem(Transaction::Ptr&&);
-	uint8_t OnTransactionFluff(Transaction::Ptr&&, const PeerID*, Dandelion::Element*);
+	uint8_t OnTransactionStem(Transaction::Ptr&&, const NodeProcessor::TxBatchEntry* pBatched = nullptr);
+	uint8_t OnTransactionFluff(Transaction::Ptr&&, const PeerID*, Dandelion::Element*, const NodeProcessor::TxBatchEntry* pBatched = nullptr);
 	void OnTransactionAggregated(Dandelion::Element&);
 	void PerformAggregation(Dandelion::Element&);
 	void AddDummyInputs(Transaction&);
@@ -393,7 +466,9 @@ private:
 	void AddDummyOutputs(Transaction&);
 	Height SampleDummySpentHeight();
 
-	uint8_t ValidateTx(Transaction::Context&, const Transaction&); // complete validation
+	uint8_t ValidateTx(Transaction::Context&, const Transaction&, const NodeProcessor::TxBatchEntry* pBatched); // complete validation, unless context-free part is already batch-verified
+	static uint8_t ValidateTxLimits(const Transaction&); // cheap context-free checks, before the crypto
+	bool IsTxVerificationNeeded(const Transaction&, bool bFluff); // false if OnTransaction would resolve it without the crypto (rejected or duplicate)
 	void LogTx(const Transaction&, uint8_t nStatus, const Transaction::KeyType&);
 	void LogTxStem(const Transaction&, const char* szTxt);
 
@@ -409,6 +484,8 @@ private:
 
 		static void CalcMsgKey(NodeDB::WalkerBbs::Data&);
 		uint32_t m_LastCleanup_ms = 0;
+		void Open();
+		void ImportFromDB();
 		void Cleanup();
 		void MaybeCleanup();
 		bool IsInLimits() const;
@@ -437,7 +514,7 @@ private:
 		Subscription::BbsSet m_Subscribed;
 		Timestamp m_HighestPosted_s = 0;
 
-		NodeDB::BbsTotals m_Totals;
+		BbsStore m_Store;
 
 		IMPLEMENT_GET_PARENT_OBJ(Node, m_Bbs)
 	} m_Bbs;
@@ -483,6 +560,53 @@ private:
 		IMPLEMENT_GET_PARENT_OBJ(Node, m_PeerMan)
 	} m_PeerMan;
 
+	// Threads that serve read-only requests via their own db connections (i.e. the last committed state), concurrently with the block processing.
+	// Until the response is ready, the outgoing messages to the peer are held, to keep the responses order.
+	// The part that isn't committed yet (or was reverted meanwhile) is completed on the node thread.
+	// Served this way: events and shielded proofs. The utxo proofs are not: the utxo tree is in-memory, and is modified in-place by the block processing.
+	// Neither the explorer requests, which are built from the NodeProcessor state.
+	struct Readers
+	{
+		struct Task
+		{
+			typedef std::shared_ptr<Task> Ptr;
+
+			Peer* m_pPeer = nullptr; // reset if the peer is deleted meanwhile
+			bool m_bOk = false;
+
+			// node thread only
+			Height m_hSnapshot = 0; // committed height when pushed
+			bool m_bStale = false; // rolled back below the snapshot meanwhile
+
+			virtual ~Task() {}
+			virtual void Exec(NodeDB&) = 0; // reader thread
+			virtual void OnDone(Peer&) = 0; // node thread
+		};
+
+		struct TaskEvents;
+		template <typename TMsg, typename TMsgOut> struct TaskShielded;
+
+		std::vector<std::thread> m_vThreads;
+		std::mutex m_Mutex;
+		std::condition_variable m_Cv;
+		std::deque<Task::Ptr> m_qPending;
+		std::deque<Task::Ptr> m_qDone;
+		bool m_bStop = false;
+		io::AsyncEvent::Ptr m_pEvtDone;
+
+		bool IsEnabled() const { return !m_vThreads.empty(); }
+		void Initialize();
+		void Stop();
+		void Push(Peer&, Task::Ptr&&);
+		void RunThread();
+		void OnDone();
+		void OnRolledBack(Height);
+
+		IMPLEMENT_GET_PARENT_OBJ(Node, m_Readers)
+	} m_Readers;
+
+	proto::NodeConnection::IoThreads m_IoThreads;
+
 	struct Peer
 		:public proto::NodeConnection
 		,public boost::intrusive::list_base_hook<>
@@ -523,6 +647,8 @@ private:
 		io::Timer::Ptr m_pTimerRequest;
 		io::Timer::Ptr m_pTimerPeers;
 
+		Readers::Task::Ptr m_pReadTask;
+
 		Peer(Node& n) :m_This(n) {}
 
 		void TakeTasks();
@@ -555,6 +681,7 @@ private:
 		void SendTx(Transaction::Ptr& ptx, bool bFluff);
 
 		// proto::NodeConnection
+		virtual IoThreads* get_IoThreads() override { return &m_This.m_IoThreads; }
 		virtual void OnConnectedSecure() override;
 		virtual void OnDisconnect(const DisconnectReason&) override;
 		virtual void GenerateSChannelNonce(ECC::Scalar::Native&) override; // Must be overridden to support SChannel
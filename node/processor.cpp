@@ -20,6 +20,8 @@
 #include "../utility/logger.h"
 #include "../utility/logger_checkpoints.h"
 #include <condition_variable>
+#include <chrono>
+#include <atomic>
 #include <cctype>
 
 namespace beam {
@@ -86,7 +88,7 @@ void NodeProcessor::Initialize(const char* szPath)
 
 void NodeProcessor::Initialize(const char* szPath, const StartParams& sp)
 {
-	m_DB.Open(szPath);
+	m_DB.Open(szPath, sp.m_SharedRead);
 	m_DbTx.Start(m_DB);
 
 	if (sp.m_CheckIntegrity)
@@ -153,6 +155,7 @@ void NodeProcessor::Initialize(const char* szPath, const StartParams& sp)
 	LogSyncData();
 
 	m_nSizeUtxoComission = 0;
+	m_nSizeTxMin = 0;
 
 	if (Rules::get().TreasuryChecksum == Zero)
 		m_Extra.m_TxosTreasury = 1; // artificial gap
@@ -163,10 +166,19 @@ void NodeProcessor::Initialize(const char* szPath, const StartParams& sp)
 	m_Mmr.m_States.m_Count = m_Cursor.m_Sid.m_Height - Rules::HeightGenesis;
 	InitCursor(false);
 
+	m_Committed.m_Height = m_Cursor.m_ID.m_Height;
+	m_Committed.m_Shielded = m_Mmr.m_Shielded.m_Count;
+
 	InitializeUtxos(szPath);
 
 	m_Extra.m_Txos = get_TxosBefore(m_Cursor.m_ID.m_Height + 1);
 
+	if (sp.m_PersistValCache)
+	{
+		get_ValCachePath(m_sValCachePath, szPath);
+		LoadValCache();
+	}
+
 	m_Horizon.Normalize();
 
 	uint64_t nFlags1 = m_DB.ParamIntGetDef(NodeDB::ParamID::Flags1);
@@ -254,18 +266,75 @@ int My_strcmpi(const char* sz1, const char* sz2)
 	return 0;
 }
 
-void NodeProcessor::get_UtxoMappingPath(std::string& sPath, const char* sz)
+void NodeProcessor::get_DerivedPath(std::string& sPath, const char* sz, const char* szSufix)
 {
-	// derive UTXO path from db path
 	sPath = sz;
 
-	static const char szSufix[] = ".db";
-	const size_t nSufix = _countof(szSufix) - 1;
+	static const char szDbSufix[] = ".db";
+	const size_t nSufix = _countof(szDbSufix) - 1;
 
-	if ((sPath.size() >= nSufix) && !My_strcmpi(sPath.c_str() + sPath.size() - nSufix, szSufix))
+	if ((sPath.size() >= nSufix) && !My_strcmpi(sPath.c_str() + sPath.size() - nSufix, szDbSufix))
 		sPath.resize(sPath.size() - nSufix);
 
-	sPath += "-utxo-image.bin";
+	sPath += szSufix;
+}
+
+void NodeProcessor::get_UtxoMappingPath(std::string& sPath, const char* sz)
+{
+	// derive UTXO path from db path
+	get_DerivedPath(sPath, sz, "-utxo-image.bin");
+}
+
+void NodeProcessor::get_ValCachePath(std::string& sPath, const char* sz)
+{
+	get_DerivedPath(sPath, sz, "-validated.bin");
+}
+
+void NodeProcessor::get_BbsPath(std::string& sPath, const char* sz)
+{
+	get_DerivedPath(sPath, sz, "-bbs");
+}
+
+void NodeProcessor::get_ValCacheStamp(Merkle::Hash& hv)
+{
+	// the cached shielded proofs are valid for the current shielded set, output proofs depend only on the rules
+	ECC::Hash::Processor()
+		<< "vc.stamp"
+		<< Rules::get().get_LastFork().m_Hash
+		<< m_Cursor.m_ID.m_Height
+		<< m_Cursor.m_ID.m_Hash
+		<< m_Extra.m_ShieldedOutputs
+		>> hv;
+}
+
+void NodeProcessor::LoadValCache()
+{
+	Merkle::Hash hv;
+	get_ValCacheStamp(hv);
+
+	try {
+		if (m_ValCache.Load(m_sValCachePath.c_str(), hv))
+		{
+			m_ValCache.OnShLo(m_Extra.m_ShieldedOutputs);
+			LOG_INFO() << "Validated cache loaded, " << m_ValCache.get_Count() << " entries";
+		}
+	}
+	catch (const std::exception& e) {
+		LOG_WARNING() << "Validated cache not loaded: " << e.what();
+	}
+}
+
+void NodeProcessor::SaveValCache()
+{
+	Merkle::Hash hv;
+	get_ValCacheStamp(hv);
+
+	try {
+		m_ValCache.Save(m_sValCachePath.c_str(), hv);
+	}
+	catch (const std::exception& e) {
+		LOG_WARNING() << "Validated cache not saved: " << e.what();
+	}
 }
 
 bool NodeProcessor::InitUtxoMapping(const char* sz, bool bForceReset)
@@ -339,6 +408,9 @@ NodeProcessor::~NodeProcessor()
 			LOG_ERROR() << "DB Commit failed: %s" << e.m_sErr;
 		}
 	}
+
+	if (!m_sValCachePath.empty())
+		SaveValCache();
 }
 
 void NodeProcessor::CommitUtxosAndDB()
@@ -362,6 +434,9 @@ void NodeProcessor::CommitUtxosAndDB()
 
 	m_DbTx.Commit();
 
+	m_Committed.m_Height = m_Cursor.m_ID.m_Height;
+	m_Committed.m_Shielded = m_Mmr.m_Shielded.m_Count;
+
 	if (bFlushUtxos)
 		m_Utxos.FlushStrict(us);
 }
@@ -918,7 +993,7 @@ struct NodeProcessor::MultiShieldedContext
 	void MoveToGlobalCache(ValidatedCache& vc)
 	{
 		m_Vc.MoveInto(vc);
-		vc.ShrinkTo(10 * 1024);
+		vc.Shrink();
 	}
 
 	bool IsValid(const TxVectors::Eternal&, ECC::InnerProduct::BatchContext&, uint32_t iVerifier, uint32_t nTotal, ValidatedCache&);
@@ -1077,6 +1152,14 @@ bool NodeProcessor::MultiAssetContext::BatchCtx::IsValid(ECC::Point::Native& hGe
 	return true;
 }
 
+namespace
+{
+	uint64_t GetTime_us()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
 struct NodeProcessor::MultiblockContext
 {
 	NodeProcessor& m_This;
@@ -1127,6 +1210,41 @@ struct NodeProcessor::MultiblockContext
 	MultiShieldedContext m_Msc;
 	MultiAssetContext m_Mac;
 
+	struct ProofCache
+		:public TxBase::Context::Params::IProofCache
+	{
+		NodeProcessor& m_This;
+		std::mutex& m_Mutex; // shared with m_Msc, both access the global cache
+		ValidatedCache m_Vc; // pending, until the batch is verified
+		bool m_Remember = false; // for txs. Block outputs aren't expected to be seen again
+
+		ProofCache(NodeProcessor& np, std::mutex& mx) :m_This(np), m_Mutex(mx) {}
+
+		virtual bool IsVerified(const ECC::Hash::Value& hv) override
+		{
+			std::unique_lock<std::mutex> scope(m_Mutex);
+			return
+				m_Vc.Find(hv) ||
+				m_This.m_ValCache.Find(hv);
+		}
+
+		virtual void OnVerified(const ECC::Hash::Value& hv) override
+		{
+			if (m_Remember)
+			{
+				std::unique_lock<std::mutex> scope(m_Mutex);
+				m_Vc.Insert(hv, 0);
+			}
+		}
+
+		void MoveToGlobalCache()
+		{
+			m_Vc.MoveInto(m_This.m_ValCache);
+			m_This.m_ValCache.Shrink();
+		}
+
+	} m_Pc{ m_This, m_Msc.m_Mutex };
+
 	size_t m_SizePending = 0;
 	bool m_bFail = false;
 	bool m_bBatchDirty = false;
@@ -1180,9 +1298,87 @@ struct NodeProcessor::MultiblockContext
 		uint32_t m_iVerifier;
 	};
 
+	struct Decoded
+	{
+		typedef std::shared_ptr<Decoded> Ptr;
+
+		uint64_t m_Row;
+		ByteBuffer m_bbP;
+		ByteBuffer m_bbE;
+		MyTask::SharedBlock::Ptr m_pShared;
+		std::atomic<bool> m_bClaimed{ false }; // either by the task, or by the consumer (if the task didn't start yet)
+		bool m_bDone = false;
+		bool m_bOk = false;
+
+		void Decode(MultiblockContext&);
+	};
+
+	struct DecodeTask
+		:public Executor::TaskAsync
+	{
+		MultiblockContext* m_pMbc;
+		Decoded::Ptr m_pD;
+
+		virtual void Exec(Executor::Context&) override;
+	};
+
+	std::deque<Decoded::Ptr> m_qDecoded;
+
+	void Prefetch(uint64_t row)
+	{
+		// the DB is accessed on this thread only, the deserialization is deferred
+		Decoded::Ptr pD = std::make_shared<Decoded>();
+		pD->m_Row = row;
+		pD->m_pShared = std::make_shared<MyTask::SharedBlock>(*this);
+		m_This.m_DB.GetStateBlock(row, &pD->m_bbP, &pD->m_bbE, nullptr);
+		pD->m_pShared->m_Size = pD->m_bbP.size() + pD->m_bbE.size();
+
+		m_qDecoded.push_back(pD);
+
+		std::unique_ptr<DecodeTask> pTask(new DecodeTask);
+		pTask->m_pMbc = this;
+		pTask->m_pD = std::move(pD);
+		m_This.get_Executor().Push(std::move(pTask));
+	}
+
+	Decoded::Ptr PopDecoded(uint64_t row)
+	{
+		assert(!m_qDecoded.empty() && (m_qDecoded.front()->m_Row == row));
+		Decoded::Ptr pD = std::move(m_qDecoded.front());
+		m_qDecoded.pop_front();
+
+		if (!pD->m_bClaimed.exchange(true))
+		{
+			// the task is still queued (probably behind the verification tasks), don't wait for it
+			pD->Decode(*this);
+			return pD;
+		}
+
+		uint64_t t0_us = GetTime_us();
+
+		Executor& ex = m_This.get_Executor();
+		for (uint32_t nTasks = static_cast<uint32_t>(-1); ; )
+		{
+			{
+				std::unique_lock<std::mutex> scope(m_Mutex);
+				if (pD->m_bDone)
+					break;
+			}
+
+			assert(nTasks);
+			nTasks = ex.Flush(nTasks - 1);
+		}
+
+		m_This.m_BlockPipelineStats.m_DecodeWait_us += GetTime_us() - t0_us;
+		return pD;
+	}
+
 	bool Flush()
 	{
+		uint64_t t0_us = GetTime_us();
 		FlushInternal();
+		m_This.m_BlockPipelineStats.m_VerifyWait_us += GetTime_us() - t0_us;
+
 		return !m_bFail;
 	}
 
@@ -1282,6 +1478,7 @@ struct NodeProcessor::MultiblockContext
 		m_InProgress.m_Min = m_InProgress.m_Max + 1;
 
 		m_Msc.MoveToGlobalCache(m_This.m_ValCache);
+		m_Pc.MoveToGlobalCache();
 	}
 
 	void OnBlock(const PeerID& pid, const MyTask::SharedBlock::Ptr& pShared)
@@ -1306,6 +1503,8 @@ struct NodeProcessor::MultiblockContext
 
 		const size_t nSizeMax = 1024 * 1024 * 10; // fair enough
 
+		uint64_t t0_us = GetTime_us();
+
 		Executor& ex = m_This.get_Executor();
 		for (uint32_t nTasks = static_cast<uint32_t>(-1); ; )
 		{
@@ -1322,6 +1521,8 @@ struct NodeProcessor::MultiblockContext
 			nTasks = ex.Flush(nTasks - 1);
 		}
 
+		m_This.m_BlockPipelineStats.m_VerifyWait_us += GetTime_us() - t0_us;
+
 		// The following won't hold if some blocks in the current range were already verified in the past, and omitted from the current verification
 		//		m_InProgress.m_Max++;
 		//		assert(m_InProgress.m_Max == pShared->m_Ctx.m_Height.m_Min);
@@ -1344,6 +1545,9 @@ struct NodeProcessor::MultiblockContext
 		pars.m_pAbort = &m_bFail;
 		pars.m_nVerifiers = ex.get_Threads();
 
+		if (m_Pc.m_Remember || !m_This.m_ValCache.m_MruOutputs.empty())
+			pars.m_pProofCache = &m_Pc;
+
 		for (uint32_t i = 0; i < pars.m_nVerifiers; i++)
 		{
 			std::unique_ptr<MyTask> pTask(new MyTask);
@@ -1388,6 +1592,45 @@ struct NodeProcessor::MultiblockContext
 	}
 };
 
+void NodeProcessor::MultiblockContext::DecodeTask::Exec(Executor::Context&)
+{
+	if (!m_pD->m_bClaimed.exchange(true))
+		m_pD->Decode(*m_pMbc);
+}
+
+void NodeProcessor::MultiblockContext::Decoded::Decode(MultiblockContext& mbc)
+{
+	uint64_t t0_us = GetTime_us();
+
+	Decoded& d = *this;
+	Block::Body& block = d.m_pShared->m_Body;
+
+	try {
+		// all the block elements in a few contiguous chunks, released at once with the block
+		Arena::Local arena(d.m_bbP.size() + d.m_bbE.size());
+
+		Deserializer der;
+		der.reset(d.m_bbP);
+		der & Cast::Down<Block::BodyBase>(block);
+		der & Cast::Down<TxVectors::Perishable>(block);
+
+		der.reset(d.m_bbE);
+		der & Cast::Down<TxVectors::Eternal>(block);
+
+		d.m_bOk = true;
+	}
+	catch (const std::exception&) {
+	}
+
+	ByteBuffer().swap(d.m_bbE); // not needed anymore
+
+	uint64_t dt_us = GetTime_us() - t0_us;
+
+	std::unique_lock<std::mutex> scope(mbc.m_Mutex);
+	mbc.m_This.m_BlockPipelineStats.m_Decode_us += dt_us;
+	d.m_bDone = true;
+}
+
 void NodeProcessor::MultiblockContext::MyTask::Exec(Executor::Context&)
 {
 	MultiAssetContext::BatchCtx bcAssets(m_pShared->m_Mbc.m_Mac);
@@ -1508,15 +1751,28 @@ void NodeProcessor::TryGoTo(NodeDB::StateID& sidTrg)
 	NodeDB::StateID sidFwd = m_Cursor.m_Sid;
 
 	size_t iPos = vPath.size();
+	size_t iPrefetch = iPos; // vPath[iPrefetch..iPos) are decoded or in progress
 	while (iPos)
 	{
+		while (iPrefetch && (iPos - iPrefetch <= m_DecodeAhead))
+			mbc.Prefetch(vPath[--iPrefetch]);
+
 		sidFwd.m_Height = m_Cursor.m_Sid.m_Height + 1;
 		sidFwd.m_Row = vPath[--iPos];
 
 		Block::SystemState::Full s;
 		m_DB.get_State(sidFwd.m_Row, s); // need it for logging anyway
 
-		if (!HandleBlock(sidFwd, s, mbc))
+		BlockPipelineStats& st = m_BlockPipelineStats;
+		uint64_t tWait0_us = st.m_DecodeWait_us + st.m_VerifyWait_us;
+		uint64_t t0_us = GetTime_us();
+
+		bool bOk = HandleBlock(sidFwd, s, mbc);
+
+		st.m_Blocks++;
+		st.m_Apply_us += (GetTime_us() - t0_us) - (st.m_DecodeWait_us + st.m_VerifyWait_us - tWait0_us);
+
+		if (!bOk)
 		{
 			bContextFail = mbc.m_bFail = true;
 
@@ -1909,7 +2165,7 @@ bool NodeProcessor::Evaluator::get_History(Merkle::Hash& hv)
 
 bool NodeProcessor::Evaluator::get_Utxos(Merkle::Hash& hv)
 {
-	m_Proc.m_Utxos.get_Hash(hv);
+	m_Proc.m_Utxos.get_Hash(hv, m_Proc.get_Executor());
 	return true;
 }
 
@@ -2199,6 +2455,9 @@ struct NodeProcessor::KrnFlyMmr
 
 bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, const Block::SystemState::Full& s, MultiblockContext& mbc)
 {
+	MultiblockContext::Decoded::Ptr pD = mbc.PopDecoded(sid.m_Row);
+	MultiblockContext::Decoded& d = *pD;
+
 	if (s.m_Height == m_sidForbidden.m_Height)
 	{
 		Merkle::Hash hv;
@@ -2210,30 +2469,19 @@ bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, const Block::SystemS
 		}
 	}
 
-	ByteBuffer bbP, bbE;
-	m_DB.GetStateBlock(sid.m_Row, &bbP, &bbE, nullptr);
-
-	MultiblockContext::MyTask::SharedBlock::Ptr pShared = std::make_shared<MultiblockContext::MyTask::SharedBlock>(mbc);
-	Block::Body& block = pShared->m_Body;
-
-	try {
-		Deserializer der;
-		der.reset(bbP);
-		der & Cast::Down<Block::BodyBase>(block);
-		der & Cast::Down<TxVectors::Perishable>(block);
-
-		der.reset(bbE);
-		der & Cast::Down<TxVectors::Eternal>(block);
-	}
-	catch (const std::exception&) {
+	if (!d.m_bOk)
+	{
 		LOG_WARNING() << LogSid(m_DB, sid) << " Block deserialization failed";
 		return false;
 	}
 
+	ByteBuffer& bbP = d.m_bbP; // reused for the rollback data
+	MultiblockContext::MyTask::SharedBlock::Ptr& pShared = d.m_pShared;
+	Block::Body& block = pShared->m_Body;
+
 	bool bFirstTime = (m_DB.get_StateTxos(sid.m_Row) == MaxHeight);
 	if (bFirstTime)
 	{
-		pShared->m_Size = bbP.size() + bbE.size();
 		pShared->m_Ctx.m_Height = sid.m_Height;
 
 		PeerID pid;
@@ -3845,6 +4093,9 @@ void NodeProcessor::RollbackTo(Height h)
 	if (!TestDefinition())
 		OnCorrupted();
 
+	std::setmin(m_Committed.m_Height, m_Cursor.m_ID.m_Height);
+	std::setmin(m_Committed.m_Shielded, m_Mmr.m_Shielded.m_Count);
+
 	OnRolledBack();
 }
 
@@ -4355,6 +4606,18 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 		m_nSizeUtxoComission = ssc2.m_Counter.m_Value;
 	}
 
+	if (!m_nSizeTxMin)
+	{
+		// the smallest possible tx: a single default kernel
+		Transaction tx;
+		tx.m_Offset = Zero;
+		tx.m_vKernels.emplace_back(new TxKernelStd);
+
+		TxPool::Profit x;
+		x.SetSize(tx);
+		m_nSizeTxMin = x.m_nSize;
+	}
+
 	if (bc.m_Fees)
 		ssc.m_Counter.m_Value += m_nSizeUtxoComission;
 
@@ -4368,8 +4631,16 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 
 	size_t nTxNum = 0;
 
+	TxPool::Fluff::Template& tpl = bc.m_TxPool.m_Template;
+	tpl.m_Generation++;
+	tpl.m_Threshold.m_Fee = Zero;
+	tpl.m_Threshold.m_nSize = 0;
+
 	for (TxPool::Fluff::ProfitSet::iterator it = bc.m_TxPool.m_setProfit.begin(); bc.m_TxPool.m_setProfit.end() != it; )
 	{
+		if (ssc.m_Counter.m_Value + m_nSizeTxMin > nSizeMax)
+			break; // full, no need to walk through the rest of the pool
+
 		TxPool::Fluff::Element& x = (it++)->get_ParentObj();
 
 		if (AmountBig::get_Hi(x.m_Profit.m_Fee))
@@ -4414,6 +4685,10 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 				ssc.m_Counter.m_Value = nSizeNext;
 				offset += ECC::Scalar::Native(tx.m_Offset);
 				++nTxNum;
+
+				x.m_Template = tpl.m_Generation;
+				tpl.m_Threshold.m_Fee = x.m_Profit.m_Fee;
+				tpl.m_Threshold.m_nSize = x.m_Profit.m_nSize;
 			}
 			else
 			{
@@ -4430,6 +4705,9 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 
 	LOG_INFO() << "GenerateNewBlock: size of block = " << ssc.m_Counter.m_Value << "; amount of tx = " << nTxNum;
 
+	tpl.m_SizeRemaining = nSizeMax - ssc.m_Counter.m_Value;
+	tpl.m_Dirty = false;
+
 	if (BlockContext::Mode::Assemble != bc.m_Mode)
 	{
 		if (bc.m_Fees)
@@ -4520,7 +4798,10 @@ bool NodeProcessor::GenerateNewBlock(BlockContext& bc)
 		bc.m_Block.m_vInputs[i]->m_Internal.m_Maturity = 0;
 
 	if (!nSizeEstimated)
+	{
+		bc.m_TxPool.m_Template.m_Dirty = true;
 		return false;
+	}
 
 	if (BlockContext::Mode::Assemble == bc.m_Mode)
 	{
@@ -4544,6 +4825,7 @@ bool NodeProcessor::GenerateNewBlock(BlockContext& bc)
 	if (!bOk)
 	{
 		LOG_WARNING() << "couldn't apply block after cut-through!";
+		bc.m_TxPool.m_Template.m_Dirty = true;
 		return false; // ?!
 	}
 	GenerateNewHdr(bc);
@@ -4653,6 +4935,7 @@ bool NodeProcessor::ValidateAndSummarize(TxBase::Context& ctx, const TxBase& txb
 	};
 
 	MultiblockContext mbc(*this);
+	mbc.m_Pc.m_Remember = true;
 
 	std::shared_ptr<MyShared> pShared = std::make_shared<MyShared>(mbc);
 
@@ -4667,6 +4950,109 @@ bool NodeProcessor::ValidateAndSummarize(TxBase::Context& ctx, const TxBase& txb
 	return mbc.Flush();
 }
 
+bool NodeProcessor::ValidateAndSummarizeBatch(TxBatchEntry* pE, uint32_t nCount)
+{
+	std::vector<TxBatchItem> v;
+	v.resize(nCount);
+
+	for (uint32_t i = 0; i < nCount; i++)
+	{
+		TxBatchItem& x = v[i];
+		x.m_pE = pE + i;
+		x.m_Hr = x.m_pE->m_pCtx->m_Height;
+	}
+
+	if (ValidateBatchInternal(&v.front(), nCount))
+		return true;
+
+	BisectBatch(&v.front(), nCount);
+	return false;
+}
+
+bool NodeProcessor::ValidateBatchInternal(TxBatchItem* p, uint32_t nCount)
+{
+	struct MyShared
+		:public MultiblockContext::MyTask::Shared
+	{
+		TxBatchEntry* m_pE;
+
+		MyShared(MultiblockContext& mbc)
+			:MultiblockContext::MyTask::Shared(mbc)
+		{
+		}
+
+		virtual ~MyShared() {} // auto
+
+		virtual void Exec(uint32_t) override
+		{
+			// don't fail the whole batch, other txs are independent. Though the batch is likely to fail, if an invalid tx has already added its terms
+			TxBase::Context& ctxOut = *m_pE->m_pCtx;
+			const Transaction& tx = *m_pE->m_pTx;
+
+			TxBase::Context::Params pars = ctxOut.m_Params;
+			pars.m_pProofCache = &m_Mbc.m_Pc;
+
+			TxBase::Context ctx(pars);
+			ctx.m_Height = ctxOut.m_Height;
+			ctx.m_iVerifier = ctxOut.m_iVerifier;
+
+			m_pE->m_bValid = ctx.ValidateAndSummarize(tx, tx.get_Reader()) && ctx.IsValidTransaction();
+
+			ctxOut.m_Sigma = ctx.m_Sigma;
+			ctxOut.m_Stats = ctx.m_Stats;
+			ctxOut.m_Height = ctx.m_Height;
+		}
+	};
+
+	MultiblockContext mbc(*this);
+	mbc.m_InProgress.m_Max++; // dummy, just to emulate ongoing progress
+	mbc.m_bBatchDirty = true;
+	mbc.m_Pc.m_Remember = true;
+
+	Executor& ex = get_Executor();
+
+	for (uint32_t i = 0; i < nCount; i++)
+	{
+		TxBatchEntry& e = *p[i].m_pE;
+		assert(1 == e.m_pCtx->m_Params.m_nVerifiers);
+		e.m_pCtx->m_Height = p[i].m_Hr; // could be narrowed by the previous attempt
+
+		std::shared_ptr<MyShared> pShared = std::make_shared<MyShared>(mbc);
+		pShared->m_pE = &e;
+
+		std::unique_ptr<MultiblockContext::MyTask> pTask(new MultiblockContext::MyTask);
+		pTask->m_pShared = std::move(pShared);
+		pTask->m_iVerifier = 0;
+		ex.Push(std::move(pTask));
+	}
+
+	return mbc.Flush();
+}
+
+void NodeProcessor::BisectBatch(TxBatchItem* p, uint32_t nCount)
+{
+	// The batch of those has failed. Those that failed on their own are invalid, the rest are re-verified in halves
+	if (1 == nCount)
+	{
+		p->m_pE->m_bValid = false;
+		return;
+	}
+
+	uint32_t nValid = 0;
+	for (uint32_t i = 0; i < nCount; i++)
+		if (p[i].m_pE->m_bValid)
+			p[nValid++] = p[i];
+
+	uint32_t n0 = nValid / 2;
+	uint32_t n1 = nValid - n0;
+
+	if (n0 && !ValidateBatchInternal(p, n0))
+		BisectBatch(p, n0);
+
+	if (n1 && !ValidateBatchInternal(p + n0, n1))
+		BisectBatch(p + n0, n1);
+}
+
 bool NodeProcessor::ExtractBlockWithExtra(Block::Body& block, std::vector<Output::Ptr>& vOutsIn, const NodeDB::StateID& sid)
 {
 	ByteBuffer bbE;
@@ -5223,10 +5609,12 @@ int NodeProcessor::get_AssetAt(Asset::Full& ai, Height h)
 	return 1;
 }
 
-void NodeProcessor::ValidatedCache::ShrinkTo(uint32_t n)
+void NodeProcessor::ValidatedCache::ShrinkTo(uint32_t nShielded, uint32_t nOutputs)
 {
-	while (m_Mru.size() > n)
-		Delete(m_Mru.back().get_ParentObj());
+	while (m_MruShielded.size() > nShielded)
+		Delete(m_MruShielded.back().get_ParentObj());
+	while (m_MruOutputs.size() > nOutputs)
+		Delete(m_MruOutputs.back().get_ParentObj());
 }
 
 void NodeProcessor::ValidatedCache::OnShLo(const Entry::ShLo::Type& nShLo)
@@ -5249,7 +5637,7 @@ void NodeProcessor::ValidatedCache::RemoveRaw(Entry& x)
 {
 	m_Keys.erase(KeySet::s_iterator_to(x.m_Key));
 	m_ShLo.erase(ShLoSet::s_iterator_to(x.m_ShLo));
-	m_Mru.erase(MruList::s_iterator_to(x.m_Mru));
+	get_Mru(x).erase(MruList::s_iterator_to(x.m_Mru));
 }
 
 void NodeProcessor::ValidatedCache::Delete(Entry& x)
@@ -5260,8 +5648,9 @@ void NodeProcessor::ValidatedCache::Delete(Entry& x)
 
 void NodeProcessor::ValidatedCache::MoveToFront(Entry& x)
 {
-	m_Mru.erase(MruList::s_iterator_to(x.m_Mru));
-	m_Mru.push_front(x.m_Mru);
+	MruList& mru = get_Mru(x);
+	mru.erase(MruList::s_iterator_to(x.m_Mru));
+	mru.push_front(x.m_Mru);
 }
 
 bool NodeProcessor::ValidatedCache::Find(const Entry::Key::Type& val)
@@ -5283,24 +5672,158 @@ void NodeProcessor::ValidatedCache::Insert(const Entry::Key::Type& val, const En
 	pEntry->m_Key.m_Value = val;
 	pEntry->m_ShLo.m_End = nShLo;
 
-	InsertRaw(*pEntry);
+	if (!InsertRaw(*pEntry))
+		delete pEntry;
 }
 
-void NodeProcessor::ValidatedCache::InsertRaw(Entry& x)
+bool NodeProcessor::ValidatedCache::InsertRaw(Entry& x)
 {
-	m_Keys.insert(x.m_Key);
+	if (!m_Keys.insert(x.m_Key).second)
+		return false;
+
 	m_ShLo.insert(x.m_ShLo);
-	m_Mru.push_front(x.m_Mru);
+	get_Mru(x).push_front(x.m_Mru);
+	return true;
 }
 
 void NodeProcessor::ValidatedCache::MoveInto(ValidatedCache& dst)
 {
-	while (!m_Mru.empty())
+	for (MruList* pMru : { &m_MruShielded, &m_MruOutputs })
 	{
-		Entry& x = m_Mru.back().get_ParentObj();
-		RemoveRaw(x);
-		dst.InsertRaw(x);
+		while (!pMru->empty())
+		{
+			Entry& x = pMru->back().get_ParentObj();
+			RemoveRaw(x);
+
+			// could be verified and cached concurrently by another context (e.g. a tx and a block)
+			if (dst.InsertRaw(x))
+				continue;
+
+			dst.Find(x.m_Key.m_Value); // just refresh it
+			delete &x;
+		}
 	}
 }
 
+namespace
+{
+	struct ValCacheFile
+	{
+		struct Hdr
+		{
+			Merkle::Hash m_Stamp;
+			MappedFile::Offset m_Head; // records in MRU order
+			uint64_t m_Count;
+		};
+
+		struct Rec
+		{
+			MappedFile::Offset m_Next;
+			ECC::Hash::Value m_Key;
+			TxoID m_ShLo;
+		};
+
+		static void get_Defs(MappedFile::Defs& d)
+		{
+			// change this when format changes
+			static const uint8_t s_pSig[] = {
+				0x5B, 0x31, 0xC2, 0x7E,
+				0x08, 0x9D, 0xA4, 0x63,
+				0xF1, 0x27, 0x4E, 0xB0,
+				0x96, 0x0C, 0x3A, 0xD5
+			};
+
+			d.m_pSig = s_pSig;
+			d.m_nSizeSig = sizeof(s_pSig);
+			d.m_nBanks = 1;
+			d.m_nFixedHdr = sizeof(Hdr);
+		}
+	};
+}
+
+void NodeProcessor::ValidatedCache::Save(const char* szPath, const Merkle::Hash& hvStamp) const
+{
+	MappedFile::Defs d;
+	ValCacheFile::get_Defs(d);
+
+	MappedFile mf;
+	mf.Open(szPath, d, true);
+
+	// the mapping may move on each allocation, track offsets only
+	MappedFile::Offset nPrev = 0;
+	uint64_t nCount = 0;
+
+	// both lists, each in its MRU order. Load sorts them out by ShLo
+	auto fnSaveList = [&](const MruList& mru, uint32_t nMax)
+	{
+		uint32_t i = 0;
+		for (MruList::const_iterator it = mru.begin(); (mru.end() != it) && (i < nMax); it++, i++, nCount++)
+		{
+			const Entry& x = it->get_ParentObj();
+
+			ValCacheFile::Rec* pRec = static_cast<ValCacheFile::Rec*>(mf.Allocate(0, sizeof(ValCacheFile::Rec)));
+			pRec->m_Next = 0;
+			pRec->m_Key = x.m_Key.m_Value;
+			pRec->m_ShLo = x.m_ShLo.m_End;
+
+			MappedFile::Offset n = mf.get_Offset(pRec);
+			if (nPrev)
+				mf.get_At<ValCacheFile::Rec>(nPrev).m_Next = n;
+			else
+				static_cast<ValCacheFile::Hdr*>(mf.get_FixedHdr())->m_Head = n;
+
+			nPrev = n;
+		}
+	};
+
+	fnSaveList(m_MruShielded, s_MaxShielded);
+	fnSaveList(m_MruOutputs, s_MaxOutputs);
+
+	ValCacheFile::Hdr& h = *static_cast<ValCacheFile::Hdr*>(mf.get_FixedHdr());
+	h.m_Count = nCount;
+	h.m_Stamp = hvStamp; // last, after all the data is written
+}
+
+bool NodeProcessor::ValidatedCache::Load(const char* szPath, const Merkle::Hash& hvStamp)
+{
+	MappedFile::Defs d;
+	ValCacheFile::get_Defs(d);
+
+	MappedFile mf;
+	mf.Open(szPath, d);
+
+	ValCacheFile::Hdr& h = *static_cast<ValCacheFile::Hdr*>(mf.get_FixedHdr());
+	bool bMatch = (h.m_Stamp == hvStamp);
+
+	if (bMatch)
+	{
+		MappedFile::Offset n = h.m_Head;
+		for (uint64_t i = 0; (i < h.m_Count) && (i < s_MaxShielded + s_MaxOutputs) && n; i++)
+		{
+			const ValCacheFile::Rec& r = mf.get_At<ValCacheFile::Rec>(n);
+			n = r.m_Next;
+
+			// the file is in MRU order, append at the back
+			Entry* pEntry(new Entry);
+			pEntry->m_Key.m_Value = r.m_Key;
+			pEntry->m_ShLo.m_End = r.m_ShLo;
+
+			MruList& mru = get_Mru(*pEntry);
+			if ((mru.size() >= (r.m_ShLo ? s_MaxShielded : s_MaxOutputs)) || !m_Keys.insert(pEntry->m_Key).second)
+			{
+				delete pEntry; // over the budget, or a duplicate
+				continue;
+			}
+
+			m_ShLo.insert(pEntry->m_ShLo);
+			mru.push_back(pEntry->m_Mru);
+		}
+	}
+
+	// consumed. Don't reuse it if the node doesn't shut down properly
+	h.m_Stamp = Zero;
+
+	return bMatch;
+}
+
 } // namespace beam
@@ -38,6 +38,7 @@ class NodeProcessor
 	UtxoTreeMapped m_Utxos;
 
 	size_t m_nSizeUtxoComission;
+	uint32_t m_nSizeTxMin; // lower bound, for the block template
 
 	struct MultiblockContext;
 	struct MultiSigmaContext;
@@ -110,6 +111,12 @@ class NodeProcessor
 	void InitCursor(bool bMovingUp);
 	bool InitUtxoMapping(const char*, bool bForceReset);
 	void InitializeUtxos(const char*);
+	static void get_DerivedPath(std::string&, const char* szDb, const char* szSufix);
+
+	std::string m_sValCachePath; // empty if not persistent
+	void get_ValCacheStamp(Merkle::Hash&);
+	void LoadValCache();
+	void SaveValCache();
 	static void OnCorrupted();
 
 	typedef std::pair<int64_t, std::pair<int64_t, Difficulty::Raw> > THW; // Time-Height-Work. Time and Height are signed
@@ -173,12 +180,16 @@ public:
 		bool m_Vacuum = false;
 		bool m_ResetSelfID = false;
 		bool m_EraseSelfID = false;
+		bool m_PersistValCache = true; // keep the validated proofs across restarts
+		bool m_SharedRead = false; // allow concurrent read-only db connections (NodeDB::OpenReader)
 	};
 
 	void Initialize(const char* szPath);
 	void Initialize(const char* szPath, const StartParams&);
 
 	static void get_UtxoMappingPath(std::string&, const char*);
+	static void get_ValCachePath(std::string&, const char*);
+	static void get_BbsPath(std::string&, const char*);
 
 	NodeProcessor();
 	virtual ~NodeProcessor();
@@ -208,6 +219,22 @@ public:
 
 	} m_Horizon;
 
+	// Blocks are loaded and deserialized this much in advance (on the executor), while the current block is interpreted
+	uint32_t m_DecodeAhead = 8;
+
+	struct BlockPipelineStats
+	{
+		// cumulative, for the blocks handled on the way up
+		uint32_t m_Blocks = 0;
+		uint64_t m_Decode_us = 0; // deserialization, on the executor
+		uint64_t m_DecodeWait_us = 0; // the interpretation awaited the decoded block
+		uint64_t m_Apply_us = 0; // contextual interpretation and DB writes
+		uint64_t m_VerifyWait_us = 0; // the interpretation awaited the context-free verification
+
+		void Reset() { *this = BlockPipelineStats(); }
+
+	} m_BlockPipelineStats;
+
 	struct Cursor
 	{
 		// frequently used data
@@ -233,6 +260,15 @@ public:
 
 	} m_Extra;
 
+	// The state as of the last db commit, i.e. what the read-only connections see (NodeDB::OpenReader). On rollback it's lowered,
+	// the committed data below is the same as the current one.
+	struct Committed
+	{
+		Height m_Height = 0;
+		uint64_t m_Shielded = 0; // shielded mmr elements
+
+	} m_Committed;
+
 	struct SyncData
 	{
 		NodeDB::StateID m_Target; // can move fwd during sync
@@ -363,6 +399,17 @@ public:
 
 	bool ValidateAndSummarize(TxBase::Context&, const TxBase&, TxBase::IReader&&);
 
+	// Context-free verification of several independent transactions at once. Each tx is verified by a single thread, all of them share the batch (multi-exponentiation).
+	// If the batch fails - it's bisected, to find the culprit(s).
+	struct TxBatchEntry
+	{
+		const Transaction* m_pTx;
+		Transaction::Context* m_pCtx; // must be initialized by the caller (height range)
+		bool m_bValid; // out. Includes IsValidTransaction()
+	};
+
+	bool ValidateAndSummarizeBatch(TxBatchEntry*, uint32_t nCount); // returns false if the batch failed, and the txs were re-verified in parts
+
 	struct ViewerKeys
 	{
 		Key::IPKdf* m_pMw;
@@ -538,6 +585,9 @@ public:
 
 	} m_Mmr;
 
+	// Already verified proofs (shielded inputs, tx output proofs), keyed by hash. Shielded entries depend on the shielded outputs below ShLo,
+	// and are dropped if those are reverted. Output entries have zero ShLo.
+	// Each kind has its own MRU and budget, so that the (many and cheaper) output proofs don't evict the shielded ones.
 	struct ValidatedCache
 	{
 		struct Entry
@@ -567,22 +617,30 @@ public:
 			} m_ShLo;
 		};
 
-		typedef boost::intrusive::multiset<Entry::Key> KeySet;
+		typedef boost::intrusive::set<Entry::Key> KeySet;
 		typedef boost::intrusive::multiset<Entry::ShLo> ShLoSet;
 		typedef boost::intrusive::list<Entry::Mru> MruList;
 
+		static const uint32_t s_MaxShielded = 10 * 1024;
+		static const uint32_t s_MaxOutputs = 32 * 1024;
+
 		KeySet m_Keys;
 		ShLoSet m_ShLo;
-		MruList m_Mru;
+		MruList m_MruShielded;
+		MruList m_MruOutputs;
 
 		~ValidatedCache() {
-			ShrinkTo(0);
+			ShrinkTo(0, 0);
 		}
 
+		MruList& get_Mru(const Entry& x) { return x.m_ShLo.m_End ? m_MruShielded : m_MruOutputs; }
+		size_t get_Count() const { return m_MruShielded.size() + m_MruOutputs.size(); }
+
 		void Delete(Entry&);
 		void MoveToFront(Entry&);
 
-		void ShrinkTo(uint32_t);
+		void ShrinkTo(uint32_t nShielded, uint32_t nOutputs);
+		void Shrink() { ShrinkTo(s_MaxShielded, s_MaxOutputs); }
 		void OnShLo(const Entry::ShLo::Type& nShLo);
 
 		bool Find(const Entry::Key::Type&); // modifies MRU if found
@@ -590,13 +648,26 @@ public:
 
 		void MoveInto(ValidatedCache& dst);
 
+		// The file is only accepted if the stamp matches, i.e. the cache is loaded at the same state it was saved
+		void Save(const char* szPath, const Merkle::Hash& hvStamp) const;
+		bool Load(const char* szPath, const Merkle::Hash& hvStamp);
+
 	protected:
-		void InsertRaw(Entry&);
+		bool InsertRaw(Entry&); // fails if the key is already there
 		void RemoveRaw(Entry&);
 
 	} m_ValCache;
 
 private:
+	struct TxBatchItem
+	{
+		TxBatchEntry* m_pE;
+		HeightRange m_Hr; // original, the verification narrows it
+	};
+
+	bool ValidateBatchInternal(TxBatchItem*, uint32_t nCount);
+	void BisectBatch(TxBatchItem*, uint32_t nCount);
+
 	size_t GenerateNewBlockInternal(BlockContext&, BlockInterpretCtx&);
 	void GenerateNewHdr(BlockContext&);
 	DataStatus::Enum OnStateInternal(const Block::SystemState::Full&, Block::SystemState::ID&, bool bAlreadyChecked);
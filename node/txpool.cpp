@@ -57,17 +57,35 @@ TxPool::Fluff::Element* TxPool::Fluff::AddValidTx(Transaction::Ptr&& pValue, con
 
 	InternalInsert(*p);
 
+	if (m_Template.IsAffectedBy(*p))
+		m_Template.m_Dirty = true;
+
 	p->m_Queue.m_Refs = 1;
 	m_Queue.push_back(p->m_Queue);
 
 	return p;
 }
 
+bool TxPool::Fluff::Template::IsAffectedBy(const Element& x) const
+{
+	if (x.m_Template == m_Generation)
+		return true; // included
+
+	// would it be included, if added before the template was built?
+	return (x.m_Profit < m_Threshold) || (x.m_Profit.m_nSize <= m_SizeRemaining);
+}
+
 void TxPool::Fluff::SetOutdated(Element& x, Height h)
 {
+	if (x.m_Template == m_Template.m_Generation)
+		m_Template.m_Dirty = true;
+
 	InternalErase(x);
 	x.m_Outdated.m_Height = h;
 	InternalInsert(x);
+
+	if (!x.IsOutdated() && m_Template.IsAffectedBy(x))
+		m_Template.m_Dirty = true; // became eligible again
 }
 
 void TxPool::Fluff::InternalInsert(Element& x)
@@ -102,6 +120,10 @@ void TxPool::Fluff::Delete(Element& x)
 void TxPool::Fluff::DeleteEmpty(Element& x)
 {
 	assert(!x.m_pValue);
+
+	if (x.m_Template == m_Template.m_Generation)
+		m_Template.m_Dirty = true;
+
 	InternalErase(x);
 	Release(x);
 }
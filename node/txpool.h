@@ -73,6 +73,8 @@ struct TxPool
 				IMPLEMENT_GET_PARENT_OBJ(Element, m_Queue)
 			} m_Queue;
 
+			uint32_t m_Template = 0; // generation of the block template that includes this tx
+
 			bool IsOutdated() const { return MaxHeight != m_Outdated.m_Height; }
 		};
 
@@ -86,6 +88,24 @@ struct TxPool
 		OutdatedSet m_setOutdated;
 		Queue m_Queue;
 
+		// The latest block template built from this pool. Used to tell if the pool changes (new/removed txs) may affect it,
+		// so that the miner doesn't rebuild it for nothing.
+		struct Template
+		{
+			uint32_t m_Generation = 0;
+			bool m_Dirty = true;
+			size_t m_SizeRemaining = 0; // room left in the block
+			Profit m_Threshold; // the least profitable tx included (or zero if none)
+
+			Template()
+			{
+				m_Threshold.m_Fee = Zero;
+				m_Threshold.m_nSize = 0;
+			}
+
+			bool IsAffectedBy(const Element&) const;
+		} m_Template;
+
 		Element* AddValidTx(Transaction::Ptr&&, const Transaction::Context&, const Transaction::KeyType&);
 		void SetOutdated(Element&, Height);
 		void Delete(Element&);
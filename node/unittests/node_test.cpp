@@ -21,6 +21,7 @@
 #include "../../core/serialization_adapters.h"
 #include "../../core/treasury.h"
 #include "../../core/block_rw.h"
+#include "../../core/lz.h"
 #include "../../utility/test_helpers.h"
 #include "../../utility/serialize.h"
 #include "../../core/unittest/mini_blockchain.h"
@@ -510,6 +511,12 @@ namespace beam
 				;
 		}
 
+		db.BbsDelUpTo(150);
+
+		NodeDB::BbsTotals totsBbs;
+		db.get_BbsTotals(totsBbs);
+		verify_test(totsBbs.m_Count == 50);
+
 		Key::ID kid(Zero);
 		kid.m_Idx = 345;
 
@@ -670,9 +677,118 @@ namespace beam
 		// in a 'friendly' scenario, where we only add and calculate root - cache must be 100% effective
 		verify_test(!myMmr.m_Miss);
 
+		// Txos, pending (write-behind) and flushed
+		{
+			const TxoID nTxos = 150; // more than in a single multi-row statement
+			for (TxoID id = 1; id <= nTxos; id++)
+				db.TxoAdd(id, Blob(&id, sizeof(id)));
+
+			db.TxoSetSpent(7, 30);
+
+			NodeDB::WalkerTxo wlk;
+			db.TxoGetValue(wlk, 9);
+			verify_test((wlk.m_Value.n == sizeof(TxoID)) && (*reinterpret_cast<const TxoID*>(wlk.m_Value.p) == 9));
+
+			db.TxoDelFrom(140);
+
+			TxoID nCount = 0;
+			for (db.EnumTxos(wlk, 0); wlk.MoveNext(); nCount++)
+			{
+				verify_test(wlk.m_ID == nCount + 1);
+				verify_test(*reinterpret_cast<const TxoID*>(wlk.m_Value.p) == wlk.m_ID);
+				verify_test(wlk.m_SpendHeight == ((7 == wlk.m_ID) ? 30 : MaxHeight));
+			}
+			verify_test(nCount == 139);
+
+			db.TxoSetSpent(8, 31);
+			db.TxoAdd(140, Blob(&nCount, sizeof(nCount)));
+			db.TxoSetSpent(140, 32);
+
+			db.TxoGetValue(wlk, 8);
+			verify_test(*reinterpret_cast<const TxoID*>(wlk.m_Value.p) == 8);
+			db.TxoGetValue(wlk, 140);
+			verify_test(*reinterpret_cast<const TxoID*>(wlk.m_Value.p) == 139);
+
+			// the value of a pending row must survive the following modifications
+			db.TxoFlush();
+			for (TxoID id = 141; id < 400; id++)
+				db.TxoAdd(id, Blob(&id, sizeof(id)));
+			verify_test((wlk.m_Value.n == sizeof(TxoID)) && (*reinterpret_cast<const TxoID*>(wlk.m_Value.p) == 139));
+			db.TxoDelFrom(141);
+
+			db.EnumTxos(wlk, 140);
+			verify_test(wlk.MoveNext() && (140 == wlk.m_ID) && (32 == wlk.m_SpendHeight));
+			verify_test(!wlk.MoveNext());
+
+			for (TxoID id = 10; id < 90; id++)
+				db.TxoSetSpent(id, 40); // more than a single multi-row statement
+
+			for (db.EnumTxos(wlk, 0); wlk.MoveNext(); )
+				if ((wlk.m_ID >= 10) && (wlk.m_ID < 90))
+					verify_test(40 == wlk.m_SpendHeight);
+
+			db.TxoDelFrom(1);
+			db.EnumTxos(wlk, 0);
+			verify_test(!wlk.MoveNext());
+		}
+
 		tr.Commit();
 	}
 
+	void BenchmarkNodeDBTxos(const char* sz)
+	{
+		// mimics the initial sync: per-block outputs creation and spending, periodic commits
+		const uint32_t nBlocks = 200;
+		const uint32_t nOuts = 1000;
+		const uint32_t nSpends = 700;
+		const uint32_t nBlocksPerCommit = 10;
+
+		uint8_t pVal[100];
+		memset(pVal, 0xcd, sizeof(pVal));
+
+		for (uint32_t iPass = 0; iPass < 2; iPass++)
+		{
+			DeleteFile(sz);
+
+			NodeDB db;
+			db.Open(sz);
+			if (!iPass)
+				db.m_TxoPendingMax = 0;
+
+			helpers::StopWatch sw;
+			sw.start();
+
+			NodeDB::Transaction tr(db);
+			TxoID nTxos = 0;
+
+			for (uint32_t iBlock = 0; iBlock < nBlocks; iBlock++)
+			{
+				for (uint32_t i = 0; i < nOuts; i++)
+					db.TxoAdd(++nTxos, Blob(pVal, sizeof(pVal)));
+
+				for (uint32_t i = 0; i < nSpends; i++)
+				{
+					// the older is the output - the more likely it's spent
+					TxoID id = 1 + (nTxos - nOuts / 2) * i / nSpends + iBlock % 2;
+					db.TxoSetSpent(id, iBlock + 1);
+				}
+
+				if (!((iBlock + 1) % nBlocksPerCommit))
+				{
+					tr.Commit();
+					tr.Start(db);
+				}
+			}
+
+			tr.Commit();
+			sw.stop();
+
+			printf("NodeDB.Txos %-14s: %u ms\n", iPass ? "write-behind" : "direct", static_cast<uint32_t>(sw.milliseconds()));
+		}
+
+		DeleteFile(sz);
+	}
+
 #ifdef WIN32
 		const char* g_sz = "mytest.db";
 		const char* g_sz2 = "mytest2.db";
@@ -932,6 +1048,7 @@ namespace beam
 
 		for (Height h = Rules::HeightGenesis; h < 96 + Rules::HeightGenesis; h++)
 		{
+			std::vector<Transaction::Ptr> vTxs;
 			while (true)
 			{
 				// Spend it in a transaction
@@ -939,6 +1056,57 @@ namespace beam
 				if (!np.m_Wallet.MakeTx(pTx, np.m_Cursor.m_ID.m_Height, hIncubation))
 					break;
 
+				vTxs.push_back(std::move(pTx));
+			}
+
+			if (!vTxs.empty())
+			{
+				// batch context-free verification
+				Transaction::Context::Params pars;
+				std::deque<Transaction::Context> vCtx;
+				std::vector<NodeProcessor::TxBatchEntry> vBatch;
+
+				for (size_t i = 0; i < vTxs.size(); i++)
+				{
+					Transaction::Context& ctx = vCtx.emplace_back(pars);
+					ctx.m_Height.m_Min = np.m_Cursor.m_ID.m_Height + 1;
+
+					NodeProcessor::TxBatchEntry& e = vBatch.emplace_back();
+					e.m_pTx = vTxs[i].get();
+					e.m_pCtx = &ctx;
+					e.m_bValid = false;
+				}
+
+				size_t nCached = np.m_ValCache.m_MruOutputs.size();
+
+				verify_test(np.ValidateAndSummarizeBatch(&vBatch.front(), static_cast<uint32_t>(vBatch.size())));
+				for (size_t i = 0; i < vBatch.size(); i++)
+					verify_test(vBatch[i].m_bValid);
+
+				verify_test(np.m_ValCache.m_MruOutputs.size() > nCached); // output proofs are remembered
+
+				// spoil one tx, the other txs must pass
+				ECC::Scalar k = vTxs[0]->m_Offset;
+				vTxs[0]->m_Offset.m_Value.Inc();
+
+				for (size_t i = 0; i < vBatch.size(); i++)
+				{
+					vBatch[i].m_pCtx->Reset();
+					vBatch[i].m_pCtx->m_Height.m_Min = np.m_Cursor.m_ID.m_Height + 1;
+				}
+
+				np.ValidateAndSummarizeBatch(&vBatch.front(), static_cast<uint32_t>(vBatch.size()));
+				verify_test(!vBatch[0].m_bValid);
+				for (size_t i = 1; i < vBatch.size(); i++)
+					verify_test(vBatch[i].m_bValid);
+
+				vTxs[0]->m_Offset = k;
+			}
+
+			for (size_t iTx = 0; iTx < vTxs.size(); iTx++)
+			{
+				Transaction::Ptr& pTx = vTxs[iTx];
+
 				HeightRange hr(np.m_Cursor.m_ID.m_Height + 1, MaxHeight);
 
 				verify_test(proto::TxStatus::Ok == np.ValidateTxContextEx(*pTx, hr, false));
@@ -999,6 +1167,833 @@ namespace beam
 	}
 
 
+	void TestBlockTemplate(uint32_t nTxs, bool bBenchmark)
+	{
+		MyNodeProcessor1 np;
+		np.Initialize(g_sz);
+		np.OnTreasury(g_Treasury);
+
+		// Fill the pool. Kernel-only txs (context-free validation isn't needed here), different fee rates
+		uint32_t nKrn = 0;
+
+		auto addTx = [&](Amount fee)
+		{
+			TxKernelStd::Ptr pKrn(new TxKernelStd);
+			pKrn->m_Fee = fee;
+			pKrn->m_Commitment.m_X = ++nKrn; // unique kernel ID
+			pKrn->UpdateID();
+
+			Transaction::Ptr pTx(new Transaction);
+			pTx->m_Offset = Zero;
+			pTx->m_vKernels.push_back(std::move(pKrn));
+
+			Transaction::Context::Params pars;
+			Transaction::Context ctx(pars);
+			ctx.m_Height.m_Min = np.m_Cursor.m_ID.m_Height + 1;
+			ctx.m_Stats.m_Fee = fee;
+
+			Transaction::KeyType key;
+			pTx->get_Key(key);
+
+			np.m_TxPool.AddValidTx(std::move(pTx), ctx, key);
+		};
+
+		for (uint32_t i = 0; i < nTxs; i++)
+			addTx(1000 + (i * 7919) % 100000);
+
+		helpers::StopWatch sw;
+		sw.start();
+
+		NodeProcessor::BlockContext bc(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+		verify_test(np.GenerateNewBlock(bc));
+
+		sw.stop();
+
+		verify_test(!np.m_TxPool.m_Template.m_Dirty);
+		verify_test(bc.m_Block.m_vKernels.size() < nTxs); // the block must be full, otherwise the checks below are meaningless
+
+		// incoming txs. Those that can't get into the template (full block, lower fee rate) shouldn't trigger its rebuild
+		const uint32_t nIncoming = 1000;
+		uint32_t nRebuilds = 0;
+
+		for (uint32_t i = 0; i < nIncoming; i++)
+		{
+			addTx(500 + i % 500);
+
+			while (np.m_TxPool.m_setProfit.size() > nTxs)
+				np.m_TxPool.Delete(np.m_TxPool.m_setProfit.rbegin()->get_ParentObj());
+
+			if (np.m_TxPool.m_Template.m_Dirty)
+			{
+				nRebuilds++;
+				NodeProcessor::BlockContext bc2(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+				verify_test(np.GenerateNewBlock(bc2));
+			}
+		}
+
+		verify_test(!nRebuilds);
+
+		addTx(1000000); // best fee rate
+		verify_test(np.m_TxPool.m_Template.m_Dirty);
+
+		{
+			// outdated tx that becomes eligible again
+			NodeProcessor::BlockContext bc2(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+			verify_test(np.GenerateNewBlock(bc2));
+			verify_test(!np.m_TxPool.m_Template.m_Dirty);
+
+			TxPool::Fluff::Element& x = np.m_TxPool.m_setProfit.begin()->get_ParentObj(); // the best one, included
+			np.m_TxPool.SetOutdated(x, np.m_Cursor.m_ID.m_Height);
+			verify_test(np.m_TxPool.m_Template.m_Dirty);
+
+			NodeProcessor::BlockContext bc3(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+			verify_test(np.GenerateNewBlock(bc3));
+			verify_test(!np.m_TxPool.m_Template.m_Dirty);
+
+			np.m_TxPool.SetOutdated(x, MaxHeight);
+			verify_test(np.m_TxPool.m_Template.m_Dirty);
+		}
+
+		if (bBenchmark)
+			printf("Block template: pool=%u txs, block=%u txs, %u ms, rebuilds for %u incoming txs: %u\n",
+				nTxs, (uint32_t) bc.m_Block.m_vKernels.size(), (uint32_t) (sw.microseconds() / 1000), nIncoming, nRebuilds);
+	}
+
+	void TestBlockTemplate()
+	{
+		// enough kernel-only txs to overflow the block
+		TestBlockTemplate(30000, false);
+	}
+
+	void BenchmarkBlockTemplate()
+	{
+		// pool filled to its limit
+		TestBlockTemplate(Node::Config().m_MaxPoolTransactions, true);
+	}
+
+	void DeleteBbsStore(const char* szDb)
+	{
+		std::string sDir;
+		NodeProcessor::get_BbsPath(sDir, szDb);
+		BbsStore::Destroy(sDir.c_str());
+	}
+
+	void TestBbsStore(const char* szDb)
+	{
+		std::string sDir;
+		NodeProcessor::get_BbsPath(sDir, szDb);
+		BbsStore::Destroy(sDir.c_str());
+
+		const uint32_t nMsgs = 200;
+		const Timestamp t0 = 1000;
+
+		uint8_t pMsg[0x20];
+		memset(pMsg, 0x5a, sizeof(pMsg));
+
+		BbsStore::Totals tots;
+		BbsStore::WalkerBbs wlk;
+
+		{
+			BbsStore bbs;
+			bbs.m_SegmentPeriod_s = 100;
+			bbs.Open(sDir.c_str());
+
+			BbsStore::Data d;
+			d.m_Message.p = pMsg;
+			d.m_Nonce = 0;
+
+			for (uint32_t i = 0; i < nMsgs; i++)
+			{
+				d.m_Key = i + 1;
+				d.m_Channel = i % 7;
+				d.m_TimePosted = t0 + i * 5; // 20 messages per segment
+				d.m_Message.n = i % sizeof(pMsg);
+
+				verify_test(!bbs.BbsFind(d.m_Key));
+				verify_test(bbs.BbsIns(d) == i + 1);
+			}
+
+			verify_test(bbs.get_Segments() == 10);
+			verify_test(bbs.get_BbsMaxTime() == t0 + (nMsgs - 1) * 5);
+		}
+
+		// reopen, the indexes are rebuilt from the segments
+		std::string sSeg = sDir + "/1900.seg";
+		{
+			std::FStream fs;
+			verify_test(fs.Open(sSeg.c_str(), false, false, true));
+			fs.write(pMsg, 10); // torn record, must be truncated
+		}
+
+		BbsStore bbs;
+		bbs.m_SegmentPeriod_s = 100;
+		bbs.m_MaxOpenFiles = 2; // less than the segments
+		bbs.Open(sDir.c_str());
+
+		bbs.get_BbsTotals(tots);
+		verify_test(tots.m_Count == nMsgs);
+		verify_test(bbs.get_BbsLastID() == nMsgs);
+		verify_test(bbs.get_Segments() == 10);
+
+		wlk.m_Data.m_Key = 77U;
+		verify_test(bbs.BbsFind(wlk));
+		verify_test(wlk.m_ID == 77);
+		verify_test(wlk.m_Data.m_Channel == 76 % 7);
+		verify_test(wlk.m_Data.m_TimePosted == t0 + 76 * 5);
+		verify_test(wlk.m_Data.m_Message.n == 76 % sizeof(pMsg));
+		verify_test(!memcmp(wlk.m_Data.m_Message.p, pMsg, wlk.m_Data.m_Message.n));
+
+		wlk.m_Data.m_Key = nMsgs + 1;
+		verify_test(!bbs.BbsFind(wlk));
+
+		uint32_t nCount = 0;
+		for (wlk.m_Data.m_Channel = 0; wlk.m_Data.m_Channel < 7; wlk.m_Data.m_Channel++)
+		{
+			uint64_t id0 = 0;
+			wlk.m_ID = 0;
+			for (bbs.EnumBbsCSeq(wlk); wlk.MoveNext(); nCount++)
+			{
+				verify_test(wlk.m_ID > id0);
+				verify_test((wlk.m_ID - 1) % 7 == wlk.m_Data.m_Channel);
+				id0 = wlk.m_ID;
+			}
+			verify_test(wlk.m_ID == id0); // the cursor stays at the last one
+		}
+		verify_test(nCount == nMsgs);
+
+		BbsStore::WalkerBbsLite wlkLite;
+		wlkLite.m_ID = 150;
+		for (bbs.EnumAllBbsSeq(wlkLite); wlkLite.MoveNext(); )
+			verify_test(wlkLite.m_Key == BbsStore::Key(wlkLite.m_ID));
+		verify_test(wlkLite.m_ID == nMsgs);
+
+		verify_test(bbs.BbsFindCursor(t0 + 500) == 101);
+		verify_test(bbs.BbsFindCursor(t0 + 502) == 102);
+		verify_test(bbs.BbsFindCursor(0) == 1);
+		verify_test(bbs.BbsFindCursor(t0 + 5000) == nMsgs + 1);
+
+		// expiration: whole segments only
+		BbsStore::Totals lims;
+		lims.m_Count = nMsgs;
+		lims.m_Size = 1000000;
+
+		bbs.Cleanup(t0 + 290, lims); // the 3rd segment still has a message at 1295
+		verify_test(bbs.get_Segments() == 8);
+
+		bbs.Cleanup(t0 + 300, lims);
+		verify_test(bbs.get_Segments() == 7);
+		verify_test(!DeleteFile((sDir + "/1000.seg").c_str())); // already deleted
+
+		bbs.get_BbsTotals(tots);
+		verify_test(tots.m_Count == 140);
+
+		wlk.m_Data.m_Key = 60U;
+		verify_test(!bbs.BbsFind(wlk));
+		verify_test(bbs.BbsFind(BbsStore::Key(61U)) == 61);
+
+		lims.m_Count = 100;
+		bbs.Cleanup(0, lims);
+		bbs.get_BbsTotals(tots);
+		verify_test(tots.m_Count == 100);
+		verify_test(bbs.get_Segments() == 5);
+
+		// out-of-order times within a segment
+		BbsStore::Data d;
+		d.m_Message.p = pMsg;
+		d.m_Message.n = 1;
+		d.m_Nonce = 0;
+		d.m_Channel = 0;
+
+		d.m_Key = nMsgs + 1;
+		d.m_TimePosted = t0 + 999;
+		verify_test(bbs.BbsIns(d) == nMsgs + 1);
+
+		d.m_Key = nMsgs + 2;
+		d.m_TimePosted = t0 + 998;
+		verify_test(bbs.BbsIns(d) == nMsgs + 2);
+
+		verify_test(bbs.BbsFindCursor(t0 + 998) == nMsgs + 1);
+		verify_test(bbs.BbsFindCursor(t0 + 996) == nMsgs + 1);
+		verify_test(bbs.BbsFindCursor(t0 + 995) == nMsgs);
+
+		// IDs aren't reused, even after all the segments are deleted
+		lims.m_Count = 0;
+		bbs.Cleanup(0, lims);
+		verify_test(!bbs.get_Segments());
+
+		bbs.Close();
+		bbs.Open(sDir.c_str());
+		verify_test(bbs.get_BbsLastID() == nMsgs + 2);
+
+		d.m_Key = nMsgs + 3;
+		verify_test(bbs.BbsIns(d) == nMsgs + 3);
+
+		bbs.Close();
+		BbsStore::Destroy(sDir.c_str());
+	}
+
+	void TestValidatedCache()
+	{
+		ECC::Hash::Value pHv[3];
+		for (uint32_t i = 0; i < _countof(pHv); i++)
+			ECC::Hash::Processor() << "vc.test" << i >> pHv[i];
+
+		Merkle::Hash hvStamp, hvStamp2;
+		ECC::Hash::Processor() << "stamp" >> hvStamp;
+		hvStamp2 = hvStamp;
+		hvStamp2.Inc();
+
+		std::string sPath;
+		NodeProcessor::get_ValCachePath(sPath, g_sz);
+
+		{
+			NodeProcessor::ValidatedCache vc;
+			vc.Insert(pHv[0], 0);
+			vc.Insert(pHv[1], 5);
+			vc.Insert(pHv[2], 9);
+
+			vc.Save(sPath.c_str(), hvStamp);
+			{
+				NodeProcessor::ValidatedCache vc2;
+				verify_test(!vc2.Load(sPath.c_str(), hvStamp2));
+				verify_test(!vc2.get_Count());
+			}
+
+			vc.Save(sPath.c_str(), hvStamp);
+			{
+				NodeProcessor::ValidatedCache vc2;
+				verify_test(vc2.Load(sPath.c_str(), hvStamp));
+				verify_test(vc2.get_Count() == 3);
+				verify_test(vc2.m_MruShielded.size() == 2);
+				verify_test(vc2.m_MruShielded.front().get_ParentObj().m_Key.m_Value == pHv[2]); // MRU order preserved
+
+				for (uint32_t i = 0; i < _countof(pHv); i++)
+					verify_test(vc2.Find(pHv[i]));
+
+				vc2.OnShLo(5);
+				verify_test(vc2.get_Count() == 2);
+				verify_test(!vc2.Find(pHv[2]));
+			}
+
+			// consumed on load
+			NodeProcessor::ValidatedCache vc3;
+			verify_test(!vc3.Load(sPath.c_str(), hvStamp));
+		}
+
+		{
+			// outputs don't evict the shielded entries
+			NodeProcessor::ValidatedCache vc;
+			vc.Insert(pHv[1], 5);
+
+			ECC::Hash::Value hv = pHv[0];
+			for (uint32_t i = 0; i < NodeProcessor::ValidatedCache::s_MaxOutputs + 10; i++)
+			{
+				hv.Inc();
+				vc.Insert(hv, 0);
+			}
+
+			vc.Shrink();
+			verify_test(vc.m_MruOutputs.size() == NodeProcessor::ValidatedCache::s_MaxOutputs);
+			verify_test(vc.Find(pHv[1]));
+
+			// duplicates are dropped
+			size_t nCount = vc.get_Count();
+			vc.Insert(pHv[1], 5);
+			verify_test(vc.get_Count() == nCount);
+
+			NodeProcessor::ValidatedCache vc2;
+			vc2.Insert(pHv[1], 5);
+			vc2.Insert(pHv[2], 9);
+			vc2.MoveInto(vc);
+			verify_test(!vc2.get_Count());
+			verify_test(vc.get_Count() == nCount + 1);
+			verify_test(vc.m_MruShielded.front().get_ParentObj().m_Key.m_Value == pHv[2]);
+		}
+
+		// across node restarts
+		DeleteFile(g_sz);
+		{
+			NodeProcessor np;
+			np.Initialize(g_sz);
+			verify_test(!np.m_ValCache.get_Count());
+			np.m_ValCache.Insert(pHv[0], 0);
+			np.m_ValCache.Insert(pHv[1], 1); // beyond the current shielded outputs
+		}
+		{
+			NodeProcessor np;
+			np.Initialize(g_sz);
+			verify_test(np.m_ValCache.Find(pHv[0]));
+			verify_test(!np.m_ValCache.Find(pHv[1]));
+		}
+		{
+			NodeProcessor::StartParams sp;
+			sp.m_PersistValCache = false;
+
+			NodeProcessor np;
+			np.Initialize(g_sz, sp);
+			verify_test(!np.m_ValCache.get_Count());
+		}
+
+		DeleteFile(g_sz);
+		DeleteFile(sPath.c_str());
+	}
+
+	void BenchmarkBlockPipeline(const std::vector<BlockPlus::Ptr>& blockChain)
+	{
+		// replay of a recorded chain: all the blocks are imported into the DB, then interpreted in a single run
+		struct MyProcessor
+			:public NodeProcessor
+		{
+			struct MyExecutorMT
+				:public ExecutorMT
+			{
+				virtual void RunThread(uint32_t iThread) override
+				{
+					MyExecutor::MyContext ctx;
+					ctx.m_iThread = iThread;
+					ECC::InnerProduct::BatchContext::Scope scope(ctx.m_BatchCtx);
+
+					RunThreadCtx(ctx);
+				}
+
+			} m_ExecutorMT;
+
+			virtual Executor& get_Executor() override { return m_ExecutorMT; }
+		};
+
+		for (uint32_t iPass = 0; iPass < 2; iPass++)
+		{
+			DeleteFile(g_sz);
+
+			MyProcessor np;
+			np.m_DecodeAhead = iPass ? 8 : 0;
+			np.Initialize(g_sz);
+			np.OnTreasury(g_Treasury);
+
+			for (size_t i = 0; i < blockChain.size(); i++)
+			{
+				const BlockPlus& bp = *blockChain[i];
+				np.OnState(bp.m_Hdr, PeerID());
+
+				Block::SystemState::ID id;
+				bp.m_Hdr.get_ID(id);
+				np.OnBlock(id, bp.m_BodyP, bp.m_BodyE, PeerID());
+			}
+
+			np.m_BlockPipelineStats.Reset();
+
+			helpers::StopWatch sw;
+			sw.start();
+			np.TryGoUp();
+			sw.stop();
+
+			verify_test(np.m_Cursor.m_ID.m_Height == blockChain.size());
+
+			const NodeProcessor::BlockPipelineStats& st = np.m_BlockPipelineStats;
+			auto fnRate = [&st](uint64_t t_us) { return st.m_Blocks * 1e6 / std::max<uint64_t>(t_us, 1); };
+
+			printf("Block pipeline, decode-ahead=%u, threads=%u: %.1f blocks/s. Per-stage: decode=%.1f, apply=%.1f blocks/s. Waits: decode=%u ms, verify=%u ms\n",
+				np.m_DecodeAhead,
+				np.m_ExecutorMT.get_Threads(),
+				fnRate(sw.microseconds()),
+				fnRate(st.m_Decode_us),
+				fnRate(st.m_Apply_us),
+				static_cast<uint32_t>(st.m_DecodeWait_us / 1000),
+				static_cast<uint32_t>(st.m_VerifyWait_us / 1000));
+		}
+
+		DeleteFile(g_sz);
+	}
+
+	void TestRecoveryCache(const std::vector<BlockPlus::Ptr>& blockChain)
+	{
+		// conversion
+		size_t nOutputs = 0;
+		for (size_t i = 0; i < blockChain.size(); i++)
+		{
+			ByteBuffer buf = blockChain[i]->m_BodyP;
+			Node::ConvertToRecovery1(buf);
+
+			Block::Body block;
+			Deserializer der;
+			der.reset(buf);
+			der & Cast::Down<Block::BodyBase>(block);
+			der & Cast::Down<TxVectors::Perishable>(block);
+
+			for (size_t j = 0; j < block.m_vOutputs.size(); j++)
+				verify_test(block.m_vOutputs[j]->m_RecoveryOnly);
+
+			nOutputs += block.m_vOutputs.size();
+		}
+		verify_test(nOutputs);
+
+		// cache
+		typedef Node::RecoveryCache::Entry::Key Key;
+		auto fnKey = [](uint64_t iRow) {
+			Key key;
+			key.m_Row = iRow;
+			key.m_h0 = 0;
+			key.m_hLo1 = 10;
+			key.m_hHi1 = 20;
+			return key;
+		};
+
+		ByteBuffer buf(100, 7);
+		size_t nEntry = Node::RecoveryCache::get_EntrySize(buf);
+
+		Node::RecoveryCache rc;
+		rc.Insert(fnKey(1), buf, 0); // disabled
+		verify_test(!rc.Find(fnKey(1)));
+
+		rc.Insert(fnKey(1), buf, nEntry - 1); // too large
+		verify_test(!rc.Find(fnKey(1)));
+
+		const size_t nMax = nEntry * 3;
+		for (uint64_t i = 1; i <= 3; i++)
+			rc.Insert(fnKey(i), buf, nMax);
+		verify_test(rc.m_Size == nMax);
+
+		Key key = fnKey(1);
+		key.m_hHi1++;
+		verify_test(!rc.Find(key)); // all the params matter
+
+		const ByteBuffer* pBuf = rc.Find(fnKey(1)); // becomes MRU
+		verify_test(pBuf && (*pBuf == buf));
+
+		rc.Insert(fnKey(4), buf, nMax);
+		verify_test(rc.m_Size == nMax);
+		verify_test(rc.Find(fnKey(1)));
+		verify_test(!rc.Find(fnKey(2))); // LRU evicted
+		verify_test(rc.Find(fnKey(3)));
+		verify_test(rc.Find(fnKey(4)));
+
+		rc.ShrinkTo(0);
+		verify_test(rc.m_Keys.empty() && rc.m_Mru.empty() && !rc.m_Size);
+	}
+
+	void BenchmarkRecoveryCache(const std::vector<BlockPlus::Ptr>& blockChain)
+	{
+		// a full body pack served to a syncing peer, repeatedly
+		const uint32_t nPack = Node::Config().m_BandwidthCtl.m_MaxBodyPackCount;
+
+		Node::RecoveryCache rc;
+		Node::RecoveryCache::Entry::Key key;
+		key.m_h0 = 0;
+		key.m_hLo1 = 0;
+		key.m_hHi1 = 0;
+
+		uint64_t nBytes = 0;
+		ByteBuffer buf;
+
+		helpers::StopWatch sw;
+		sw.start();
+
+		for (uint32_t i = 0; i < nPack; i++)
+		{
+			buf = blockChain[i % blockChain.size()]->m_BodyP;
+			Node::ConvertToRecovery1(buf);
+			nBytes += buf.size();
+
+			key.m_Row = i;
+			rc.Insert(key, buf, static_cast<size_t>(-1));
+		}
+
+		sw.stop();
+		double rate0 = nBytes * 1e6 / std::max<uint64_t>(sw.microseconds(), 1);
+
+		nBytes = 0;
+		sw.start();
+
+		for (uint32_t i = 0; i < nPack; i++)
+		{
+			key.m_Row = i;
+			const ByteBuffer* pBuf = rc.Find(key);
+			verify_test(pBuf);
+			buf = *pBuf;
+			nBytes += buf.size();
+		}
+
+		sw.stop();
+		double rate1 = nBytes * 1e6 / std::max<uint64_t>(sw.microseconds(), 1);
+
+		printf("Recovery body pack (%u blocks): transcoded=%.1f MB/s, cached=%.1f MB/s\n", nPack, rate0 / 1e6, rate1 / 1e6);
+	}
+
+	void TestLz()
+	{
+		ByteBuffer vDict(500);
+		for (size_t i = 0; i < vDict.size(); i++)
+			vDict[i] = static_cast<uint8_t>(i * 7 + (i >> 3));
+
+		Lz::Encoder enc;
+
+		for (uint32_t iCase = 0; iCase < 4; iCase++)
+		{
+			ByteBuffer vSrc(0x5000);
+
+			switch (iCase)
+			{
+			case 0: // random
+				ECC::GenRandom(&vSrc.front(), (uint32_t) vSrc.size());
+				break;
+
+			case 1: // zeroes
+				break;
+
+			case 2: // random and repeated chunks
+				for (size_t i = 0; i < vSrc.size(); i += 64)
+				{
+					if ((i >> 6) & 1)
+						ECC::GenRandom(&vSrc.front() + i, 64);
+					else
+						memcpy(&vSrc.front() + i, &vDict.front() + (i % 256), 64);
+				}
+				break;
+
+			default: // the dictionary content at the beginning, then random
+				memcpy(&vSrc.front(), &vDict.front(), vDict.size());
+				ECC::GenRandom(&vSrc.front() + vDict.size(), (uint32_t) (vSrc.size() - vDict.size()));
+			}
+
+			size_t pEnc[2];
+
+			for (uint32_t bDict = 0; bDict < 2; bDict++)
+			{
+				size_t nDict = bDict ? vDict.size() : 0;
+
+				ByteBuffer vIn(nDict + vSrc.size());
+				memcpy(&vIn.front(), &vDict.front(), nDict);
+				memcpy(&vIn.front() + nDict, &vSrc.front(), vSrc.size());
+
+				ByteBuffer vEnc(Lz::get_MaxEncoded(vSrc.size()));
+				size_t nEnc = enc.Encode(&vEnc.front(), vEnc.size(), &vIn.front(), nDict, vSrc.size());
+				verify_test(nEnc);
+				pEnc[bDict] = nEnc;
+
+				ByteBuffer vOut(nDict + vSrc.size());
+				memcpy(&vOut.front(), &vDict.front(), nDict);
+
+				verify_test(Lz::Decode(&vOut.front(), nDict, vSrc.size(), &vEnc.front(), nEnc));
+				verify_test(vOut == vIn);
+
+				// wrong size, truncated
+				verify_test(!Lz::Decode(&vOut.front(), nDict, vSrc.size() - 1, &vEnc.front(), nEnc));
+				vOut.resize(vOut.size() + 1);
+				verify_test(!Lz::Decode(&vOut.front(), nDict, vSrc.size() + 1, &vEnc.front(), nEnc));
+				verify_test(!Lz::Decode(&vOut.front(), nDict, vSrc.size(), &vEnc.front(), nEnc - 1));
+
+				// limited output
+				verify_test(!enc.Encode(&vEnc.front(), nEnc - 1, &vIn.front(), nDict, vSrc.size()));
+
+				// corrupted, must not overflow anything
+				for (uint32_t i = 0; i < 100; i++)
+				{
+					ByteBuffer vBad(vEnc.begin(), vEnc.begin() + nEnc);
+					uint32_t iPos;
+					ECC::GenRandom(&iPos, sizeof(iPos));
+					ECC::GenRandom(&vBad.front() + iPos % nEnc, 1);
+
+					Lz::Decode(&vOut.front(), nDict, vSrc.size(), &vBad.front(), vBad.size());
+				}
+			}
+
+			switch (iCase)
+			{
+			case 0:
+				verify_test(pEnc[0] > vSrc.size());
+				break;
+			case 1:
+				verify_test(pEnc[0] < 100);
+				break;
+			case 2:
+				verify_test(pEnc[0] < vSrc.size() * 6 / 10);
+				break;
+			default:
+				verify_test(pEnc[1] + vDict.size() / 2 < pEnc[0]);
+			}
+		}
+	}
+
+	void TestCompressedWrapper()
+	{
+		struct Handler
+			:public IErrorHandler
+		{
+			uint32_t m_Errors = 0;
+			uint32_t m_Msgs = 0;
+
+			void on_protocol_error(uint64_t, ProtocolError) override { m_Errors++; }
+			void on_connection_error(uint64_t, io::ErrorCode) override {}
+
+			bool OnEvents(uint64_t, proto::Events&&) { m_Msgs++; return true; }
+		} h;
+
+		proto::ProtocolPlus prot('B', 'm', 10, proto::ProtocolPlus::s_CodeCompressed + 1, h, 20000);
+		prot.add_message_handler<Handler, proto::Events, &Handler::OnEvents>(proto::Events::s_Code, &h, 0, 1024 * 1024 * 10);
+
+		proto::Events msg;
+		msg.m_Events.assign(10000, 0x5a);
+
+		SerializedMsg sm;
+		MsgSerializer& ser = prot.serializeNoFinalize(sm, proto::Events::s_Code, msg);
+		prot.Compress(sm, ser, proto::Events::s_Code);
+		prot.Seal(sm, ser); // plaintext, no MAC
+
+		io::SharedBuffer buf = io::normalize(sm, false);
+		MsgHeader hdr(buf.data);
+		verify_test(proto::ProtocolPlus::s_CodeCompressed == hdr.type);
+
+		ByteBuffer v(buf.data + MsgHeader::SIZE, buf.data + MsgHeader::SIZE + hdr.size);
+
+		// not before the secure channel
+		verify_test(!prot.on_new_message(0, hdr.type, &v.front(), v.size()));
+		verify_test((1 == h.m_Errors) && !h.m_Msgs);
+
+		prot.m_Mode = proto::ProtocolPlus::Mode::Duplex;
+		verify_test(prot.on_new_message(0, hdr.type, &v.front(), v.size()));
+		verify_test((1 == h.m_Errors) && (1 == h.m_Msgs));
+
+		// declared size beyond the max expansion of the compressed data. Rejected before the allocation
+		uint32_t nSize = static_cast<uint32_t>(Lz::get_MaxDecoded(v.size() - 5)) + 1;
+		for (uint32_t i = 0; i < 4; i++)
+			v[i + 1] = static_cast<uint8_t>(nSize >> (i << 3));
+
+		verify_test(!prot.on_new_message(0, hdr.type, &v.front(), v.size()));
+		verify_test((2 == h.m_Errors) && (1 == h.m_Msgs));
+	}
+
+	struct CompressTestHandler
+		:public IErrorHandler
+	{
+		void on_protocol_error(uint64_t, ProtocolError) override { verify_test(false); }
+		void on_connection_error(uint64_t, io::ErrorCode) override {}
+
+		proto::BodyPack m_BodyPack;
+		proto::HdrPack m_HdrPack;
+		proto::Events m_Events;
+
+		bool OnBodyPack(uint64_t, proto::BodyPack&& msg) { m_BodyPack = std::move(msg); return true; }
+		bool OnHdrPack(uint64_t, proto::HdrPack&& msg) { m_HdrPack = std::move(msg); return true; }
+		bool OnEvents(uint64_t, proto::Events&& msg) { m_Events = std::move(msg); return true; }
+	};
+
+	template <typename TMsg>
+	void BenchmarkCompression(const char* szName, const TMsg& msg, const TMsg& msgOut, proto::ProtocolPlus& prot)
+	{
+		const uint32_t nIterations = 10;
+		size_t pWire[2];
+		uint64_t pEnc_us[2], pDec_us[2];
+
+		for (uint32_t bCompress = 0; bCompress < 2; bCompress++)
+		{
+			pEnc_us[bCompress] = pDec_us[bCompress] = 0;
+
+			for (uint32_t i = 0; i < nIterations; i++)
+			{
+				helpers::StopWatch sw;
+				sw.start();
+
+				SerializedMsg sm;
+				MsgSerializer& ser = prot.serializeNoFinalize(sm, TMsg::s_Code, msg);
+				if (bCompress)
+					prot.Compress(sm, ser, TMsg::s_Code);
+				prot.Seal(sm, ser);
+
+				sw.stop();
+				pEnc_us[bCompress] += sw.microseconds();
+
+				io::SharedBuffer buf = io::normalize(sm, false);
+				MsgHeader hdr(buf.data);
+				verify_test((hdr.type == proto::ProtocolPlus::s_CodeCompressed) == (bCompress != 0));
+				pWire[bCompress] = buf.size;
+
+				// the compressed wrapper is accepted over the secure channel only. Sealed as plaintext, i.e. without the MAC
+				prot.m_Mode = proto::ProtocolPlus::Mode::Duplex;
+
+				sw.start();
+				verify_test(prot.on_new_message(0, hdr.type, buf.data + MsgHeader::SIZE, hdr.size));
+				sw.stop();
+
+				prot.m_Mode = proto::ProtocolPlus::Mode::Plaintext;
+				pDec_us[bCompress] += sw.microseconds();
+			}
+
+			Serializer ser0, ser1;
+			ser0 & msg;
+			ser1 & msgOut;
+			verify_test(ser0.buffer().second == ser1.buffer().second);
+			verify_test(!memcmp(ser0.buffer().first, ser1.buffer().first, ser0.buffer().second));
+		}
+
+		double nMB = pWire[0] * nIterations / 1e6;
+
+		printf("Compression, %s: %u -> %u bytes on wire (%.1f%%), encode +%.1f ms/MB, decode +%.1f ms/MB\n",
+			szName,
+			(uint32_t) pWire[0],
+			(uint32_t) pWire[1],
+			pWire[1] * 100. / pWire[0],
+			(double(pEnc_us[1]) - double(pEnc_us[0])) / 1e3 / nMB,
+			(double(pDec_us[1]) - double(pDec_us[0])) / 1e3 / nMB);
+	}
+
+	void BenchmarkCompression(const std::vector<BlockPlus::Ptr>& blockChain)
+	{
+		CompressTestHandler h;
+
+		proto::ProtocolPlus prot('B', 'm', 10, proto::ProtocolPlus::s_CodeCompressed + 1, h, 20000);
+		prot.add_message_handler<CompressTestHandler, proto::BodyPack, &CompressTestHandler::OnBodyPack>(proto::BodyPack::s_Code, &h, 0, 1024 * 1024 * 10);
+		prot.add_message_handler<CompressTestHandler, proto::HdrPack, &CompressTestHandler::OnHdrPack>(proto::HdrPack::s_Code, &h, 0, 1024 * 1024 * 10);
+		prot.add_message_handler<CompressTestHandler, proto::Events, &CompressTestHandler::OnEvents>(proto::Events::s_Code, &h, 0, 1024 * 1024 * 10);
+
+		{
+			// the whole recorded chain, each block once
+			proto::BodyPack msg;
+			for (size_t i = 0; i < blockChain.size(); i++)
+			{
+				proto::BodyBuffers& bb = msg.m_Bodies.emplace_back();
+				bb.m_Perishable = blockChain[i]->m_BodyP;
+				bb.m_Eternal = blockChain[i]->m_BodyE;
+			}
+
+			BenchmarkCompression("body pack", msg, h.m_BodyPack, prot);
+		}
+
+		{
+			proto::HdrPack msg;
+			for (size_t i = blockChain.size(); i--; )
+				msg.m_vElements.push_back(blockChain[i]->m_Hdr);
+			msg.m_Prefix = blockChain.front()->m_Hdr;
+
+			BenchmarkCompression("hdr pack", msg, h.m_HdrPack, prot);
+		}
+
+		{
+			// utxo events, as sent to a wallet
+			Serializer ser;
+			for (uint32_t i = 0; i < proto::Event::s_Max; i++)
+			{
+				Height h = Rules::HeightGenesis + 100 + i / 3;
+				ser & h;
+
+				proto::Event::Utxo evt;
+				evt.m_Flags = proto::Event::Flags::Add;
+				evt.m_Cid = CoinID(1000000 + i * 137, 500 + i, Key::Type::Regular, i % 3);
+				ECC::SetRandom(evt.m_Commitment.m_X);
+				evt.m_Commitment.m_Y = i & 1;
+				evt.m_Maturity = h + 1;
+
+				proto::Event::Type::Enum eType = proto::Event::Type::Utxo;
+				ser & eType;
+				ser & evt;
+			}
+
+			proto::Events msg;
+			ser.swap_buf(msg.m_Events);
+
+			BenchmarkCompression("events", msg, h.m_Events, prot);
+		}
+	}
+
 	void TestNodeProcessor2(std::vector<BlockPlus::Ptr>& blockChain)
 	{
 		NodeProcessor::Horizon horz;
@@ -1423,7 +2418,7 @@ namespace beam
 
 	const uint16_t g_Port = 25003; // don't use the default port to prevent collisions with running nodes, beacons and etc.
 
-	void TestNodeConversation()
+	void TestNodeConversation(uint32_t nIoThreads)
 	{
 		// Testing configuration: Node0 <-> Node1 <-> Client.
 
@@ -1446,6 +2441,7 @@ namespace beam
 		node2.m_Cfg.m_Treasury = g_Treasury;
 
 		node2.m_Cfg.m_BeaconPort = g_Port;
+		node2.m_Cfg.m_IoThreads = nIoThreads; // if set - its outbound connections are served by the I/O thread
 
 		ECC::SetRandom(node);
 		ECC::SetRandom(node2);
@@ -1478,107 +2474,327 @@ namespace beam
 
 			io::Timer::Ptr m_pTimer;
 
-			void OnTimer() {
-
+			void OnTimer() {
+
+
+				if (m_HeightMax < m_HeightTrg)
+				{
+					Node& n = *m_ppNode[m_iNode];
+
+					TxPool::Fluff txPool; // empty, no transactions
+					NodeProcessor::BlockContext bc(txPool, 0, *n.m_Keys.m_pMiner, *n.m_Keys.m_pMiner);
+
+					verify_test(n.get_Processor().GenerateNewBlock(bc));
+
+					n.get_Processor().OnState(bc.m_Hdr, PeerID());
+
+					Block::SystemState::ID id;
+					bc.m_Hdr.get_ID(id);
+
+					n.get_Processor().OnBlock(id, bc.m_BodyP, bc.m_BodyE, PeerID());
+					n.get_Processor().TryGoUp();
+
+					std::setmax(m_HeightMax, bc.m_Hdr.m_Height);
+
+					printf("Mined block Height = %u, node = %u \n", (unsigned int) bc.m_Hdr.m_Height, (unsigned int)m_iNode);
+
+					++m_iNode %= _countof(m_ppNode);
+				}
+				else
+					if (m_WaitingCycles++ > 60)
+					{
+						fail_test("Blockchain height didn't reach target");
+						io::Reactor::get_Current().stop();
+					}
+
+				SetTimer(100);
+			}
+
+			virtual void OnMsg(proto::NewTip&& msg) override
+			{
+				printf("Tip Height=%u\n", (unsigned int) msg.m_Description.m_Height);
+				verify_test(msg.m_Description.m_Height <= m_HeightMax);
+				if (msg.m_Description.m_Height == m_HeightTrg)
+					io::Reactor::get_Current().stop();
+			}
+
+			void SetTimer(uint32_t timeout_ms) {
+				m_pTimer->start(timeout_ms, false, [this]() { return (this->OnTimer)(); });
+			}
+		};
+
+		MyClient cl;
+		cl.m_iNode = 0;
+		cl.m_HeightMax = 0;
+		cl.m_WaitingCycles = 0;
+		cl.m_ppNode[0] = &node;
+		cl.m_ppNode[1] = &node2;
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port + 1);
+
+		cl.Connect(addr);
+
+
+		pReactor->run();
+
+		node.GenerateRecoveryInfo(g_sz3);
+
+		struct MyParser :public RecoveryInfo::IParser
+		{
+			Key::IPKdf::Ptr m_pOwner1;
+			Key::IPKdf::Ptr m_pOwner2;
+			uint32_t m_nUnrecognized = 0;
+
+			virtual bool OnUtxo(Height h, const Output& outp) override
+			{
+				verify_test(outp.m_RecoveryOnly);
+
+				CoinID cid;
+				bool b1 = outp.Recover(h, *m_pOwner1, cid);
+				bool b2 = outp.Recover(h, *m_pOwner2, cid);
+				if (!(b1 || b2))
+				{
+					verify_test(!h); // treasury
+					m_nUnrecognized++;
+					verify_test(m_nUnrecognized <= 1);
+				}
+
+				return true;
+			}
+		} parser;
+		parser.m_pOwner1 = node.m_Keys.m_pOwner;
+		parser.m_pOwner2 = node2.m_Keys.m_pOwner;
+
+		verify_test(parser.Proceed(g_sz3));
+
+		DeleteFile(g_sz3);
+	}
+
+
+
+	void BenchmarkIoThreads()
+	{
+		// Simulated clients (in their own threads) keep pinging the node over the secure channels.
+		// All the messages are handled by the node thread, the socket I/O and the encryption are done either by it, or by the I/O threads
+		const uint32_t nClientThreads = 4;
+		const uint32_t nClientsPerThread = 16;
+		const uint32_t nWindow = 8; // pings in flight per client
+		const uint32_t nDuration_ms = 1000;
+
+		struct MyClient
+			:public proto::NodeConnection
+		{
+			std::atomic<uint32_t>* m_pConnected;
+			std::atomic<uint64_t>* m_pPongs;
+			uint32_t m_nWindow;
+
+			virtual void OnConnectedSecure() override
+			{
+				(*m_pConnected)++;
+				for (uint32_t i = 0; i < m_nWindow; i++)
+					Send(proto::Ping(Zero));
+			}
+
+			virtual void OnMsg(proto::Pong&&) override
+			{
+				(*m_pPongs)++;
+				Send(proto::Ping(Zero));
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override
+			{
+				fail_test("OnDisconnect");
+				Reset();
+			}
+		};
+
+		const uint32_t pIoThreads[] = { 0, 1, 2, 4, 8 };
+		for (uint32_t iCfg = 0; iCfg < _countof(pIoThreads); iCfg++)
+		{
+			DeleteFile(g_sz);
+
+			io::Reactor::Ptr pReactor(io::Reactor::create());
+			io::Reactor::Scope scope(*pReactor);
+
+			Node node;
+			node.m_Cfg.m_sPathLocal = g_sz;
+			node.m_Cfg.m_Listen.port(g_Port);
+			node.m_Cfg.m_Listen.ip(INADDR_ANY);
+			node.m_Cfg.m_IoThreads = pIoThreads[iCfg];
+			ECC::SetRandom(node);
+			node.Initialize();
+
+			std::atomic<uint32_t> nConnected(0);
+			std::atomic<uint64_t> nPongs(0);
+
+			std::vector<io::Reactor::Ptr> vReactors(nClientThreads);
+			std::vector<std::thread> vThreads(nClientThreads);
+
+			for (uint32_t iThread = 0; iThread < nClientThreads; iThread++)
+			{
+				vReactors[iThread] = io::Reactor::create();
+				vThreads[iThread] = std::thread([&, iThread]()
+				{
+					io::Reactor& r = *vReactors[iThread];
+					io::Reactor::Scope scope2(r);
+
+					io::Address addr;
+					addr.resolve("127.0.0.1");
+					addr.port(g_Port);
+
+					std::vector<MyClient> vClients(nClientsPerThread);
+					for (uint32_t i = 0; i < nClientsPerThread; i++)
+					{
+						MyClient& c = vClients[i];
+						c.m_pConnected = &nConnected;
+						c.m_pPongs = &nPongs;
+						c.m_nWindow = nWindow;
+						c.Connect(addr);
+					}
+
+					r.run();
+				});
+			}
+
+			helpers::StopWatch sw;
+			uint64_t nPongs0 = 0;
+			bool bMeasuring = false;
+
+			io::Timer::Ptr pTimer = io::Timer::create(*pReactor);
+			pTimer->start(50, true, [&]()
+			{
+				if (!bMeasuring)
+				{
+					if (nConnected < nClientThreads * nClientsPerThread)
+						return;
+
+					bMeasuring = true;
+					nPongs0 = nPongs;
+					sw.start();
+					return;
+				}
+
+				helpers::StopWatch swNow = sw;
+				swNow.stop();
+				if (swNow.milliseconds() < nDuration_ms)
+					return;
+
+				uint64_t nRoundtrips = nPongs - nPongs0;
+				verify_test(nRoundtrips);
+
+				printf("I/O threads = %u, clients = %u, ping-pong roundtrips/s = %.0f\n", pIoThreads[iCfg], nClientThreads * nClientsPerThread, nRoundtrips * 1000. / swNow.milliseconds());
+				io::Reactor::get_Current().stop();
+			});
+
+			pReactor->run();
+			pTimer.reset();
+
+			for (uint32_t iThread = 0; iThread < nClientThreads; iThread++)
+			{
+				vReactors[iThread]->stop();
+				vThreads[iThread].join();
+			}
+		}
+
+		DeleteFile(g_sz);
+	}
+
+	void TestTxDeferred()
+	{
+		// txs from other nodes are verified deferred, in batches. The cheap rejections must be resolved before the batch crypto
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_Treasury = g_Treasury;
+		ECC::SetRandom(node);
+		node.Initialize();
+
+		struct MyClient
+			:public proto::NodeConnection
+		{
+			const Node::TxValidationStats* m_pStats;
+			io::Timer::Ptr m_pTimer;
+
+			static Transaction::Ptr MakeTx()
+			{
+				// single kernel, no inputs and outputs
+				ECC::Scalar::Native sk;
+				ECC::SetRandom(sk);
 
-				if (m_HeightMax < m_HeightTrg)
-				{
-					Node& n = *m_ppNode[m_iNode];
+				TxKernelStd::Ptr pKrn(new TxKernelStd);
+				pKrn->Sign(sk);
 
-					TxPool::Fluff txPool; // empty, no transactions
-					NodeProcessor::BlockContext bc(txPool, 0, *n.m_Keys.m_pMiner, *n.m_Keys.m_pMiner);
+				Transaction::Ptr pTx = std::make_shared<Transaction>();
+				pTx->m_vKernels.push_back(std::move(pKrn));
+				pTx->m_Offset = Zero;
+				pTx->Normalize();
 
-					verify_test(n.get_Processor().GenerateNewBlock(bc));
+				return pTx;
+			}
 
-					n.get_Processor().OnState(bc.m_Hdr, PeerID());
+			virtual void OnConnectedSecure() override
+			{
+				// identify as a node, our txs are deferred
+				ECC::Scalar::Native sk;
+				ECC::SetRandom(sk);
+				ProveID(sk, proto::IDType::Node);
 
-					Block::SystemState::ID id;
-					bc.m_Hdr.get_ID(id);
+				proto::NewTransaction msg;
+				msg.m_Transaction = MakeTx();
+				msg.m_Fluff = false; // too small for the stem, must be skipped
+				Send(msg);
 
-					n.get_Processor().OnBlock(id, bc.m_BodyP, bc.m_BodyE, PeerID());
-					n.get_Processor().TryGoUp();
+				msg.m_Transaction = MakeTx();
+				msg.m_Fluff = true; // goes to the batch, invalid
+				Send(msg);
 
-					std::setmax(m_HeightMax, bc.m_Hdr.m_Height);
+				m_pTimer = io::Timer::create(io::Reactor::get_Current());
+				m_pTimer->start(20, true, [this]() { OnTimer(); });
+			}
 
-					printf("Mined block Height = %u, node = %u \n", (unsigned int) bc.m_Hdr.m_Height, (unsigned int)m_iNode);
+			void OnTimer()
+			{
+				if (m_pStats->m_Txs < 2)
+					return;
 
-					++m_iNode %= _countof(m_ppNode);
-				}
-				else
-					if (m_WaitingCycles++ > 60)
-					{
-						fail_test("Blockchain height didn't reach target");
-						io::Reactor::get_Current().stop();
-					}
+				verify_test(2 == m_pStats->m_Txs);
+				verify_test(1 == m_pStats->m_Skipped);
+				verify_test(1 == m_pStats->m_Invalid);
+				verify_test(m_pStats->m_Batches);
 
-				SetTimer(100);
+				io::Reactor::get_Current().stop();
 			}
 
-			virtual void OnMsg(proto::NewTip&& msg) override
+			virtual void OnDisconnect(const DisconnectReason&) override
 			{
-				printf("Tip Height=%u\n", (unsigned int) msg.m_Description.m_Height);
-				verify_test(msg.m_Description.m_Height <= m_HeightMax);
-				if (msg.m_Description.m_Height == m_HeightTrg)
-					io::Reactor::get_Current().stop();
-			}
-
-			void SetTimer(uint32_t timeout_ms) {
-				m_pTimer->start(timeout_ms, false, [this]() { return (this->OnTimer)(); });
+				fail_test("OnDisconnect");
+				io::Reactor::get_Current().stop();
 			}
 		};
 
 		MyClient cl;
-		cl.m_iNode = 0;
-		cl.m_HeightMax = 0;
-		cl.m_WaitingCycles = 0;
-		cl.m_ppNode[0] = &node;
-		cl.m_ppNode[1] = &node2;
+		cl.m_pStats = &node.m_TxValidationStats;
 
 		io::Address addr;
 		addr.resolve("127.0.0.1");
-		addr.port(g_Port + 1);
-
+		addr.port(g_Port);
 		cl.Connect(addr);
 
-
 		pReactor->run();
-
-		node.GenerateRecoveryInfo(g_sz3);
-
-		struct MyParser :public RecoveryInfo::IParser
-		{
-			Key::IPKdf::Ptr m_pOwner1;
-			Key::IPKdf::Ptr m_pOwner2;
-			uint32_t m_nUnrecognized = 0;
-
-			virtual bool OnUtxo(Height h, const Output& outp) override
-			{
-				verify_test(outp.m_RecoveryOnly);
-
-				CoinID cid;
-				bool b1 = outp.Recover(h, *m_pOwner1, cid);
-				bool b2 = outp.Recover(h, *m_pOwner2, cid);
-				if (!(b1 || b2))
-				{
-					verify_test(!h); // treasury
-					m_nUnrecognized++;
-					verify_test(m_nUnrecognized <= 1);
-				}
-
-				return true;
-			}
-		} parser;
-		parser.m_pOwner1 = node.m_Keys.m_pOwner;
-		parser.m_pOwner2 = node2.m_Keys.m_pOwner;
-
-		verify_test(parser.Proceed(g_sz3));
-
-		DeleteFile(g_sz3);
 	}
 
+	// Recorded by TestNodeClientProto, to test the requests on its chain later
+	ECC::uintBig g_ClientProtoSeed; // node keys
+	ShieldedTxo::DescriptionOutp g_ShieldedOutp;
+	ShieldedTxo::DescriptionInp g_ShieldedInp;
 
-
-	void TestNodeClientProto()
+	void TestNodeClientProto(uint32_t nIoThreads, uint32_t nReadThreads)
 	{
 		// Testing configuration: Node <-> Client. Node is a miner
 
@@ -1591,8 +2807,11 @@ namespace beam
 		node.m_Cfg.m_Listen.ip(INADDR_ANY);
 		node.m_Cfg.m_TestMode.m_FakePowSolveTime_ms = 100;
 		node.m_Cfg.m_MiningThreads = 1;
+		node.m_Cfg.m_ReadThreads = nReadThreads; // if set - events are served from the db snapshots, the responses order must be preserved
+		node.m_Cfg.m_IoThreads = nIoThreads;
 
-		ECC::SetRandom(node);
+		ECC::SetRandom(g_ClientProtoSeed);
+		node.m_Keys.InitSingleKey(g_ClientProtoSeed);
 
 		node.m_Cfg.m_Horizon.m_Branching = 6;
 		node.m_Cfg.m_Horizon.m_Sync.Hi = 10;
@@ -1923,6 +3142,7 @@ namespace beam
 
 				verify_test(m_vStates.back().IsValidProofShieldedOutp(d, msg.m_Proof));
 				m_Shielded.m_Confirmed = msg.m_ID;
+				g_ShieldedOutp = d;
 
 				m_Shielded.m_N = m_Shielded.m_Cfg.get_N();
 
@@ -1946,6 +3166,7 @@ namespace beam
 				d.m_SpendPk = m_Shielded.m_Params.m_Ticket.m_SpendPk;
 
 				verify_test(m_vStates.back().IsValidProofShieldedInp(d, msg.m_Proof));
+				g_ShieldedInp = d;
 			}
 
 			virtual void OnMsg(proto::ProofAsset&& msg) override
@@ -2667,6 +3888,218 @@ namespace beam
 		verify_test(proc.m_sidForbidden.m_Height > Rules::HeightGenesis); // some rollback with forbidden state update must take place
 	}
 
+	void TestReadersUnderSync()
+	{
+		// Node2 (with the read threads) syncs the chain of TestNodeClientProto from Node. Meanwhile the client keeps requesting
+		// the shielded proofs and events from Node2, so that they're served both from the db snapshots and from the current state.
+		// The responses must arrive in order, and be consistent with the Node2 tip that precedes them.
+
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		DeleteFile(g_sz);
+		std::string sPath;
+		NodeProcessor::get_UtxoMappingPath(sPath, g_sz);
+		DeleteFile(sPath.c_str());
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz2; // the full chain, synced by Node2 of TestNodeClientProto
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+
+		ECC::SetRandom(node);
+		node.Initialize();
+
+		Node node2;
+		node2.m_Cfg.m_sPathLocal = g_sz;
+		node2.m_Cfg.m_Listen.port(g_Port + 1);
+		node2.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node2.m_Cfg.m_Connect.resize(1);
+		node2.m_Cfg.m_Connect[0].resolve("127.0.0.1");
+		node2.m_Cfg.m_Connect[0].port(g_Port);
+		node2.m_Cfg.m_ReadThreads = 2;
+
+		node2.m_Keys.InitSingleKey(g_ClientProtoSeed); // to recognize the events
+		node2.Initialize();
+
+		struct MyClient
+			:public proto::NodeConnection
+		{
+			enum struct Response { Outp, Inp, Events };
+
+			Node& m_Node;
+			const Height m_hTrg;
+			Key::IKdf::Ptr m_pKdf;
+
+			io::Timer::Ptr m_pTimer;
+			io::Timer::Ptr m_pTimeout;
+
+			Block::SystemState::Full m_Tip;
+			std::deque<Response> m_qExpected;
+			uint32_t m_nResponsesSynced = 0;
+			uint32_t m_nProofs = 0;
+			uint32_t m_nEvents = 0;
+
+			MyClient(Node& n, Height hTrg)
+				:m_Node(n)
+				,m_hTrg(hTrg)
+			{
+				ZeroObject(m_Tip);
+				m_pTimer = io::Timer::create(io::Reactor::get_Current());
+				m_pTimeout = io::Timer::create(io::Reactor::get_Current());
+			}
+
+			virtual void OnConnectedSecure() override
+			{
+				SendLogin();
+
+				m_pTimeout->start(60 * 1000, false, []() {
+					fail_test("Node2 didn't sync");
+					io::Reactor::get_Current().stop();
+				});
+			}
+
+			virtual void OnDisconnect(const DisconnectReason&) override {
+				fail_test("OnDisconnect");
+				io::Reactor::get_Current().stop();
+			}
+
+			virtual void OnMsg(proto::Authentication&& msg) override
+			{
+				proto::NodeConnection::OnMsg(std::move(msg));
+
+				switch (msg.m_IDType)
+				{
+				case proto::IDType::Node:
+					ProveKdfObscured(*m_pKdf, proto::IDType::Owner);
+					break;
+
+				case proto::IDType::Viewer:
+					// authorized to get events
+					m_pTimer->start(5, true, [this]() { OnTimer(); });
+					break;
+
+				default: // suppress warning
+					break;
+				}
+			}
+
+			void OnTimer()
+			{
+				if (m_qExpected.size() >= 30)
+					return; // don't flood
+
+				proto::GetProofShieldedOutp msgOutp;
+				msgOutp.m_SerialPub = g_ShieldedOutp.m_SerialPub;
+				Send(msgOutp);
+				m_qExpected.push_back(Response::Outp);
+
+				proto::GetEvents msgEvts;
+				msgEvts.m_HeightMin = 0;
+				Send(msgEvts);
+				m_qExpected.push_back(Response::Events);
+
+				proto::GetProofShieldedInp msgInp;
+				msgInp.m_SpendPk = g_ShieldedInp.m_SpendPk;
+				Send(msgInp);
+				m_qExpected.push_back(Response::Inp);
+			}
+
+			virtual void OnMsg(proto::NewTip&& msg) override
+			{
+				verify_test(msg.m_Description.m_Height >= m_Tip.m_Height); // no rollbacks expected
+				m_Tip = msg.m_Description;
+			}
+
+			void OnResponse(Response x)
+			{
+				verify_test(!m_qExpected.empty() && (m_qExpected.front() == x));
+				if (!m_qExpected.empty())
+					m_qExpected.pop_front();
+
+				if (m_Tip.m_Height < m_hTrg)
+					return;
+
+				if (++m_nResponsesSynced == 90)
+					io::Reactor::get_Current().stop();
+			}
+
+			virtual void OnMsg(proto::ProofShieldedOutp&& msg) override
+			{
+				// should be there iff the tip reached it
+				verify_test(msg.m_Proof.empty() == (m_Tip.m_Height < g_ShieldedOutp.m_Height));
+
+				if (!msg.m_Proof.empty())
+				{
+					verify_test((msg.m_ID == g_ShieldedOutp.m_ID) && (msg.m_Height == g_ShieldedOutp.m_Height));
+					verify_test(msg.m_Commitment == g_ShieldedOutp.m_Commitment);
+					verify_test(m_Tip.IsValidProofShieldedOutp(g_ShieldedOutp, msg.m_Proof));
+					m_nProofs++;
+				}
+
+				OnResponse(Response::Outp);
+			}
+
+			virtual void OnMsg(proto::ProofShieldedInp&& msg) override
+			{
+				verify_test(msg.m_Proof.empty() == (m_Tip.m_Height < g_ShieldedInp.m_Height));
+
+				if (!msg.m_Proof.empty())
+				{
+					verify_test(msg.m_Height == g_ShieldedInp.m_Height);
+					verify_test(m_Tip.IsValidProofShieldedInp(g_ShieldedInp, msg.m_Proof));
+					m_nProofs++;
+				}
+
+				OnResponse(Response::Inp);
+			}
+
+			virtual void OnMsg(proto::Events&& msg) override
+			{
+				// must be the same as the events in the Node2 db up to the tip (the older heights don't change, since there are no rollbacks)
+				NodeDB::WalkerEvent wlk;
+				Serializer ser;
+				Height hLast = 0;
+				uint32_t nCount = 0;
+
+				for (m_Node.get_Processor().get_DB().EnumEvents(wlk, 0); wlk.MoveNext(); hLast = wlk.m_Height)
+				{
+					if ((wlk.m_Height > m_Tip.m_Height) || ((nCount >= proto::Event::s_Max) && (wlk.m_Height != hLast)))
+						break;
+
+					ser & wlk.m_Height;
+					ser.WriteRaw(wlk.m_Body.p, wlk.m_Body.n);
+					nCount++;
+				}
+
+				ByteBuffer buf;
+				ser.swap_buf(buf);
+				verify_test(buf == msg.m_Events);
+
+				std::setmax(m_nEvents, nCount);
+
+				OnResponse(Response::Events);
+			}
+		};
+
+		Height hTrg = node.get_Processor().m_Cursor.m_ID.m_Height;
+		verify_test(hTrg >= g_ShieldedInp.m_Height);
+
+		MyClient cl(node2, hTrg);
+		cl.m_pKdf = node2.m_Keys.m_pMiner;
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port + 1);
+
+		cl.Connect(addr);
+
+		pReactor->run();
+
+		verify_test(cl.m_Tip.m_Height == hTrg);
+		verify_test(cl.m_nProofs && cl.m_nEvents);
+	}
+
 
 	void TestChainworkProof()
 	{
@@ -2947,7 +4380,7 @@ namespace beam
 
 }
 
-void TestAll()
+void TestAll(bool bBenchmark)
 {
 	ECC::PseudoRandomGenerator prg;
 	ECC::PseudoRandomGenerator::Scope scopePrg(&prg);
@@ -2985,6 +4418,8 @@ void TestAll()
 
 	beam::DeleteFile(beam::g_sz);
 	beam::DeleteFile(beam::g_sz2);
+	beam::DeleteBbsStore(beam::g_sz);
+	beam::DeleteBbsStore(beam::g_sz2);
 
 	if (!bClientProtoOnly)
 	{
@@ -2994,6 +4429,12 @@ void TestAll()
 		beam::TestNodeDB();
 		beam::DeleteFile(beam::g_sz);
 
+		if (bBenchmark)
+			beam::BenchmarkNodeDBTxos(beam::g_sz);
+
+		beam::TestBbsStore(beam::g_sz);
+		beam::TestValidatedCache();
+
 		{
 			printf("NodeProcessor test1...\n");
 			fflush(stdout);
@@ -3004,6 +4445,15 @@ void TestAll()
 			beam::DeleteFile(beam::g_sz);
 			beam::DeleteFile(beam::g_sz2);
 
+			beam::TestBlockTemplate();
+			beam::DeleteFile(beam::g_sz);
+
+			if (bBenchmark)
+			{
+				beam::BenchmarkBlockTemplate();
+				beam::DeleteFile(beam::g_sz);
+			}
+
 			printf("NodeProcessor test2...\n");
 			fflush(stdout);
 
@@ -3016,14 +4466,42 @@ void TestAll()
 			beam::TestNodeProcessor3(blockChain);
 			beam::DeleteFile(beam::g_sz);
 			beam::DeleteFile(beam::g_sz2);
+
+			if (bBenchmark)
+				beam::BenchmarkBlockPipeline(blockChain);
+
+			beam::TestRecoveryCache(blockChain);
+			if (bBenchmark)
+				beam::BenchmarkRecoveryCache(blockChain);
+
+			beam::TestLz();
+			beam::TestCompressedWrapper();
+			if (bBenchmark)
+				beam::BenchmarkCompression(blockChain);
 		}
 
 		printf("NodeX2 concurrent test...\n");
 		fflush(stdout);
 
-		beam::TestNodeConversation();
+		// default configuration, then with the I/O thread
+		for (uint32_t nIoThreads = 0; nIoThreads < 2; nIoThreads++)
+		{
+			beam::TestNodeConversation(nIoThreads);
+			beam::DeleteFile(beam::g_sz);
+			beam::DeleteFile(beam::g_sz2);
+			beam::DeleteBbsStore(beam::g_sz);
+			beam::DeleteBbsStore(beam::g_sz2);
+		}
+
+		beam::TestTxDeferred();
 		beam::DeleteFile(beam::g_sz);
-		beam::DeleteFile(beam::g_sz2);
+		beam::DeleteBbsStore(beam::g_sz);
+
+		if (bBenchmark)
+		{
+			beam::BenchmarkIoThreads();
+			beam::DeleteBbsStore(beam::g_sz);
+		}
 	}
 
 	beam::Rules::get().pForks[2].m_Height = 17;
@@ -3035,7 +4513,27 @@ void TestAll()
 	printf("Node <---> Client test (with proofs)...\n");
 	fflush(stdout);
 
-	beam::TestNodeClientProto();
+	// default configuration (no read threads, no I/O threads)
+	beam::TestNodeClientProto(0, 0);
+
+	{
+		beam::DeleteFile(beam::g_sz);
+		beam::DeleteFile(beam::g_sz2);
+		beam::DeleteFile(beam::g_sz3);
+		beam::DeleteBbsStore(beam::g_sz);
+		beam::DeleteBbsStore(beam::g_sz2);
+
+		std::string sPath;
+		beam::NodeProcessor::get_UtxoMappingPath(sPath, beam::g_sz);
+		beam::DeleteFile(sPath.c_str());
+		beam::NodeProcessor::get_UtxoMappingPath(sPath, beam::g_sz2);
+		beam::DeleteFile(sPath.c_str());
+	}
+
+	printf("Node <---> Client test (with proofs), read and I/O threads...\n");
+	fflush(stdout);
+
+	beam::TestNodeClientProto(2, 2);
 
 	{
 		// test utxo set image rebuilding with shielded in/outs
@@ -3051,22 +4549,33 @@ void TestAll()
 		node.Initialize();
 	}
 
+	printf("Node sync with concurrent read requests...\n");
+	fflush(stdout);
+
+	beam::TestReadersUnderSync();
+	beam::DeleteBbsStore(beam::g_sz);
+
 	beam::DeleteFile(beam::g_sz);
 	beam::DeleteFile(beam::g_sz2);
 	beam::DeleteFile(beam::g_sz3);
+	beam::DeleteBbsStore(beam::g_sz);
+	beam::DeleteBbsStore(beam::g_sz2);
 
 	printf("Node <---> FlyClient test...\n");
 	fflush(stdout);
 
 	beam::TestFlyClient();
 	beam::DeleteFile(beam::g_sz);
+	beam::DeleteBbsStore(beam::g_sz);
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+	bool bBenchmark = (argc > 1) && !strcmp(argv[1], "--benchmark");
+
 	try
 	{
-		TestAll();
+		TestAll(bBenchmark);
 	}
 	catch (const std::exception & ex)
 	{
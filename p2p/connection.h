@@ -49,6 +49,12 @@ public:
     /// Disables all messages
     void disable_all_msg_types() { _msgReader.disable_all_msg_types(); }
 
+    /// Stops processing the incoming data until resume (see MsgReader::suspend)
+    void suspend_reading() { _msgReader.suspend(); }
+
+    /// Processes the data received while suspended. Returns false if the reading is over
+    bool resume_reading() { return _msgReader.resume(); }
+
 private:
     MsgReader _msgReader;
 };
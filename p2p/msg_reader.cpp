@@ -23,7 +23,8 @@ MsgReader::MsgReader(ProtocolBase& protocol, uint64_t streamId, size_t defaultSi
     _streamId(streamId),
     _defaultSize(defaultSize),
     _bytesLeft(MsgHeader::SIZE),
-    _state(reading_header)
+    _state(reading_header),
+    _suspended(false)
 {
 	_pAlive.reset(new bool);
 	*_pAlive = true;
@@ -48,6 +49,19 @@ void MsgReader::reset() {
     _cursor = _msgBuffer.data();
 }
 
+void MsgReader::suspend() {
+    _suspended = true;
+}
+
+bool MsgReader::resume() {
+    _suspended = false;
+
+    std::vector<uint8_t> data;
+    data.swap(_suspendedData);
+
+    return new_data_from_stream(io::EC_OK, data.data(), data.size());
+}
+
 void MsgReader::change_id(uint64_t newStreamId) {
     _streamId = newStreamId;
 }
@@ -69,6 +83,29 @@ void MsgReader::disable_all_msg_types() {
 }
 
 bool MsgReader::new_data_from_stream(io::ErrorCode connectionStatus, const void* data, size_t size) {
+    if (connectionStatus || !data || !size) {
+        return new_data_from_stream(connectionStatus, static_cast<void*>(nullptr), 0);
+    }
+
+    // the data is modified (decrypted) while processed, hence a copy
+    std::vector<uint8_t> buf;
+    buf.swap(_copyBuffer);
+
+    const uint8_t* p = (const uint8_t*)data;
+    buf.assign(p, p + size);
+
+	std::shared_ptr<bool> pAlive(_pAlive);
+    bool ret = new_data_from_stream(io::EC_OK, buf.data(), buf.size());
+
+    if (*pAlive && (buf.capacity() <= 2 * _defaultSize)) {
+        // keep it for the next time, unless it's excessive
+        _copyBuffer.swap(buf);
+    }
+
+    return ret;
+}
+
+bool MsgReader::new_data_from_stream(io::ErrorCode connectionStatus, void* data, size_t size) {
     if (connectionStatus != 0) {
         _protocol.on_connection_error(_streamId, connectionStatus);
         return false;
@@ -78,67 +115,73 @@ bool MsgReader::new_data_from_stream(io::ErrorCode connectionStatus, const void*
         return true;
     }
 
+    if (_suspended) {
+        const uint8_t* p = (const uint8_t*)data;
+        _suspendedData.insert(_suspendedData.end(), p, p + size);
+        return true;
+    }
+
 	std::shared_ptr<bool> pAlive(_pAlive);
 	volatile const bool& bAlive = *pAlive;
 
-    const uint8_t* p = (const uint8_t*)data;
+    uint8_t* p = (uint8_t*)data;
     size_t sz = size;
 
 	while (sz >= _bytesLeft)
 	{
-		memcpy(_cursor, p, _bytesLeft);
-		_protocol.Decrypt(_cursor, (uint32_t) _bytesLeft); // decrypt as much as we expect, no more (because cipher may change)
-
-		sz -= _bytesLeft;
-		p += _bytesLeft;
-
-		MsgHeader header(_msgBuffer.data());
-
-		if (_state == reading_header)
+		// decrypt as much as we expect, no more (because cipher may change)
+		if ((reading_header == _state) && (MsgHeader::SIZE == _bytesLeft))
 		{
-			// header has just been read
-			if (!_protocol.approve_msg_header(_streamId, header))
-				// at this moment, the *this* may be deleted
-				return false;
+			// the whole header is available, decrypt it in-place
+			_protocol.Decrypt(p, MsgHeader::SIZE);
 
-			if (!bAlive)
+			MsgHeader header(p);
+			if (!on_header(header, bAlive))
 				return false;
 
-			if (!_expectedMsgTypes.test(header.type)) {
-				_protocol.on_unexpected_msg(_streamId, header.type);
-				// at this moment, the *this* may be deleted
-				return false;
-			}
-
-			if (!bAlive)
-				return false;
+			size_t nMsgSize = MsgHeader::SIZE + header.size;
+			if (sz >= nMsgSize)
+			{
+				// the whole message is available as well, handle it in-place, without copying
+				_protocol.Decrypt(p + MsgHeader::SIZE, header.size);
 
-			// header deserialized successfully
-			_bytesLeft = header.size;
-			_msgBuffer.resize(MsgHeader::SIZE + _bytesLeft);
-			_cursor = _msgBuffer.data() + MsgHeader::SIZE;
+				if (!on_message(p, nMsgSize, bAlive))
+					return false;
 
-			_state = reading_message;
+				sz -= nMsgSize;
+				p += nMsgSize;
+			}
+			else
+			{
+				memcpy(_msgBuffer.data(), p, MsgHeader::SIZE);
+				sz -= MsgHeader::SIZE;
+				p += MsgHeader::SIZE;
 
+				start_message(header.size);
+				continue;
+			}
 		}
 		else
 		{
-			// whole message has been read
-			if (!_protocol.VerifyMsg(_msgBuffer.data(), static_cast<uint32_t>(_msgBuffer.size())))
+			memcpy(_cursor, p, _bytesLeft);
+			_protocol.Decrypt(_cursor, (uint32_t) _bytesLeft);
+
+			sz -= _bytesLeft;
+			p += _bytesLeft;
+
+			if (_state == reading_header)
 			{
-				_protocol.on_corrupt_msg(_streamId);
-				return false;
-			}
+				// header has just been read
+				MsgHeader header(_msgBuffer.data());
+				if (!on_header(header, bAlive))
+					return false;
 
-            if (!_protocol.on_new_message(_streamId, header.type, _msgBuffer.data() + MsgHeader::SIZE, header.size - _protocol.get_MacSize())) {
-                // at this moment, the *this* may be deleted
-                if (bAlive) {
-                    reset();
-                }
-                return false;
-            }
+				start_message(header.size);
+				continue;
+			}
 
-			if (!bAlive)
+			// whole message has been read
+			if (!on_message(_msgBuffer.data(), _msgBuffer.size(), bAlive))
 				return false;
 
 			if (_msgBuffer.size() > 2 * _defaultSize) {
@@ -154,6 +197,12 @@ bool MsgReader::new_data_from_stream(io::ErrorCode connectionStatus, const void*
 
 			_cursor = _msgBuffer.data();
 		}
+
+		if (_suspended)
+		{
+			_suspendedData.assign(p, p + sz);
+			return true;
+		}
 	}
 
 	if (sz)
@@ -168,5 +217,50 @@ bool MsgReader::new_data_from_stream(io::ErrorCode connectionStatus, const void*
 	return true;
 }
 
+bool MsgReader::on_header(const MsgHeader& header, volatile const bool& bAlive) {
+	if (!_protocol.approve_msg_header(_streamId, header))
+		// at this moment, the *this* may be deleted
+		return false;
+
+	if (!bAlive)
+		return false;
+
+	if (!_expectedMsgTypes.test(header.type)) {
+		_protocol.on_unexpected_msg(_streamId, header.type);
+		// at this moment, the *this* may be deleted
+		return false;
+	}
+
+	return bAlive;
+}
+
+void MsgReader::start_message(uint32_t size) {
+	// header deserialized successfully
+	_bytesLeft = size;
+	_msgBuffer.resize(MsgHeader::SIZE + _bytesLeft);
+	_cursor = _msgBuffer.data() + MsgHeader::SIZE;
+
+	_state = reading_message;
+}
+
+bool MsgReader::on_message(const uint8_t* p, size_t size, volatile const bool& bAlive) {
+	if (!_protocol.VerifyMsg(p, static_cast<uint32_t>(size)))
+	{
+		_protocol.on_corrupt_msg(_streamId);
+		return false;
+	}
+
+	MsgHeader header(p);
+    if (!_protocol.on_new_message(_streamId, header.type, p + MsgHeader::SIZE, header.size - _protocol.get_MacSize())) {
+        // at this moment, the *this* may be deleted
+        if (bAlive) {
+            reset();
+        }
+        return false;
+    }
+
+	return bAlive;
+}
+
 
 } //namespace
@@ -33,6 +33,9 @@ public:
     /// Calls the callback whenever a new protocol message is exctracted or on errors
     bool new_data_from_stream(io::ErrorCode connectionStatus, const void* data, size_t size);
 
+    /// Same, but the data is decrypted in-place, the messages received entirely are handled without copying
+    bool new_data_from_stream(io::ErrorCode connectionStatus, void* data, size_t size);
+
     /// Allows receiving messages of given type
     void enable_msg_type(MsgType type);
 
@@ -48,10 +51,22 @@ public:
     /// Resets to initial state
     void reset();
 
+    /// Stops processing the incoming data, can be called from within the message handler.
+    /// The data received meanwhile is kept as-is (not decrypted), so that the cipher can be changed before resume
+    void suspend();
+
+    /// Processes the kept data and continues. Returns false if the reading is over (the *this* may be deleted)
+    bool resume();
+
 private:
     /// 2 states of the reader
     enum State { reading_header, reading_message };
 
+    /// Header/message processing, return false if the reading is over (the *this* may be deleted)
+    bool on_header(const MsgHeader& header, volatile const bool& bAlive);
+    bool on_message(const uint8_t* p, size_t size, volatile const bool& bAlive);
+    void start_message(uint32_t size);
+
     /// Callbacks
     ProtocolBase& _protocol;
 
@@ -76,6 +91,13 @@ private:
     /// Filter for per-connection protocol logic
     std::bitset<256> _expectedMsgTypes;
 
+    /// Copy of the const data being processed, kept for reuse
+    std::vector<uint8_t> _copyBuffer;
+
+    /// Suspended state, and the data received meanwhile
+    bool _suspended;
+    std::vector<uint8_t> _suspendedData;
+
 	std::shared_ptr<bool> _pAlive;
 };
 
@@ -75,6 +75,11 @@ public:
         return *this;
     }
 
+    /// Appends raw data to message
+    void write(const void* ptr, size_t size) {
+        _os.write(ptr, size);
+    }
+
     /// Finalizes current message serialization. Returns serialized data in fragments
     /// If externalTailSize > 0 then serialized msg must be followed by raw buffer of thet size
     void finalize(SerializedMsg& fragments, size_t externalTailSize=0) {
@@ -53,11 +53,18 @@ public:
         i.maxSize = maxMsgSize;
     }
 
+    /// Default deserialization scope, does nothing
+    struct NoScope {
+        NoScope(size_t /* msgSize */) {}
+    };
+
     /// Called on protocol dispatch table setup
+    /// DeserializeScope object (constructed from the message size) lives while the message object is being deserialized
     template <
         typename MsgHandler,
         typename MsgObject,
-        bool(MsgHandler::*MessageFn)(uint64_t, MsgObject&&)
+        bool(MsgHandler::*MessageFn)(uint64_t, MsgObject&&),
+        typename DeserializeScope = NoScope
     >
     void add_message_handler(MsgType type, MsgHandler* msgHandler, uint32_t minMsgSize, uint32_t maxMsgSize) {
         add_custom_message_handler(
@@ -65,7 +72,12 @@ public:
             [](void* msgHandler, IErrorHandler& errorHandler, Deserializer& des, uint64_t fromStream, const void* data, size_t size) -> bool {
                 MsgObject m;
                 des.reset(data, size);
-                if (!des.deserialize(m) || des.bytes_left() > 0) {
+                bool ok;
+                {
+                    DeserializeScope scope(size);
+                    ok = des.deserialize(m) && !des.bytes_left();
+                }
+                if (!ok) {
                     errorHandler.on_protocol_error(fromStream, ProtocolError::message_corrupted);
                     return false;
                 }
@@ -0,0 +1,323 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Many mostly idle connections within a single reactor: memory footprint and message throughput
+
+#include "p2p/connection.h"
+#include "p2p/protocol.h"
+#include "utility/io/tcpserver.h"
+#include "utility/io/timer.h"
+#include "utility/helpers.h"
+#include "utility/test_helpers.h"
+#include <iostream>
+#include <fstream>
+#include <map>
+#ifndef WIN32
+#   include <sys/resource.h>
+#   include <unistd.h>
+#endif
+
+using namespace beam;
+using namespace beam::io;
+using namespace std;
+
+namespace {
+
+constexpr uint16_t g_port = 33334;
+constexpr size_t g_maxConnections = 10000;
+constexpr size_t g_maxPendingConnects = 64;
+constexpr size_t g_largePayload = 200 * 1024; // exceeds the read buffer, sent on some connections
+constexpr size_t g_smallPayload = 100;
+constexpr uint64_t g_throughputMsec = 1000;
+
+constexpr MsgType msgPing = 1;
+constexpr MsgType msgPong = 2;
+
+int g_failures = 0;
+
+#define CHECK(x) if (!(x)) { cout << "assertion failed: " #x " at " << __LINE__ << endl; ++g_failures; }
+
+struct Payload {
+    uint32_t n = 0;
+    std::vector<uint8_t> data;
+
+    void fill(uint32_t n_, size_t size) {
+        n = n_;
+        data.resize(size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = uint8_t(n + i);
+    }
+
+    bool verify() const {
+        for (size_t i = 0; i < data.size(); i++)
+            if (data[i] != uint8_t(n + i))
+                return false;
+        return true;
+    }
+
+    SERIALIZE(n, data);
+};
+
+struct MemStat {
+    size_t vm = 0;
+    size_t rss = 0;
+
+    void take() {
+#ifdef __linux__
+        std::ifstream fs("/proc/self/statm");
+        fs >> vm >> rss;
+        size_t nPage = sysconf(_SC_PAGESIZE);
+        vm *= nPage;
+        rss *= nPage;
+#endif // __linux__
+    }
+};
+
+size_t get_max_connections() {
+    size_t n = g_maxConnections;
+#ifndef WIN32
+    // each connection takes 2 descriptors (both sides are in this process)
+    rlimit rl;
+    if (!getrlimit(RLIMIT_NOFILE, &rl)) {
+        if (rl.rlim_cur < rl.rlim_max) {
+            rl.rlim_cur = rl.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &rl);
+            getrlimit(RLIMIT_NOFILE, &rl);
+        }
+        if (rl.rlim_cur != RLIM_INFINITY)
+            n = std::min(n, size_t(rl.rlim_cur > 200 ? (rl.rlim_cur - 100) / 2 : 50));
+    }
+#endif // WIN32
+    return n;
+}
+
+struct Test : IErrorHandler {
+
+    enum struct Phase {
+        Connecting,
+        Echo,
+        Throughput,
+        Done
+    };
+
+    Reactor::Ptr _reactor;
+    Protocol _srvProtocol;
+    Protocol _cliProtocol;
+    TcpServer::Ptr _server;
+    Timer::Ptr _timer;
+
+    std::map<uint64_t, Connection::Ptr> _srvConnections;
+    std::vector<Connection::Ptr> _cliConnections;
+    uint64_t _lastSrvId = 0;
+
+    size_t _numConnections;
+    size_t _connectsIssued = 0;
+    size_t _connected = 0;
+    size_t _accepted = 0;
+    size_t _pongs = 0;
+
+    Phase _phase = Phase::Connecting;
+    helpers::StopWatch _sw;
+    MemStat _memStart, _memConnected, _memEcho;
+
+    Test(size_t numConnections) :
+        _reactor(Reactor::create()),
+        _srvProtocol(0xAA, 0xBB, 0xCC, 8, *this, 200),
+        _cliProtocol(0xAA, 0xBB, 0xCC, 8, *this, 200),
+        _numConnections(numConnections)
+    {
+        _srvProtocol.add_message_handler<Test, Payload, &Test::on_ping>(msgPing, this, 4, 1024 * 1024);
+        _cliProtocol.add_message_handler<Test, Payload, &Test::on_pong>(msgPong, this, 4, 1024 * 1024);
+        _cliConnections.resize(_numConnections);
+    }
+
+    void on_protocol_error(uint64_t fromStream, ProtocolError error) override {
+        cout << __FUNCTION__ << "(" << fromStream << "," << static_cast<int32_t>(error) << ")" << endl;
+        ++g_failures;
+        _reactor->stop();
+    }
+
+    void on_connection_error(uint64_t fromStream, io::ErrorCode errorCode) override {
+        if (Phase::Done == _phase)
+            return;
+        cout << __FUNCTION__ << "(" << fromStream << "," << errorCode << ")" << endl;
+        ++g_failures;
+        _reactor->stop();
+    }
+
+    bool on_ping(uint64_t fromStream, Payload&& msg) {
+        auto it = _srvConnections.find(fromStream);
+        if (_srvConnections.end() == it)
+            return false;
+
+        SerializedMsg buf;
+        _srvProtocol.serialize(buf, msgPong, msg);
+        return it->second->write_msg(buf) == EC_OK;
+    }
+
+    bool on_pong(uint64_t fromStream, Payload&& msg) {
+        CHECK(msg.n == fromStream);
+        CHECK(msg.verify());
+
+        _pongs++;
+
+        switch (_phase)
+        {
+        case Phase::Echo:
+            CHECK(msg.data.size() == get_payload_size(fromStream));
+            if (_pongs == _numConnections) {
+                _memEcho.take();
+                _phase = Phase::Throughput;
+                _pongs = 0;
+                _sw.start();
+
+                for (size_t i = 0; i < _numConnections; i++)
+                    send_ping(i, g_smallPayload);
+            }
+            break;
+
+        case Phase::Throughput:
+            {
+                helpers::StopWatch swNow = _sw;
+                swNow.stop();
+                if (swNow.milliseconds() < g_throughputMsec)
+                    send_ping(fromStream, g_smallPayload);
+                else
+                {
+                    _phase = Phase::Done;
+                    _sw.stop();
+                    _reactor->stop();
+                }
+            }
+            break;
+
+        default: // Done, the remaining responses are ignored
+            break;
+        }
+
+        return true;
+    }
+
+    static size_t get_payload_size(uint64_t i) {
+        return (i % 100) ? g_smallPayload : g_largePayload;
+    }
+
+    void send_ping(uint64_t i, size_t nSize) {
+        Payload msg;
+        msg.fill(uint32_t(i), nSize);
+
+        SerializedMsg buf;
+        _cliProtocol.serialize(buf, msgPing, msg);
+        _cliConnections[i]->write_msg(buf);
+    }
+
+    void connect_next() {
+        while ((_connectsIssued < _numConnections) && (_connectsIssued - _connected < g_maxPendingConnects)) {
+            auto res = _reactor->tcp_connect(Address::localhost().port(g_port), _connectsIssued, BIND_THIS_MEMFN(on_connected));
+            if (!res) {
+                on_connection_error(_connectsIssued, res.error());
+                return;
+            }
+            _connectsIssued++;
+        }
+    }
+
+    void on_connected(uint64_t tag, TcpStream::Ptr&& newStream, io::ErrorCode status) {
+        if (!newStream) {
+            on_connection_error(tag, status);
+            return;
+        }
+
+        _cliConnections[tag] = make_unique<Connection>(_cliProtocol, tag, Connection::outbound, 100, move(newStream));
+        _connected++;
+        connect_next();
+        on_connection_progress();
+    }
+
+    void on_accepted(TcpStream::Ptr&& newStream, io::ErrorCode status) {
+        if (!newStream) {
+            on_connection_error(0, status);
+            return;
+        }
+
+        uint64_t id = ++_lastSrvId;
+        _srvConnections[id] = make_unique<Connection>(_srvProtocol, id, Connection::inbound, 100, move(newStream));
+        _accepted++;
+        on_connection_progress();
+    }
+
+    void on_connection_progress() {
+        if ((_connected < _numConnections) || (_accepted < _numConnections))
+            return;
+
+        _memConnected.take();
+        _phase = Phase::Echo;
+
+        for (size_t i = 0; i < _numConnections; i++)
+            send_ping(i, get_payload_size(i));
+    }
+
+    void run() {
+        Reactor::Scope scope(*_reactor);
+
+        _memStart.take();
+
+        _server = TcpServer::create(*_reactor, Address::localhost().port(g_port), BIND_THIS_MEMFN(on_accepted));
+
+        _timer = Timer::create(*_reactor);
+        _timer->start(60000, false, [this] {
+            cout << "timed out" << endl;
+            ++g_failures;
+            _reactor->stop();
+        });
+
+        connect_next();
+        _reactor->run();
+
+        CHECK(Phase::Done == _phase);
+        if (Phase::Done != _phase)
+            return;
+
+        cout << "connections: " << _numConnections;
+        if (_numConnections < g_maxConnections)
+            cout << " (capped by the descriptors limit)";
+        cout << endl;
+
+        auto perConnection = [this](size_t a, size_t b) {
+            return (b > a) ? (b - a) / (2 * _numConnections) : 0;
+        };
+
+        cout << "per connection side, idle: RSS " << perConnection(_memStart.rss, _memConnected.rss)
+            << " bytes, VM " << perConnection(_memStart.vm, _memConnected.vm) << " bytes" << endl;
+        cout << "per connection side, after echo: RSS " << perConnection(_memStart.rss, _memEcho.rss)
+            << " bytes, VM " << perConnection(_memStart.vm, _memEcho.vm) << " bytes" << endl;
+
+        uint64_t ms = _sw.milliseconds();
+        cout << "throughput: " << (_pongs * 1000 / std::max<uint64_t>(ms, 1)) << " roundtrips/sec" << endl;
+    }
+};
+
+} // namespace
+
+int main() {
+    try {
+        Test t(get_max_connections());
+        t.run();
+    } catch (const std::exception& e) {
+        cout << "Exception: " << e.what() << "\n";
+        ++g_failures;
+    }
+
+    return g_failures ? -1 : 0;
+}
@@ -105,9 +105,20 @@ bool Block::PoW::IsValid(const void* pInput, uint32_t nSizeInput, Height h) cons
 	Helper hlp;
 	hlp.Reset(pInput, nSizeInput, m_Nonce, h);
 
-	std::vector<uint8_t> v(m_Indices.begin(), m_Indices.end());
+	PoWScheme* pScheme = hlp.getCurrentPoW(h);
+	bool bValid;
+
+	if (pScheme == &hlp.BeamHashIII)
+		// header sync verifies thousands of them, avoid the allocations of the generic path
+		bValid = BeamHash_III::IsValidSolutionFast(hlp.m_Blake, &m_Indices.front(), m_Indices.size());
+	else
+	{
+		std::vector<uint8_t> v(m_Indices.begin(), m_Indices.end());
+		bValid = pScheme->IsValidSolution(hlp.m_Blake, v);
+	}
+
     return
-		hlp.getCurrentPoW(h)->IsValidSolution(hlp.m_Blake, v) &&
+		bValid &&
 		hlp.TestDifficulty(&m_Indices.front(), (uint32_t) m_Indices.size(), m_Difficulty);
 }
 
@@ -15,8 +15,11 @@
 #include "core/block_crypt.h"
 #include <iostream>
 #include "3rdparty/crypto/equihashR.h"
+#include "3rdparty/crypto/beamHashIII.h"
 #include "wallet/unittests/test_helpers.h"
+#include "utility/hex.h"
 #include <algorithm>
+#include <chrono>
 
 WALLET_TEST_INIT
 using namespace std;
@@ -89,9 +92,152 @@ void TestArrayExpanding()
     TestArrayExpanding(96, 5);
 }
 
+namespace
+{
+    // precomputed BeamHash III solution for the input {1,2,3,4,5}, zero nonce
+    const uint8_t g_pBH3Input[] = { 1, 2, 3, 4, 5 };
+    const char g_szBH3Solution[] =
+        "fe7c02d06ee4db12edf9946e9932fc439bb2b0225852732be2b5f87aba5313bd93262a21faf63e07cd5d71649151e79b75f050b81496de00a1db1091b289578fd344fa15db1e76d9d092ead13934769b715f5cd864470f0e1a9b0dd93a36aa5a519c3be000000000";
+
+    void InitBH3State(BeamHash_III& bh, blake2b_state& state)
+    {
+        bh.InitialiseState(state);
+        blake2b_update(&state, g_pBH3Input, sizeof(g_pBH3Input));
+
+        beam::Block::PoW::NonceType nonce(beam::Zero);
+        blake2b_update(&state, nonce.m_pData, nonce.nBytes);
+    }
+
+    void SetBH3Index(vector<uint8_t>& sol, uint32_t i, uint32_t val)
+    {
+        for (uint32_t iBit = 0; iBit < 25; iBit++)
+        {
+            uint32_t pos = i * 25 + iBit;
+            uint8_t msk = uint8_t(1 << (pos & 7));
+            if ((val >> iBit) & 1)
+                sol[pos >> 3] |= msk;
+            else
+                sol[pos >> 3] &= ~msk;
+        }
+    }
+
+    uint32_t GetBH3Index(const vector<uint8_t>& sol, uint32_t i)
+    {
+        uint32_t val = 0;
+        for (uint32_t iBit = 0; iBit < 25; iBit++)
+        {
+            uint32_t pos = i * 25 + iBit;
+            if ((sol[pos >> 3] >> (pos & 7)) & 1)
+                val |= 1U << iBit;
+        }
+        return val;
+    }
+}
+
+void TestBeamHashIII()
+{
+    cout << "Test BeamHash III verification...\n";
+
+    BeamHash_III bh;
+    blake2b_state state;
+    InitBH3State(bh, state);
+
+    vector<uint8_t> sol = beam::from_hex(g_szBH3Solution);
+    WALLET_CHECK(sol.size() == 104);
+
+    WALLET_CHECK(bh.IsValidSolution(state, sol));
+    WALLET_CHECK(BeamHash_III::IsValidSolutionFast(state, &sol.front(), sol.size()));
+    WALLET_CHECK(!BeamHash_III::IsValidSolutionFast(state, &sol.front(), sol.size() - 1));
+
+    {
+        beam::Block::PoW pow;
+        pow.m_Nonce = beam::Zero;
+        pow.m_Difficulty = beam::Difficulty(0);
+        std::copy(sol.begin(), sol.end(), pow.m_Indices.begin());
+
+        beam::Height h = beam::Rules::get().pForks[2].m_Height;
+        WALLET_CHECK(pow.IsValid(g_pBH3Input, sizeof(g_pBH3Input), h));
+
+        pow.m_Nonce.Inc();
+        WALLET_CHECK(!pow.IsValid(g_pBH3Input, sizeof(g_pBH3Input), h));
+    }
+
+    // both verifiers must agree on every single-bit corruption
+    uint32_t nAccepted = 0;
+    for (uint32_t iBit = 0; iBit < sol.size() * 8; iBit++)
+    {
+        vector<uint8_t> v = sol;
+        v[iBit >> 3] ^= uint8_t(1 << (iBit & 7));
+
+        bool bRef = bh.IsValidSolution(state, v);
+        bool bFast = BeamHash_III::IsValidSolutionFast(state, &v.front(), v.size());
+        WALLET_CHECK(bRef == bFast);
+        if (bFast)
+            nAccepted++;
+    }
+    WALLET_CHECK(!nAccepted);
+
+    // swapped subtrees break the index order at the corresponding round, duplicated indices - the distinctness
+    for (uint32_t nLeafs = 1; nLeafs < 32; nLeafs <<= 1)
+    {
+        vector<uint8_t> v = sol;
+        for (uint32_t i = 0; i < nLeafs; i++)
+        {
+            uint32_t a = GetBH3Index(sol, i);
+            uint32_t b = GetBH3Index(sol, i + nLeafs);
+            SetBH3Index(v, i, b);
+            SetBH3Index(v, i + nLeafs, a);
+        }
+
+        WALLET_CHECK(!bh.IsValidSolution(state, v));
+        WALLET_CHECK(!BeamHash_III::IsValidSolutionFast(state, &v.front(), v.size()));
+
+        v = sol;
+        SetBH3Index(v, nLeafs, GetBH3Index(sol, 0));
+
+        WALLET_CHECK(!bh.IsValidSolution(state, v));
+        WALLET_CHECK(!BeamHash_III::IsValidSolutionFast(state, &v.front(), v.size()));
+    }
+}
+
+void BenchmarkBeamHashIII()
+{
+    BeamHash_III bh;
+    blake2b_state state;
+    InitBH3State(bh, state);
+
+    vector<uint8_t> sol = beam::from_hex(g_szBH3Solution);
+
+    for (uint32_t iFast = 0; iFast < 2; iFast++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        uint32_t nDone = 0;
+        double dt_s = 0;
+
+        do
+        {
+            for (uint32_t i = 0; i < 100; i++)
+            {
+                bool bValid = iFast ?
+                    BeamHash_III::IsValidSolutionFast(state, &sol.front(), sol.size()) :
+                    bh.IsValidSolution(state, sol);
+                WALLET_CHECK(bValid);
+            }
+
+            nDone += 100;
+            dt_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        } while (dt_s < 0.5);
+
+        cout << "BeamHash III verify " << (iFast ? "fast" : "reference") << ": " << static_cast<uint32_t>(nDone / dt_s) << " hdrs/sec\n";
+    }
+}
+
 int main()
 {
     TestArrayExpanding();
+    TestBeamHashIII();
+    BenchmarkBeamHashIII();
     
     // commented since it doesn't complete in 10 minutes and failes auto tests
 /*
@@ -138,6 +138,8 @@ namespace beam
         const char* MINING_THREADS = "mining_threads";
         const char* POW_SOLVE_TIME = "pow_solve_time";
         const char* VERIFICATION_THREADS = "verification_threads";
+        const char* IO_THREADS = "io_threads";
+        const char* READ_THREADS = "read_threads";
         const char* NONCEPREFIX_DIGITS = "nonceprefix_digits";
         const char* NODE_PEER = "peer";
         const char* NODE_PEERS_PERSISTENT = "peers_persistent";
@@ -368,6 +370,8 @@ namespace beam
             (cli::POW_SOLVE_TIME, po::value<uint32_t>()->default_value(15 * 1000), "pow solve time. It works if FakePoW is enabled")
 
             (cli::VERIFICATION_THREADS, po::value<int>()->default_value(-1), "number of threads for cryptographic verifications (0 = single thread, -1 = auto)")
+            (cli::IO_THREADS, po::value<uint32_t>()->default_value(0), "number of threads serving the node connections: socket I/O, encryption, deserialization (0 = none, served by the node thread). Not supported on Windows")
+            (cli::READ_THREADS, po::value<uint32_t>()->default_value(0), "number of threads serving heavy read-only requests (events, shielded proofs) from db snapshots (0 = served by the node thread)")
             (cli::NONCEPREFIX_DIGITS, po::value<unsigned>()->default_value(0), "number of hex digits for nonce prefix for stratum client (0..6)")
             (cli::NODE_PEER, po::value<vector<string>>()->multitoken(), "nodes to connect to")
             (cli::NODE_PEERS_PERSISTENT, po::value<bool>()->default_value(false), "Keep persistent connection to the specified peers, regardless to ratings")
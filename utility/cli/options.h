@@ -36,6 +36,8 @@ namespace beam
         extern const char* MINING_THREADS;
         extern const char* POW_SOLVE_TIME;
         extern const char* VERIFICATION_THREADS;
+        extern const char* IO_THREADS;
+        extern const char* READ_THREADS;
         extern const char* NONCEPREFIX_DIGITS;
         extern const char* NODE_PEER;
         extern const char* NODE_PEERS_PERSISTENT;
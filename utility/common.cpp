@@ -152,17 +152,106 @@ namespace beam
 		return m_Threads;
 	}
 
+	void ExecutorMT::Ring::Init(uint32_t nSize)
+	{
+		size_t n = 2;
+		while (n < nSize)
+			n <<= 1;
+
+		m_pCells.reset(new Cell[n]);
+		m_Mask = n - 1;
+
+		for (size_t i = 0; i < n; i++)
+			m_pCells[i].m_Seq.store(i, std::memory_order_relaxed);
+
+		m_Tail.store(0, std::memory_order_relaxed);
+		m_Head.store(0, std::memory_order_relaxed);
+	}
+
+	bool ExecutorMT::Ring::TryPush(TaskAsync* pTask)
+	{
+		size_t pos = m_Tail.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& c = m_pCells[pos & m_Mask];
+			intptr_t dif = static_cast<intptr_t>(c.m_Seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos);
+
+			if (!dif)
+			{
+				if (m_Tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					c.m_pTask = pTask;
+					c.m_Seq.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else
+			{
+				if (dif < 0)
+					return false; // full
+				pos = m_Tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	Executor::TaskAsync* ExecutorMT::Ring::TryPop()
+	{
+		size_t pos = m_Head.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& c = m_pCells[pos & m_Mask];
+			intptr_t dif = static_cast<intptr_t>(c.m_Seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos + 1);
+
+			if (!dif)
+			{
+				if (m_Head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					TaskAsync* pTask = c.m_pTask;
+					c.m_Seq.store(pos + m_Mask + 1, std::memory_order_release);
+					return pTask;
+				}
+			}
+			else
+			{
+				if (dif < 0)
+					return nullptr; // empty
+				pos = m_Head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	namespace
+	{
+		// the worker the current thread runs (if any)
+		thread_local const Executor* g_pWorkerOf = nullptr;
+		thread_local uint32_t g_iWorker = 0;
+		thread_local Executor::Context* g_pWorkerCtx = nullptr;
+	}
+
 	void ExecutorMT::InitSafe()
 	{
 		if (!m_vThreads.empty())
 			return;
 
+		uint32_t nThreads = get_Threads();
+		assert(nThreads);
+
 		m_Run = true;
-		m_pCtl = nullptr;
 		m_InProgress = 0;
 		m_FlushTarget = static_cast<uint32_t>(-1);
+		m_Sleepers = 0;
+		m_iNext = 0;
+
+		m_pWorkers.reset(new Worker[nThreads]);
+		for (uint32_t i = 0; i < nThreads; i++)
+		{
+			Worker& w = m_pWorkers[i];
+			w.m_Ring.Init(m_QueueSize);
+			w.m_pCtl = nullptr;
+			w.m_Sleeping = false;
+			w.m_Signaled = false;
+		}
 
-		uint32_t nThreads = get_Threads();
 		m_vThreads.resize(nThreads);
 
 		for (uint32_t i = 0; i < nThreads; i++)
@@ -174,49 +263,134 @@ namespace beam
 		assert(pTask);
 		InitSafe();
 
-		std::unique_lock<std::mutex> scope(m_Mutex);
+		uint32_t nThreads = get_Threads();
+		bool bWorker = (this == g_pWorkerOf);
+
+		uint32_t iThread = bWorker ?
+			g_iWorker :
+			(m_iNext.fetch_add(1, std::memory_order_relaxed) % nThreads);
+
+		m_InProgress.fetch_add(1);
+		TaskAsync* p = pTask.release();
+
+		while (true)
+		{
+			for (uint32_t i = 0; i < nThreads; i++)
+			{
+				uint32_t iDst = (iThread + i) % nThreads;
+				if (m_pWorkers[iDst].m_Ring.TryPush(p))
+				{
+					WakeOne(iDst);
+					return;
+				}
+			}
+
+			// all queues are full
+			if (bWorker)
+			{
+				// no point to wait for ourselves
+				TaskAsync::Ptr pGuard(p);
+				p->Exec(*g_pWorkerCtx);
+				pGuard.reset();
+
+				OnTaskDone();
+				return;
+			}
+
+			WakeOne(iThread);
+			std::this_thread::yield();
+		}
+	}
+
+	void ExecutorMT::WakeOne(uint32_t iThread)
+	{
+		// pairs with the fence in Sleep(): either we see the sleeper, or it sees the new task
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!m_Sleepers.load(std::memory_order_relaxed))
+			return;
+
+		uint32_t nThreads = get_Threads();
+		for (uint32_t i = 0; i < nThreads; i++)
+		{
+			Worker& w = m_pWorkers[(iThread + i) % nThreads];
+			if (!w.m_Sleeping.load())
+				continue;
 
-		m_queTasks.push_back(*pTask.release());
-		m_InProgress++;
+			std::unique_lock<std::mutex> scope(w.m_Mutex);
+			if (w.m_Sleeping && !w.m_Signaled)
+			{
+				w.m_Signaled = true;
+				w.m_Wake.notify_one();
+				return;
+			}
+		}
+	}
 
-		m_NewTask.notify_one();
+	void ExecutorMT::Wake(Worker& w)
+	{
+		std::unique_lock<std::mutex> scope(w.m_Mutex);
+		w.m_Signaled = true;
+		w.m_Wake.notify_one();
 	}
 
 	uint32_t ExecutorMT::Flush(uint32_t nMaxTasks)
 	{
 		InitSafe();
-
-		std::unique_lock<std::mutex> scope(m_Mutex);
-		FlushLocked(scope, nMaxTasks);
+		FlushInternal(nMaxTasks);
 
 		return m_InProgress;
 	}
 
-	void ExecutorMT::FlushLocked(std::unique_lock<std::mutex>& scope, uint32_t nMaxTasks)
+	void ExecutorMT::FlushInternal(uint32_t nMaxTasks)
 	{
-		m_FlushTarget = nMaxTasks;
+		if (m_InProgress <= nMaxTasks)
+			return;
 
-		while (m_InProgress > nMaxTasks)
-			m_Flushed.wait(scope);
+		std::unique_lock<std::mutex> scope(m_MutexFlush);
 
-		m_FlushTarget = static_cast<uint32_t>(-1);
+		// there may be several concurrent flushers. Completions signal once the highest target is reached (it's reached first), each flusher re-checks its own
+		auto it = m_FlushTargets.insert(nMaxTasks);
+		m_FlushTarget = *m_FlushTargets.rbegin();
+
+		m_Flushed.wait(scope, [this, nMaxTasks] { return m_InProgress <= nMaxTasks; });
+
+		m_FlushTargets.erase(it);
+		m_FlushTarget = m_FlushTargets.empty() ? static_cast<uint32_t>(-1) : *m_FlushTargets.rbegin();
+	}
+
+	void ExecutorMT::OnTaskDone()
+	{
+		uint32_t nLeft = m_InProgress.fetch_sub(1) - 1;
+		uint32_t nTarget = m_FlushTarget;
+
+		if ((nLeft <= nTarget) && (static_cast<uint32_t>(-1) != nTarget))
+		{
+			// lock to avoid the race with the flusher between its check and wait
+			std::unique_lock<std::mutex> scope(m_MutexFlush);
+			m_Flushed.notify_all();
+		}
 	}
 
 	void ExecutorMT::ExecAll(TaskSync& t)
 	{
-		InitSafe();
+		// the workers are shared, concurrent callers take turns
+		std::unique_lock<std::mutex> scope(m_MutexExecAll);
 
-		std::unique_lock<std::mutex> scope(m_Mutex);
-		FlushLocked(scope, 0);
+		InitSafe();
+		FlushInternal(0);
 
-		assert(!m_pCtl && !m_InProgress);
-		m_pCtl = &t;
-		m_InProgress = get_Threads();
+		uint32_t nThreads = get_Threads();
+		m_InProgress.fetch_add(nThreads); // not a store: tasks may be pushed concurrently by other threads
 
-		m_NewTask.notify_all();
+		for (uint32_t i = 0; i < nThreads; i++)
+		{
+			Worker& w = m_pWorkers[i];
+			assert(!w.m_pCtl);
+			w.m_pCtl = &t;
+			Wake(w);
+		}
 
-		FlushLocked(scope, 0);
-		assert(!m_pCtl);
+		FlushInternal(0);
 	}
 
 	void ExecutorMT::Stop()
@@ -224,11 +398,11 @@ namespace beam
 		if (m_vThreads.empty())
 			return;
 
-		{
-			std::unique_lock<std::mutex> scope(m_Mutex);
-			m_Run = false;
-			m_NewTask.notify_all();
-		}
+		m_Run = false;
+
+		uint32_t nThreads = static_cast<uint32_t>(m_vThreads.size());
+		for (uint32_t i = 0; i < nThreads; i++)
+			Wake(m_pWorkers[i]);
 
 		for (size_t i = 0; i < m_vThreads.size(); i++)
 			if (m_vThreads[i].joinable())
@@ -236,11 +410,17 @@ namespace beam
 
 		m_vThreads.clear();
 
-		while (!m_queTasks.empty())
+		for (uint32_t i = 0; i < nThreads; i++)
 		{
-			TaskAsync::Ptr pGuard(&m_queTasks.front());
-			m_queTasks.pop_front();
+			while (true)
+			{
+				TaskAsync::Ptr pGuard(m_pWorkers[i].m_Ring.TryPop());
+				if (!pGuard)
+					break;
+			}
 		}
+
+		m_pWorkers.reset();
 	}
 
 	void ExecutorMT::RunThread(uint32_t iThread)
@@ -250,67 +430,96 @@ namespace beam
 		RunThreadCtx(ctx);
 	}
 
-	void ExecutorMT::RunThreadCtx(Context& ctx)
+	Executor::TaskAsync* ExecutorMT::Fetch(uint32_t iThread)
 	{
-		ctx.m_pThis = this;
-
-		while (true)
+		uint32_t nThreads = get_Threads();
+		for (uint32_t i = 0; i < nThreads; i++)
 		{
-			TaskAsync::Ptr pGuard;
-			TaskSync* pTask;
+			// own queue first, then steal
+			TaskAsync* pTask = m_pWorkers[(iThread + i) % nThreads].m_Ring.TryPop();
+			if (pTask)
+				return pTask;
+		}
+		return nullptr;
+	}
 
-			{
-				std::unique_lock<std::mutex> scope(m_Mutex);
-				while (true)
-				{
-					if (!m_Run)
-						return;
+	Executor::TaskAsync* ExecutorMT::Sleep(Worker& w, uint32_t iThread)
+	{
+		std::unique_lock<std::mutex> scope(w.m_Mutex);
 
-					if (!m_queTasks.empty())
-					{
-						pGuard.reset(&m_queTasks.front());
-						pTask = pGuard.get();
-						m_queTasks.pop_front();
-						break;
-					}
+		w.m_Sleeping = true;
+		m_Sleepers.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
 
-					if (m_pCtl)
-					{
-						pTask = m_pCtl;
-						break;
-					}
+		// re-check after being visible as a sleeper
+		TaskAsync* pTask = Fetch(iThread);
+		if (!pTask && m_Run && !w.m_pCtl)
+		{
+			while (!w.m_Signaled)
+				w.m_Wake.wait(scope);
+		}
 
-					m_NewTask.wait(scope);
-				}
-			}
+		w.m_Signaled = false;
+		w.m_Sleeping = false;
+		m_Sleepers.fetch_sub(1);
 
-			assert(pTask && m_InProgress);
-			pTask->Exec(ctx);
+		return pTask;
+	}
+
+	void ExecutorMT::RunThreadCtx(Context& ctx)
+	{
+		ctx.m_pThis = this;
+
+		const uint32_t iThread = ctx.m_iThread;
+		Worker& w = m_pWorkers[iThread];
 
-			std::unique_lock<std::mutex> scope(m_Mutex);
+		g_pWorkerOf = this;
+		g_iWorker = iThread;
+		g_pWorkerCtx = &ctx;
 
-			assert(m_InProgress);
-			m_InProgress--;
+		const uint32_t nSpin = 16;
+		uint32_t nIdle = 0;
 
-			if (pGuard)
+		while (true)
+		{
+			TaskSync* pCtl = w.m_pCtl.exchange(nullptr);
+			if (pCtl)
 			{
-				// standard task
-				if (m_InProgress == m_FlushTarget)
-					m_Flushed.notify_one();
+				// control task, exactly once per thread
+				pCtl->Exec(ctx);
+				OnTaskDone();
+				continue;
 			}
-			else
+
+			TaskAsync* pTask = Fetch(iThread);
+			if (!pTask)
 			{
-				// control task
-				if (m_InProgress)
-					m_Flushed.wait(scope); // make sure we give other threads opportuinty to execute the control task
-				else
+				if (!m_Run)
+					break;
+
+				if (++nIdle < nSpin)
 				{
-					m_pCtl = nullptr;
-					m_Flushed.notify_all();
+					std::this_thread::yield();
+					continue;
 				}
+
+				nIdle = 0;
+				pTask = Sleep(w, iThread);
+				if (!pTask)
+					continue;
 			}
 
+			nIdle = 0;
+
+			TaskAsync::Ptr pGuard(pTask);
+			pTask->Exec(ctx);
+			pGuard.reset();
+
+			OnTaskDone();
 		}
+
+		g_pWorkerOf = nullptr;
+		g_pWorkerCtx = nullptr;
 	}
 
 } // namespace beam
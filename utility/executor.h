@@ -16,7 +16,10 @@
 
 #include "common.h"
 #include <condition_variable>
+#include <atomic>
+#include <memory>
 #include <thread>
+#include <set>
 #include <boost/intrusive/list.hpp>
 
 namespace beam
@@ -64,12 +67,15 @@ namespace beam
 
 		virtual uint32_t get_Threads() = 0;
 		virtual void Push(TaskAsync::Ptr&&) = 0;
-		virtual uint32_t Flush(uint32_t nMaxTasks = 0) = 0;
+		virtual uint32_t Flush(uint32_t nMaxTasks = 0) = 0; // waits until at most nMaxTasks are in progress, returns their count. Flush(-1) doesn't wait
 		virtual void ExecAll(TaskSync&) = 0;
 		virtual ~Executor() = default;
 	};
 
-	// standard multi-threaded executor. All threads are created with default stack and priority
+	// standard multi-threaded executor. All threads are created with default stack and priority.
+	// Each thread owns a bounded lock-free task queue. Submission is spread across the queues (the submitting worker's own queue if called from within a task),
+	// idle threads steal from the others. Only sleeping threads are woken, and only one per submitted task. Flush only wakes the flushing thread.
+	// ExecAll may be called concurrently from different (non-worker) threads, the calls are serialized.
 	struct ExecutorMT
 		:public Executor
 	{
@@ -84,6 +90,8 @@ namespace beam
 
 		void set_Threads(uint32_t);
 
+		uint32_t m_QueueSize = 0x400; // per thread, rounded up to power of 2. Applied on thread (re)start
+
 	protected:
 
 		uint32_t m_Threads; // set at c'tor to num of cores.
@@ -92,20 +100,59 @@ namespace beam
 		void RunThreadCtx(Context&);
 
 	private:
-		std::mutex m_Mutex;
 
-		boost::intrusive::list<TaskAsync> m_queTasks;
+		// bounded MPMC queue (sequence-tagged cells). The owner and the thieves use the same pop.
+		struct Ring
+		{
+			struct Cell
+			{
+				std::atomic<size_t> m_Seq;
+				TaskAsync* m_pTask;
+			};
+
+			std::unique_ptr<Cell[]> m_pCells;
+			size_t m_Mask;
 
-		uint32_t m_InProgress;
-		uint32_t m_FlushTarget;
-		bool m_Run;
-		TaskSync* m_pCtl;
-		std::condition_variable m_NewTask;
-		std::condition_variable m_Flushed;
+			alignas(64) std::atomic<size_t> m_Tail;
+			alignas(64) std::atomic<size_t> m_Head;
+
+			void Init(uint32_t nSize);
+			bool TryPush(TaskAsync*);
+			TaskAsync* TryPop();
+		};
+
+		struct alignas(64) Worker
+		{
+			Ring m_Ring;
+			std::atomic<TaskSync*> m_pCtl;
+			std::atomic<bool> m_Sleeping;
+
+			std::mutex m_Mutex;
+			std::condition_variable m_Wake;
+			bool m_Signaled;
+		};
 
+		std::unique_ptr<Worker[]> m_pWorkers;
 		std::vector<std::thread> m_vThreads;
 
+		std::atomic<bool> m_Run;
+		std::atomic<uint32_t> m_InProgress;
+		std::atomic<uint32_t> m_FlushTarget;
+		std::atomic<uint32_t> m_Sleepers;
+		std::atomic<uint32_t> m_iNext;
+
+		std::mutex m_MutexFlush;
+		std::condition_variable m_Flushed;
+		std::multiset<uint32_t> m_FlushTargets; // of all the waiting flushers, m_FlushTarget is the highest
+
+		std::mutex m_MutexExecAll;
+
 		void InitSafe();
-		void FlushLocked(std::unique_lock<std::mutex>&, uint32_t nMaxTasks);
+		void FlushInternal(uint32_t nMaxTasks);
+		void OnTaskDone();
+		TaskAsync* Fetch(uint32_t iThread);
+		void WakeOne(uint32_t iThread);
+		void Wake(Worker&);
+		TaskAsync* Sleep(Worker&, uint32_t iThread);
 	};
 }
@@ -23,6 +23,7 @@
 
 #ifndef WIN32
 #include <signal.h>
+#include <unistd.h>
 #endif // WIN32
 
 #ifndef LOG_VERBOSE_ENABLED
@@ -339,6 +340,61 @@ private:
     std::unordered_map<uv_write_t*, Ctx> _data;
 };
 
+class ReadBuffers {
+public:
+    ReadBuffers() :
+        _maxSize(config().get_int("io.stream_read_buffer_size", 256*1024, 2048, 1024*1024*16))
+    {}
+
+    ~ReadBuffers() {
+        for (auto& v : _free) {
+            for (char* p : v) free(p);
+        }
+    }
+
+    void alloc(uv_buf_t& buf, size_t size) {
+        uint32_t iClass = 0;
+        size_t len = MIN_SIZE;
+        for (; (len < size) && (len < _maxSize); iClass++)
+            len <<= 2;
+
+        len = std::min(len, _maxSize);
+
+        std::vector<char*>& v = _free[iClass];
+        if (v.empty())
+            buf.base = (char*) malloc(len);
+        else {
+            buf.base = v.back();
+            v.pop_back();
+        }
+
+        buf.len = buf.base ? len : 0;
+    }
+
+    void release(const uv_buf_t& buf) {
+        if (!buf.base)
+            return;
+
+        uint32_t iClass = 0;
+        for (size_t len = MIN_SIZE; (len < buf.len) && (len < _maxSize); iClass++)
+            len <<= 2;
+
+        std::vector<char*>& v = _free[iClass];
+        if (v.size() < MAX_FREE)
+            v.push_back(buf.base);
+        else
+            free(buf.base);
+    }
+
+private:
+    static const size_t MIN_SIZE = 4096;
+    static const size_t MAX_FREE = 8; // per size class. The buffers are borrowed only within read callbacks, so few are needed
+    static const uint32_t NUM_CLASSES = 8; // 4K * 4^7 = 64M, above the max allowed size
+
+    const size_t _maxSize;
+    std::vector<char*> _free[NUM_CLASSES];
+};
+
 Reactor::Ptr Reactor::create() {
     struct make_shared_enabler : public Reactor {};
     return std::make_shared<make_shared_enabler>();
@@ -380,6 +436,7 @@ Reactor::Reactor() :
     _tcpConnectors  = std::make_unique<TcpConnectors>(*this);
     _proxyConnector = std::make_unique<ProxyConnector>(*this);
     _tcpShutdowns   = std::make_unique<TcpShutdowns>(*this);
+    _readBuffers    = std::make_unique<ReadBuffers>();
     _creatingInternalObjects = false;
 }
 
@@ -557,6 +614,25 @@ ErrorCode Reactor::init_tcpstream(Object* o) {
     return init_object(errorCode, o, h);
 }
 
+std::unique_ptr<TcpStream> Reactor::tcp_attach(uv_os_sock_t sock) {
+    std::unique_ptr<TcpStream> stream(new TcpStream());
+
+    ErrorCode errorCode = init_tcpstream(stream.get());
+    if (errorCode == EC_OK) {
+        errorCode = (ErrorCode)uv_tcp_open((uv_tcp_t*)stream->_handle, sock);
+        if (errorCode == EC_OK) {
+            return stream;
+        }
+    }
+
+#ifdef WIN32
+    closesocket(sock);
+#else // WIN32
+    close(sock);
+#endif // WIN32
+    IO_EXCEPTION(errorCode);
+}
+
 TcpStream* Reactor::stream_connected(TcpStream* stream, uv_handle_t* h) {
     stream->_handle = h;
     stream->_handle->data = stream;
@@ -607,6 +683,14 @@ ErrorCode Reactor::async_write(Reactor::Object* o, BufferChain& unsent, const Re
     return _pendingWrites->async_write(o, unsent, cb);
 }
 
+void Reactor::alloc_read_buffer(uv_buf_t& buf, size_t size) {
+    _readBuffers->alloc(buf, size);
+}
+
+void Reactor::release_read_buffer(const uv_buf_t& buf) {
+    _readBuffers->release(buf);
+}
+
 Result Reactor::tcp_connect(
     Address address,
     uint64_t tag,
@@ -30,6 +30,7 @@ class TcpConnectors;
 class ProxyConnector;
 class TcpShutdowns;
 class PendingWrites;
+class ReadBuffers;
 class SslStream;
 
 class Reactor : public std::enable_shared_from_this<Reactor> {
@@ -82,6 +83,10 @@ public:
 
     void cancel_tcp_connect(uint64_t tag);
 
+    /// Creates a stream for the socket detached from a connected stream (see TcpStream::detach_socket).
+    /// Must be called from this reactor's thread. Throws on errors, the socket is closed then
+    std::unique_ptr<TcpStream> tcp_attach(uv_os_sock_t sock);
+
 	class Scope
 	{
 		Reactor* m_pPrev;
@@ -174,6 +179,10 @@ private:
     ErrorCode init_object(ErrorCode errorCode, Object* o, uv_handle_t* h);
     void async_close(uv_handle_t*& handle);
 
+    /// Read buffers are pooled, size-classed, and borrowed by the streams only for the duration of a read
+    void alloc_read_buffer(uv_buf_t& buf, size_t size);
+    void release_read_buffer(const uv_buf_t& buf);
+
     union Handles {
         uv_timer_t timer;
         uv_async_t async;
@@ -189,6 +198,7 @@ private:
     std::unique_ptr<TcpConnectors> _tcpConnectors;
     std::unique_ptr<ProxyConnector> _proxyConnector;
     std::unique_ptr<TcpShutdowns>  _tcpShutdowns;
+    std::unique_ptr<ReadBuffers>   _readBuffers;
     StopCallback _stopCB;
 
     friend class TcpConnectors;
@@ -16,6 +16,9 @@
 #include "utility/config.h"
 #include "utility/helpers.h"
 #include <assert.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif // WIN32
 
 #define LOG_DEBUG_ENABLED 0
 #include "utility/logger.h"
@@ -31,21 +34,6 @@ TcpStream::~TcpStream() {
     if (_handle) _handle->data = 0;
 }
 
-void TcpStream::alloc_read_buffer() {
-    if (!_readBuffer.base) {
-        if (_readBuffer.len == 0) {
-            _readBuffer.len = config().get_int("io.stream_read_buffer_size", 256*1024, 2048, 1024*1024*16);
-        }
-        _readBuffer.base = (char*)malloc(_readBuffer.len);
-    }
-}
-
-void TcpStream::free_read_buffer() {
-    if (_readBuffer.base) free(_readBuffer.base);
-    _readBuffer.base = 0;
-    _readBuffer.len = 0;
-}
-
 Result TcpStream::enable_read(const TcpStream::Callback& callback) {
     assert(callback);
 
@@ -53,8 +41,6 @@ Result TcpStream::enable_read(const TcpStream::Callback& callback) {
         return make_unexpected(EC_ENOTCONN);
     }
 
-    alloc_read_buffer();
-
     static uv_alloc_cb read_alloc_cb = [](
         uv_handle_t* handle,
         size_t /*suggested_size*/,
@@ -62,14 +48,13 @@ Result TcpStream::enable_read(const TcpStream::Callback& callback) {
     ) {
         TcpStream* self = reinterpret_cast<TcpStream*>(handle->data);
         if (self) {
-            *buf = self->_readBuffer;
+            self->_reactor->alloc_read_buffer(*buf, self->_readSize);
         }
     };
 
     ErrorCode errorCode = (ErrorCode)uv_read_start((uv_stream_t*)_handle, read_alloc_cb, read_cb);
     if (errorCode != 0) {
         _callback = Callback();
-        free_read_buffer();
         return make_unexpected(errorCode);
     }
 
@@ -85,7 +70,6 @@ void TcpStream::disable_read() {
             LOG_DEBUG() << "uv_read_stop failed,code=" << errorCode;
         }
     }
-    free_read_buffer();
 }
 
 Result TcpStream::write(const SharedBuffer& buf, bool flush) {
@@ -127,6 +111,27 @@ void TcpStream::enable_keepalive(unsigned initialDelaySecs) {
     }
 }
 
+Result TcpStream::detach_socket(uv_os_sock_t& sock) {
+    if (!is_connected()) return make_unexpected(EC_ENOTCONN);
+#ifdef WIN32
+    return make_unexpected(EC_ENOTSUP);
+#else // WIN32
+    assert(!_callback);
+
+    uv_os_fd_t fd;
+    ErrorCode errorCode = (ErrorCode)uv_fileno(_handle, &fd);
+    if (errorCode != 0) return make_unexpected(errorCode);
+
+    // the handle owns its fd and closes it, keep a duplicate
+    int fdDup = dup(fd);
+    if (fdDup < 0) return make_unexpected((ErrorCode)uv_translate_sys_error(errno));
+
+    async_close();
+    sock = fdDup;
+    return Ok();
+#endif // WIN32
+}
+
 Result TcpStream::do_write(bool flush) {
     size_t nBytes = _writeBuffer.size();
     if (flush && nBytes > 0) {
@@ -177,9 +182,18 @@ void TcpStream::read_cb(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf)
 
     // self becomes null after async close
     if (self) {
-        if (nread > 0) self->on_read(EC_OK, buf->base, size_t(nread));
+        if (nread > 0) {
+            // larger buffer if it was filled entirely (more data is likely pending), smaller if it was mostly unused
+            if (size_t(nread) == buf->len) self->_readSize = buf->len * 4;
+            else if (size_t(nread) <= buf->len / 4) self->_readSize = buf->len / 4;
+
+            self->on_read(EC_OK, buf->base, size_t(nread));
+        }
         else if (nread < 0) self->on_read(ErrorCode(nread), 0, 0);
     }
+
+    // the stream may be deleted meanwhile
+    reinterpret_cast<Reactor*>(handle->loop->data)->release_read_buffer(*buf);
 }
 
 bool TcpStream::on_read(ErrorCode errorCode, void* data, size_t size) {
@@ -23,12 +23,8 @@ public:
     //using Ptr = std::shared_ptr<TcpStream>;
     using Ptr = std::unique_ptr<TcpStream>;
 
-    // TODO consider 2 more options for read buffer if it appears cheaper to avoid
-    // double copying:
-    // 1) call back with sub-chunk of shared memory
-    // 2) embed deserializer (protocol-specific) object into stream
-
-    /// errorCode==0 on new data
+    /// errorCode==0 on new data. The data buffer is borrowed from the reactor's pool only for the duration of the callback,
+    /// it may be modified in-place
     using Callback = std::function<bool(ErrorCode errorCode, void* data, size_t size)>;
 
     struct State {
@@ -80,6 +76,10 @@ public:
     /// Enables tcp keep-alive
     void enable_keepalive(unsigned initialDelaySecs);
 
+    /// Detaches the socket, so that it can be served by another reactor (see Reactor::tcp_attach), possibly in another thread.
+    /// Must be called before reading is enabled. On success the stream is closed, the socket remains open. Not supported on Windows
+    Result detach_socket(uv_os_sock_t& sock);
+
 protected:
     TcpStream();
 
@@ -94,8 +94,6 @@ private:
     friend class Reactor;
     friend class TcpConnectors;
 
-    void alloc_read_buffer();
-    void free_read_buffer();
 
     // sends async write request if flush == true
     Result do_write(bool flush);
@@ -103,7 +101,7 @@ private:
     // callback from write request
     void on_data_written(ErrorCode errorCode, size_t n);
 
-    uv_buf_t _readBuffer={0, 0};
+    size_t _readSize=0; // hint for the next read buffer size, adjusted to the incoming data rate
     BufferChain _writeBuffer;
     Callback _callback;
     State _state;
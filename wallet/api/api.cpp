@@ -1201,6 +1201,18 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
             }
         }
 
+        if (existsJsonParam(params, "cursor"))
+        {
+            if (params["cursor"].is_string())
+            {
+                getUtxo.cursor = params["cursor"].get<std::string>();
+            }
+            else
+            {
+                throw jsonrpc_exception{ApiError::InvalidJsonRpc, "Invalid 'cursor' parameter.", id};
+            }
+        }
+
         getHandler().onMessage(id, getUtxo);
     }
 
@@ -1268,6 +1280,15 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
             else throw jsonrpc_exception{ ApiError::InvalidJsonRpc, "Invalid 'skip' parameter.", id };
         }
 
+        if (existsJsonParam(params, "cursor"))
+        {
+            if (params["cursor"].is_string())
+            {
+                txList.cursor = params["cursor"].get<std::string>();
+            }
+            else throw jsonrpc_exception{ ApiError::InvalidJsonRpc, "Invalid 'cursor' parameter.", id };
+        }
+
         getHandler().onMessage(id, txList);
     }
 
@@ -1582,6 +1603,17 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
                 {"session", utxo.m_sessionId}
             });
         }
+
+        if (res.nextCursor)
+        {
+            // cursor-based paging
+            json items = std::move(msg["result"]);
+            msg["result"] = json
+            {
+                {"items", std::move(items)},
+                {"next_cursor", *res.nextCursor}
+            };
+        }
     }
 
     void WalletApi::getResponse(const JsonRpcId& id, const Send::Response& res, json& msg)
@@ -1761,6 +1793,17 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
                 resItem.systemHeight);
             msg["result"].push_back(item);
         }
+
+        if (res.nextCursor)
+        {
+            // cursor-based paging
+            json items = std::move(msg["result"]);
+            msg["result"] = json
+            {
+                {"items", std::move(items)},
+                {"next_cursor", *res.nextCursor}
+            };
+        }
     }
 
     void WalletApi::getResponse(const JsonRpcId& id, const WalletStatus::Response& res, json& msg)
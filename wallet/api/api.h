@@ -418,6 +418,7 @@ namespace beam::wallet
         int count = 0;
         int skip = 0;
         bool withAssets = false;
+        boost::optional<std::string> cursor; // empty for the first page, then the one returned
 
         struct
         {
@@ -428,6 +429,7 @@ namespace beam::wallet
         {
             std::vector<Coin> utxos;
             uint32_t confirmations_count = 0;
+            boost::optional<std::string> nextCursor; // empty if no more
         };
     };
 
@@ -465,10 +467,12 @@ namespace beam::wallet
 
         int count = 0;
         int skip = 0;
+        boost::optional<std::string> cursor; // empty for the first page, then the one returned
 
         struct Response
         {
             std::vector<Status::Response> resultList;
+            boost::optional<std::string> nextCursor; // empty if no more
         };
     };
 
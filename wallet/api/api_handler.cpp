@@ -143,6 +143,62 @@ namespace
 
 #endif  // BEAM_ATOMIC_SWAP_SUPPORT
 
+    // opaque paging cursors: the position of the last returned element, big-endian, in hex
+    void WriteCursorNum(uint64_t n, std::vector<uint8_t>& buf)
+    {
+        for (int i = 64; i; )
+        {
+            i -= 8;
+            buf.push_back(static_cast<uint8_t>(n >> i));
+        }
+    }
+
+    uint64_t ReadCursorNum(const uint8_t* p)
+    {
+        uint64_t n = 0;
+        for (int i = 0; i < 8; i++)
+            n = (n << 8) | p[i];
+        return n;
+    }
+
+    std::string EncodeCursor(const beam::wallet::TxHistoryFilter::Position& pos)
+    {
+        std::vector<uint8_t> buf;
+        WriteCursorNum(pos.m_MinHeight, buf);
+        buf.insert(buf.end(), pos.m_TxID.begin(), pos.m_TxID.end());
+        return to_hex(buf.data(), buf.size());
+    }
+
+    bool DecodeCursor(const std::string& s, beam::wallet::TxHistoryFilter::Position& pos)
+    {
+        bool bValid = false;
+        auto buf = from_hex(s, &bValid);
+        if (!bValid || (buf.size() != sizeof(uint64_t) + pos.m_TxID.size()))
+            return false;
+
+        pos.m_MinHeight = ReadCursorNum(buf.data());
+        std::copy(buf.begin() + sizeof(uint64_t), buf.end(), pos.m_TxID.begin());
+        return true;
+    }
+
+    std::string EncodeCursor(uint64_t pos)
+    {
+        std::vector<uint8_t> buf;
+        WriteCursorNum(pos, buf);
+        return to_hex(buf.data(), buf.size());
+    }
+
+    bool DecodeCursor(const std::string& s, uint64_t& pos)
+    {
+        bool bValid = false;
+        auto buf = from_hex(s, &bValid);
+        if (!bValid || (buf.size() != sizeof(uint64_t)))
+            return false;
+
+        pos = ReadCursorNum(buf.data());
+        return true;
+    }
+
 }  // namespace
 
 namespace beam::wallet
@@ -783,22 +839,52 @@ namespace beam::wallet
             return doError(id, ApiError::NotOpenedError);
         }
 
+        uint64_t posAfter = 0;
+        if (data.cursor && !data.cursor->empty() && !DecodeCursor(*data.cursor, posAfter))
+        {
+            return doError(id, ApiError::InvalidParamsJsonRpc, "Invalid 'cursor' parameter.");
+        }
+
         GetUtxo::Response response;
         response.confirmations_count = walletDB->getCoinConfirmationsOffset();
-        walletDB->visitCoins([&response, &data](const Coin& c)->bool {
-            if(!data.withAssets && c.isAsset())
+        if (data.cursor)
+        {
+            response.nextCursor = std::string();
+        }
+
+        boost::optional<Asset::ID> assetId = data.filter.assetId;
+        if (!data.withAssets)
+        {
+            if (assetId && *assetId != Asset::s_BeamID)
             {
-                return true;
+                return doResponse(id, response); // assets excluded
             }
-            if (data.filter.assetId && !c.isAsset(*data.filter.assetId))
+            assetId = Asset::s_BeamID;
+        }
+
+        // filtering and paging are done by the db, fetch one more to see if there's a next page.
+        // As before, skip is ignored unless count is specified
+        size_t count = data.count > 0 ? static_cast<size_t>(data.count) : std::numeric_limits<size_t>::max();
+        uint32_t skip = data.count > 0 ? static_cast<uint32_t>(data.skip) : 0;
+        bool bMore = false;
+        uint64_t posLast = 0;
+
+        walletDB->visitCoinsFrom(assetId, posAfter, skip, [&](const Coin& c, uint64_t pos)->bool {
+            if (response.utxos.size() == count)
             {
-                return true;
+                bMore = true;
+                return false;
             }
             response.utxos.push_back(c);
+            posLast = pos;
             return true;
         });
 
-        doPagination(data.skip, data.count, response.utxos);
+        if (bMore && data.cursor)
+        {
+            response.nextCursor = EncodeCursor(posLast);
+        }
+
         doResponse(id, response);
     }
 
@@ -887,6 +973,10 @@ namespace beam::wallet
         LOG_DEBUG() << "List(filter.status = " << (data.filter.status ? std::to_string((uint32_t)*data.filter.status) : "nul") << ")";
 
         TxList::Response res;
+        if (data.cursor)
+        {
+            res.nextCursor = std::string();
+        }
 
         {
             auto walletDB = _walletData.getWalletDBPtr();
@@ -894,59 +984,68 @@ namespace beam::wallet
                 return doError(id, ApiError::NotOpenedError);
             }
 
-            auto txList = walletDB->getTxHistory(TxType::Simple);
+            TxHistoryFilter filter;
+            if (data.cursor && !data.cursor->empty())
+            {
+                filter.m_After.emplace();
+                if (!DecodeCursor(*data.cursor, *filter.m_After))
+                {
+                    return doError(id, ApiError::InvalidParamsJsonRpc, "Invalid 'cursor' parameter.");
+                }
+            }
 
+            filter.m_Types.push_back(TxType::Simple);
+            filter.m_AssetID = data.filter.assetId;
             if (data.withAssets)
             {
-                auto txIssue = walletDB->getTxHistory(TxType::AssetIssue);
-                auto txConsume = walletDB->getTxHistory(TxType::AssetConsume);
-                auto txInfo = walletDB->getTxHistory(TxType::AssetInfo);
-
-                txList.insert(txList.end(), txIssue.begin(), txIssue.end());
-                txList.insert(txList.end(), txConsume.begin(), txConsume.end());
-                txList.insert(txList.end(), txInfo.begin(), txInfo.end());
+                filter.m_Types.push_back(TxType::AssetIssue);
+                filter.m_Types.push_back(TxType::AssetConsume);
+                filter.m_Types.push_back(TxType::AssetInfo);
             }
-
-            std::sort(txList.begin(), txList.end(), [](const TxDescription& a, const TxDescription& b) -> bool {
-                return a.m_minHeight > b.m_minHeight;
-             });
-
-            Block::SystemState::ID stateID = {};
-            walletDB->getSystemStateID(stateID);
-
-            for (const auto& tx : txList)
+            else
             {
-                if (!data.withAssets && tx.m_assetId != Asset::s_InvalidID)
+                if (data.filter.assetId && *data.filter.assetId != Asset::s_InvalidID)
                 {
-                    continue;
+                    return doResponse(id, res); // assets excluded
                 }
+                filter.m_AssetID = Asset::s_InvalidID;
+            }
 
-                if (data.filter.assetId && tx.m_assetId != *data.filter.assetId)
-                {
-                    continue;
-                }
+            filter.m_Status = data.filter.status;
+            filter.m_ProofHeight = data.filter.height;
+            filter.m_Skip = data.count > 0 ? static_cast<uint32_t>(data.skip) : 0; // as before, skip is ignored unless count is specified
 
-                if (data.filter.status && tx.m_status != *data.filter.status)
-                {
-                    continue;
-                }
+            Block::SystemState::ID stateID = {};
+            walletDB->getSystemStateID(stateID);
 
-                const auto height = storage::DeduceTxProofHeight(*walletDB, tx);
-                if (data.filter.height && height != *data.filter.height)
+            // filtering, ordering and paging are done by the db, fetch one more to see if there's a next page
+            size_t count = data.count > 0 ? static_cast<size_t>(data.count) : std::numeric_limits<size_t>::max();
+            bool bMore = false;
+
+            walletDB->visitTxHistory(filter, [&](const TxDescription& tx, Height height)->bool {
+                if (res.resultList.size() == count)
                 {
-                    continue;
+                    bMore = true;
+                    return false;
                 }
 
-                Status::Response item;
+                Status::Response& item = res.resultList.emplace_back();
                 item.tx = tx;
                 item.txHeight = height;
                 item.systemHeight = stateID.m_Height;
                 item.confirmations = 0;
-                res.resultList.push_back(item);
+                return true;
+            });
+
+            if (bMore && data.cursor)
+            {
+                TxHistoryFilter::Position pos;
+                pos.m_MinHeight = res.resultList.back().tx.m_minHeight;
+                pos.m_TxID = res.resultList.back().tx.m_txId;
+                res.nextCursor = EncodeCursor(pos);
             }
         }
 
-        doPagination(data.skip, data.count, res.resultList);
         doResponse(id, res);
     }
 
@@ -553,13 +553,21 @@ namespace beam::wallet
         MyRequestShieldedList::Ptr pVal(new MyRequestShieldedList);
         pVal->m_callback = std::move(callback);
         pVal->m_TxID = txId;
+        pVal->m_Id0 = startIndex;
+        pVal->m_Count = count;
 
-        pVal->m_Msg.m_Id0 = startIndex;
-        pVal->m_Msg.m_Count = count;
+        pVal->m_vCached.resize(count);
+        uint32_t nCached = count ? m_ShieldedListCache.Read(startIndex, &pVal->m_vCached.front(), count) : 0;
+        pVal->m_vCached.resize(nCached);
+
+        // fetch the rest, including the last cached element
+        uint32_t nSkip = nCached ? (nCached - 1) : 0;
+        pVal->m_Msg.m_Id0 = startIndex + nSkip;
+        pVal->m_Msg.m_Count = count - nSkip;
 
         if (PostReqUnique(*pVal))
         {
-            LOG_INFO() << txId << " Get shielded list, start_index = " << startIndex << ", count = " << count;
+            LOG_INFO() << txId << " Get shielded list, start_index = " << startIndex << ", count = " << count << ", cached = " << nCached;
         }
     }
 
@@ -982,7 +990,182 @@ namespace beam::wallet
 
     void Wallet::OnRequestComplete(MyRequestShieldedList& r)
     {
-        r.m_callback(r.m_Msg.m_Id0, r.m_Msg.m_Count, r.m_Res);
+        Block::SystemState::Full sTip;
+        if (get_tip(sTip))
+            m_ShieldedListCache.OnShieldedOuts(sTip.m_Height, r.m_Res.m_ShieldedOuts);
+
+        std::vector<ECC::Point::Storage>& vItems = r.m_Res.m_Items;
+        if (!vItems.empty())
+            m_ShieldedListCache.Write(r.m_Msg.m_Id0, &vItems.front(), static_cast<uint32_t>(vItems.size()));
+
+        if (!r.m_vCached.empty())
+        {
+            if (vItems.empty() || (vItems.front().m_X != r.m_vCached.back().m_X) || (vItems.front().m_Y != r.m_vCached.back().m_Y))
+            {
+                // the node doesn't agree with our cache (reorg?)
+                LOG_INFO() << r.m_TxID << " Shielded list cache mismatch, refetching";
+
+                m_ShieldedListCache.Invalidate();
+
+                MyRequestShieldedList::Ptr pVal(new MyRequestShieldedList);
+                pVal->m_callback = std::move(r.m_callback);
+                pVal->m_TxID = r.m_TxID;
+                pVal->m_Id0 = r.m_Id0;
+                pVal->m_Count = r.m_Count;
+                pVal->m_Msg.m_Id0 = r.m_Id0;
+                pVal->m_Msg.m_Count = r.m_Count;
+
+                PostReqUnique(*pVal);
+                return;
+            }
+
+            r.m_vCached.pop_back();
+            vItems.insert(vItems.begin(), r.m_vCached.begin(), r.m_vCached.end());
+        }
+
+        r.m_callback(r.m_Id0, r.m_Count, r.m_Res);
+    }
+
+    uint32_t Wallet::ShieldedListCache::get_MaxRecent()
+    {
+        return Rules::get().Shielded.m_ProofMax.get_N() * 2;
+    }
+
+    uint32_t Wallet::ShieldedListCache::Read(TxoID id0, ECC::Point::Storage* p, uint32_t nCount) const
+    {
+        uint32_t nDone = 0;
+        while (nDone < nCount)
+        {
+            TxoID id = id0 + nDone;
+            uint32_t nMax = nCount - nDone;
+
+            if ((id >= m_Id0) && (id < get_RecentEnd()))
+            {
+                std::setmin(nMax, static_cast<uint32_t>(get_RecentEnd() - id));
+                std::copy_n(m_vRecent.begin() + (id - m_Id0), nMax, p + nDone);
+                nDone += nMax;
+                continue;
+            }
+
+            if (id < m_Id0)
+                std::setmin(nMax, static_cast<uint32_t>(m_Id0 - id));
+
+            uint32_t n = get_ParentObj().m_WalletDB->readShieldedList(id, p + nDone, nMax);
+            nDone += n;
+
+            if (n < nMax)
+                break;
+        }
+
+        return nDone;
+    }
+
+    void Wallet::ShieldedListCache::Write(TxoID id0, const ECC::Point::Storage* p, uint32_t nCount)
+    {
+        TxoID id1 = id0 + nCount;
+
+        if (m_vRecent.empty() || (id1 < m_Id0) || (id0 > get_RecentEnd()))
+        {
+            // not adjacent to the window, replace it. Save what's final in the outgoing one first.
+            // m_Persisted refers to the old window, the new one is persisted from its beginning
+            Persist();
+            m_Id0 = id0;
+            m_Persisted = id0;
+            m_vRecent.assign(p, p + nCount);
+        }
+        else
+        {
+            if (id0 < m_Id0)
+            {
+                m_vRecent.insert(m_vRecent.begin(), static_cast<size_t>(m_Id0 - id0), ECC::Point::Storage());
+                m_Id0 = id0;
+                std::setmin(m_Persisted, id0); // the prepended ones may already be final
+            }
+
+            if (id1 > get_RecentEnd())
+                m_vRecent.resize(static_cast<size_t>(id1 - m_Id0));
+
+            std::copy_n(p, nCount, m_vRecent.begin() + (id0 - m_Id0));
+        }
+
+        uint32_t nMax = get_MaxRecent();
+        if (m_vRecent.size() > nMax)
+        {
+            // forget the oldest ones (they're most likely final, and persisted)
+            size_t nExtra = m_vRecent.size() - nMax;
+            Persist();
+            m_vRecent.erase(m_vRecent.begin(), m_vRecent.begin() + nExtra);
+            m_Id0 += nExtra;
+        }
+
+        Persist();
+    }
+
+    void Wallet::ShieldedListCache::Persist()
+    {
+        TxoID id0 = std::max(m_Persisted, m_Id0);
+        TxoID id1 = std::min(m_Final, get_RecentEnd());
+
+        if (id0 < id1)
+        {
+            get_ParentObj().m_WalletDB->saveShieldedList(id0, &m_vRecent.front() + (id0 - m_Id0), static_cast<uint32_t>(id1 - id0));
+            m_Persisted = id1;
+        }
+    }
+
+    void Wallet::ShieldedListCache::OnShieldedOuts(Height h, TxoID nOuts)
+    {
+        TxoID& val = m_Observed[h];
+        std::setmax(val, nOuts);
+
+        Height dh = Rules::get().MaxRollback;
+        if (h <= dh)
+            return;
+
+        // whatever was observed deeper than max rollback is final
+        while (!m_Observed.empty())
+        {
+            auto it = m_Observed.begin();
+            if (it->first > h - dh)
+                break;
+
+            std::setmax(m_Final, it->second);
+            m_Observed.erase(it);
+        }
+
+        Persist();
+    }
+
+    void Wallet::ShieldedListCache::OnRolledBack(Height h)
+    {
+        TxoID nValid = m_Final;
+
+        while (!m_Observed.empty())
+        {
+            auto it = std::prev(m_Observed.end());
+            if (it->first <= h)
+            {
+                std::setmax(nValid, it->second);
+                break;
+            }
+            m_Observed.erase(it);
+        }
+
+        if (get_RecentEnd() > nValid)
+        {
+            if (m_Id0 >= nValid)
+                m_vRecent.clear();
+            else
+                m_vRecent.resize(static_cast<size_t>(nValid - m_Id0));
+        }
+
+        std::setmin(m_Persisted, m_Final);
+    }
+
+    void Wallet::ShieldedListCache::Invalidate()
+    {
+        m_Observed.clear();
+        OnRolledBack(0);
     }
 
     void Wallet::OnRequestComplete(MyRequestProofShieldedInp& r)
@@ -1004,6 +1187,10 @@ namespace beam::wallet
     {
         // TODO: save full response?
         m_WalletDB->set_ShieldedOuts(r.m_Res.m_ShieldedOuts);
+
+        Block::SystemState::Full sTip;
+        if (get_tip(sTip))
+            m_ShieldedListCache.OnShieldedOuts(sTip.m_Height, r.m_Res.m_ShieldedOuts);
     }
 
     void Wallet::RequestEvents()
@@ -1197,6 +1384,7 @@ namespace beam::wallet
         m_WalletDB->rollbackConfirmedUtxo(sTip.m_Height);
         m_WalletDB->rollbackConfirmedShieldedUtxo(sTip.m_Height);
         m_WalletDB->rollbackAssets(sTip.m_Height);
+        m_ShieldedListCache.OnRolledBack(sTip.m_Height);
 
         // Rollback active transaction
         for (auto it = m_ActiveTransactions.begin(); m_ActiveTransactions.end() != it; it++)
@@ -290,6 +290,9 @@ namespace beam::wallet
             {
                 TxID m_TxID;
                 ShieldedListCallback m_callback;
+                TxoID m_Id0; // as requested by the tx
+                uint32_t m_Count;
+                std::vector<ECC::Point::Storage> m_vCached; // prefix of the requested range, m_Msg asks for the rest (incl. the last cached element)
             };
         };
 
@@ -337,6 +340,32 @@ namespace beam::wallet
 
 
         IWalletDB::Ptr m_WalletDB; 
+
+        // Shielded pool elements, requested by the txs for the spend proofs. The final ones (deeper than max rollback) are persisted
+        // in the wallet db, the recent ones are kept in memory. Only the missing suffix of the requested range is downloaded,
+        // the last cached element is re-fetched as well, to verify the cache is consistent with the node.
+        struct ShieldedListCache
+        {
+            static uint32_t get_MaxRecent();
+
+            TxoID m_Final = 0; // the elements below are final
+            TxoID m_Persisted = 0; // the elements below are in the db (if they were fetched)
+            TxoID m_Id0 = 0; // the recent elements window
+            std::vector<ECC::Point::Storage> m_vRecent;
+            std::map<Height, TxoID> m_Observed; // shielded outs at heights, not final yet
+
+            uint32_t Read(TxoID id0, ECC::Point::Storage*, uint32_t nCount) const; // returns the num of consecutive elements available
+            void Write(TxoID id0, const ECC::Point::Storage*, uint32_t nCount);
+            void OnShieldedOuts(Height, TxoID);
+            void OnRolledBack(Height);
+            void Invalidate(); // drop the recent non-final elements
+
+        private:
+            TxoID get_RecentEnd() const { return m_Id0 + m_vRecent.size(); }
+            void Persist();
+
+            IMPLEMENT_GET_PARENT_OBJ(Wallet, m_ShieldedListCache)
+        } m_ShieldedListCache;
         
         std::shared_ptr<proto::FlyClient::INetwork> m_NodeEndpoint;
         std::set<IWalletMessageEndpoint::Ptr> m_MessageEndpoints;
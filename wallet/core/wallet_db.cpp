@@ -81,6 +81,9 @@
 #define LASER_UPDATES_NAME "LaserUpdates"
 #define ASSETS_NAME "Assets"
 #define SHIELDED_COINS_NAME "ShieldedCoins"
+#define SHIELDED_LIST_NAME "ShieldedList"
+#define TX_INDEX_NAME "TxIndex"
+#define COIN_TOTALS_NAME "CoinTotals"
 #define NOTIFICATIONS_NAME "notifications"
 #define EXCHANGE_RATES_NAME "exchangeRates"
 #define VOUCHERS_NAME "vouchers"
@@ -193,6 +196,26 @@
 
 #define VOUCHERS_FIELDS ENUM_VOUCHERS_FIELDS(LIST, COMMA, )
 
+#define ENUM_COIN_TOTALS_FIELDS(each, sep, obj) \
+    each(assetId,           Totals.AssetId,           INTEGER NOT NULL PRIMARY KEY, obj) sep \
+    each(coins,             Coins,                    INTEGER NOT NULL, obj) sep \
+    each(shieldedUnspent,   ShieldedUnspent,          INTEGER NOT NULL, obj) sep \
+    each(avail,             Totals.Avail,             BLOB NOT NULL, obj) sep \
+    each(maturing,          Totals.Maturing,          BLOB NOT NULL, obj) sep \
+    each(incoming,          Totals.Incoming,          BLOB NOT NULL, obj) sep \
+    each(receivingIncoming, Totals.ReceivingIncoming, BLOB NOT NULL, obj) sep \
+    each(receivingChange,   Totals.ReceivingChange,   BLOB NOT NULL, obj) sep \
+    each(unavail,           Totals.Unavail,           BLOB NOT NULL, obj) sep \
+    each(outgoing,          Totals.Outgoing,          BLOB NOT NULL, obj) sep \
+    each(availCoinbase,     Totals.AvailCoinbase,     BLOB NOT NULL, obj) sep \
+    each(coinbase,          Totals.Coinbase,          BLOB NOT NULL, obj) sep \
+    each(availFee,          Totals.AvailFee,          BLOB NOT NULL, obj) sep \
+    each(fee,               Totals.Fee,               BLOB NOT NULL, obj) sep \
+    each(unspent,           Totals.Unspent,           BLOB NOT NULL, obj) sep \
+    each(shielded,          Totals.Shielded,          BLOB NOT NULL, obj)
+
+#define COIN_TOTALS_FIELDS ENUM_COIN_TOTALS_FIELDS(LIST, COMMA, )
+
 namespace std
 {
     template<>
@@ -597,6 +620,11 @@ namespace beam::wallet
                 bind(col, &s, sizeof(s));
             }
 
+            void bind(int col, const ECC::Point::Storage& x)
+            {
+                bind(col, &x, sizeof(x));
+            }
+
             void bind(int col, const ShieldedTxo::BaseKey& x)
             {
                 const auto& b = _buffers.emplace_back(toByteBuffer(x));
@@ -715,6 +743,11 @@ namespace beam::wallet
                 fromByteBuffer(b, x);
             }
 
+            void get(int col, ECC::Point::Storage& x)
+            {
+                getBlobStrict(col, &x, sizeof(x));
+            }
+
             void get(int col, ShieldedTxo::User& x)
             {
                 // read/write as a blob, skip serialization
@@ -884,7 +917,10 @@ namespace beam::wallet
         const char* SystemStateIDName = "SystemStateID";
         const char* LastUpdateTimeName = "LastUpdateTime";
         const int BusyTimeoutMs = 5000;
-        const int DbVersion   = 23;
+        const int DbVersion   = 26;
+        const int DbVersion25 = 25;
+        const int DbVersion24 = 24;
+        const int DbVersion23 = 23;
         const int DbVersion22 = 22;
         const int DbVersion21 = 21;
         const int DbVersion20 = 20;
@@ -1218,6 +1254,78 @@ namespace beam::wallet
             throwIfError(ret, db);
         }
 
+        void CreateShieldedListTable(sqlite3* db)
+        {
+            const char* req = "CREATE TABLE " SHIELDED_LIST_NAME " (ID INTEGER NOT NULL PRIMARY KEY, Commitment BLOB NOT NULL);";
+            int ret = sqlite3_exec(db, req, nullptr, nullptr, nullptr);
+            throwIfError(ret, db);
+        }
+
+        void CreateTxIndexTable(sqlite3* db)
+        {
+            // the summary of the txs (the fields used for filtering and ordering), to avoid loading all the tx parameters
+            const char* req = "CREATE TABLE " TX_INDEX_NAME " (txID BLOB NOT NULL PRIMARY KEY, txType INTEGER, status INTEGER, assetID INTEGER, minHeight INTEGER, proofHeight INTEGER) WITHOUT ROWID;"
+                "CREATE INDEX " TX_INDEX_NAME "Order ON " TX_INDEX_NAME "(minHeight, txID);";
+            int ret = sqlite3_exec(db, req, nullptr, nullptr, nullptr);
+            throwIfError(ret, db);
+        }
+
+        void CreateCoinsAssetIndex(sqlite3* db)
+        {
+            const char* req = "CREATE INDEX IF NOT EXISTS CoinAssetIndex ON " STORAGE_NAME "(assetId);";
+            int ret = sqlite3_exec(db, req, nullptr, nullptr, nullptr);
+            throwIfError(ret, db);
+        }
+
+        void CreateCoinTotalsTable(sqlite3* db)
+        {
+            const char* req = "CREATE TABLE " COIN_TOTALS_NAME " (" ENUM_COIN_TOTALS_FIELDS(LIST_WITH_TYPES, COMMA, ) ");";
+            int ret = sqlite3_exec(db, req, nullptr, nullptr, nullptr);
+            throwIfError(ret, db);
+        }
+
+        void CreateCoinTotalsIndexes(sqlite3* db)
+        {
+            // to locate the coins whose status may change with the height or with the tx status, and the earliest coin of the asset
+            const char* req =
+                "CREATE INDEX IF NOT EXISTS CoinMaturityIndex ON " STORAGE_NAME "(maturity);"
+                "CREATE INDEX IF NOT EXISTS CoinCreateTxIndex ON " STORAGE_NAME "(createTxId);"
+                "CREATE INDEX IF NOT EXISTS CoinSpentTxIndex ON " STORAGE_NAME "(spentTxId);"
+                "CREATE INDEX IF NOT EXISTS CoinAssetConfirmIndex ON " STORAGE_NAME "(assetId, confirmHeight);";
+            int ret = sqlite3_exec(db, req, nullptr, nullptr, nullptr);
+            throwIfError(ret, db);
+        }
+
+        bool IsOngoingStatus(TxStatus txStatus)
+        {
+            switch (txStatus)
+            {
+            case TxStatus::Canceled:
+            case TxStatus::Failed:
+            case TxStatus::Completed:
+                return false;
+
+            default:
+                return true;
+            }
+        }
+
+        bool IsTxIndexParam(TxParameterID paramID)
+        {
+            switch (paramID)
+            {
+            case TxParameterID::TransactionType:
+            case TxParameterID::Status:
+            case TxParameterID::AssetID:
+            case TxParameterID::MinHeight:
+            case TxParameterID::KernelProofHeight:
+            case TxParameterID::AssetConfirmedHeight:
+                return true;
+            default:
+                return false;
+            }
+        }
+
         void CreateVouchersTable(sqlite3* db)
         {
             const char* req = "CREATE TABLE " VOUCHERS_NAME " (" ENUM_VOUCHERS_FIELDS(LIST_WITH_TYPES, COMMA, ) ");"
@@ -1341,6 +1449,11 @@ namespace beam::wallet
         CreateNotificationsTable(db);
         CreateExchangeRatesTable(db);
         CreateVouchersTable(db);
+        CreateShieldedListTable(db);
+        CreateTxIndexTable(db);
+        CreateCoinsAssetIndex(db);
+        CreateCoinTotalsTable(db);
+        CreateCoinTotalsIndexes(db);
     }
 
     std::shared_ptr<WalletDB> WalletDB::initBase(const string& path, const SecString& password, bool separateDBForPrivateData)
@@ -1372,6 +1485,7 @@ namespace beam::wallet
         createTables(walletDB->_db, walletDB->m_PrivateDB);
 
         storage::setVar(*walletDB, Version, DbVersion);
+        walletDB->loadCoinTotals();
 
         return walletDB;
 
@@ -1807,6 +1921,25 @@ namespace beam::wallet
 
                 case DbVersion22:
                     CreateShieldedCoinsTableIndex(db);
+                    // no break
+
+                case DbVersion23:
+                    LOG_INFO() << "Converting DB from format 23...";
+                    CreateShieldedListTable(db);
+                    // no break
+
+                case DbVersion24:
+                    LOG_INFO() << "Converting DB from format 24...";
+                    CreateTxIndexTable(db);
+                    CreateCoinsAssetIndex(db);
+                    walletDB->fillTxIndex();
+                    // no break
+
+                case DbVersion25:
+                    LOG_INFO() << "Converting DB from format 25...";
+                    CreateCoinTotalsTable(db);
+                    CreateCoinTotalsIndexes(db);
+                    // the totals are calculated once the db is opened
 
                     storage::setVar(*walletDB, Version, DbVersion);
                     // no break
@@ -1891,6 +2024,7 @@ namespace beam::wallet
             }
         }
         walletDB->getVarRaw(COIN_CONFIRMATIONS_COUNT, &walletDB->m_coinConfirmationsOffset, sizeof(uint32_t));
+        walletDB->loadCoinTotals();
         walletDB->m_Initialized = true;
         return static_pointer_cast<IWalletDB>(walletDB);
     }
@@ -1969,6 +2103,7 @@ namespace beam::wallet
             {
                 try
                 {
+                    saveCoinTotals();
                     m_DbTransaction->commit();
                 }
                 catch (const runtime_error& ex)
@@ -2424,23 +2559,18 @@ namespace beam::wallet
         Block::SystemState::ID stateID = {};
         getSystemStateID(stateID);
 
-        {
-            const char* query = "SELECT " STORAGE_FIELDS " FROM " STORAGE_NAME " WHERE maturity>=0 AND maturity<=?1 AND spentHeight<0 ORDER BY amount ASC";
-
-            sqlite::Statement stm(this, query);
-            stm.bind(1, stateID.m_Height);
+        prepareCoinIndex(stateID.m_Height);
 
-            while (stm.step())
+        auto itAsset = m_CoinIndex.m_Mature.find(assetId);
+        if (m_CoinIndex.m_Mature.end() != itAsset)
+        {
+            for (const Coin* pCoin : itAsset->second)
             {
-                auto& coin = coins.emplace_back();
-                int colIdx = 0;
-                ENUM_ALL_STORAGE_FIELDS(STM_GET_LIST, NOSEP, coin);
+                auto& coin = coins.emplace_back(*pCoin);
 
-                storage::DeduceStatus(*this, coin, stateID.m_Height);
+                storage::DeduceStatus(*this, coin, stateID.m_Height); // may still be outgoing, or not confirmed enough
                 if (Coin::Status::Available != coin.m_status)
                     coins.pop_back();
-                else if (coin.m_ID.m_AssetID != assetId)
-                    coins.pop_back();
                 else
                 {
                     if (coin.m_ID.m_Value >= amount)
@@ -2548,6 +2678,8 @@ namespace beam::wallet
         int colIdx = 0;
         ENUM_ALL_STORAGE_FIELDS(STM_BIND_LIST, NOSEP, coin);
         stm.step();
+
+        updateCoinTotals(coin, true);
     }
 
     void WalletDB::insertNewCoin(Coin& coin)
@@ -2563,6 +2695,14 @@ namespace beam::wallet
 
     bool WalletDB::updateCoinRaw(const Coin& coin)
     {
+        if (m_CoinTotals.m_Valid)
+        {
+            Coin cPrev;
+            cPrev.m_ID = coin.m_ID;
+            if (findCoin(cPrev))
+                m_CoinTotals.Add(cPrev, false);
+        }
+
         const char* req = "UPDATE " STORAGE_NAME " SET " ENUM_STORAGE_FIELDS(SET_LIST, COMMA, ) STORAGE_WHERE_ID  ";";
         sqlite::Statement stm(this, req);
 
@@ -2571,7 +2711,11 @@ namespace beam::wallet
         ENUM_STORAGE_ID(STM_BIND_LIST, NOSEP, coin);
         stm.step();
 
-        return sqlite3_changes(_db) > 0;
+        if (!sqlite3_changes(_db))
+            return false;
+
+        updateCoinTotals(coin, true);
+        return true;
     }
 
     void WalletDB::saveCoinRaw(const Coin& coin)
@@ -2630,201 +2774,580 @@ namespace beam::wallet
         return coin;
     }
 
-    void WalletDB::storeCoin(Coin& coin)
-    {
-        coin.m_ID.m_Idx = get_RandomID();
-        insertNewCoin(coin);
-        notifyCoinsChanged(ChangeAction::Added, {coin});
-    }
-
-    void WalletDB::storeCoins(std::vector<Coin>& coins)
+    void WalletDB::prepareCoinIndex(Height h)
     {
-        if (coins.empty())
+        if (m_CoinIndex.m_Valid)
+        {
+            m_CoinIndex.SetHeight(h);
             return;
+        }
 
-        uint64_t nKeyIndex = get_RandomID();
-        for (auto& coin : coins)
+        m_CoinIndex.Reset();
+        m_CoinIndex.m_Height = h;
+
+        const char* query = "SELECT " STORAGE_FIELDS " FROM " STORAGE_NAME " WHERE maturity>=0 AND spentHeight<0";
+        sqlite::Statement stm(this, query);
+
+        while (stm.step())
         {
-            coin.m_ID.m_Idx = nKeyIndex;
-            insertNewCoin(coin);
-            nKeyIndex = coin.m_ID.m_Idx + 1;
+            Coin coin;
+            int colIdx = 0;
+            ENUM_ALL_STORAGE_FIELDS(STM_GET_LIST, NOSEP, coin);
+            m_CoinIndex.Insert(coin);
         }
-        notifyCoinsChanged(ChangeAction::Added, coins);
+
+        m_CoinIndex.m_Valid = true;
     }
 
-    void WalletDB::saveCoin(const Coin& coin)
+    bool WalletDB::CoinIndex::IDCmp::operator()(const Coin::ID& a, const Coin::ID& b) const
     {
-        saveCoinRaw(coin);
-        notifyCoinsChanged(ChangeAction::Updated, getUpdatedCoins({coin}));
+        int n = a.cmp(b);
+        if (n)
+            return n < 0;
+        if (a.m_Value != b.m_Value)
+            return a.m_Value < b.m_Value;
+        return a.m_AssetID < b.m_AssetID;
     }
 
-    void WalletDB::saveCoins(const vector<Coin>& coins)
+    bool WalletDB::CoinIndex::AmountCmp::operator()(const Coin* a, const Coin* b) const
     {
-        if (coins.empty())
-            return;
+        if (a->m_ID.m_Value != b->m_ID.m_Value)
+            return a->m_ID.m_Value < b->m_ID.m_Value;
+        return IDCmp()(a->m_ID, b->m_ID);
+    }
 
-        for (auto& coin : coins)
-        {
-            saveCoinRaw(coin);
-        }
+    bool WalletDB::CoinIndex::IsCandidate(const Coin& c)
+    {
+        return (MaxHeight == c.m_spentHeight) && (MaxHeight != c.m_maturity);
+    }
 
-        notifyCoinsChanged(ChangeAction::Updated, getUpdatedCoins(coins));
+    void WalletDB::CoinIndex::Reset()
+    {
+        m_Mature.clear();
+        m_Maturing.clear();
+        m_Coins.clear();
+        m_Valid = false;
     }
 
-    uint64_t WalletDB::AllocateKidRange(uint64_t nCount)
+    void WalletDB::CoinIndex::Classify(const Coin& c)
     {
-        // a bit akward, but ok
-        static const char szName[] = "LastKid";
+        if (c.m_maturity <= m_Height)
+            m_Mature[c.m_ID.m_AssetID].insert(&c);
+        else
+            m_Maturing.emplace(c.m_maturity, &c);
+    }
 
-        uint64_t nLast;
-        uintBigFor<uint64_t>::Type var;
+    void WalletDB::CoinIndex::Insert(const Coin& c)
+    {
+        Delete(c.m_ID);
+        Classify(m_Coins.emplace(c.m_ID, c).first->second);
+    }
 
-        if (storage::getVar(*this, szName, var))
+    void WalletDB::CoinIndex::Delete(const Coin::ID& cid)
+    {
+        auto it = m_Coins.find(cid);
+        if (m_Coins.end() == it)
+            return;
+
+        const Coin& c = it->second;
+        if (c.m_maturity <= m_Height)
         {
-            var.Export(nLast);
+            auto itAsset = m_Mature.find(c.m_ID.m_AssetID);
+            assert(m_Mature.end() != itAsset);
+
+            itAsset->second.erase(&c);
+            if (itAsset->second.empty())
+                m_Mature.erase(itAsset);
         }
         else
         {
-            nLast = getTimestamp(); // by default initialize by current time X1M (1sec resolution) to prevent collisions after reinitialization. Should be ok if creating less than 1M keys / sec average
-            nLast *= 1000000;
+            for (auto range = m_Maturing.equal_range(c.m_maturity); range.first != range.second; ++range.first)
+            {
+                if (range.first->second == &c)
+                {
+                    m_Maturing.erase(range.first);
+                    break;
+                }
+            }
         }
 
-        var = nLast + nCount;
-        storage::setVar(*this, szName, var);
-
-        return nLast;
+        m_Coins.erase(it);
     }
 
-    void WalletDB::removeCoins(const vector<Coin::ID>& coins)
+    void WalletDB::CoinIndex::SetHeight(Height h)
     {
-        if (coins.size())
+        if (h < m_Height)
         {
-            for (const auto& cid : coins)
-                removeCoinImpl(cid);
+            // rollback, should be rare. Re-classify all
+            m_Mature.clear();
+            m_Maturing.clear();
+            m_Height = h;
 
-            notifyCoinsChanged(ChangeAction::Removed, converIDsToCoins(coins));
+            for (const auto& x : m_Coins)
+                Classify(x.second);
+            return;
+        }
+
+        m_Height = h;
+
+        while (!m_Maturing.empty() && (m_Maturing.begin()->first <= h))
+        {
+            const Coin* pCoin = m_Maturing.begin()->second;
+            m_Mature[pCoin->m_ID.m_AssetID].insert(pCoin);
+            m_Maturing.erase(m_Maturing.begin());
         }
     }
 
-    void WalletDB::removeCoinImpl(const Coin::ID& cid)
+    void WalletDB::CoinIndex::OnCoinsChanged(ChangeAction action, const std::vector<Coin>& items)
     {
-        const char* req = "DELETE FROM " STORAGE_NAME STORAGE_WHERE_ID;
-        sqlite::Statement stm(this, req);
-
-        struct DummyWrapper {
-            Coin::ID m_ID;
-        };
+        if (!m_Valid)
+            return;
 
-        static_assert(sizeof(DummyWrapper) == sizeof(cid), "");
-        const DummyWrapper& wrp = reinterpret_cast<const DummyWrapper&>(cid);
+        switch (action)
+        {
+        case ChangeAction::Reset:
+            Reset(); // will be rebuilt on demand
+            break;
 
-        int colIdx = 0;
-        STORAGE_BIND_ID(wrp)
+        case ChangeAction::Removed:
+            for (const auto& c : items)
+                Delete(c.m_ID);
+            break;
 
-        stm.step();
+        default:
+            for (const auto& c : items)
+            {
+                if (IsCandidate(c))
+                    Insert(c);
+                else
+                    Delete(c.m_ID);
+            }
+        }
     }
 
-    void WalletDB::removeCoin(const Coin::ID& cid)
+    void WalletDB::CoinTotals::Reset()
     {
-        removeCoinImpl(cid);
-        notifyCoinsChanged(ChangeAction::Removed, converIDsToCoins({cid}));
+        m_Assets.clear();
+        m_Dirty.clear();
+        m_Valid = false;
     }
 
-    void WalletDB::clearCoins()
+    WalletDB::CoinTotals::Entry& WalletDB::CoinTotals::get_Entry(Asset::ID aid)
     {
-        sqlite::Statement stm(this, "DELETE FROM " STORAGE_NAME ";");
-        stm.step();
-        notifyCoinsChanged(ChangeAction::Reset, {});
-    }
+        m_Dirty.insert(aid);
 
-    void WalletDB::setCoinConfirmationsOffset(uint32_t offset)
-    {
-        setVarRaw(COIN_CONFIRMATIONS_COUNT, &offset, sizeof(uint32_t));
-        m_coinConfirmationsOffset = offset;
+        auto it = m_Assets.find(aid);
+        if (m_Assets.end() != it)
+            return it->second;
+
+        Entry& e = m_Assets[aid];
+        e.m_Totals.AssetId = aid;
+        return e;
     }
 
-    uint32_t WalletDB::getCoinConfirmationsOffset() const
+    void WalletDB::CoinTotals::OnChanged(Asset::ID aid, const Entry& e)
     {
-        return m_coinConfirmationsOffset;
+        if (!e.m_Coins && !e.m_ShieldedUnspent)
+            m_Assets.erase(aid);
     }
 
-    bool WalletDB::findCoin(Coin& coin)
+    void WalletDB::CoinTotals::Add(const Coin& c, bool bAdd)
     {
-        const char* req = "SELECT " ENUM_STORAGE_FIELDS(LIST, COMMA, ) " FROM " STORAGE_NAME STORAGE_WHERE_ID;
-        sqlite::Statement stm(this, req);
-
-        int colIdx = 0;
-        STORAGE_BIND_ID(coin)
-
-        if (!stm.step())
-            return false;
+        Entry& e = get_Entry(c.m_ID.m_AssetID);
+        e.m_Totals.AddCoin(c, bAdd);
 
-        colIdx = 0;
-        ENUM_STORAGE_FIELDS(STM_GET_LIST, NOSEP, coin);
-
-        storage::DeduceStatus(*this, coin, getCurrentHeight());
+        if (bAdd)
+            e.m_Coins++;
+        else
+        {
+            assert(e.m_Coins);
+            e.m_Coins--;
+        }
 
-        return true;
+        OnChanged(c.m_ID.m_AssetID, e);
     }
 
-    struct WalletDB::ShieldedStatusCtx
+    void WalletDB::CoinTotals::Add(const ShieldedCoin& c, bool bAdd)
     {
-        Height m_hTip;
+        if (MaxHeight != c.m_spentHeight)
+            return; // only unspent are accounted
 
-        ShieldedStatusCtx(const WalletDB& db)
+        Entry& e = get_Entry(c.m_CoinID.m_AssetID);
+        e.m_Totals.AddShielded(c, bAdd);
+
+        if (bAdd)
+            e.m_ShieldedUnspent++;
+        else
         {
-            m_hTip = db.getCurrentHeight();
+            assert(e.m_ShieldedUnspent);
+            e.m_ShieldedUnspent--;
         }
-    };
 
-    void WalletDB::visitShieldedCoins(std::function<bool(const ShieldedCoin& info)> func)
+        OnChanged(c.m_CoinID.m_AssetID, e);
+    }
+
+    void WalletDB::loadCoinTotals()
     {
-        ShieldedStatusCtx ssc(*this);
+        m_CoinTotals.Reset();
 
-        sqlite::Statement stm(this, "SELECT " SHIELDED_COIN_FIELDS " FROM " SHIELDED_COINS_NAME " ORDER BY Key;"); // the order is not importantt, but at least it should be by indexed field
+        sqlite::Statement stm(this, "SELECT " COIN_TOTALS_FIELDS " FROM " COIN_TOTALS_NAME ";");
         while (stm.step())
         {
-            ShieldedCoin coin;
-
+            CoinTotals::Entry e;
             int colIdx = 0;
-            ENUM_SHIELDED_COIN_FIELDS(STM_GET_LIST, NOSEP, coin);
-
-            coin.DeduceStatus(*this, ssc.m_hTip);
-            if (!func(coin))
-                break;
+            ENUM_COIN_TOTALS_FIELDS(STM_GET_LIST, NOSEP, e);
+            m_CoinTotals.m_Assets[e.m_Totals.AssetId] = e;
         }
+
+        if (m_CoinTotals.m_Assets.empty())
+            rebuildCoinTotals(); // new or just migrated db (or there are no coins at all)
+        else
+            m_CoinTotals.m_Valid = true;
     }
 
-    void WalletDB::visitShieldedCoinsUnspent(const std::function<bool(const ShieldedCoin& info)>& func)
+    void WalletDB::rebuildCoinTotals()
     {
-        ShieldedStatusCtx ssc(*this);
+        m_CoinTotals.Reset();
+        {
+            sqlite::Statement stm(this, "DELETE FROM " COIN_TOTALS_NAME ";");
+            stm.step();
+        }
 
-        sqlite::Statement stm(this, "SELECT " SHIELDED_COIN_FIELDS " FROM " SHIELDED_COINS_NAME " WHERE spentHeight <0;");
-        while (stm.step())
+        visitCoins([this](const Coin& c) -> bool
         {
-            ShieldedCoin coin;
+            m_CoinTotals.Add(c, true);
+            return true;
+        });
 
-            int colIdx = 0;
-            ENUM_SHIELDED_COIN_FIELDS(STM_GET_LIST, NOSEP, coin);
+        visitShieldedCoinsUnspent([this](const ShieldedCoin& c) -> bool
+        {
+            m_CoinTotals.Add(c, true);
+            return true;
+        });
 
-            coin.DeduceStatus(*this, ssc.m_hTip);
-            if (!func(coin))
-                break;
-        }
+        m_CoinTotals.m_Valid = true;
+        if (!m_CoinTotals.m_Dirty.empty())
+            onModified(); // make sure they're saved
     }
 
-    void WalletDB::visitCoins(function<bool(const Coin& coin)> func)
+    void WalletDB::saveCoinTotals()
     {
-        const char* req = "SELECT " STORAGE_FIELDS " FROM " STORAGE_NAME " ORDER BY ROWID;";
-        sqlite::Statement stm(this, req);
+        // called on flush, the statements are not tracked as modifications
+        const WalletDB* pThis = this;
 
-        Height h = getCurrentHeight();
-        while (stm.step())
+        for (Asset::ID aid : m_CoinTotals.m_Dirty)
         {
-            Coin coin;
+            auto it = m_CoinTotals.m_Assets.find(aid);
+            if (m_CoinTotals.m_Assets.end() == it)
+            {
+                sqlite::Statement stm(pThis, "DELETE FROM " COIN_TOTALS_NAME " WHERE assetId=?1;");
+                stm.bind(1, aid);
+                stm.step();
+            }
+            else
+            {
+                sqlite::Statement stm(pThis, "INSERT OR REPLACE INTO " COIN_TOTALS_NAME " (" COIN_TOTALS_FIELDS ") VALUES(" ENUM_COIN_TOTALS_FIELDS(BIND_LIST, COMMA, ) ");");
+                int colIdx = 0;
+                ENUM_COIN_TOTALS_FIELDS(STM_BIND_LIST, NOSEP, it->second);
+                stm.step();
+            }
+        }
 
-            int colIdx = 0;
-            ENUM_ALL_STORAGE_FIELDS(STM_GET_LIST, NOSEP, coin);
+        m_CoinTotals.m_Dirty.clear();
+    }
+
+    void WalletDB::updateCoinTotals(Coin c, bool bAdd)
+    {
+        if (m_CoinTotals.m_Valid)
+        {
+            storage::DeduceStatus(*this, c, getCurrentHeight());
+            m_CoinTotals.Add(c, bAdd);
+        }
+    }
+
+    void WalletDB::updateShieldedCoinTotals(const ShieldedTxo::BaseKey& key, bool bAdd)
+    {
+        if (m_CoinTotals.m_Valid)
+        {
+            auto c = getShieldedCoin(key);
+            if (c)
+                m_CoinTotals.Add(*c, bAdd);
+        }
+    }
+
+    bool WalletDB::isTxCoinTotalsParam(const TxID& txID, SubTxID subTxID, TxParameterID paramID, const ByteBuffer* pBlob) const
+    {
+        // the tx status affects the coin status only when it goes from/to the 'ongoing' state
+        if (!m_CoinTotals.m_Valid || (kDefaultSubTxID != subTxID) || (TxParameterID::Status != paramID))
+            return false;
+
+        TxStatus txStatus;
+        bool bOngoing = pBlob && fromByteBuffer(*pBlob, txStatus) && IsOngoingStatus(txStatus);
+        bool bWasOngoing = storage::getTxParameter(*this, txID, TxParameterID::Status, txStatus) && IsOngoingStatus(txStatus);
+
+        return bWasOngoing != bOngoing;
+    }
+
+    void WalletDB::updateTxCoinTotals(const TxID& txID, bool bAdd)
+    {
+        // the shielded totals don't depend on the tx status
+        Height h = getCurrentHeight();
+        for (auto& c : getCoinsByTx(txID))
+        {
+            storage::DeduceStatus(*this, c, h);
+            m_CoinTotals.Add(c, bAdd);
+        }
+    }
+
+    void WalletDB::updateHeightCoinTotals(Height hPrev, Height h)
+    {
+        if (hPrev == h)
+            return;
+
+        Height h0 = std::min(hPrev, h);
+        Height h1 = std::max(hPrev, h);
+
+        Height dh = getCoinConfirmationsOffset();
+        if (h0 < dh)
+        {
+            // the confirmations offset is not applied below it, should happen at the very beginning only
+            rebuildCoinTotals();
+            return;
+        }
+
+        // The status of the unspent coin may change when the height crosses its maturity or confirmHeight + offset.
+        // The shielded totals don't depend on the height
+        const char* req = "SELECT " STORAGE_FIELDS " FROM " STORAGE_NAME " WHERE spentHeight<0 AND ((maturity>?1 AND maturity<=?2) OR (confirmHeight>?3 AND confirmHeight<=?4));";
+        sqlite::Statement stm(this, req);
+        stm.bind(1, h0);
+        stm.bind(2, h1);
+        stm.bind(3, h0 - dh);
+        stm.bind(4, h1 - dh);
+
+        while (stm.step())
+        {
+            Coin c;
+            int colIdx = 0;
+            ENUM_ALL_STORAGE_FIELDS(STM_GET_LIST, NOSEP, c);
+
+            storage::DeduceStatus(*this, c, hPrev);
+            m_CoinTotals.Add(c, false);
+
+            storage::DeduceStatus(*this, c, h);
+            m_CoinTotals.Add(c, true);
+        }
+    }
+
+    void WalletDB::storeCoin(Coin& coin)
+    {
+        coin.m_ID.m_Idx = get_RandomID();
+        insertNewCoin(coin);
+        notifyCoinsChanged(ChangeAction::Added, {coin});
+    }
+
+    void WalletDB::storeCoins(std::vector<Coin>& coins)
+    {
+        if (coins.empty())
+            return;
+
+        uint64_t nKeyIndex = get_RandomID();
+        for (auto& coin : coins)
+        {
+            coin.m_ID.m_Idx = nKeyIndex;
+            insertNewCoin(coin);
+            nKeyIndex = coin.m_ID.m_Idx + 1;
+        }
+        notifyCoinsChanged(ChangeAction::Added, coins);
+    }
+
+    void WalletDB::saveCoin(const Coin& coin)
+    {
+        saveCoinRaw(coin);
+        notifyCoinsChanged(ChangeAction::Updated, getUpdatedCoins({coin}));
+    }
+
+    void WalletDB::saveCoins(const vector<Coin>& coins)
+    {
+        if (coins.empty())
+            return;
+
+        for (auto& coin : coins)
+        {
+            saveCoinRaw(coin);
+        }
+
+        notifyCoinsChanged(ChangeAction::Updated, getUpdatedCoins(coins));
+    }
+
+    uint64_t WalletDB::AllocateKidRange(uint64_t nCount)
+    {
+        // a bit akward, but ok
+        static const char szName[] = "LastKid";
+
+        uint64_t nLast;
+        uintBigFor<uint64_t>::Type var;
+
+        if (storage::getVar(*this, szName, var))
+        {
+            var.Export(nLast);
+        }
+        else
+        {
+            nLast = getTimestamp(); // by default initialize by current time X1M (1sec resolution) to prevent collisions after reinitialization. Should be ok if creating less than 1M keys / sec average
+            nLast *= 1000000;
+        }
+
+        var = nLast + nCount;
+        storage::setVar(*this, szName, var);
+
+        return nLast;
+    }
+
+    void WalletDB::removeCoins(const vector<Coin::ID>& coins)
+    {
+        if (coins.size())
+        {
+            for (const auto& cid : coins)
+                removeCoinImpl(cid);
+
+            notifyCoinsChanged(ChangeAction::Removed, converIDsToCoins(coins));
+        }
+    }
+
+    void WalletDB::removeCoinImpl(const Coin::ID& cid)
+    {
+        if (m_CoinTotals.m_Valid)
+        {
+            Coin c;
+            c.m_ID = cid;
+            if (findCoin(c))
+                m_CoinTotals.Add(c, false);
+        }
+
+        const char* req = "DELETE FROM " STORAGE_NAME STORAGE_WHERE_ID;
+        sqlite::Statement stm(this, req);
+
+        struct DummyWrapper {
+            Coin::ID m_ID;
+        };
+
+        static_assert(sizeof(DummyWrapper) == sizeof(cid), "");
+        const DummyWrapper& wrp = reinterpret_cast<const DummyWrapper&>(cid);
+
+        int colIdx = 0;
+        STORAGE_BIND_ID(wrp)
+
+        stm.step();
+    }
+
+    void WalletDB::removeCoin(const Coin::ID& cid)
+    {
+        removeCoinImpl(cid);
+        notifyCoinsChanged(ChangeAction::Removed, converIDsToCoins({cid}));
+    }
+
+    void WalletDB::clearCoins()
+    {
+        sqlite::Statement stm(this, "DELETE FROM " STORAGE_NAME ";");
+        stm.step();
+
+        if (m_CoinTotals.m_Valid)
+            rebuildCoinTotals(); // only the shielded remain
+        notifyCoinsChanged(ChangeAction::Reset, {});
+    }
+
+    void WalletDB::setCoinConfirmationsOffset(uint32_t offset)
+    {
+        bool bChanged = (m_coinConfirmationsOffset != offset);
+        setVarRaw(COIN_CONFIRMATIONS_COUNT, &offset, sizeof(uint32_t));
+        m_coinConfirmationsOffset = offset;
+
+        if (bChanged && m_CoinTotals.m_Valid)
+            rebuildCoinTotals(); // maturing coins are re-evaluated
+    }
+
+    uint32_t WalletDB::getCoinConfirmationsOffset() const
+    {
+        return m_coinConfirmationsOffset;
+    }
+
+    bool WalletDB::findCoin(Coin& coin)
+    {
+        const char* req = "SELECT " ENUM_STORAGE_FIELDS(LIST, COMMA, ) " FROM " STORAGE_NAME STORAGE_WHERE_ID;
+        sqlite::Statement stm(this, req);
+
+        int colIdx = 0;
+        STORAGE_BIND_ID(coin)
+
+        if (!stm.step())
+            return false;
+
+        colIdx = 0;
+        ENUM_STORAGE_FIELDS(STM_GET_LIST, NOSEP, coin);
+
+        storage::DeduceStatus(*this, coin, getCurrentHeight());
+
+        return true;
+    }
+
+    struct WalletDB::ShieldedStatusCtx
+    {
+        Height m_hTip;
+
+        ShieldedStatusCtx(const WalletDB& db)
+        {
+            m_hTip = db.getCurrentHeight();
+        }
+    };
+
+    void WalletDB::visitShieldedCoins(std::function<bool(const ShieldedCoin& info)> func)
+    {
+        ShieldedStatusCtx ssc(*this);
+
+        sqlite::Statement stm(this, "SELECT " SHIELDED_COIN_FIELDS " FROM " SHIELDED_COINS_NAME " ORDER BY Key;"); // the order is not importantt, but at least it should be by indexed field
+        while (stm.step())
+        {
+            ShieldedCoin coin;
+
+            int colIdx = 0;
+            ENUM_SHIELDED_COIN_FIELDS(STM_GET_LIST, NOSEP, coin);
+
+            coin.DeduceStatus(*this, ssc.m_hTip);
+            if (!func(coin))
+                break;
+        }
+    }
+
+    void WalletDB::visitShieldedCoinsUnspent(const std::function<bool(const ShieldedCoin& info)>& func)
+    {
+        ShieldedStatusCtx ssc(*this);
+
+        sqlite::Statement stm(this, "SELECT " SHIELDED_COIN_FIELDS " FROM " SHIELDED_COINS_NAME " WHERE spentHeight <0;");
+        while (stm.step())
+        {
+            ShieldedCoin coin;
+
+            int colIdx = 0;
+            ENUM_SHIELDED_COIN_FIELDS(STM_GET_LIST, NOSEP, coin);
+
+            coin.DeduceStatus(*this, ssc.m_hTip);
+            if (!func(coin))
+                break;
+        }
+    }
+
+    void WalletDB::visitCoins(function<bool(const Coin& coin)> func)
+    {
+        const char* req = "SELECT " STORAGE_FIELDS " FROM " STORAGE_NAME " ORDER BY ROWID;";
+        sqlite::Statement stm(this, req);
+
+        Height h = getCurrentHeight();
+        while (stm.step())
+        {
+            Coin coin;
+
+            int colIdx = 0;
+            ENUM_ALL_STORAGE_FIELDS(STM_GET_LIST, NOSEP, coin);
 
             storage::DeduceStatus(*this, coin, h);
 
@@ -2833,6 +3356,60 @@ namespace beam::wallet
         }
     }
 
+    void WalletDB::visitCoinTotals(std::function<bool(const storage::Totals::AssetTotals&)> func)
+    {
+        sqlite::Statement stm(this, "SELECT confirmHeight FROM " STORAGE_NAME " WHERE assetId=?1 AND confirmHeight>=0 ORDER BY confirmHeight LIMIT 1;");
+
+        for (const auto& x : m_CoinTotals.m_Assets)
+        {
+            storage::Totals::AssetTotals totals = x.second.m_Totals;
+            if (x.second.m_Coins)
+            {
+                // the earliest confirmed coin, if any
+                totals.MinCoinHeight = MaxHeight;
+
+                stm.bind(1, x.first);
+                if (stm.step())
+                    stm.get(0, totals.MinCoinHeight);
+                stm.Reset();
+            }
+
+            if (!func(totals))
+                break;
+        }
+    }
+
+    void WalletDB::visitCoinsFrom(const boost::optional<Asset::ID>& assetId, uint64_t posAfter, uint32_t nSkip, std::function<bool(const Coin&, uint64_t pos)> func)
+    {
+        std::string req = "SELECT " STORAGE_FIELDS ", ROWID FROM " STORAGE_NAME " WHERE ROWID>?1";
+        if (assetId)
+            req += " AND assetId=?2";
+        req += " ORDER BY ROWID LIMIT -1 OFFSET ?3;";
+
+        sqlite::Statement stm(this, req.c_str());
+        stm.bind(1, posAfter);
+        if (assetId)
+            stm.bind(2, *assetId);
+        stm.bind(3, nSkip);
+
+        Height h = getCurrentHeight();
+        while (stm.step())
+        {
+            Coin coin;
+
+            int colIdx = 0;
+            ENUM_ALL_STORAGE_FIELDS(STM_GET_LIST, NOSEP, coin);
+
+            uint64_t pos = 0;
+            stm.get(colIdx, pos);
+
+            storage::DeduceStatus(*this, coin, h);
+
+            if (!func(coin, pos))
+                break;
+        }
+    }
+
     void WalletDB::setVarRaw(const char* name, const void* data, size_t size)
     {
         const char* req = "INSERT or REPLACE INTO " VARIABLES_NAME " (" VARIABLES_FIELDS ") VALUES(?1, ?2);";
@@ -2910,8 +3487,15 @@ namespace beam::wallet
 
     void WalletDB::setSystemStateID(const Block::SystemState::ID& stateID)
     {
+        Height hPrev = getCurrentHeight();
+
         storage::setVar(*this, SystemStateIDName, stateID);
         storage::setVar(*this, LastUpdateTimeName, getTimestamp());
+
+        if (m_CoinIndex.m_Valid)
+            m_CoinIndex.SetHeight(stateID.m_Height);
+        if (m_CoinTotals.m_Valid)
+            updateHeightCoinTotals(hPrev, stateID.m_Height);
         notifySystemStateChanged(stateID);
     }
 
@@ -2946,6 +3530,12 @@ namespace beam::wallet
         }
         if (!changedRows.empty())
         {
+            if (m_CoinTotals.m_Valid)
+            {
+                for (const auto& c : getCoinsByRowIDs(changedRows))
+                    m_CoinTotals.Add(c, false);
+            }
+
             {
                 const char* req = "UPDATE " STORAGE_NAME " SET confirmHeight=?1 WHERE confirmHeight > ?2;";
                 sqlite::Statement stm(this, req);
@@ -2962,7 +3552,13 @@ namespace beam::wallet
                 stm.step();
             }
  
-            notifyCoinsChanged(ChangeAction::Updated, getCoinsByRowIDs(changedRows));
+            auto coins = getCoinsByRowIDs(changedRows);
+            if (m_CoinTotals.m_Valid)
+            {
+                for (const auto& c : coins)
+                    m_CoinTotals.Add(c, true);
+            }
+            notifyCoinsChanged(ChangeAction::Updated, coins);
         }
     }
 
@@ -3045,6 +3641,9 @@ namespace beam::wallet
     {
         sqlite::Statement stm(this, "DELETE FROM " SHIELDED_COINS_NAME ";");
         stm.step();
+
+        if (m_CoinTotals.m_Valid)
+            rebuildCoinTotals();
         notifyShieldedCoinsChanged(ChangeAction::Reset, {});
     }
 
@@ -3105,6 +3704,41 @@ namespace beam::wallet
         }
     }
 
+    uint32_t WalletDB::readShieldedList(TxoID id0, ECC::Point::Storage* p, uint32_t nCount) const
+    {
+        sqlite::Statement stm(this, "SELECT ID, Commitment FROM " SHIELDED_LIST_NAME " WHERE ID>=?1 AND ID<?2 ORDER BY ID;");
+        stm.bind(1, id0);
+        stm.bind(2, id0 + nCount);
+
+        uint32_t n = 0;
+        while (stm.step())
+        {
+            TxoID id;
+            stm.get(0, id);
+            if (id != id0 + n)
+                break; // gap
+
+            stm.get(1, p[n++]);
+        }
+
+        return n;
+    }
+
+    void WalletDB::saveShieldedList(TxoID id0, const ECC::Point::Storage* p, uint32_t nCount)
+    {
+        sqlite::Statement stm(this, "INSERT OR REPLACE INTO " SHIELDED_LIST_NAME " (ID, Commitment) VALUES(?1, ?2);");
+
+        for (uint32_t i = 0; i < nCount; i++)
+        {
+            if (i)
+                stm.Reset();
+
+            stm.bind(1, id0 + i);
+            stm.bind(2, p[i]);
+            stm.step();
+        }
+    }
+
     void WalletDB::insertShieldedCoinRaw(const ShieldedCoin& coin)
     {
         const char* req = "INSERT INTO " SHIELDED_COINS_NAME " (" ENUM_SHIELDED_COIN_FIELDS(LIST, COMMA, ) ") VALUES(" ENUM_SHIELDED_COIN_FIELDS(BIND_LIST, COMMA, ) ");";
@@ -3113,10 +3747,15 @@ namespace beam::wallet
        
         ENUM_SHIELDED_COIN_FIELDS(STM_BIND_LIST, NOSEP, coin);
         stm.step();
+
+        if (m_CoinTotals.m_Valid)
+            m_CoinTotals.Add(coin, true);
     }
 
     bool WalletDB::updateShieldedCoinRaw(const ShieldedCoin& coin)
     {
+        updateShieldedCoinTotals(coin.m_CoinID.m_Key, false);
+
         const char* req = "UPDATE " SHIELDED_COINS_NAME " SET " ENUM_SHIELDED_COIN_FIELDS(SET_LIST, COMMA, ) "WHERE Key = ?;";
         sqlite::Statement stm(this, req);
         int colIdx = 0;
@@ -3125,7 +3764,12 @@ namespace beam::wallet
         stm.bind(++colIdx, coin.m_CoinID.m_Key);
         stm.step();
 
-        return sqlite3_changes(_db) > 0;
+        if (!sqlite3_changes(_db))
+            return false;
+
+        if (m_CoinTotals.m_Valid)
+            m_CoinTotals.Add(coin, true);
+        return true;
     }
 
     void WalletDB::saveShieldedCoinRaw(const ShieldedCoin& coin)
@@ -3239,6 +3883,60 @@ namespace beam::wallet
         return boost::optional<TxDescription>{};
     }
 
+    void WalletDB::visitTxHistory(const TxHistoryFilter& f, std::function<bool(const TxDescription&, Height hProof)> func) const
+    {
+        std::string req = "SELECT txID, proofHeight FROM " TX_INDEX_NAME " WHERE 1";
+
+        if (!f.m_Types.empty())
+        {
+            req += " AND txType IN (";
+            for (size_t i = 0; i < f.m_Types.size(); i++)
+            {
+                if (i)
+                    req += ",";
+                req += std::to_string(static_cast<int>(f.m_Types[i]));
+            }
+            req += ")";
+        }
+
+        if (f.m_Status)
+            req += " AND status=?1";
+        if (f.m_AssetID)
+            req += " AND assetID=?2";
+        if (f.m_ProofHeight)
+            req += " AND proofHeight=?3";
+        if (f.m_After)
+            req += " AND (minHeight, txID) < (?4, ?5)";
+
+        req += " ORDER BY minHeight DESC, txID DESC LIMIT -1 OFFSET ?6;";
+
+        sqlite::Statement stm(this, req.c_str());
+        if (f.m_Status)
+            stm.bind(1, *f.m_Status);
+        if (f.m_AssetID)
+            stm.bind(2, *f.m_AssetID);
+        if (f.m_ProofHeight)
+            stm.bind(3, *f.m_ProofHeight);
+        if (f.m_After)
+        {
+            stm.bind(4, f.m_After->m_MinHeight);
+            stm.bind(5, f.m_After->m_TxID);
+        }
+        stm.bind(6, f.m_Skip);
+
+        while (stm.step())
+        {
+            TxID txID;
+            Height hProof = 0;
+            stm.get(0, txID);
+            stm.get(1, hProof);
+
+            auto tx = getTx(txID);
+            if (tx && !func(*tx, hProof))
+                break;
+        }
+    }
+
     void WalletDB::saveTx(const TxDescription& p)
     {
         ChangeAction action = ChangeAction::Added;
@@ -3270,6 +3968,10 @@ namespace beam::wallet
         auto tx = getTx(txId);
         if (tx.is_initialized())
         {
+            bool bTotals = isTxCoinTotalsParam(txId, kDefaultSubTxID, TxParameterID::Status, nullptr);
+            if (bTotals)
+                updateTxCoinTotals(txId, false);
+
             // we left one record about tx type in order to avoid re-launching of deleted transaction
             const char* req = "DELETE FROM " TX_PARAMS_NAME " WHERE txID=?1 AND paramID!=?2;";
             sqlite::Statement stm(this, req);
@@ -3278,7 +3980,15 @@ namespace beam::wallet
             stm.bind(2, TxParameterID::TransactionType);
 
             stm.step();
+
+            sqlite::Statement stm2(this, "DELETE FROM " TX_INDEX_NAME " WHERE txID=?1;");
+            stm2.bind(1, txId);
+            stm2.step();
+
             deleteParametersFromCache(txId);
+            if (bTotals)
+                updateTxCoinTotals(txId, true);
+
             notifyTransactionChanged(ChangeAction::Removed, { *tx });
         }
     }
@@ -3298,13 +4008,26 @@ namespace beam::wallet
         }
         if (!updatedRows.empty())
         {
+            if (m_CoinTotals.m_Valid)
+            {
+                for (const auto& c : getCoinsByRowIDs(updatedRows))
+                    m_CoinTotals.Add(c, false);
+            }
+
             {
                 const char* req = "UPDATE " STORAGE_NAME " SET spentTxId=NULL WHERE spentTxId=?1;";
                 sqlite::Statement stm(this, req);
                 stm.bind(1, txId);
                 stm.step();
             }
-            notifyCoinsChanged(ChangeAction::Updated, getCoinsByRowIDs(updatedRows));
+
+            auto coins = getCoinsByRowIDs(updatedRows);
+            if (m_CoinTotals.m_Valid)
+            {
+                for (const auto& c : coins)
+                    m_CoinTotals.Add(c, true);
+            }
+            notifyCoinsChanged(ChangeAction::Updated, coins);
         }
 
         deleteCoinsCreatedByTx(txId);
@@ -3327,6 +4050,9 @@ namespace beam::wallet
         }
         if (!deletedItems.empty())
         {
+            for (const auto& c : deletedItems)
+                updateCoinTotals(c, false);
+
             const char* req = "DELETE FROM " STORAGE_NAME " WHERE createTxId=?1 AND confirmHeight=?2;";
             sqlite::Statement stm(this, req);
             stm.bind(1, txId);
@@ -3352,6 +4078,9 @@ namespace beam::wallet
         }
         if (!updatedRows.empty())
         {
+            for (const auto& key : updatedRows)
+                updateShieldedCoinTotals(key, false);
+
             {
                 const char* req = "UPDATE " SHIELDED_COINS_NAME " SET spentTxId=NULL WHERE spentTxId=?1;";
                 sqlite::Statement stm(this, req);
@@ -3367,6 +4096,9 @@ namespace beam::wallet
             {
                 auto& coin = updatedCoins.emplace_back(getShieldedCoin(key).value());
                 coin.DeduceStatus(*this, currentHeight);
+
+                if (m_CoinTotals.m_Valid)
+                    m_CoinTotals.Add(coin, true);
             }
 
             notifyShieldedCoinsChanged(ChangeAction::Updated, updatedCoins);
@@ -3375,6 +4107,8 @@ namespace beam::wallet
 
     void WalletDB::DeleteShieldedCoin(const ShieldedTxo::BaseKey& key)
     {
+        updateShieldedCoinTotals(key, false);
+
         const char* req = "DELETE FROM " SHIELDED_COINS_NAME " WHERE Key=?1;";
         sqlite::Statement stm(this, req);
         stm.bind(1, key);
@@ -4019,6 +4753,10 @@ namespace beam::wallet
                     return false;
                 }
 
+                bool bTotals = isTxCoinTotalsParam(txID, subTxID, paramID, &blob);
+                if (bTotals)
+                    updateTxCoinTotals(txID, false);
+
                 sqlite::Statement stm2(this, "UPDATE " TX_PARAMS_NAME  " SET value = ?4 WHERE txID = ?1 AND subTxID=?2 AND paramID = ?3;");
                 stm2.bind(1, txID);
                 stm2.bind(2, subTxID);
@@ -4026,6 +4764,14 @@ namespace beam::wallet
                 stm2.bind(4, blob);
                 stm2.step();
 
+                insertParameterToCache(txID, subTxID, paramID, blob);
+                if (bTotals)
+                    updateTxCoinTotals(txID, true);
+                if ((kDefaultSubTxID == subTxID) && isTxIndexParam(paramID))
+                {
+                    updateTxIndex(txID);
+                }
+
                 if (shouldNotifyAboutChanges)
                 {
                     auto tx = getTx(txID);
@@ -4034,11 +4780,14 @@ namespace beam::wallet
                         notifyTransactionChanged(ChangeAction::Updated, { *tx });
                     }
                 }
-                insertParameterToCache(txID, subTxID, paramID, blob);
                 return true;
             }
         }
-        
+
+        bool bTotals = isTxCoinTotalsParam(txID, subTxID, paramID, &blob);
+        if (bTotals)
+            updateTxCoinTotals(txID, false);
+
         sqlite::Statement stm(this, "INSERT INTO " TX_PARAMS_NAME " (" ENUM_TX_PARAMS_FIELDS(LIST, COMMA, ) ") VALUES(" ENUM_TX_PARAMS_FIELDS(BIND_LIST, COMMA, ) ");");
         TxParameter parameter;
         parameter.m_txID = txID;
@@ -4048,6 +4797,14 @@ namespace beam::wallet
         int colIdx = 0;
         ENUM_TX_PARAMS_FIELDS(STM_BIND_LIST, NOSEP, parameter);
         stm.step();
+        insertParameterToCache(txID, subTxID, paramID, blob);
+        if (bTotals)
+            updateTxCoinTotals(txID, true);
+        if ((kDefaultSubTxID == subTxID) && isTxIndexParam(paramID))
+        {
+            updateTxIndex(txID);
+        }
+
         if (shouldNotifyAboutChanges)
         {
             auto tx = getTx(txID);
@@ -4056,12 +4813,15 @@ namespace beam::wallet
                 notifyTransactionChanged(hasTx ? ChangeAction::Updated : ChangeAction::Added, { *tx });
             }
         }
-        insertParameterToCache(txID, subTxID, paramID, blob);
         return true;
     }
 
     bool WalletDB::delTxParameter(const TxID& txID, SubTxID subTxID, TxParameterID paramID)
     {
+        bool bTotals = isTxCoinTotalsParam(txID, subTxID, paramID, nullptr);
+        if (bTotals)
+            updateTxCoinTotals(txID, false);
+
         if (auto txIter = m_TxParametersCache.find(txID); txIter != m_TxParametersCache.end())
         {
             if (auto subTxIter = txIter->second.find(subTxID); subTxIter != txIter->second.end())
@@ -4081,6 +4841,14 @@ namespace beam::wallet
 
         stm.step();
 
+        if (bTotals)
+            updateTxCoinTotals(txID, true);
+
+        if ((kDefaultSubTxID == subTxID) && isTxIndexParam(paramID))
+        {
+            updateTxIndex(txID);
+        }
+
         return true;
     }
 
@@ -4162,6 +4930,66 @@ namespace beam::wallet
         return true;
     }
 
+    bool WalletDB::isTxIndexParam(TxParameterID paramID) const
+    {
+        // the mandatory params decide if the tx is listed at all
+        return IsTxIndexParam(paramID) || m_mandatoryTxParams.count(paramID);
+    }
+
+    void WalletDB::updateTxIndex(const TxID& txID)
+    {
+        // only the txs that can be read (see getTx) are indexed. Otherwise they'd be counted by the paging (skip), but not listed.
+        // This excludes the incomplete txs, and the stubs left by deleteTx
+        TxType txType = TxType::Simple;
+        if (!hasTransaction(txID) || !storage::getTxParameter(*this, txID, TxParameterID::TransactionType, txType))
+        {
+            sqlite::Statement stm(this, "DELETE FROM " TX_INDEX_NAME " WHERE txID=?1;");
+            stm.bind(1, txID);
+            stm.step();
+            return;
+        }
+
+        TxStatus status = TxStatus::Pending;
+        Asset::ID assetID = Asset::s_InvalidID;
+        Height hMin = 0, hProof = 0;
+
+        storage::getTxParameter(*this, txID, TxParameterID::Status, status);
+        storage::getTxParameter(*this, txID, TxParameterID::AssetID, assetID);
+        storage::getTxParameter(*this, txID, TxParameterID::MinHeight, hMin);
+        // see storage::DeduceTxProofHeight
+        storage::getTxParameter(*this, txID, (TxType::AssetInfo == txType) ? TxParameterID::AssetConfirmedHeight : TxParameterID::KernelProofHeight, hProof);
+
+        sqlite::Statement stm(this, "INSERT OR REPLACE INTO " TX_INDEX_NAME " (txID, txType, status, assetID, minHeight, proofHeight) VALUES(?1, ?2, ?3, ?4, ?5, ?6);");
+        stm.bind(1, txID);
+        stm.bind(2, txType);
+        stm.bind(3, status);
+        stm.bind(4, assetID);
+        stm.bind(5, hMin);
+        stm.bind(6, hProof);
+        stm.step();
+    }
+
+    void WalletDB::fillTxIndex()
+    {
+        std::vector<TxID> vTxs;
+        {
+            sqlite::Statement stm(this, "SELECT DISTINCT txID FROM " TX_PARAMS_NAME " WHERE subTxID=?1;");
+            stm.bind(1, kDefaultSubTxID);
+            while (stm.step())
+            {
+                stm.get(0, vTxs.emplace_back());
+            }
+        }
+
+        for (const auto& txID : vTxs)
+        {
+            if (hasTransaction(txID))
+            {
+                updateTxIndex(txID);
+            }
+        }
+    }
+
     void WalletDB::flushDB()
     {
         if (m_IsFlushPending)
@@ -4184,6 +5012,10 @@ namespace beam::wallet
                 m_DbTransaction->rollback();
                 m_DbTransaction.reset();
             }
+
+            m_CoinIndex.Reset();
+            if (m_CoinTotals.m_Valid)
+                loadCoinTotals(); // revert to the saved state
         }
     }
 
@@ -4207,6 +5039,7 @@ namespace beam::wallet
     void WalletDB::onFlushTimer()
     {
         m_IsFlushPending = false;
+        saveCoinTotals();
         if (m_DbTransaction)
         {
             m_DbTransaction->commit();
@@ -4224,6 +5057,8 @@ namespace beam::wallet
 
     void WalletDB::notifyCoinsChanged(ChangeAction action, const vector<Coin>& items)
     {
+        m_CoinIndex.OnCoinsChanged(action, items);
+
         if (items.empty() && action != ChangeAction::Reset)
             return;
 
@@ -4317,14 +5152,31 @@ namespace beam::wallet
 
     bool WalletDB::unlockCoins(uint64_t session)
     {
-        const char* req = "UPDATE " STORAGE_NAME " SET sessionId=0 WHERE sessionId=?1;";
-        sqlite::Statement stm(this, req);
+        std::vector<int> updatedRows;
+        {
+            const char* req = "SELECT rowid FROM " STORAGE_NAME " WHERE sessionId=?1;";
+            sqlite::Statement stm(this, req);
+            stm.bind(1, session);
+            while (stm.step())
+            {
+                int& coin = updatedRows.emplace_back();
+                stm.get(0, coin);
+            }
+        }
 
-        stm.bind(1, session);
+        if (updatedRows.empty())
+            return false;
 
-        stm.step();
+        {
+            const char* req = "UPDATE " STORAGE_NAME " SET sessionId=0 WHERE sessionId=?1;";
+            sqlite::Statement stm(this, req);
+            stm.bind(1, session);
+            stm.step();
+        }
 
-        return sqlite3_changes(_db) > 0;
+        // keep the coin index copies (and the subscribers) up to date
+        notifyCoinsChanged(ChangeAction::Updated, getCoinsByRowIDs(updatedRows));
+        return true;
     }
 
     CoinIDList WalletDB::getLockedCoins(uint64_t session) const
@@ -4594,103 +5446,105 @@ namespace beam::wallet
             Init(db);
         }
 
-        void Totals::Init(IWalletDB& walletDB)
+        void Totals::AssetTotals::AddCoin(const Coin& c, bool bAdd)
         {
-            auto getTotalsRef = [this](Asset::ID assetId) -> AssetTotals& {
-                if (allTotals.find(assetId) == allTotals.end()) {
-                    allTotals[assetId] = AssetTotals();
-                    allTotals[assetId].AssetId = assetId;
-                }
-                return allTotals[assetId];
-            };
+            AmountBig::Type value = c.m_ID.m_Value;
+            if (!bAdd)
+                value.Negate();
 
-            walletDB.visitCoins([getTotalsRef] (const Coin& c) -> bool
+            switch (c.m_status)
             {
-                auto& totals = getTotalsRef(c.m_ID.m_AssetID);
+            case Coin::Status::Available:
+                Avail += value;
+                Unspent += value;
+                switch (c.m_ID.m_Type)
+                {
+                case Key::Type::Coinbase:
+                    assert(!c.isAsset());
+                    AvailCoinbase += value;
+                    break;
+                case Key::Type::Comission:
+                    assert(!c.isAsset());
+                    AvailFee += value;
+                    break;
+                default: // suppress warning
+                    break;
+                }
+                break;
 
-                if (totals.MinCoinHeight == 0)
+            case Coin::Status::Maturing:
+                Maturing += value;
+                Unspent += value;
+                break;
+
+            case Coin::Status::Incoming:
+                Incoming += value;
+                if (c.m_ID.m_Type == Key::Type::Change)
                 {
-                    totals.MinCoinHeight = c.m_confirmHeight;
+                    ReceivingChange += value;
                 }
                 else
                 {
-                    totals.MinCoinHeight = std::min(c.m_confirmHeight, totals.MinCoinHeight);
+                    ReceivingIncoming += value;
                 }
+                break;
 
-                const AmountBig::Type value = c.m_ID.m_Value;
-                switch (c.m_status)
-                {
-                case Coin::Status::Available:
-                    totals.Avail += value;
-                    totals.Unspent += value;
-                    switch (c.m_ID.m_Type)
-                    {
-                    case Key::Type::Coinbase:
-                        assert(!c.isAsset());
-                        totals.AvailCoinbase += value;
-                        break;
-                    case Key::Type::Comission:
-                        assert(!c.isAsset());
-                        totals.AvailFee += value;
-                        break;
-                    default: // suppress warning
-                        break;
-                    }
-                    break;
+            case Coin::Status::Outgoing:
+                Outgoing += value;
+                break;
 
-                case Coin::Status::Maturing:
-                    totals.Maturing += value;
-                    totals.Unspent += value;
-                    break;
+            case Coin::Status::Unavailable:
+                Unavail += value;
+                break;
 
-                case Coin::Status::Incoming:
-                    totals.Incoming += value;
-                    if (c.m_ID.m_Type == Key::Type::Change)
-                    {
-                        totals.ReceivingChange += value;
-                    }
-                    else
-                    {
-                        totals.ReceivingIncoming += value;
-                    }
-                    break;
+            default: // suppress warning
+                break;
+            }
 
-                case Coin::Status::Outgoing:
-                    totals.Outgoing += value;
-                    break;
+            switch (c.m_ID.m_Type)
+            {
+            case Key::Type::Coinbase:
+                assert(!c.isAsset());
+                Coinbase += value;
+                break;
+            case Key::Type::Comission:
+                assert(!c.isAsset());
+                Fee += value;
+                break;
+            default: // suppress warning
+                break;
+            }
+        }
 
-                case Coin::Status::Unavailable:
-                    totals.Unavail += value;
-                    break;
+        void Totals::AssetTotals::AddShielded(const ShieldedCoin& c, bool bAdd)
+        {
+            if (c.IsAvailable())
+            {
+                AmountBig::Type value = c.m_CoinID.m_Value;
+                if (!bAdd)
+                    value.Negate();
 
-                default: // suppress warning
-                    break;
-                }
+                Shielded += value;
+            }
+        }
 
-                switch (c.m_ID.m_Type)
-                {
-                case Key::Type::Coinbase:
-                    assert(!c.isAsset());
-                    totals.Coinbase += value;
-                    break;
-                case Key::Type::Comission:
-                    assert(!c.isAsset());
-                    totals.Fee += value;
-                    break;
-                default: // suppress warning
-                    break;
+        void Totals::Init(IWalletDB& walletDB)
+        {
+            auto getTotalsRef = [this](Asset::ID assetId) -> AssetTotals& {
+                if (allTotals.find(assetId) == allTotals.end()) {
+                    allTotals[assetId] = AssetTotals();
+                    allTotals[assetId].AssetId = assetId;
                 }
-                return true;
-            });
+                return allTotals[assetId];
+            };
 
-            walletDB.visitShieldedCoinsUnspent([getTotalsRef](const ShieldedCoin& coin) -> bool {
-                // always add to totals even if there will be no available coins
-                auto& totals = getTotalsRef(coin.m_CoinID.m_AssetID);
-                if(coin.IsAvailable())
-                {
-                    const AmountBig::Type value = coin.m_CoinID.m_Value;
-                    totals.Shielded += value;
-                }
+            // maintained by the db, includes the assets of all the coins and unspent shielded coins
+            walletDB.visitCoinTotals([getTotalsRef](const AssetTotals& x) -> bool
+            {
+                auto& totals = getTotalsRef(x.AssetId);
+                Asset::ID assetId = totals.AssetId;
+                totals = x;
+                totals.AssetId = assetId;
                 return true;
             });
 
@@ -4734,21 +5588,7 @@ namespace beam::wallet
                 return false;
 
             TxStatus txStatus;
-            if (getTxParameter(walletDB, txID.get(), TxParameterID::Status, txStatus))
-            {
-                switch (txStatus)
-                {
-                case TxStatus::Canceled:
-                case TxStatus::Failed:
-                case TxStatus::Completed:
-                    break;
-
-                default:
-                    return true;
-                }
-            }
-
-            return false;
+            return getTxParameter(walletDB, txID.get(), TxParameterID::Status, txStatus) && IsOngoingStatus(txStatus);
         }
 
         bool IsConsumeTx(const IWalletDB& walletDB, const boost::optional<TxID>& txID)
@@ -362,6 +362,65 @@ namespace beam::wallet
         virtual void onShieldedCoinsChanged(ChangeAction action, const std::vector<ShieldedCoin>& items) {};
     };
 
+    // Filter and position for the paged tx history. Ordered by MinHeight, then by TxID (both descending)
+    struct TxHistoryFilter
+    {
+        std::vector<TxType> m_Types; // empty - any
+        boost::optional<TxStatus> m_Status;
+        boost::optional<Asset::ID> m_AssetID;
+        boost::optional<Height> m_ProofHeight;
+
+        struct Position
+        {
+            Height m_MinHeight = 0;
+            TxID m_TxID;
+        };
+
+        boost::optional<Position> m_After; // continue after this tx
+        uint32_t m_Skip = 0;
+    };
+
+    namespace storage
+    {
+        // Used in statistics
+        struct Totals
+        {
+            struct AssetTotals {
+                Asset::ID AssetId = Asset::s_InvalidID;
+                AmountBig::Type Avail = 0U;
+                AmountBig::Type Maturing = 0U;
+                AmountBig::Type Incoming = 0U;
+                AmountBig::Type ReceivingIncoming = 0U;
+                AmountBig::Type ReceivingChange = 0U;
+                AmountBig::Type Unavail = 0U;
+                AmountBig::Type Outgoing = 0U;
+                AmountBig::Type AvailCoinbase = 0U;
+                AmountBig::Type Coinbase = 0U;
+                AmountBig::Type AvailFee = 0U;
+                AmountBig::Type Fee = 0U;
+                AmountBig::Type Unspent = 0U;
+                AmountBig::Type Shielded = 0U;
+                Height MinCoinHeight = 0;
+
+                void AddCoin(const Coin&, bool bAdd = true); // the coin status must be deduced
+                void AddShielded(const ShieldedCoin&, bool bAdd = true);
+            };
+
+            Totals();
+            explicit Totals(IWalletDB& db);
+            void Init(IWalletDB&);
+
+            bool HasTotals(Asset::ID) const;
+            AssetTotals GetTotals(Asset::ID) const;
+
+            inline AssetTotals GetBeamTotals() const {
+                return GetTotals(Zero);
+            }
+
+            mutable std::map<Asset::ID, AssetTotals> allTotals;
+        };
+    }
+
     struct IWalletDB : IVariablesDB
     {
         using Ptr = std::shared_ptr<IWalletDB>;
@@ -441,6 +500,12 @@ namespace beam::wallet
         virtual void visitShieldedCoins(std::function<bool(const ShieldedCoin& info)> func) = 0;
         virtual void visitShieldedCoinsUnspent(const std::function<bool(const ShieldedCoin& info)>& func) = 0;
 
+        // Coins in the storage order (optionally of a single asset), starting after the given position. The visitor also gets the coin position
+        virtual void visitCoinsFrom(const boost::optional<Asset::ID>& assetId, uint64_t posAfter, uint32_t nSkip, std::function<bool(const Coin&, uint64_t pos)> func) = 0;
+
+        // Per-asset totals of the coins and the unspent shielded coins. Maintained by the db as the coins, txs and the height change, no coin scan
+        virtual void visitCoinTotals(std::function<bool(const storage::Totals::AssetTotals&)> func) = 0;
+
         // Used in split API for session management
         virtual bool lockCoins(const CoinIDList& list, uint64_t session) = 0;
         virtual bool unlockCoins(uint64_t session) = 0;
@@ -465,10 +530,15 @@ namespace beam::wallet
         // Rollback shielded UTXO set to known height (used in rollback scenario)
         virtual void rollbackConfirmedShieldedUtxo(Height minHeight) = 0;
 
+        // Cached shielded pool elements (only the final ones are supposed to be stored)
+        virtual uint32_t readShieldedList(TxoID id0, ECC::Point::Storage*, uint32_t nCount) const = 0; // returns the num of consecutive elements found
+        virtual void saveShieldedList(TxoID id0, const ECC::Point::Storage*, uint32_t nCount) = 0;
+
         // /////////////////////////////////////////////
         // Transaction management
         virtual std::vector<TxDescription> getTxHistory(wallet::TxType txType = wallet::TxType::Simple, uint64_t start = 0, int count = std::numeric_limits<int>::max()) const = 0;
         virtual boost::optional<TxDescription> getTx(const TxID& txId) const = 0;
+        virtual void visitTxHistory(const TxHistoryFilter&, std::function<bool(const TxDescription&, Height hProof)> func) const = 0; // via the tx index, no full scan
         virtual void saveTx(const TxDescription& p) = 0;
         virtual void deleteTx(const TxID& txId) = 0;
         virtual bool setTxParameter(const TxID& txID, SubTxID subTxID, TxParameterID paramID,
@@ -602,6 +672,8 @@ namespace beam::wallet
         void visitAssets(std::function<bool(const WalletAsset& info)> func) override;
         void visitShieldedCoins(std::function<bool(const ShieldedCoin& info)> func) override;
         void visitShieldedCoinsUnspent(const std::function<bool(const ShieldedCoin& info)>& func) override;
+        void visitCoinsFrom(const boost::optional<Asset::ID>& assetId, uint64_t posAfter, uint32_t nSkip, std::function<bool(const Coin&, uint64_t pos)> func) override;
+        void visitCoinTotals(std::function<bool(const storage::Totals::AssetTotals&)> func) override;
 
         void setVarRaw(const char* name, const void* data, size_t size) override;
         bool getVarRaw(const char* name, void* data, int size) const override;
@@ -623,9 +695,12 @@ namespace beam::wallet
         void saveShieldedCoin(const ShieldedCoin& shieldedCoin) override;
         void DeleteShieldedCoin(const ShieldedTxo::BaseKey&) override;
         void rollbackConfirmedShieldedUtxo(Height minHeight) override;
+        uint32_t readShieldedList(TxoID id0, ECC::Point::Storage*, uint32_t nCount) const override;
+        void saveShieldedList(TxoID id0, const ECC::Point::Storage*, uint32_t nCount) override;
 
         std::vector<TxDescription> getTxHistory(wallet::TxType txType, uint64_t start, int count) const override;
         boost::optional<TxDescription> getTx(const TxID& txId) const override;
+        void visitTxHistory(const TxHistoryFilter&, std::function<bool(const TxDescription&, Height hProof)> func) const override;
         void saveTx(const TxDescription& p) override;
         void deleteTx(const TxID& txId) override;
         void rollbackTx(const TxID& txId) override;
@@ -720,6 +795,15 @@ namespace beam::wallet
         void saveShieldedCoinRaw(const ShieldedCoin& coin);
 
         Amount selectCoinsStd(Amount nTrg, Amount nSel, Asset::ID, std::vector<Coin>&);
+        void prepareCoinIndex(Height);
+        void loadCoinTotals();
+        void rebuildCoinTotals();
+        void saveCoinTotals();
+        void updateCoinTotals(Coin, bool bAdd);
+        void updateShieldedCoinTotals(const ShieldedTxo::BaseKey&, bool bAdd);
+        void updateTxCoinTotals(const TxID&, bool bAdd);
+        void updateHeightCoinTotals(Height hPrev, Height h);
+        bool isTxCoinTotalsParam(const TxID&, SubTxID, TxParameterID, const ByteBuffer*) const;
 
         // ////////////////////////////////////////
         // Cache for optimized access for database fields
@@ -728,6 +812,9 @@ namespace beam::wallet
         void insertParameterToCache(const TxID& txID, SubTxID subTxID, TxParameterID paramID, const boost::optional<ByteBuffer>& blob) const;
         void deleteParametersFromCache(const TxID& txID);
         bool hasTransaction(const TxID& txID) const;
+        bool isTxIndexParam(TxParameterID) const;
+        void updateTxIndex(const TxID& txID);
+        void fillTxIndex();
         void insertAddressToCache(const WalletID& id, const boost::optional<WalletAddress>& address) const;
         void deleteAddressFromCache(const WalletID& id);
         void flushDB();
@@ -771,6 +858,62 @@ namespace beam::wallet
         LocalKeyKeeper* m_pLocalKeyKeeper = nullptr;
         uint32_t m_coinConfirmationsOffset = 0;
 
+        // Confirmed unspent coins (the candidates for the coin selection), mature ones are ordered by amount per asset.
+        // Built on demand, then kept coherent via the coin change notifications
+        struct CoinIndex
+        {
+            struct IDCmp {
+                bool operator()(const Coin::ID&, const Coin::ID&) const;
+            };
+
+            struct AmountCmp {
+                bool operator()(const Coin*, const Coin*) const;
+            };
+
+            typedef std::set<const Coin*, AmountCmp> AmountSet;
+
+            std::map<Coin::ID, Coin, IDCmp> m_Coins;
+            std::map<Asset::ID, AmountSet> m_Mature;
+            std::multimap<Height, const Coin*> m_Maturing;
+            Height m_Height = 0;
+            bool m_Valid = false;
+
+            static bool IsCandidate(const Coin&);
+            void Reset();
+            void Insert(const Coin&);
+            void Delete(const Coin::ID&);
+            void SetHeight(Height);
+            void OnCoinsChanged(ChangeAction, const std::vector<Coin>&);
+
+        private:
+            void Classify(const Coin&);
+        } m_CoinIndex;
+
+        // Per-asset totals, persisted (on flush, within the same db transaction). Kept up-to-date on each coin write, on the tx status changes
+        // that affect the coin status (via the tx coin indexes), and on the height changes (only the coins with the status transition in-between,
+        // via the maturity/confirm height indexes)
+        struct CoinTotals
+        {
+            struct Entry
+            {
+                storage::Totals::AssetTotals m_Totals; // MinCoinHeight is not maintained, it's queried on demand
+                uint64_t m_Coins = 0;
+                uint64_t m_ShieldedUnspent = 0;
+            };
+
+            std::map<Asset::ID, Entry> m_Assets;
+            std::set<Asset::ID> m_Dirty; // to be saved
+            bool m_Valid = false;
+
+            void Reset();
+            void Add(const Coin&, bool bAdd); // the coin status must be deduced
+            void Add(const ShieldedCoin&, bool bAdd);
+
+        private:
+            Entry& get_Entry(Asset::ID);
+            void OnChanged(Asset::ID, const Entry&);
+        } m_CoinTotals;
+
         struct ShieldedStatusCtx;
     };
 
@@ -847,41 +990,6 @@ namespace beam::wallet
         Coin::Status GetCoinStatus(const IWalletDB&, const Coin&, Height hTop);
         void DeduceStatus(const IWalletDB&, Coin&, Height hTop);
 
-        // Used in statistics
-        struct Totals
-        {
-            struct AssetTotals {
-                Asset::ID AssetId = Asset::s_InvalidID;
-                AmountBig::Type Avail = 0U;
-                AmountBig::Type Maturing = 0U;
-                AmountBig::Type Incoming = 0U;
-                AmountBig::Type ReceivingIncoming = 0U;
-                AmountBig::Type ReceivingChange = 0U;
-                AmountBig::Type Unavail = 0U;
-                AmountBig::Type Outgoing = 0U;
-                AmountBig::Type AvailCoinbase = 0U;
-                AmountBig::Type Coinbase = 0U;
-                AmountBig::Type AvailFee = 0U;
-                AmountBig::Type Fee = 0U;
-                AmountBig::Type Unspent = 0U;
-                AmountBig::Type Shielded = 0U;
-                Height MinCoinHeight = 0;
-            };
-
-            Totals();
-            explicit Totals(IWalletDB& db);
-            void Init(IWalletDB&);
-
-            bool HasTotals(Asset::ID) const;
-            AssetTotals GetTotals(Asset::ID) const;
-
-            inline AssetTotals GetBeamTotals() const {
-                return GetTotals(Zero);
-            }
-
-            mutable std::map<Asset::ID, AssetTotals> allTotals;
-        };
-
         // Used for Payment Proof feature
         struct PaymentInfo
         {
@@ -57,32 +57,117 @@ namespace beam::wallet {
             DeleteAddr(m_Addresses.begin()->get_ParentObj());
     }
 
+    struct BaseMessageEndpoint::TrialDecrypt
+        :public Executor::TaskSync
+    {
+        static const uint32_t s_ParallelMin = 8; // don't bother with fewer addresses
+
+        struct Result
+        {
+            ByteBuffer m_Buf; // empty if failed
+            uint8_t* m_pMsg;
+            uint32_t m_nSize;
+        };
+
+        const ByteBuffer& m_Msg;
+        const std::vector<const Addr*>& m_vAddrs;
+        std::vector<Result> m_vRes; // if not empty - the results of the parallel pass
+
+        TrialDecrypt(const ByteBuffer& msg, const std::vector<const Addr*>& vAddrs)
+            :m_Msg(msg)
+            ,m_vAddrs(vAddrs)
+        {
+        }
+
+        bool Decrypt(Result& res, size_t iAddr) const
+        {
+            res.m_Buf = m_Msg; // duplicate
+            res.m_pMsg = &res.m_Buf.front();
+            res.m_nSize = static_cast<uint32_t>(res.m_Buf.size());
+
+            return proto::Bbs::Decrypt(res.m_pMsg, res.m_nSize, m_vAddrs[iAddr]->m_sk);
+        }
+
+        void Exec(Executor::Context& ctx) override
+        {
+            uint32_t i0, nCount;
+            ctx.get_Portion(i0, nCount, static_cast<uint32_t>(m_vAddrs.size()));
+
+            Result res;
+            for (uint32_t i = i0; i < i0 + nCount; i++)
+                if (Decrypt(res, i))
+                    m_vRes[i] = std::move(res); // the buffer moves along with the message pointer
+        }
+
+        void RunParallel(Executor& ex)
+        {
+            if ((m_vAddrs.size() < s_ParallelMin) || (ex.get_Threads() < 2))
+                return;
+
+            m_vRes.resize(m_vAddrs.size());
+            ex.ExecAll(*this);
+        }
+
+        const Result* get_Result(size_t iAddr, Result& res) const
+        {
+            if (!m_vRes.empty())
+                return m_vRes[iAddr].m_Buf.empty() ? nullptr : &m_vRes[iAddr];
+
+            return Decrypt(res, iAddr) ? &res : nullptr;
+        }
+    };
+
     void BaseMessageEndpoint::ProcessMessage(BbsChannel channel, const ByteBuffer& msg)
     {
         Addr::Channel key;
         key.m_Value = channel;
 
-        for (ChannelSet::iterator it = m_Channels.lower_bound(key); ; ++it)
+        ChannelSet::iterator it = m_Channels.lower_bound(key);
+        if ((m_Channels.end() == it) || (it->m_Value != channel))
+            return;
+
+        if (!m_pKdfSbbs)
         {
-            if (m_Channels.end() == it)
-                break;
-            if (it->m_Value != channel)
-                break; // as well
+            // read-only wallet
+            m_WalletDB->saveIncomingWalletMessage(channel, msg);
+            OnIncomingMessage();
+            return;
+        }
 
+        if (msg.empty())
+            return;
 
-            if (!m_pKdfSbbs)
-            {
-                // read-only wallet
-                m_WalletDB->saveIncomingWalletMessage(channel, msg);
-                OnIncomingMessage();
-                return;
-            }
+        std::vector<const Addr*> vAddrs;
+
+        proto::Bbs::HintTag tag;
+        bool bHint = proto::Bbs::get_Hint(tag, &msg.front(), static_cast<uint32_t>(msg.size()));
+        if (bHint)
+        {
+            // only the addresses with the matching tag
+            Addr::Hint keyH;
+            keyH.m_Channel = channel;
+            keyH.m_Tag = tag;
+
+            for (auto range = m_Hints.equal_range(keyH); range.first != range.second; ++range.first)
+                vAddrs.push_back(&range.first->get_ParentObj());
+        }
+        else
+        {
+            // legacy message, try all the channel addresses
+            for ( ; (m_Channels.end() != it) && (it->m_Value == channel); ++it)
+                vAddrs.push_back(&it->get_ParentObj());
+        }
 
-            ByteBuffer buf = msg; // duplicate
-            uint8_t* pMsg = &buf.front();
-            uint32_t nSize = static_cast<uint32_t>(buf.size());
+        TrialDecrypt td(msg, vAddrs);
+        if (!bHint)
+            td.RunParallel(m_TrialDecryptExecutor);
 
-            if (!proto::Bbs::Decrypt(pMsg, nSize, it->get_ParentObj().m_sk))
+        TrialDecrypt::Result res;
+
+        for (size_t i = 0; i < vAddrs.size(); i++)
+        {
+            const TrialDecrypt::Result* pRes = td.get_Result(i, res);
+            if (!pRes)
                 continue;
 
             SetTxParameter msgWallet;
@@ -90,7 +175,7 @@ namespace beam::wallet {
 
             try {
                 Deserializer der;
-                der.reset(pMsg, nSize);
+                der.reset(pRes->m_pMsg, pRes->m_nSize);
                 der& msgWallet;
                 bValid = true;
             }
@@ -100,7 +185,7 @@ namespace beam::wallet {
 
             if (bValid)
             {
-                m_Wallet.OnWalletMessage(it->get_ParentObj().m_Wid.m_Value, msgWallet);
+                m_Wallet.OnWalletMessage(vAddrs[i]->m_Wid.m_Value, msgWallet);
                 break;
             }
         }
@@ -111,9 +196,12 @@ namespace beam::wallet {
         Addr* pAddr = new Addr;
         pAddr->m_Wid.m_Value = wid;
         pAddr->m_Channel.m_Value = wid.get_Channel();
+        pAddr->m_Hint.m_Channel = pAddr->m_Channel.m_Value;
+        pAddr->m_Hint.m_Tag = proto::Bbs::get_HintTag(wid.m_Pk);
 
         m_Addresses.insert(pAddr->m_Wid);
         m_Channels.insert(pAddr->m_Channel);
+        m_Hints.insert(pAddr->m_Hint);
 
         if (IsSingleChannelUser(pAddr->m_Channel))
             OnChannelAdded(pAddr->m_Channel.m_Value);
@@ -166,6 +254,7 @@ namespace beam::wallet {
 
         m_Addresses.erase(WidSet::s_iterator_to(v.m_Wid));
         m_Channels.erase(ChannelSet::s_iterator_to(v.m_Channel));
+        m_Hints.erase(HintSet::s_iterator_to(v.m_Hint));
         delete& v;
     }
 
@@ -202,7 +291,7 @@ namespace beam::wallet {
         m_pKdfSbbs->DeriveKey(nonce, hvRandom.V);
 
         ByteBuffer encryptedMessage;
-        if (proto::Bbs::Encrypt(encryptedMessage, peerID.m_Pk, nonce, sb.first, static_cast<uint32_t>(sb.second)))
+        if (proto::Bbs::Encrypt(encryptedMessage, peerID.m_Pk, nonce, sb.first, static_cast<uint32_t>(sb.second), true))
         {
             SendRawMessage(peerID, encryptedMessage);
         }
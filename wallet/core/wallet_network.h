@@ -17,6 +17,7 @@
 #include "utility/logger.h"
 #include "core/proto.h"
 #include "utility/io/timer.h"
+#include "utility/executor.h"
 #include "bbs_miner.h"
 #include <boost/intrusive/set.hpp>
 #include <boost/intrusive/list.hpp>
@@ -44,6 +45,13 @@ namespace beam::wallet
                 IMPLEMENT_GET_PARENT_OBJ(Addr, m_Channel)
             } m_Channel;
 
+            struct Hint :public boost::intrusive::set_base_hook<> {
+                BbsChannel m_Channel;
+                proto::Bbs::HintTag m_Tag;
+                bool operator < (const Hint& x) const { return (m_Channel < x.m_Channel) || ((m_Channel == x.m_Channel) && (m_Tag < x.m_Tag)); }
+                IMPLEMENT_GET_PARENT_OBJ(Addr, m_Hint)
+            } m_Hint;
+
             bool IsExpired() const
             {
                 return getTimestamp() > m_ExpirationTime;
@@ -64,7 +72,11 @@ namespace beam::wallet
         virtual void OnChannelAdded(BbsChannel channel) {};
         virtual void OnChannelDeleted(BbsChannel channel) {};
         virtual void OnIncomingMessage() {};
+
+        ExecutorMT m_TrialDecryptExecutor; // dedicated, legacy messages are trial-decrypted in parallel. The threads are created on the first use
     private:
+        struct TrialDecrypt;
+
         void DeleteAddr(const Addr&);
         bool IsSingleChannelUser(const Addr::Channel&);
         Addr* CreateOwnAddr(const WalletID&);
@@ -82,6 +94,9 @@ namespace beam::wallet
         typedef  bi::multiset<Addr::Channel> ChannelSet;
         ChannelSet m_Channels;
 
+        typedef  bi::multiset<Addr::Hint> HintSet;
+        HintSet m_Hints;
+
         IWalletMessageConsumer& m_Wallet;
         IWalletDB::Ptr m_WalletDB;
         Key::IKdf::Ptr m_pKdfSbbs;
@@ -619,6 +619,38 @@ namespace
         WALLET_CHECK(api.parse(msg.data(), msg.size()));
     }
 
+    void testTxListCursorJsonRpc(const std::string& msg, const std::string& cursor)
+    {
+        class WalletApiHandler : public WalletApiHandlerBase
+        {
+        public:
+            WalletApiHandler(const std::string& cursor_) : _cursor(cursor_)
+            {}
+
+            void onInvalidJsonRpc(const json& msg) override
+            {
+                WALLET_CHECK(!"invalid list api json!!!");
+
+                cout << msg["error"] << endl;
+            }
+
+            void onMessage(const JsonRpcId& id, const TxList& data) override
+            {
+                WALLET_CHECK(id > 0);
+
+                WALLET_CHECK(data.count == 10);
+                WALLET_CHECK(data.cursor && *data.cursor == _cursor);
+            }
+
+            std::string _cursor;
+        };
+
+        WalletApiHandler handler(cursor);
+        WalletApi api(handler);
+
+        WALLET_CHECK(api.parse(msg.data(), msg.size()));
+    }
+
     void testValidateAddressJsonRpc(const std::string& msg, bool valid)
     {
         class WalletApiHandler : public WalletApiHandlerBase
@@ -1600,6 +1632,30 @@ int main()
         }
     }));
 
+    testTxListCursorJsonRpc(JSON_CODE(
+    {
+        "jsonrpc": "2.0",
+        "id" : 12345,
+        "method" : "tx_list",
+        "params" :
+        {
+            "count" : 10,
+            "cursor" : ""
+        }
+    }), "");
+
+    testTxListCursorJsonRpc(JSON_CODE(
+    {
+        "jsonrpc": "2.0",
+        "id" : 12345,
+        "method" : "tx_list",
+        "params" :
+        {
+            "count" : 10,
+            "cursor" : "00000000000000640102"
+        }
+    }), "00000000000000640102");
+
     testValidateAddressJsonRpc(JSON_CODE(
     {
         "jsonrpc": "2.0",
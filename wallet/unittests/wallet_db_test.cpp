@@ -22,6 +22,7 @@
 #include <boost/filesystem.hpp>
 #include <numeric>
 #include <queue>
+#include <cstring>
 
 #include "keykeeper/local_private_key_keeper.h"
 
@@ -1249,6 +1250,137 @@ void TestSelect7()
     SelectCoins(db, 6'456'001'778'569 + 1000, false);
 }
 
+void TestSelectIndex()
+{
+    cout << "\nWallet database coin selection index test\n";
+    auto db = createSqliteWalletDB(); // height 134
+
+    auto setHeight = [&db](Height h)
+    {
+        beam::Block::SystemState::ID id = { };
+        id.m_Height = h;
+        db->setSystemStateID(id);
+    };
+
+    auto selectSingle = [&db](Amount amount, Asset::ID aid = 0) -> Amount
+    {
+        auto coins = db->selectCoins(amount, aid);
+        return (coins.size() == 1) ? coins.front().m_ID.m_Value : 0;
+    };
+
+    Coin c1 = CreateAvailCoin(10);
+    Coin c2 = CreateAvailCoin(20);
+    Coin c3 = CreateAvailCoin(27, 150); // maturing
+    Coin c4 = CreateAvailCoin(40);
+    c4.m_ID.m_AssetID = 1;
+    db->storeCoin(c1);
+    db->storeCoin(c2);
+    db->storeCoin(c3);
+    db->storeCoin(c4);
+
+    WALLET_CHECK(selectSingle(10) == 10); // index is built here
+    WALLET_CHECK(selectSingle(25) == 0);
+    WALLET_CHECK(selectSingle(40, 1) == 40);
+    WALLET_CHECK(db->selectCoins(40, 0).empty());
+
+    // maturity
+    setHeight(150);
+    WALLET_CHECK(selectSingle(25) == 27);
+    setHeight(140); // rollback
+    WALLET_CHECK(selectSingle(25) == 0);
+    setHeight(150);
+
+    // added
+    Coin c5 = CreateAvailCoin(25);
+    db->storeCoin(c5);
+    WALLET_CHECK(selectSingle(25) == 25);
+
+    // spent
+    c5.m_spentHeight = 150;
+    db->saveCoin(c5);
+    WALLET_CHECK(selectSingle(25) == 27);
+
+    // outgoing (being spent by an ongoing tx)
+    TxID txID = { {1} };
+    storage::setTxParameter(*db, txID, TxParameterID::Status, TxStatus::InProgress, true);
+    c3.m_spentTxId = txID;
+    db->saveCoin(c3);
+    WALLET_CHECK(selectSingle(25) == 0);
+    storage::setTxParameter(*db, txID, TxParameterID::Status, TxStatus::Failed, true);
+    WALLET_CHECK(selectSingle(25) == 27);
+
+    // locked/unlocked by a session. The index copies must follow
+    auto isSelectedInSession = [&db](Amount amount, uint64_t session)
+    {
+        auto coins = db->selectCoins(amount, 0);
+        return (coins.size() == 1) && (coins.front().m_sessionId == session);
+    };
+
+    const uint64_t nSession = 7;
+    WALLET_CHECK(db->lockCoins({ c3.m_ID }, nSession));
+    WALLET_CHECK(isSelectedInSession(25, nSession));
+    WALLET_CHECK(db->unlockCoins(nSession));
+    WALLET_CHECK(isSelectedInSession(25, EmptyCoinSession));
+    WALLET_CHECK(!db->unlockCoins(nSession));
+
+    // removed
+    db->removeCoin(c3.m_ID);
+    WALLET_CHECK(selectSingle(25) == 0);
+
+    // unconfirmed
+    db->rollbackConfirmedUtxo(5);
+    WALLET_CHECK(db->selectCoins(10, 0).empty());
+    WALLET_CHECK(db->selectCoins(40, 1).empty());
+
+    c1.m_confirmHeight = 10;
+    db->saveCoin(c1);
+    WALLET_CHECK(selectSingle(10) == 10);
+
+    db->clearCoins();
+    WALLET_CHECK(db->selectCoins(10, 0).empty());
+}
+
+// Average duration of a call, in microseconds
+template <typename Fn>
+uint64_t MeasureAvg_us(uint32_t nCycles, Fn&& fn)
+{
+    helpers::StopWatch sw;
+    sw.start();
+    for (uint32_t i = 0; i < nCycles; ++i)
+        fn(i);
+    sw.stop();
+    return sw.microseconds() / nCycles;
+}
+
+void BenchmarkSelectIndex()
+{
+    cout << "\nWallet database coin selection benchmark\n";
+
+    for (uint32_t count : { 10'000, 100'000, 1'000'000 })
+    {
+        auto db = createSqliteWalletDB();
+
+        vector<Coin> coins;
+        coins.reserve(count);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            auto& c = coins.emplace_back(CreateAvailCoin(1'000'000 + rand() % 100'000));
+            c.m_ID.m_AssetID = i % 4; // several assets
+        }
+
+        db->storeCoins(coins);
+
+        const Amount amount = 50'000'000;
+
+        // the 1st one builds the index, similar to the storage scan
+        uint64_t t0_us = MeasureAvg_us(1, [&](uint32_t) { WALLET_CHECK(!db->selectCoins(amount, 0).empty()); });
+        uint64_t t1_us = MeasureAvg_us(20, [&](uint32_t i) { WALLET_CHECK(!db->selectCoins(amount, i % 4).empty()); });
+
+        cout << count << " coins: first select " << t0_us << " us, then " << t1_us << " us per select\n";
+    }
+}
+
 void TestWalletMessages()
 {
     cout << "\nWallet database wallet messages test\n";
@@ -1471,10 +1603,464 @@ void TestVouchers()
     WALLET_CHECK(db->getVoucherCount(receiverID) == 0);
 }
 
+
+void TestShieldedList()
+{
+    cout << "\nWallet database shielded list test\n";
+    auto db = createSqliteWalletDB();
+
+    std::vector<ECC::Point::Storage> v(20);
+    for (uint32_t i = 0; i < v.size(); i++)
+    {
+        v[i].m_X = i + 1;
+        v[i].m_Y = i * 3;
+    }
+
+    db->saveShieldedList(10, &v.front(), 10);
+    db->saveShieldedList(25, &v.front() + 15, 5); // gap at [20, 25)
+
+    std::vector<ECC::Point::Storage> vRes(20);
+    WALLET_CHECK(db->readShieldedList(0, &vRes.front(), 20) == 0);
+    WALLET_CHECK(db->readShieldedList(10, &vRes.front(), 20) == 10); // stops at the gap
+    for (uint32_t i = 0; i < 10; i++)
+        WALLET_CHECK(vRes[i].m_X == v[i].m_X && vRes[i].m_Y == v[i].m_Y);
+
+    WALLET_CHECK(db->readShieldedList(27, &vRes.front(), 20) == 3);
+    WALLET_CHECK(vRes[0].m_X == v[17].m_X);
+
+    db->saveShieldedList(20, &v.front() + 10, 5); // fill the gap, overwrite the rest
+    WALLET_CHECK(db->readShieldedList(10, &vRes.front(), 20) == 20);
+    for (uint32_t i = 0; i < 20; i++)
+        WALLET_CHECK(vRes[i].m_X == v[i].m_X && vRes[i].m_Y == v[i].m_Y);
 }
 
-int main() 
+
+void TestTxHistoryPaging()
 {
+    cout << "\nWallet database tx history paging test\n";
+    auto db = createSqliteWalletDB();
+
+    const uint32_t nTxs = 50;
+    for (uint32_t i = 0; i < nTxs; ++i)
+    {
+        TxDescription tx(TxID{ { static_cast<uint8_t>(i), 1 } });
+        tx.m_amount = 10;
+        tx.m_createTime = 100 + i;
+        tx.m_minHeight = 100 + i / 3; // duplicated heights
+        tx.m_status = (i % 5) ? TxStatus::Completed : TxStatus::Failed;
+        tx.m_assetId = (i % 10) ? 0 : 2;
+        if (i % 7 == 3)
+        {
+            tx.m_txType = TxType::AssetIssue;
+        }
+        db->saveTx(tx);
+
+        if (i % 4 == 1)
+        {
+            storage::setTxParameter(*db, tx.m_txId, TxParameterID::KernelProofHeight, Height(500), false);
+        }
+    }
+
+    // expected order
+    auto vTxs = db->getTxHistory(TxType::ALL);
+    WALLET_CHECK(vTxs.size() == nTxs);
+    std::sort(vTxs.begin(), vTxs.end(), [](const TxDescription& a, const TxDescription& b) {
+        return (a.m_minHeight != b.m_minHeight) ? (a.m_minHeight > b.m_minHeight) : (a.m_txId > b.m_txId);
+    });
+
+    auto readPaged = [&db](TxHistoryFilter f, uint32_t nPage)
+    {
+        std::vector<TxDescription> vRes;
+        while (true)
+        {
+            uint32_t n = 0;
+            db->visitTxHistory(f, [&](const TxDescription& tx, Height)
+            {
+                vRes.push_back(tx);
+                return ++n < nPage;
+            });
+
+            if (n < nPage)
+                break;
+
+            f.m_After.emplace();
+            f.m_After->m_MinHeight = vRes.back().m_minHeight;
+            f.m_After->m_TxID = vRes.back().m_txId;
+        }
+        return vRes;
+    };
+
+    TxHistoryFilter f;
+    auto vRes = readPaged(f, 7);
+    WALLET_CHECK(vRes.size() == nTxs);
+    for (size_t i = 0; i < vRes.size(); ++i)
+    {
+        WALLET_CHECK(vRes[i].m_txId == vTxs[i].m_txId);
+    }
+
+    auto countExpected = [&vTxs](const std::function<bool(const TxDescription&)>& pred)
+    {
+        return static_cast<size_t>(std::count_if(vTxs.begin(), vTxs.end(), pred));
+    };
+
+    f.m_Status = TxStatus::Failed;
+    WALLET_CHECK(readPaged(f, 3).size() == countExpected([](const TxDescription& tx) { return TxStatus::Failed == tx.m_status; }));
+
+    f.m_Status.reset();
+    f.m_Types = { TxType::Simple };
+    f.m_AssetID = 0;
+    vRes = readPaged(f, 4);
+    WALLET_CHECK(vRes.size() == countExpected([](const TxDescription& tx) { return (TxType::Simple == tx.m_txType) && !tx.m_assetId; }));
+
+    f = TxHistoryFilter();
+    f.m_ProofHeight = 500;
+    WALLET_CHECK(readPaged(f, 5).size() == countExpected([&db](const TxDescription& tx) { return storage::DeduceTxProofHeight(*db, tx) == 500; }));
+
+    f = TxHistoryFilter();
+    f.m_Skip = 45;
+    WALLET_CHECK(readPaged(f, 100).size() == 5);
+
+    // the index follows the changes
+    db->deleteTx(vTxs[0].m_txId);
+    storage::setTxParameter(*db, vTxs[1].m_txId, TxParameterID::Status, TxStatus::Failed, false);
+
+    f = TxHistoryFilter();
+    vRes = readPaged(f, 100);
+    WALLET_CHECK(vRes.size() == nTxs - 1);
+    WALLET_CHECK(vRes[0].m_txId == vTxs[1].m_txId);
+    WALLET_CHECK(vRes[0].m_status == TxStatus::Failed);
+
+    f.m_Status = TxStatus::Failed;
+    vRes = readPaged(f, 100);
+    WALLET_CHECK(!vRes.empty() && vRes[0].m_txId == vTxs[1].m_txId);
+
+    // txs that can't be read must not be counted by skip: the stub of the deleted tx (touched again), and an incomplete tx
+    storage::setTxParameter(*db, vTxs[0].m_txId, TxParameterID::Status, TxStatus::Completed, false);
+
+    TxID txIncomplete = { { 200, 1 } };
+    storage::setTxParameter(*db, txIncomplete, TxParameterID::TransactionType, TxType::Simple, false);
+    storage::setTxParameter(*db, txIncomplete, TxParameterID::Status, TxStatus::Completed, false);
+    storage::setTxParameter(*db, txIncomplete, TxParameterID::MinHeight, Height(1000), false); // would be the 1st
+
+    f = TxHistoryFilter();
+    f.m_Skip = 1;
+    vRes = readPaged(f, 100);
+    WALLET_CHECK(vRes.size() == nTxs - 2);
+    WALLET_CHECK(!vRes.empty() && vRes[0].m_txId == vTxs[2].m_txId);
+
+    f.m_Skip = nTxs - 3;
+    vRes = readPaged(f, 100);
+    WALLET_CHECK((vRes.size() == 2) && (vRes[0].m_txId == vTxs[nTxs - 2].m_txId) && (vRes[1].m_txId == vTxs[nTxs - 1].m_txId));
+
+    // completed later - listed
+    storage::setTxParameter(*db, txIncomplete, TxParameterID::Amount, Amount(10), false);
+    storage::setTxParameter(*db, txIncomplete, TxParameterID::MyID, WalletID(Zero), false);
+    storage::setTxParameter(*db, txIncomplete, TxParameterID::CreateTime, Timestamp(100), false);
+    storage::setTxParameter(*db, txIncomplete, TxParameterID::IsSender, true, false);
+
+    f = TxHistoryFilter();
+    vRes = readPaged(f, 100);
+    WALLET_CHECK(!vRes.empty() && vRes[0].m_txId == txIncomplete);
+
+    // coins
+    for (uint32_t i = 0; i < 30; ++i)
+    {
+        Coin c = CreateAvailCoin(100 + i);
+        c.m_ID.m_AssetID = i % 3;
+        db->storeCoin(c);
+    }
+
+    std::vector<Amount> vAmounts;
+    uint64_t posAfter = 0;
+    while (true)
+    {
+        uint32_t n = 0;
+        db->visitCoinsFrom(Asset::ID(1), posAfter, 0, [&](const Coin& c, uint64_t pos)
+        {
+            WALLET_CHECK(c.m_ID.m_AssetID == 1);
+            vAmounts.push_back(c.m_ID.m_Value);
+            posAfter = pos;
+            return ++n < 4;
+        });
+
+        if (n < 4)
+            break;
+    }
+
+    WALLET_CHECK(vAmounts.size() == 10);
+    for (uint32_t i = 0; i < vAmounts.size(); ++i)
+    {
+        WALLET_CHECK(vAmounts[i] == 101 + i * 3);
+    }
+}
+
+void BenchmarkTxHistoryPaging()
+{
+    cout << "\nWallet database tx history paging benchmark\n";
+    auto db = createSqliteWalletDB();
+
+    const uint32_t nTxs = 20'000;
+    for (uint32_t i = 0; i < nTxs; ++i)
+    {
+        TxID txID = {};
+        memcpy(txID.data(), &i, sizeof(i));
+
+        TxDescription tx(txID);
+        tx.m_amount = 10;
+        tx.m_createTime = 100 + i;
+        tx.m_minHeight = 100 + i;
+        tx.m_status = TxStatus::Completed;
+        db->saveTx(tx);
+    }
+
+    const uint32_t nPage = 20;
+
+    // the old way: load everything, sort, then page
+    uint64_t t0_us = MeasureAvg_us(1, [&](uint32_t)
+    {
+        auto vTxs = db->getTxHistory(TxType::Simple);
+        std::sort(vTxs.begin(), vTxs.end(), [](const TxDescription& a, const TxDescription& b) { return a.m_minHeight > b.m_minHeight; });
+        vTxs.resize(nPage);
+    });
+
+    // pages at different depths via the cursor
+    TxHistoryFilter f;
+    f.m_Types = { TxType::Simple };
+    f.m_After.emplace();
+
+    const uint32_t nCycles = 20;
+    uint64_t t1_us = MeasureAvg_us(nCycles, [&](uint32_t i)
+    {
+        f.m_After->m_MinHeight = 100 + nTxs - nTxs / nCycles * i;
+
+        std::vector<TxDescription> vRes;
+        db->visitTxHistory(f, [&](const TxDescription& tx, Height)
+        {
+            vRes.push_back(tx);
+            return vRes.size() < nPage;
+        });
+
+        WALLET_CHECK(vRes.size() == nPage);
+        WALLET_CHECK(vRes.front().m_minHeight == f.m_After->m_MinHeight - 1);
+    });
+
+    cout << nTxs << " txs, page of " << nPage << ": full load " << t0_us << " us, via cursor " << t1_us << " us\n";
+}
+
+void CheckCoinTotals(IWalletDB& db)
+{
+    // reference: the full scan
+    std::map<Asset::ID, storage::Totals::AssetTotals> mapRef;
+    auto getRef = [&mapRef](Asset::ID aid) -> storage::Totals::AssetTotals&
+    {
+        auto& t = mapRef[aid];
+        t.AssetId = aid;
+        return t;
+    };
+
+    db.visitCoins([&getRef](const Coin& c) -> bool
+    {
+        auto& t = getRef(c.m_ID.m_AssetID);
+        t.AddCoin(c);
+        t.MinCoinHeight = t.MinCoinHeight ? std::min(t.MinCoinHeight, c.m_confirmHeight) : c.m_confirmHeight;
+        return true;
+    });
+
+    db.visitShieldedCoinsUnspent([&getRef](const ShieldedCoin& c) -> bool
+    {
+        getRef(c.m_CoinID.m_AssetID).AddShielded(c);
+        return true;
+    });
+
+    size_t nCount = 0;
+    db.visitCoinTotals([&](const storage::Totals::AssetTotals& t) -> bool
+    {
+        nCount++;
+        auto it = mapRef.find(t.AssetId);
+        WALLET_CHECK(mapRef.end() != it);
+        if (mapRef.end() == it)
+            return true;
+
+        const auto& r = it->second;
+        WALLET_CHECK(t.Avail == r.Avail);
+        WALLET_CHECK(t.Maturing == r.Maturing);
+        WALLET_CHECK(t.Incoming == r.Incoming);
+        WALLET_CHECK(t.ReceivingIncoming == r.ReceivingIncoming);
+        WALLET_CHECK(t.ReceivingChange == r.ReceivingChange);
+        WALLET_CHECK(t.Unavail == r.Unavail);
+        WALLET_CHECK(t.Outgoing == r.Outgoing);
+        WALLET_CHECK(t.AvailCoinbase == r.AvailCoinbase);
+        WALLET_CHECK(t.Coinbase == r.Coinbase);
+        WALLET_CHECK(t.AvailFee == r.AvailFee);
+        WALLET_CHECK(t.Fee == r.Fee);
+        WALLET_CHECK(t.Unspent == r.Unspent);
+        WALLET_CHECK(t.Shielded == r.Shielded);
+        WALLET_CHECK(t.MinCoinHeight == r.MinCoinHeight);
+        return true;
+    });
+
+    WALLET_CHECK(nCount == mapRef.size());
+}
+
+void TestCoinTotals()
+{
+    cout << "\nWallet database coin totals test\n";
+    auto db = createSqliteWalletDB(); // height 134
+
+    auto setHeight = [&db](Height h)
+    {
+        beam::Block::SystemState::ID id = { };
+        id.m_Height = h;
+        db->setSystemStateID(id);
+    };
+
+    CheckCoinTotals(*db);
+
+    TxID tx1 = { {1} }, tx2 = { {2} }, tx3 = { {3} };
+    storage::setTxParameter(*db, tx1, TxParameterID::Status, TxStatus::InProgress, true);
+
+    Coin c1 = CreateAvailCoin(10);
+    Coin c2 = CreateAvailCoin(20, 150); // maturing
+    Coin c3 = CreateCoin(30); // incoming
+    c3.m_ID.m_Type = Key::Type::Change;
+    c3.m_createTxId = tx1;
+    Coin c4 = CreateAvailCoin(40);
+    c4.m_ID.m_AssetID = 1;
+    Coin c5 = CreateCoin(50, 200, 130); // coinbase, maturing
+    c5.m_ID.m_Type = Key::Type::Coinbase;
+    Coin c6 = CreateAvailCoin(60, 210);
+    for (Coin* pC : { &c1, &c2, &c3, &c4, &c5, &c6 })
+        db->storeCoin(*pC);
+
+    ShieldedCoin sc1, sc2;
+    sc1.m_CoinID.m_Key.m_kSerG.m_Value = 1U;
+    sc1.m_CoinID.m_Value = 70;
+    sc1.m_confirmHeight = 100;
+    sc2.m_CoinID.m_Key.m_kSerG.m_Value = 2U;
+    sc2.m_CoinID.m_Value = 80;
+    sc2.m_CoinID.m_AssetID = 2; // unconfirmed, still listed
+    db->saveShieldedCoin(sc1);
+    db->saveShieldedCoin(sc2);
+    CheckCoinTotals(*db);
+
+    {
+        storage::Totals totals(*db);
+        WALLET_CHECK(totals.HasTotals(2));
+        WALLET_CHECK(AmountBig::get_Lo(totals.GetBeamTotals().Avail) == 10);
+        WALLET_CHECK(AmountBig::get_Lo(totals.GetBeamTotals().Shielded) == 70);
+        WALLET_CHECK(totals.GetBeamTotals().MinCoinHeight == 10);
+    }
+
+    // maturity, back and forth
+    setHeight(150);
+    CheckCoinTotals(*db);
+    setHeight(140);
+    CheckCoinTotals(*db);
+    setHeight(205);
+    CheckCoinTotals(*db);
+
+    // outgoing
+    storage::setTxParameter(*db, tx2, TxParameterID::Status, TxStatus::InProgress, true);
+    c1.m_spentTxId = tx2;
+    db->saveCoin(c1);
+    CheckCoinTotals(*db);
+    storage::setTxParameter(*db, tx2, TxParameterID::Status, TxStatus::Completed, true);
+    c1.m_spentHeight = 205;
+    db->saveCoin(c1);
+    CheckCoinTotals(*db);
+
+    // the incoming tx fails, then deleted
+    storage::setTxParameter(*db, tx1, TxParameterID::Status, TxStatus::Failed, true);
+    CheckCoinTotals(*db);
+    storage::setTxParameter(*db, tx3, TxParameterID::Status, TxStatus::Registering, true);
+    c2.m_spentTxId = tx3;
+    db->saveCoin(c2);
+    CheckCoinTotals(*db);
+    db->deleteTx(tx3);
+    CheckCoinTotals(*db);
+
+    // confirmations offset
+    db->setCoinConfirmationsOffset(5);
+    CheckCoinTotals(*db);
+    setHeight(212);
+    CheckCoinTotals(*db);
+    setHeight(215);
+    CheckCoinTotals(*db);
+
+    // persisted
+    db.reset();
+    db = WalletDB::open("wallet.db", string("pass123"));
+    CheckCoinTotals(*db);
+
+    // rollbacks
+    db->rollbackConfirmedUtxo(140);
+    CheckCoinTotals(*db);
+    db->rollbackTx(tx2);
+    CheckCoinTotals(*db);
+
+    // shielded spent, coins removed
+    sc1.m_spentHeight = 215;
+    db->saveShieldedCoin(sc1);
+    CheckCoinTotals(*db);
+    db->removeCoin(c4.m_ID);
+    CheckCoinTotals(*db);
+    WALLET_CHECK(!storage::Totals(*db).HasTotals(1));
+
+    db->clearCoins();
+    CheckCoinTotals(*db);
+    db->clearShieldedCoins();
+    CheckCoinTotals(*db);
+}
+
+void BenchmarkCoinTotals()
+{
+    cout << "\nWallet database coin totals benchmark\n";
+    auto db = createSqliteWalletDB(); // height 134
+
+    const uint32_t nCount = 100'000;
+    vector<Coin> coins;
+    coins.reserve(nCount);
+
+    for (uint32_t i = 0; i < nCount; ++i)
+    {
+        auto& c = coins.emplace_back(CreateAvailCoin(1'000'000 + i, 10 + i % 200)); // some are maturing
+        c.m_ID.m_AssetID = i % 4;
+    }
+
+    db->storeCoins(coins);
+
+    // the old way: scan all the coins
+    std::map<Asset::ID, storage::Totals::AssetTotals> mapScan;
+    uint64_t t0_us = MeasureAvg_us(1, [&](uint32_t)
+    {
+        db->visitCoins([&mapScan](const Coin& c) -> bool
+        {
+            mapScan[c.m_ID.m_AssetID].AddCoin(c);
+            return true;
+        });
+    });
+
+    uint64_t t1_us = MeasureAvg_us(20, [&](uint32_t)
+    {
+        storage::Totals totals(*db);
+        WALLET_CHECK(totals.GetTotals(3).Avail == mapScan[3].Avail);
+    });
+
+    // the height change, some coins mature
+    beam::Block::SystemState::ID id = { };
+    id.m_Height = 135;
+    uint64_t t2_us = MeasureAvg_us(1, [&](uint32_t) { db->setSystemStateID(id); });
+
+    cout << nCount << " coins: full scan " << t0_us << " us, maintained totals " << t1_us << " us, new block " << t2_us << " us\n";
+}
+
+}
+
+// Benchmarks are run only if requested: wallet_db_test --benchmark
+int main(int argc, char* argv[])
+{
+    bool bBenchmark = (argc > 1) && !strcmp(argv[1], "--benchmark");
+
     int logLevel = LOG_LEVEL_DEBUG;
 #if LOG_VERBOSE_ENABLED
     logLevel = LOG_LEVEL_VERBOSE;
@@ -1497,6 +2083,7 @@ int main()
     TestSelect5();
     TestSelect6();
     TestSelect7();
+    TestSelectIndex();
     TestAddresses();
     TestExportImportTx();
     TestTxParameters();
@@ -1504,6 +2091,16 @@ int main()
     TestNotifications();
     TestExchangeRates();
     TestVouchers();
+    TestShieldedList();
+    TestTxHistoryPaging();
+    TestCoinTotals();
+
+    if (bBenchmark)
+    {
+        BenchmarkSelectIndex();
+        BenchmarkTxHistoryPaging();
+        BenchmarkCoinTotals();
+    }
 
     return WALLET_CHECK_RESULT;
 }
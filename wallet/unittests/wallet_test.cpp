@@ -2467,6 +2467,399 @@ void TestVouchers()
     WALLET_CHECK(!sender.m_Vouchers.empty());
 }
 
+void TestBbsHint()
+{
+    cout << "\nTesting BBS hinted messages...\n";
+
+    io::Reactor::Ptr mainReactor{ io::Reactor::create() };
+    io::Reactor::Scope scope(*mainReactor);
+
+    struct MyConsumer
+        :public IWalletMessageConsumer
+    {
+        uint32_t m_Received = 0;
+        WalletID m_From = Zero;
+
+        void OnWalletMessage(const WalletID& wid, const SetTxParameter&) override
+        {
+            m_Received++;
+            m_From = wid;
+        }
+    } consumer;
+
+    struct MyEndpoint
+        :public BaseMessageEndpoint
+    {
+        using BaseMessageEndpoint::BaseMessageEndpoint;
+        using BaseMessageEndpoint::ProcessMessage;
+        using BaseMessageEndpoint::m_TrialDecryptExecutor;
+
+        void SendRawMessage(const WalletID&, const ByteBuffer&) override {}
+    } ep(consumer, createSenderWalletDB());
+
+    // a busy channel, i.e. a service wallet with tens of thousands of addresses
+    const BbsChannel channel = 77;
+    const uint32_t nAddrs = 64;
+
+    Key::IKdf::Ptr pKdf;
+    HKdf::Create(pKdf, 2345U);
+    Key::Index nKey = 0;
+
+    auto newKey = [&](Scalar::Native& sk, PeerID& pk)
+    {
+        pKdf->DeriveKey(sk, Key::ID(++nKey, Key::Type::Bbs));
+        pk.FromSk(sk);
+    };
+
+    std::vector<WalletID> vWids;
+    for (uint32_t i = 0; i < nAddrs; i++)
+    {
+        Scalar::Native sk;
+        WalletID& wid = vWids.emplace_back();
+        newKey(sk, wid.m_Pk);
+        wid.m_Channel = channel;
+
+        static_cast<IWalletMessageEndpoint&>(ep).Listen(wid, sk);
+    }
+
+    SetTxParameter msgTx;
+    msgTx.m_TxID = { 1, 2, 3 };
+    msgTx.m_Type = TxType::Simple;
+    ByteBuffer bufTx = toByteBuffer(msgTx);
+
+    auto encrypt = [&](const PeerID& pk, bool bHint)
+    {
+        Scalar::Native nonce;
+        PeerID pkNonce;
+        newKey(nonce, pkNonce);
+
+        ByteBuffer res;
+        WALLET_CHECK(proto::Bbs::Encrypt(res, pk, nonce, &bufTx.front(), static_cast<uint32_t>(bufTx.size()), bHint));
+        return res;
+    };
+
+    // legacy messages are decrypted in parallel, make sure it's exercised
+    ep.m_TrialDecryptExecutor.set_Threads(std::max(ep.m_TrialDecryptExecutor.get_Threads(), 2U));
+
+    for (uint32_t iHint = 0; iHint < 2; iHint++)
+    {
+        bool bHint = !!iHint;
+
+        // ours
+        for (uint32_t i = 0; i < nAddrs; i += 7)
+        {
+            consumer.m_Received = 0;
+            ep.ProcessMessage(channel, encrypt(vWids[i].m_Pk, bHint));
+
+            WALLET_CHECK(consumer.m_Received == 1);
+            WALLET_CHECK(consumer.m_From == vWids[i]);
+        }
+
+        // someone else's on the same channel
+        const uint32_t nMsgs = 200;
+
+        std::vector<ByteBuffer> vMsgs;
+        for (uint32_t i = 0; i < nMsgs; i++)
+        {
+            Scalar::Native sk;
+            PeerID pk;
+            newKey(sk, pk);
+
+            vMsgs.push_back(encrypt(pk, bHint));
+        }
+
+        consumer.m_Received = 0;
+
+        uint32_t t = GetTime_ms();
+        for (const auto& msg : vMsgs)
+            ep.ProcessMessage(channel, msg);
+        t = GetTime_ms() - t;
+
+        WALLET_CHECK(!consumer.m_Received);
+
+        cout << (bHint ? "\tHinted" : "\tLegacy") << " foreign messages: " << nMsgs << ", addresses in channel: " << nAddrs
+            << ", time: " << t << " ms" << std::endl;
+    }
+}
+
+void TestShieldedListCache()
+{
+    cout << "\nTesting shielded list cache...\n";
+
+    io::Reactor::Ptr mainReactor{ io::Reactor::create() };
+    io::Reactor::Scope scope(*mainReactor);
+
+    Height hMaxRollback0 = Rules::get().MaxRollback;
+    Rules::get().MaxRollback = 10;
+
+    TestNodeNetwork::Shared tnns;
+
+    struct MyNetwork
+        :public TestNodeNetwork
+    {
+        std::vector<ECC::Point::Storage> m_vPool;
+        uint32_t m_Requests = 0;
+        uint64_t m_Items = 0;
+
+        using TestNodeNetwork::TestNodeNetwork;
+
+        void PostProcess(Request& r) override
+        {
+            if (Request::Type::ShieldedList != r.get_Type())
+                return TestNodeNetwork::PostProcess(r);
+
+            proto::FlyClient::RequestShieldedList& v = static_cast<proto::FlyClient::RequestShieldedList&>(r);
+            v.m_Res.m_ShieldedOuts = m_vPool.size();
+
+            if (v.m_Msg.m_Id0 < m_vPool.size())
+            {
+                uint32_t n = static_cast<uint32_t>(std::min<TxoID>(v.m_Msg.m_Count, m_vPool.size() - v.m_Msg.m_Id0));
+                v.m_Res.m_Items.assign(m_vPool.begin() + v.m_Msg.m_Id0, m_vPool.begin() + v.m_Msg.m_Id0 + n);
+                m_Items += n;
+            }
+            m_Requests++;
+        }
+    };
+
+    Wallet wallet(createSenderWalletDB());
+    auto pNet = make_shared<MyNetwork>(tnns, wallet);
+    wallet.SetNodeEndpoint(pNet);
+
+    const uint32_t nWindow = 1024; // anonymity set of each spend
+    const uint32_t nPerBlock = 10; // new shielded outputs between the withdrawals
+    const uint32_t nWithdrawals = 100;
+
+    auto addOuts = [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            ECC::Point::Storage& pt = pNet->m_vPool.emplace_back();
+            pt.m_X = pNet->m_vPool.size();
+            pt.m_Y = pNet->m_vPool.size() * 7;
+        }
+        tnns.AddBlock();
+    };
+
+    bool bOk = true;
+    auto withdrawRange = [&](TxoID id0, uint32_t nCount)
+    {
+        bool bDone = false;
+        static_cast<INegotiatorGateway&>(wallet).get_shielded_list(TxID(), id0, nCount, [&](TxoID id, uint32_t n, proto::ShieldedList& res)
+        {
+            bDone = true;
+            if ((id != id0) || (n != nCount) || (res.m_Items.size() != nCount))
+                bOk = false;
+            else
+            {
+                for (uint32_t i = 0; i < nCount; i++)
+                    if ((res.m_Items[i].m_X != pNet->m_vPool[id0 + i].m_X) || (res.m_Items[i].m_Y != pNet->m_vPool[id0 + i].m_Y))
+                        bOk = false;
+            }
+            io::Reactor::get_Current().stop();
+        });
+
+        if (!bDone)
+            mainReactor->run();
+        WALLET_CHECK(bDone);
+    };
+
+    auto withdraw = [&]()
+    {
+        TxoID id0 = (pNet->m_vPool.size() > nWindow) ? (pNet->m_vPool.size() - nWindow) : 0;
+        withdrawRange(id0, static_cast<uint32_t>(pNet->m_vPool.size() - id0));
+    };
+
+    addOuts(nWindow * 2);
+
+    uint32_t t = GetTime_ms();
+    for (uint32_t i = 0; i < nWithdrawals; i++)
+    {
+        addOuts(nPerBlock);
+        withdraw();
+    }
+    t = GetTime_ms() - t;
+
+    WALLET_CHECK(bOk);
+    WALLET_CHECK(pNet->m_Requests == nWithdrawals);
+    WALLET_CHECK(pNet->m_Items < nWindow + nWithdrawals * (nPerBlock + 1));
+
+    uint64_t nNaive = uint64_t(nWithdrawals) * nWindow;
+    cout << "\tWithdrawals: " << nWithdrawals << ", items downloaded: " << pNet->m_Items << " (" << pNet->m_Items * sizeof(ECC::Point::Storage)
+        << " bytes), without cache: " << nNaive << " (" << nNaive * sizeof(ECC::Point::Storage) << " bytes), time: " << t << " ms" << std::endl;
+
+    // the node has a different (reorged) recent history, which the wallet isn't aware of yet
+    for (uint32_t i = 0; i < 3; i++)
+        pNet->m_vPool[pNet->m_vPool.size() - 1 - i].m_X = Zero;
+
+    pNet->m_Requests = 0;
+    withdraw();
+    WALLET_CHECK(bOk);
+    WALLET_CHECK(pNet->m_Requests == 2); // mismatch detected, refetched
+
+    // an old window, not adjacent to the recent one. It's final, must be persisted on replacement
+    const uint32_t nOld = 100;
+    withdrawRange(0, nOld);
+    withdraw();
+
+    pNet->m_Items = 0;
+    withdrawRange(0, nOld);
+    WALLET_CHECK(bOk);
+    WALLET_CHECK(pNet->m_Items == 1); // only the last cached element is re-fetched
+
+    // a new window, then a range prepended to it. The prepended elements are final, must be persisted too
+    withdrawRange(600, 100);
+    withdrawRange(500, 150);
+    withdraw(); // the window moves on
+
+    pNet->m_Items = 0;
+    withdrawRange(500, 200);
+    WALLET_CHECK(bOk);
+    WALLET_CHECK(pNet->m_Items == 1);
+
+    Rules::get().MaxRollback = hMaxRollback0;
+}
+
+void TestKeyKeeperExecutor(bool bBenchmark)
+{
+    cout << "\nTesting keykeeper proof executor...\n";
+
+    Key::IKdf::Ptr pKdf;
+    HKdf::Create(pKdf, 7345U);
+    LocalPrivateKeyKeeperStd kk(pKdf);
+
+    WALLET_CHECK(kk.m_pExecutor == LocalPrivateKeyKeeper2::get_SharedExecutor());
+
+    Lelantus::Cfg cfg;
+    cfg.n = 4;
+    cfg.M = 5; // 1K elements, keep it fast
+
+    Lelantus::CmListVec lst;
+    lst.m_vec.resize(cfg.get_N());
+
+    Scalar::Native sk = 17U;
+    Point::Native pt = Context::get().G * sk;
+    for (size_t i = 0; i < lst.m_vec.size(); i++, pt += pt)
+        pt.Export(lst.m_vec[i]);
+
+    const uint32_t nProofs = 8;
+
+    typedef std::unique_ptr<TxKernelShieldedInput> KrnPtr;
+
+    auto createProof = [&](uint32_t iProof, KrnPtr& pKrn)
+    {
+        IPrivateKeyKeeper2::Method::CreateInputShielded m;
+        ZeroObject(Cast::Down<ShieldedTxo::ID>(m));
+        m.m_Value = 500 + iProof;
+        m.m_Key.m_nIdx = iProof;
+
+        m.m_pList = &lst;
+        m.m_iIdx = (iProof * 77) % cfg.get_N();
+
+        m.m_pKernel = std::make_unique<TxKernelShieldedInput>();
+        m.m_pKernel->m_Fee = 100;
+        m.m_pKernel->m_WindowEnd = cfg.get_N();
+        m.m_pKernel->m_SpendProof.m_Cfg = cfg;
+
+        WALLET_CHECK(kk.InvokeSync(m) == IPrivateKeyKeeper2::Status::Success);
+
+        pKrn = std::move(m.m_pKernel);
+    };
+
+    auto isValidProof = [&](const TxKernelShieldedInput& krn)
+    {
+        // same as the node does, the window covers the whole list
+        const Lelantus::Proof& x = krn.m_SpendProof;
+        uint32_t N = x.m_Cfg.get_N();
+
+        std::vector<Scalar::Native> vKs;
+        vKs.resize(N);
+        memset0(&vKs.front(), sizeof(Scalar::Native) * N);
+
+        Point::Native hGen;
+        if (krn.m_pAsset && !hGen.Import(krn.m_pAsset->m_hGen))
+            return false;
+
+        InnerProduct::BatchContextEx<1> bc;
+
+        Oracle oracle;
+        oracle << krn.m_Msg;
+        if (!x.IsValid(bc, oracle, &vKs.front(), &hGen))
+            return false;
+
+        lst.Calculate(bc.m_Sum, 0, N, &vKs.front());
+        return bc.Flush();
+    };
+
+    auto runThreads = [&](uint32_t nThreads, std::vector<KrnPtr>& vRes)
+    {
+        vRes.resize(nProofs);
+
+        std::vector<std::thread> vThreads;
+        for (uint32_t iThread = 0; iThread < nThreads; iThread++)
+        {
+            vThreads.emplace_back([&, iThread]()
+            {
+                for (uint32_t i = iThread; i < nProofs; i += nThreads)
+                    createProof(i, vRes[i]);
+            });
+        }
+
+        for (auto& t : vThreads)
+            t.join();
+    };
+
+    {
+        // concurrent callers share the executor
+        std::vector<KrnPtr> vRes;
+        runThreads(4, vRes);
+
+        for (uint32_t i = 0; i < nProofs; i++)
+            WALLET_CHECK(vRes[i] && isValidProof(*vRes[i]));
+    }
+
+    if (!bBenchmark)
+        return;
+
+    for (uint32_t iMode = 0; iMode < 2; iMode++)
+    {
+        bool bShared = !iMode;
+
+        for (uint32_t nThreads = 1; nThreads <= 4; nThreads <<= 1)
+        {
+            struct PerProof
+                :public Executor
+            {
+                // emulate the executor being created per proof (as it used to be)
+                virtual uint32_t get_Threads() override { return ExecutorMT().get_Threads(); }
+                virtual void Push(TaskAsync::Ptr&&) override { assert(false); }
+                virtual uint32_t Flush(uint32_t) override { return 0; }
+
+                virtual void ExecAll(TaskSync& t) override
+                {
+                    ExecutorMT ex;
+                    ex.ExecAll(t);
+                }
+            };
+
+            if (bShared)
+                kk.m_pExecutor = LocalPrivateKeyKeeper2::get_SharedExecutor();
+            else
+                kk.m_pExecutor = std::make_shared<PerProof>();
+
+            std::vector<KrnPtr> vRes;
+
+            uint32_t t = GetTime_ms();
+            runThreads(nThreads, vRes);
+            t = GetTime_ms() - t;
+
+            cout << (bShared ? "\tShared" : "\tPer-proof") << " executor, caller threads=" << nThreads
+                << ": " << (nProofs * 1000.0 / std::max<uint32_t>(t, 1)) << " proofs/sec" << std::endl;
+        }
+    }
+
+    kk.m_pExecutor = LocalPrivateKeyKeeper2::get_SharedExecutor();
+}
+
 #if defined(BEAM_HW_WALLET)
 
 //IWalletDB::Ptr createSqliteWalletDB()
@@ -2696,8 +3089,11 @@ void TestHWWallet()
 }
 #endif
 
-int main()
+// Benchmarks are run only if requested: wallet_test --benchmark
+int main(int argc, char* argv[])
 {
+    bool bBenchmark = (argc > 1) && !strcmp(argv[1], "--benchmark");
+
     int logLevel = LOG_LEVEL_DEBUG; 
 #if LOG_VERBOSE_ENABLED
     logLevel = LOG_LEVEL_VERBOSE;
@@ -2718,6 +3114,9 @@ int main()
     TestKeyKeeper();
 
     TestVouchers();
+    TestKeyKeeperExecutor(bBenchmark);
+    TestBbsHint();
+    TestShieldedListCache();
 
 
     //TestBbsDecrypt();